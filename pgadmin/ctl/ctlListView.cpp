@@ -21,7 +21,7 @@
 
 
 ctlListView::ctlListView(wxWindow *p, int id, wxPoint pos, wxSize siz, long attr)
-	: wxListView(p, id, pos, siz, attr | wxLC_REPORT)
+	: wxListView(p, id, pos, siz, attr | wxLC_REPORT), paneLoader(NULL)
 {
 }
 
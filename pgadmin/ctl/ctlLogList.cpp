@@ -0,0 +1,257 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlLogList.cpp - Virtual list view showing the tail of the server log
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "ctl/ctlLogList.h"
+
+
+void logListRow::SetText(int col, const wxString &text)
+{
+	while ((int)values.GetCount() <= col)
+		values.Add(wxEmptyString);
+	values[col] = text;
+}
+
+
+ctlLogList::ctlLogList(wxWindow *p, int id, wxPoint pos, wxSize siz, long attr)
+	: ctlListView(p, id, pos, siz, attr | wxLC_VIRTUAL),
+	  rows(NULL), capacity(0), first(0), count(0), added(0), removed(0),
+	  levelColumn(-1), lastLevel(LOGLEVEL_UNKNOWN), minLevel(LOGLEVEL_DEBUG)
+{
+	SetCapacity(LOGLIST_CAPACITY);
+}
+
+
+ctlLogList::~ctlLogList()
+{
+	delete [] rows;
+}
+
+
+void ctlLogList::SetCapacity(size_t _capacity)
+{
+	if (_capacity < 1)
+		_capacity = 1;
+
+	delete [] rows;
+	capacity = _capacity;
+	rows = new logListRow[capacity];
+	Clear();
+}
+
+
+void ctlLogList::Clear()
+{
+	first = 0;
+	count = 0;
+	added = 0;
+	removed = 0;
+	lastLevel = LOGLEVEL_UNKNOWN;
+	visible.Clear();
+	SetItemCount(0);
+	Refresh();
+}
+
+
+logListRow *ctlLogList::AddRow()
+{
+	logListRow *row;
+
+	if (count < capacity)
+		row = &rows[(first + count++) % capacity];
+	else
+	{
+		// Replace the oldest one
+		row = &rows[first];
+		first = (first + 1) % capacity;
+		removed++;
+	}
+
+	if (added < count)
+		added++;
+
+	row->values.Empty();
+	row->level = LOGLEVEL_UNKNOWN;
+	return row;
+}
+
+
+void ctlLogList::ShowAddedRows()
+{
+	if (!added && !removed)
+		return;
+
+	long oldCount = (long)visible.GetCount();
+	bool atEnd = !oldCount || GetTopItem() + GetCountPerPage() >= oldCount;
+	size_t i, gone = 0;
+
+	if (removed)
+	{
+		// Renumber the lines still there
+		while (gone < visible.GetCount() && (size_t)visible.Item(gone) < removed)
+			gone++;
+		if (gone)
+			visible.RemoveAt(0, gone);
+		for (i = 0 ; i < visible.GetCount() ; i++)
+			visible[i] -= (long)removed;
+	}
+
+	for (i = count - added ; i < count ; i++)
+	{
+		logListRow &row = Row(i);
+
+		// Continuation lines, and lines without a known severity, belong
+		// to the entry before them
+		if (levelColumn >= 0 && levelColumn < (int)row.values.GetCount())
+		{
+			int level = ParseLevel(row.values.Item(levelColumn));
+			if (level != LOGLEVEL_UNKNOWN)
+				lastLevel = level;
+		}
+		row.level = lastLevel;
+
+		if (Matches(row))
+			visible.Add((long)i);
+	}
+	added = 0;
+	removed = 0;
+
+	long newCount = (long)visible.GetCount();
+
+	// Move the selection along with the lines
+	if (gone)
+	{
+		wxArrayLong selected;
+		long item = GetFirstSelected();
+		while (item >= 0)
+		{
+			selected.Add(item);
+			item = GetNextSelected(item);
+		}
+		for (i = 0 ; i < selected.GetCount() ; i++)
+			Select(selected.Item(i), false);
+		for (i = 0 ; i < selected.GetCount() ; i++)
+		{
+			item = selected.Item(i) - (long)gone;
+			if (item >= 0 && item < newCount)
+				Select(item, true);
+		}
+	}
+
+	SetItemCount(newCount);
+	Refresh();
+
+	// Keep following the end of the log, unless scrolled up
+	if (atEnd && newCount)
+		EnsureVisible(newCount - 1);
+}
+
+
+void ctlLogList::SetFilter(int _minLevel, const wxString &_filterText)
+{
+	// The severities of the lines not shown yet are still unknown
+	ShowAddedRows();
+
+	minLevel = _minLevel;
+	filterText = _filterText.Lower();
+
+	visible.Clear();
+	for (size_t i = 0 ; i < count ; i++)
+	{
+		if (Matches(Row(i)))
+			visible.Add((long)i);
+	}
+
+	long item = GetFirstSelected();
+	while (item >= 0)
+	{
+		Select(item, false);
+		item = GetNextSelected(item);
+	}
+
+	SetItemCount((long)visible.GetCount());
+	Refresh();
+	if (visible.GetCount())
+		EnsureVisible((long)visible.GetCount() - 1);
+}
+
+
+bool ctlLogList::Matches(const logListRow &row) const
+{
+	if (row.level != LOGLEVEL_UNKNOWN && row.level < minLevel)
+		return false;
+
+	if (filterText.IsEmpty())
+		return true;
+
+	for (size_t col = 0 ; col < row.values.GetCount() ; col++)
+	{
+		if (row.values.Item(col).Lower().Find(filterText) >= 0)
+			return true;
+	}
+	return false;
+}
+
+
+int ctlLogList::ParseLevel(const wxString &text)
+{
+	wxString level = text.Strip(wxString::both).Upper();
+
+	if (level.StartsWith(wxT("DEBUG")))
+		return LOGLEVEL_DEBUG;
+	if (level.StartsWith(wxT("LOG")))
+		return LOGLEVEL_LOG;
+	if (level.StartsWith(wxT("INFO")))
+		return LOGLEVEL_INFO;
+	if (level.StartsWith(wxT("NOTICE")))
+		return LOGLEVEL_NOTICE;
+	if (level.StartsWith(wxT("WARNING")))
+		return LOGLEVEL_WARNING;
+	if (level.StartsWith(wxT("ERROR")))
+		return LOGLEVEL_ERROR;
+	if (level.StartsWith(wxT("FATAL")))
+		return LOGLEVEL_FATAL;
+	if (level.StartsWith(wxT("PANIC")))
+		return LOGLEVEL_PANIC;
+
+	// DETAIL, HINT, STATEMENT, CONTEXT and the like
+	return LOGLEVEL_UNKNOWN;
+}
+
+
+wxString ctlLogList::GetText(long row, long col)
+{
+	return OnGetItemText(row, col);
+}
+
+
+wxString ctlLogList::OnGetItemText(long item, long column) const
+{
+	if (item < 0 || item >= (long)visible.GetCount())
+		return wxEmptyString;
+
+	const wxArrayString &values = Row((size_t)visible.Item(item)).values;
+	if (column < 0 || column >= (long)values.GetCount())
+		return wxEmptyString;
+
+	return values.Item(column);
+}
+
+
+int ctlLogList::OnGetItemImage(long item) const
+{
+	return -1;
+}
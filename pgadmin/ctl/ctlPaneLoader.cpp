@@ -0,0 +1,295 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlPaneLoader.cpp - Fills the list panes of a window with the results of
+//                     queries run in the background
+//
+//////////////////////////////////////////////////////////////////////////
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "pgAdmin3.h"
+#include "ctl/ctlPaneLoader.h"
+#include "db/pgQueryThread.h"
+
+// Worker connections unused for this long are closed (in seconds)
+#define PANELOAD_IDLE_TIMEOUT   60
+
+enum
+{
+	PANELOAD_QUERY = 1000,
+	PANELOAD_IDLE_TIMER
+};
+
+BEGIN_EVENT_TABLE(ctlPaneLoader, wxEvtHandler)
+	EVT_PGQUERYRESULT(PANELOAD_QUERY, ctlPaneLoader::OnQueryComplete)
+	EVT_TIMER(PANELOAD_IDLE_TIMER,    ctlPaneLoader::OnIdleTimer)
+END_EVENT_TABLE()
+
+
+ctlPaneLoader::ctlPaneLoader()
+	: m_idleTimer(this, PANELOAD_IDLE_TIMER)
+{
+}
+
+
+ctlPaneLoader::~ctlPaneLoader()
+{
+	m_idleTimer.Stop();
+
+	while (m_requests.GetCount())
+	{
+		paneLoadRequest *req = m_requests.Item(0);
+
+		if (req->thread)
+		{
+			req->thread->CancelExecution();
+			req->thread->Wait();
+			delete req->thread;
+		}
+		if (req->conn)
+			delete req->conn;
+
+		m_requests.RemoveAt(0);
+		delete req;
+	}
+
+	while (m_idleConns.GetCount())
+	{
+		delete m_idleConns.Item(0)->conn;
+		delete m_idleConns.Item(0);
+		m_idleConns.RemoveAt(0);
+	}
+}
+
+
+void ctlPaneLoader::Add(ctlListView *list, pgConn *conn, const wxString &query, ctlListFiller *filler)
+{
+	wxString key = wxString::Format(wxT("%s:%d/%s/%s"), conn->GetHost().c_str(), conn->GetPort(),
+	                                conn->GetDbname().c_str(), conn->GetUser().c_str());
+
+	m_requests.Add(new paneLoadRequest(list, key, conn, query, filler));
+	StartQueued();
+}
+
+
+void ctlPaneLoader::Supersede(ctlListView *list)
+{
+	size_t i = 0;
+
+	while (i < m_requests.GetCount())
+	{
+		paneLoadRequest *req = m_requests.Item(i);
+
+		if (list && req->list != list)
+		{
+			i++;
+			continue;
+		}
+
+		if (!req->thread)
+		{
+			// Not started yet
+			m_requests.RemoveAt(i);
+			delete req;
+			continue;
+		}
+
+		// The event will arrive, once the server has given up on it
+		if (!req->superseded)
+		{
+			req->superseded = true;
+			req->thread->CancelExecution();
+		}
+		i++;
+	}
+}
+
+
+void ctlPaneLoader::OnQueryComplete(pgQueryResultEvent &ev)
+{
+	paneLoadRequest *req = (paneLoadRequest *)ev.GetClientData();
+
+	if (m_requests.Index(req) == wxNOT_FOUND || !req->thread ||
+	        req->thread->GetId() != ev.GetThreadID())
+		return;
+
+	pgBatchQuery *qry = ev.GetQuery();
+
+	if (!req->superseded)
+	{
+		if (qry->ReturnCode() == PGRES_TUPLES_OK && req->thread->DataSet())
+		{
+			req->list->Freeze();
+			req->filler->Fill(req->list, req->thread->DataSet());
+			req->list->Thaw();
+		}
+		else
+			wxLogInfo(wxT("Background query for the list failed: %s"), qry->GetErrorMessage().c_str());
+	}
+
+	req->thread->CancelExecution();
+	req->thread->Wait();
+	delete req->thread;
+	req->thread = NULL;
+
+	// The cancelled query has been drained by now, so the connection can
+	// be reused unless it has been left in a transaction
+	ReleaseConnection(req->key, req->conn);
+	req->conn = NULL;
+
+	Remove(req);
+	StartQueued();
+}
+
+
+void ctlPaneLoader::OnIdleTimer(wxTimerEvent &ev)
+{
+	wxDateTime now = wxDateTime::Now();
+	size_t i = 0;
+
+	while (i < m_idleConns.GetCount())
+	{
+		paneLoadConn *idle = m_idleConns.Item(i);
+
+		if ((now - idle->lastUsed).GetSeconds() >= PANELOAD_IDLE_TIMEOUT)
+		{
+			delete idle->conn;
+			m_idleConns.RemoveAt(i);
+			delete idle;
+		}
+		else
+			i++;
+	}
+
+	if (!m_idleConns.GetCount())
+		m_idleTimer.Stop();
+}
+
+
+void ctlPaneLoader::StartQueued()
+{
+	size_t i = 0;
+
+	while (i < m_requests.GetCount())
+	{
+		paneLoadRequest *req = m_requests.Item(i);
+		bool busy = (req->thread != NULL);
+		size_t j;
+
+		// One query per database at a time, in the order of the requests
+		for (j = 0 ; !busy && j < i ; j++)
+		{
+			if (m_requests.Item(j)->key == req->key)
+				busy = true;
+		}
+
+		if (busy || Start(req))
+		{
+			i++;
+			continue;
+		}
+
+		// No worker connection, let's do it the old way then
+		pgSet *set = req->baseConn->ExecuteSet(req->query);
+		if (set)
+		{
+			req->list->Freeze();
+			req->filler->Fill(req->list, set);
+			req->list->Thaw();
+			delete set;
+		}
+		m_requests.RemoveAt(i);
+		delete req;
+	}
+}
+
+
+bool ctlPaneLoader::Start(paneLoadRequest *req)
+{
+	req->conn = GetConnection(req->key, req->baseConn);
+	if (!req->conn)
+		return false;
+
+	req->thread = new pgQueryThread(req->conn, this);
+
+	if (req->thread->Create() != wxTHREAD_NO_ERROR)
+	{
+		delete req->thread;
+		req->thread = NULL;
+
+		ReleaseConnection(req->key, req->conn);
+		req->conn = NULL;
+
+		return false;
+	}
+
+	req->thread->AddQuery(req->query, NULL, PANELOAD_QUERY, req);
+	req->thread->Run();
+
+	return true;
+}
+
+
+void ctlPaneLoader::Remove(paneLoadRequest *req)
+{
+	m_requests.Remove(req);
+	delete req;
+}
+
+
+pgConn *ctlPaneLoader::GetConnection(const wxString &key, pgConn *baseConn)
+{
+	size_t i;
+
+	for (i = 0 ; i < m_idleConns.GetCount() ; i++)
+	{
+		paneLoadConn *idle = m_idleConns.Item(i);
+		if (idle->key == key)
+		{
+			pgConn *conn = idle->conn;
+
+			m_idleConns.RemoveAt(i);
+			delete idle;
+
+			if (conn->GetStatus() == PGCONN_OK)
+				return conn;
+
+			delete conn;
+			break;
+		}
+	}
+
+	if (baseConn->GetStatus() != PGCONN_OK)
+		return NULL;
+
+	pgConn *conn = baseConn->Duplicate(wxT("pgAdmin - Browser"));
+	if (conn->GetStatus() != PGCONN_OK)
+	{
+		wxLogInfo(wxT("Could not open a connection for filling the lists in the background"));
+		delete conn;
+		return NULL;
+	}
+	return conn;
+}
+
+
+void ctlPaneLoader::ReleaseConnection(const wxString &key, pgConn *conn)
+{
+	if (conn->GetStatus() != PGCONN_OK || conn->GetTxStatus() != PQTRANS_IDLE)
+	{
+		delete conn;
+		return;
+	}
+
+	m_idleConns.Add(new paneLoadConn(key, conn));
+
+	if (!m_idleTimer.IsRunning())
+		m_idleTimer.Start(PANELOAD_IDLE_TIMEOUT * 1000 / 4);
+}
@@ -127,27 +127,29 @@ wxString ctlSQLGrid::GetExportLine(int row, wxArrayInt cols)
 	if (GetNumberCols() == 0)
 		return str;
 
+	const sysSettingsSnapshot &snapshot = settings->GetSnapshot();
+
 	for (col = 0 ; col < cols.Count() ; col++)
 	{
 		if (col > 0)
-			str.Append(settings->GetCopyColSeparator());
+			str.Append(snapshot.copyColSeparator);
 
 		wxString text = GetCellValue(row, cols[col]);
 
 		bool needQuote  = false;
-		if (settings->GetCopyQuoting() == 1)
+		if (snapshot.copyQuoting == 1)
 		{
 			needQuote = IsColText(cols[col]);
 		}
-		else if (settings->GetCopyQuoting() == 2)
+		else if (snapshot.copyQuoting == 2)
 			/* Quote everything */
 			needQuote = true;
 
 		if (needQuote)
-			str.Append(settings->GetCopyQuoteChar());
+			str.Append(snapshot.copyQuoteChar);
 		str.Append(text);
 		if (needQuote)
-			str.Append(settings->GetCopyQuoteChar());
+			str.Append(snapshot.copyQuoteChar);
 	}
 	return str;
 }
@@ -21,6 +21,9 @@
 #include "utils/sysSettings.h"
 #include "frm/frmExport.h"
 
+// Formatted cells kept, a few screens full
+#define RESULT_CACHE_CELLS  8192
+
 
 
 ctlSQLResult::ctlSQLResult(wxWindow *parent, pgConn *_conn, wxWindowID id, const wxPoint &pos, const wxSize &size)
@@ -28,6 +31,7 @@ ctlSQLResult::ctlSQLResult(wxWindow *parent, pgConn *_conn, wxWindowID id, const
 {
 	conn = _conn;
 	thread = NULL;
+	streamDisplayed = false;
 
 	SetTable(new sqlResultTable(), true);
 
@@ -35,12 +39,18 @@ ctlSQLResult::ctlSQLResult(wxWindow *parent, pgConn *_conn, wxWindowID id, const
 	SetSizer(new wxBoxSizer(wxVERTICAL));
 
 	Connect(wxID_ANY, wxEVT_GRID_RANGE_SELECT, wxGridRangeSelectEventHandler(ctlSQLResult::OnGridSelect));
+	Connect(wxID_ANY, PGQueryRowsEvent, pgQueryResultEventHandler(ctlSQLResult::OnRowsAvailable));
+	Connect(wxID_ANY, SETTINGS_CHANGED_EVENT, wxCommandEventHandler(ctlSQLResult::OnSettingsChanged));
+
+	settings->AddSnapshotListener(this);
 }
 
 
 
 ctlSQLResult::~ctlSQLResult()
 {
+	settings->RemoveSnapshotListener(this);
+
 	Abort();
 
 	if (thread)
@@ -94,6 +104,23 @@ bool ctlSQLResult::ToFile(frmExport *frm)
 	return false;
 }
 
+bool ctlSQLResult::CopyFinished(frmExport *frm)
+{
+	if (!thread)
+		return false;
+
+	return frm->FinishCopy(thread, RunStatus() == PGRES_COMMAND_OK);
+}
+
+bool ctlSQLResult::GetCopyProgress(long &rows, wxLongLong &bytes)
+{
+	if (!thread || !thread->IsCopyingOut())
+		return false;
+
+	thread->GetCopyOutProgress(rows, bytes);
+	return true;
+}
+
 bool ctlSQLResult::IsColText(int col)
 {
 	switch (colTypClasses.Item(col))
@@ -107,7 +134,7 @@ bool ctlSQLResult::IsColText(int col)
 }
 
 
-int ctlSQLResult::Execute(const wxString &query, int resultToRetrieve, wxWindow *caller, long eventId, void *data)
+void ctlSQLResult::ClearGrid()
 {
 	wxGridTableMessage *msg;
 	sqlResultTable *table = (sqlResultTable *)GetTable();
@@ -117,15 +144,31 @@ int ctlSQLResult::Execute(const wxString &query, int resultToRetrieve, wxWindow
 	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_COLS_DELETED, 0, GetNumberCols());
 	ProcessTableMessage(*msg);
 	delete msg;
+}
+
+
+int ctlSQLResult::Execute(const wxString &query, int resultToRetrieve, wxWindow *caller, long eventId, void *data, bool stream)
+{
+	ClearGrid();
 
 	Abort();
 
 	colNames.Empty();
 	colTypes.Empty();
 	colTypClasses.Empty();
+	streamDisplayed = false;
 
 	thread = new pgQueryThread(conn, query, resultToRetrieve, caller, eventId, data);
 
+	// Show the rows while they are being received, unless a specific
+	// result has been asked for
+	if (stream && resultToRetrieve <= 0)
+		thread->SetStreaming(GetEventHandler(), settings->GetStreamBatchRows(),
+		                     settings->GetStreamMemoryLimit(),
+		                     settings->GetStreamMemoryPolicy());
+
+	thread->SetBinaryResults(settings->GetBinaryResults());
+
 	if (thread->Create() != wxTHREAD_NO_ERROR)
 	{
 		Abort();
@@ -139,6 +182,32 @@ int ctlSQLResult::Execute(const wxString &query, int resultToRetrieve, wxWindow
 }
 
 
+int ctlSQLResult::ExecuteCopy(const wxString &copyQuery, frmExport *frm, wxWindow *caller, long eventId, void *data)
+{
+	ClearGrid();
+
+	Abort();
+
+	colNames.Empty();
+	colTypes.Empty();
+	colTypClasses.Empty();
+	streamDisplayed = false;
+
+	thread = new pgQueryThread(conn, copyQuery, -1, caller, eventId, data);
+
+	if (!frm->StartCopy(thread) || thread->Create() != wxTHREAD_NO_ERROR)
+	{
+		Abort();
+		return -1;
+	}
+
+	((sqlResultTable *)GetTable())->SetThread(thread);
+
+	thread->Run();
+	return RunStatus();
+}
+
+
 int ctlSQLResult::Abort()
 {
 	if (thread)
@@ -161,12 +230,46 @@ int ctlSQLResult::Abort()
 
 void ctlSQLResult::DisplayData(bool single)
 {
-	if (!thread || !thread->DataValid())
+	if (!thread)
+		return;
+
+	// Pick up the last rows, the connection is available for the type
+	// lookups again now
+	if (thread->IsStreaming())
+	{
+		thread->FetchStreamedRows();
+		if (thread->DataValid())
+			thread->DataSet()->SetDeferTypeLookups(false);
+	}
+
+	if (!thread->DataValid())
 		return;
 
 	if (thread->ReturnCode() != PGRES_TUPLES_OK)
 		return;
 
+	if (streamDisplayed && !single)
+	{
+		// The columns are there already, only the types were unknown
+		AppendRows();
+
+		for (long col = 0 ; col < (long)colNames.GetCount() ; col++)
+		{
+			colTypes[col] = thread->DataSet()->ColFullType(col);
+			colTypClasses[col] = thread->DataSet()->ColTypClass(col);
+		}
+		((sqlResultTable *)GetTable())->Reset();
+		ForceRefresh();
+
+		return;
+	}
+
+	SetupColumns(single);
+}
+
+
+void ctlSQLResult::SetupColumns(bool single)
+{
 	rowcountSuppressed = single;
 	Freeze();
 
@@ -175,14 +278,11 @@ void ctlSQLResult::DisplayData(bool single)
 	 * columns, then append the correct number of them. Probably is a
 	 * better way to do this.
 	 */
+	ClearGrid();
+
 	wxGridTableMessage *msg;
 	sqlResultTable *table = (sqlResultTable *)GetTable();
-	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_DELETED, 0, GetNumberRows());
-	ProcessTableMessage(*msg);
-	delete msg;
-	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_COLS_DELETED, 0, GetNumberCols());
-	ProcessTableMessage(*msg);
-	delete msg;
+	table->Reset();
 	msg = new wxGridTableMessage(table, wxGRIDTABLE_NOTIFY_ROWS_APPENDED, NumRows());
 	ProcessTableMessage(*msg);
 	delete msg;
@@ -190,6 +290,10 @@ void ctlSQLResult::DisplayData(bool single)
 	ProcessTableMessage(*msg);
 	delete msg;
 
+	colNames.Empty();
+	colTypes.Empty();
+	colTypClasses.Empty();
+
 	if (single)
 	{
 		colNames.Add(thread->DataSet()->ColName(0));
@@ -225,6 +329,56 @@ void ctlSQLResult::DisplayData(bool single)
 }
 
 
+void ctlSQLResult::AppendRows()
+{
+	long shown = GetNumberRows();
+
+	if (NumRows() > shown)
+	{
+		wxGridTableMessage msg(GetTable(), wxGRIDTABLE_NOTIFY_ROWS_APPENDED, NumRows() - shown);
+		ProcessTableMessage(msg);
+	}
+}
+
+
+void ctlSQLResult::OnRowsAvailable(pgQueryResultEvent &ev)
+{
+	// The event may belong to an execution, which has been aborted already
+	if (thread && ev.GetThreadID() == (unsigned long)thread->GetId())
+	{
+		if (thread->FetchStreamedRows())
+		{
+			// First rows of a result, the column widths are based on them
+			SetupColumns(false);
+			streamDisplayed = true;
+		}
+		else if (streamDisplayed)
+			AppendRows();
+	}
+
+	// Let the query window know about the progress
+	ev.Skip();
+}
+
+
+void ctlSQLResult::DiscardStreamedData()
+{
+	if (!thread || !thread->IsStreaming() || !streamDisplayed)
+		return;
+
+	// The rows of an earlier result (or of a failed query) were shown
+	// while streaming, but this is not what the query returned in the end
+	ClearGrid();
+	thread->DeleteReleasedQueries();
+	((sqlResultTable *)GetTable())->Reset();
+
+	colNames.Empty();
+	colTypes.Empty();
+	colTypClasses.Empty();
+	streamDisplayed = false;
+}
+
+
 
 wxString ctlSQLResult::GetMessagesAndClear()
 {
@@ -312,61 +466,122 @@ void ctlSQLResult::OnGridSelect(wxGridRangeSelectEvent &event)
 	SetFocus();
 }
 
+// The cells shown are formatted with the new settings
+void ctlSQLResult::OnSettingsChanged(wxCommandEvent &event)
+{
+	((sqlResultTable *)GetTable())->Reset();
+	ForceRefresh();
+}
+
 wxString sqlResultTable::GetValue(int row, int col)
 {
 	if (thread && thread->DataValid())
 	{
 		if (col >= 0)
 		{
-			thread->DataSet()->Locate(row + 1);
-			if (settings->GetIndicateNull() && thread->DataSet()->IsNull(col))
-				return wxT("<NULL>");
-			else
-			{
+			const wxString *cached = cellCache.Find(row, col);
+			if (cached)
+				return *cached;
 
-				wxString decimalMark = wxT(".");
-				wxString s = thread->DataSet()->GetVal(col);
+			if (colFormats.IsEmpty())
+				SetupFormats();
 
-				if(thread->DataSet()->ColTypClass(col) == PGTYPCLASS_NUMERIC &&
-				        settings->GetDecimalMark().Length() > 0)
-				{
-					decimalMark = settings->GetDecimalMark();
-					s.Replace(wxT("."), decimalMark);
+			wxString value = FormatValue(row, col);
+			cellCache.Add(row, col, value);
 
-				}
-				if (thread->DataSet()->ColTypClass(col) == PGTYPCLASS_NUMERIC &&
-				        settings->GetThousandsSeparator().Length() > 0)
-				{
-					/* Add thousands separator */
-					size_t pos = s.find(decimalMark);
-					if (pos == wxString::npos)
-						pos = s.length();
-					while (pos > 3)
-					{
-						pos -= 3;
-						if (pos > 1 || !s.StartsWith(wxT("-")))
-							s.insert(pos, settings->GetThousandsSeparator());
-					}
-					return s;
-				}
+			return value;
+		}
+		else
+			return thread->DataSet()->ColName(col);
+	}
+	return wxEmptyString;
+}
+
+// Chooses the format of each column, using the settings at that time
+void sqlResultTable::SetupFormats()
+{
+	const sysSettingsSnapshot &snapshot = settings->GetSnapshot();
+	pgSet *set = thread->DataSet();
+
+	indicateNull = snapshot.indicateNull;
+	decimalMark = snapshot.decimalMark;
+	thousandsSeparator = snapshot.thousandsSeparator;
+	maxColSize = snapshot.maxColSize;
+
+	colFormats.Empty();
+	for (int col = 0 ; col < set->NumCols() ; col++)
+	{
+		switch (set->ColTypClass(col))
+		{
+			case PGTYPCLASS_NUMERIC:
+				if (decimalMark.IsEmpty() && thousandsSeparator.IsEmpty())
+					colFormats.Add(RESULT_FORMAT_PLAIN);
 				else
-				{
-					wxString data = thread->DataSet()->GetVal(col);
+					colFormats.Add(RESULT_FORMAT_NUMBER);
+				break;
+			case PGTYPCLASS_BOOL:
+				colFormats.Add(RESULT_FORMAT_PLAIN);
+				break;
+			default:
+				colFormats.Add(RESULT_FORMAT_TEXT);
+				break;
+		}
+	}
+}
 
-					if (data.Length() > (size_t)settings->GetMaxColSize())
-						return thread->DataSet()->GetVal(col).Left(settings->GetMaxColSize()) + wxT(" (...)");
-					else
-						return thread->DataSet()->GetVal(col);
+wxString sqlResultTable::FormatValue(int row, int col)
+{
+	pgSet *set = thread->DataSet();
+
+	set->Locate(row + 1);
+	if (indicateNull && set->IsNull(col))
+		return wxT("<NULL>");
+
+	wxString s = set->GetVal(col);
+
+	switch (colFormats.Item(col))
+	{
+		case RESULT_FORMAT_NUMBER:
+		{
+			wxString mark = wxT(".");
+			if (!decimalMark.IsEmpty())
+			{
+				mark = decimalMark;
+				s.Replace(wxT("."), mark);
+			}
+
+			if (!thousandsSeparator.IsEmpty())
+			{
+				/* Add thousands separator */
+				size_t pos = s.find(mark);
+				if (pos == wxString::npos)
+					pos = s.length();
+				while (pos > 3)
+				{
+					pos -= 3;
+					if (pos > 1 || !s.StartsWith(wxT("-")))
+						s.insert(pos, thousandsSeparator);
 				}
 			}
+			break;
 		}
-		else
-			return thread->DataSet()->ColName(col);
+		case RESULT_FORMAT_TEXT:
+			if (s.Length() > (size_t)maxColSize)
+				s = s.Left(maxColSize) + wxT(" (...)");
+			break;
 	}
-	return wxEmptyString;
+
+	return s;
+}
+
+void sqlResultTable::Reset()
+{
+	colFormats.Empty();
+	cellCache.Clear();
 }
 
 sqlResultTable::sqlResultTable()
+	: cellCache(RESULT_CACHE_CELLS)
 {
 	thread = NULL;
 }
@@ -394,3 +609,90 @@ int sqlResultTable::GetNumberCols()
 	return 0;
 }
 
+
+sqlCellCache::sqlCellCache(int _size)
+{
+	size = _size;
+	entries = new cacheEntry[size];
+	used = 0;
+	first = last = -1;
+}
+
+sqlCellCache::~sqlCellCache()
+{
+	delete[] entries;
+}
+
+const wxString *sqlCellCache::Find(int row, int col)
+{
+	sqlCellCacheMap::iterator it = index.find(Key(row, col));
+	if (it == index.end())
+		return NULL;
+
+	int entry = it->second;
+	if (entry != first)
+	{
+		Unlink(entry);
+		LinkFirst(entry);
+	}
+
+	return &entries[entry].value;
+}
+
+void sqlCellCache::Add(int row, int col, const wxString &value)
+{
+	int entry;
+
+	if (used < size)
+		entry = used++;
+	else
+	{
+		// Reuse the least recently used one
+		entry = last;
+		Unlink(entry);
+		index.erase(entries[entry].key);
+	}
+
+	entries[entry].key = Key(row, col);
+	entries[entry].value = value;
+	LinkFirst(entry);
+	index[entries[entry].key] = entry;
+}
+
+void sqlCellCache::Clear()
+{
+	for (int i = 0 ; i < used ; i++)
+		entries[i].value = wxEmptyString;
+
+	index.clear();
+	used = 0;
+	first = last = -1;
+}
+
+void sqlCellCache::Unlink(int entry)
+{
+	cacheEntry &e = entries[entry];
+
+	if (e.prev >= 0)
+		entries[e.prev].next = e.next;
+	else
+		first = e.next;
+
+	if (e.next >= 0)
+		entries[e.next].prev = e.prev;
+	else
+		last = e.prev;
+}
+
+void sqlCellCache::LinkFirst(int entry)
+{
+	cacheEntry &e = entries[entry];
+
+	e.prev = -1;
+	e.next = first;
+	if (first >= 0)
+		entries[first].prev = entry;
+	first = entry;
+	if (last < 0)
+		last = entry;
+}
@@ -0,0 +1,203 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlServerConnector.cpp - Connects to several servers at once in the
+//                          background
+//
+//////////////////////////////////////////////////////////////////////////
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "pgAdmin3.h"
+#include "ctl/ctlServerConnector.h"
+#include "frm/frmMain.h"
+#include "schema/pgServer.h"
+
+#ifdef __WXMSW__
+#include <winsock.h>
+#else
+#include <poll.h>
+#endif
+
+// Interval (ms), in which the sockets are checked
+#define SERVERCONNECT_POLL_INTERVAL   50
+// Servers not done connecting after this long are given up (in seconds)
+#define SERVERCONNECT_TIMEOUT         30
+
+enum
+{
+	SERVERCONNECT_POLL_TIMER = 1000
+};
+
+BEGIN_EVENT_TABLE(ctlServerConnector, wxEvtHandler)
+	EVT_TIMER(SERVERCONNECT_POLL_TIMER, ctlServerConnector::OnPollTimer)
+END_EVENT_TABLE()
+
+
+// Does the socket allow to read (or write) without blocking?
+static bool SocketReady(int sock, bool forWrite)
+{
+#ifdef __WXMSW__
+	fd_set fds;
+	struct timeval timeout;
+
+	FD_ZERO(&fds);
+	FD_SET(sock, &fds);
+	timeout.tv_sec = 0;
+	timeout.tv_usec = 0;
+
+	if (forWrite)
+		return select(sock + 1, NULL, &fds, NULL, &timeout) > 0;
+	return select(sock + 1, &fds, NULL, NULL, &timeout) > 0;
+#else
+	struct pollfd fd;
+
+	fd.fd = sock;
+	fd.events = forWrite ? POLLOUT : POLLIN;
+	fd.revents = 0;
+
+	// Errors and hang-ups are reported by PQconnectPoll() too
+	return poll(&fd, 1, 0) > 0;
+#endif
+}
+
+
+serverConnectRequest::serverConnectRequest(pgServer *_server)
+	: server(_server), pollStatus(PGRES_POLLING_WRITING)
+{
+	deadline = wxGetLocalTimeMillis() + SERVERCONNECT_TIMEOUT * 1000;
+}
+
+
+ctlServerConnector::ctlServerConnector(frmMain *form)
+	: m_form(form), m_pollTimer(this, SERVERCONNECT_POLL_TIMER)
+{
+}
+
+
+ctlServerConnector::~ctlServerConnector()
+{
+	m_pollTimer.Stop();
+
+	while (m_requests.GetCount())
+	{
+		delete m_requests.Item(0);
+		m_requests.RemoveAt(0);
+	}
+}
+
+
+bool ctlServerConnector::Connect(pgServer *server)
+{
+	if (IsConnecting(server))
+		return true;
+
+	if (!server->StartConnect())
+		return false;
+
+	m_requests.Add(new serverConnectRequest(server));
+
+	if (!m_pollTimer.IsRunning())
+		m_pollTimer.Start(SERVERCONNECT_POLL_INTERVAL);
+
+	return true;
+}
+
+
+bool ctlServerConnector::IsConnecting(pgServer *server)
+{
+	for (size_t i = 0 ; i < m_requests.GetCount() ; i++)
+	{
+		if (m_requests.Item(i)->server == server)
+			return true;
+	}
+	return false;
+}
+
+
+void ctlServerConnector::Cancel(pgServer *server)
+{
+	for (size_t i = 0 ; i < m_requests.GetCount() ; i++)
+	{
+		serverConnectRequest *req = m_requests.Item(i);
+
+		if (req->server == server)
+		{
+			m_requests.RemoveAt(i);
+			delete req;
+			break;
+		}
+	}
+
+	if (!m_requests.GetCount())
+		m_pollTimer.Stop();
+}
+
+
+void ctlServerConnector::OnPollTimer(wxTimerEvent &ev)
+{
+	wxLongLong now = wxGetLocalTimeMillis();
+	size_t i = 0;
+
+	while (i < m_requests.GetCount())
+	{
+		serverConnectRequest *req = m_requests.Item(i);
+		pgConn *conn = req->server->connection();
+		int sock = conn->GetSocket();
+
+		if (sock >= 0 && !SocketReady(sock, req->pollStatus == PGRES_POLLING_WRITING))
+		{
+			if (now < req->deadline)
+			{
+				i++;
+				continue;
+			}
+
+			wxLogWarning(_("Could not connect to the server %s (%s:%d): timed out after %d seconds"),
+			             req->server->GetDescription().c_str(), req->server->GetName().c_str(),
+			             req->server->GetPort(), SERVERCONNECT_TIMEOUT);
+			Finish(req, false);
+			continue;
+		}
+
+		req->pollStatus = conn->PollConnect();
+
+		if (req->pollStatus == PGRES_POLLING_OK)
+			Finish(req, true);
+		else if (req->pollStatus == PGRES_POLLING_FAILED)
+		{
+			wxLogWarning(_("Could not connect to the server %s (%s:%d): %s"),
+			             req->server->GetDescription().c_str(), req->server->GetName().c_str(),
+			             req->server->GetPort(), conn->GetLastError().c_str());
+			Finish(req, false);
+		}
+		else
+			i++;
+	}
+
+	if (!m_requests.GetCount())
+		m_pollTimer.Stop();
+}
+
+
+void ctlServerConnector::Finish(serverConnectRequest *req, bool success)
+{
+	pgServer *server = req->server;
+
+	m_requests.Remove(req);
+	delete req;
+
+	if (success && server->FinishConnect(m_form) == PGCONN_OK)
+	{
+		wxLogInfo(wxT("Connected to the server %s in the background"), server->GetName().c_str());
+		server->ShowTreeDetail(m_form->GetBrowser());
+	}
+	else
+		server->Disconnect(m_form);
+}
@@ -0,0 +1,175 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlStatusGraph.cpp - Draws the history of the server's activity
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/dcbuffer.h>
+
+// App headers
+#include "ctl/ctlStatusGraph.h"
+#include "utils/statusHistory.h"
+
+// Graphs lower than this (in pixels) are not drawn
+#define GRAPH_MIN_HEIGHT    24
+
+
+BEGIN_EVENT_TABLE(ctlStatusGraph, wxWindow)
+	EVT_PAINT(                  ctlStatusGraph::OnPaint)
+	EVT_SIZE(                   ctlStatusGraph::OnSize)
+	EVT_ERASE_BACKGROUND(       ctlStatusGraph::OnEraseBackground)
+END_EVENT_TABLE()
+
+
+ctlStatusGraph::ctlStatusGraph(wxWindow *parent, wxWindowID id, statusHistory *_history)
+	: wxWindow(parent, id, wxDefaultPosition, wxDefaultSize, wxSUNKEN_BORDER | wxFULL_REPAINT_ON_RESIZE),
+	  history(_history), span(300)
+{
+}
+
+
+void ctlStatusGraph::SetSpan(long _span)
+{
+	span = _span;
+	Refresh();
+}
+
+
+void ctlStatusGraph::SetMessage(const wxString &_message)
+{
+	message = _message;
+	Refresh();
+}
+
+
+void ctlStatusGraph::OnSize(wxSizeEvent &event)
+{
+	Refresh();
+	event.Skip();
+}
+
+
+void ctlStatusGraph::OnEraseBackground(wxEraseEvent &event)
+{
+	// Everything is painted by OnPaint(), this would only flicker
+}
+
+
+void ctlStatusGraph::OnPaint(wxPaintEvent &event)
+{
+	wxBufferedPaintDC dc(this);
+	wxSize size = GetClientSize();
+	wxColour textColour = wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOWTEXT);
+
+	dc.SetBackground(wxBrush(wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOW)));
+	dc.Clear();
+	dc.SetFont(GetFont());
+	dc.SetTextForeground(textColour);
+
+	if (!message.IsEmpty())
+	{
+		dc.DrawText(message, 5, 5);
+		return;
+	}
+
+	int width = size.GetWidth();
+	int height = size.GetHeight() / HISTORY_METRICS;
+	int textHeight = dc.GetCharHeight();
+	if (width < 2 || height < GRAPH_MIN_HEIGHT || span <= 0)
+		return;
+
+	size_t count = history->GetCount();
+	wxLongLong spanMs = wxLongLong(span) * 1000;
+	wxLongLong end = count ? history->GetTime(count - 1) : wxGetLocalTimeMillis();
+	wxLongLong start = end - spanMs;
+	size_t from = history->FindTime(start), i;
+	int metric, x;
+
+	// Sum up the samples of each pixel column
+	double *sums = new double[HISTORY_METRICS * width];
+	int *samples = new int[width];
+	for (x = 0 ; x < width ; x++)
+	{
+		samples[x] = 0;
+		for (metric = 0 ; metric < HISTORY_METRICS ; metric++)
+			sums[metric * width + x] = 0.0;
+	}
+
+	for (i = from ; i < count ; i++)
+	{
+		x = (int)((history->GetTime(i) - start) * (width - 1) / spanMs).ToLong();
+		if (x < 0)
+			x = 0;
+		if (x >= width)
+			x = width - 1;
+
+		samples[x]++;
+		for (metric = 0 ; metric < HISTORY_METRICS ; metric++)
+			sums[metric * width + x] += history->GetValue(i, metric);
+	}
+
+	wxPoint *points = new wxPoint[width];
+	wxPen linePen(wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHT), 1, wxSOLID);
+	wxPen gridPen(wxSystemSettings::GetColour(wxSYS_COLOUR_3DLIGHT), 1, wxSOLID);
+
+	for (metric = 0 ; metric < HISTORY_METRICS ; metric++)
+	{
+		int top = metric * height;
+		int plotTop = top + textHeight + 4;
+		int plotHeight = height - textHeight - 6;
+		double max = 0.0, last = 0.0;
+		int n = 0;
+
+		for (x = 0 ; x < width ; x++)
+		{
+			if (samples[x])
+			{
+				double avg = sums[metric * width + x] / samples[x];
+				if (avg > max)
+					max = avg;
+			}
+		}
+		if (count)
+			last = history->GetValue(count - 1, metric);
+
+		for (x = 0 ; x < width ; x++)
+		{
+			if (!samples[x])
+				continue;
+
+			double avg = sums[metric * width + x] / samples[x];
+			int y = plotTop + plotHeight;
+			if (max > 0.0)
+				y -= (int)(avg * plotHeight / max);
+			points[n++] = wxPoint(x, y);
+		}
+
+		if (metric > 0)
+		{
+			dc.SetPen(gridPen);
+			dc.DrawLine(0, top, width, top);
+		}
+
+		dc.DrawText(wxString::Format(_("%s: %.0f (max. %.0f)"),
+		                             statusHistory::GetMetricName(metric).c_str(), last, max), 5, top + 2);
+
+		dc.SetPen(linePen);
+		if (n > 1)
+			dc.DrawLines(n, points);
+		else if (n == 1)
+			dc.DrawPoint(points[0]);
+	}
+
+	delete [] points;
+	delete [] samples;
+	delete [] sums;
+}
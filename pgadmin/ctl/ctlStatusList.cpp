@@ -0,0 +1,160 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlStatusList.cpp - Virtual list view showing a snapshot of keyed rows
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/hashmap.h>
+
+// App headers
+#include "ctl/ctlStatusList.h"
+
+WX_DECLARE_STRING_HASH_MAP(long, statusListKeyMap);
+
+
+ctlStatusList::ctlStatusList(wxWindow *p, int id, wxPoint pos, wxSize siz, long attr)
+	: ctlListView(p, id, pos, siz, attr | wxLC_VIRTUAL)
+{
+	itemAttr = new wxListItemAttr();
+}
+
+
+ctlStatusList::~ctlStatusList()
+{
+	WX_CLEAR_ARRAY(rows);
+	delete itemAttr;
+}
+
+
+void ctlStatusList::SetRows(statusListRowArray &newRows)
+{
+	long oldCount = (long)rows.GetCount();
+	long newCount = (long)newRows.GetCount();
+	long row, first = -1;
+
+	// Remember the selection by the keys of the rows
+	wxArrayString selectedKeys;
+	wxArrayLong wasSelected;
+	wxString focusedKey;
+
+	row = GetFirstSelected();
+	while (row >= 0 && row < oldCount)
+	{
+		selectedKeys.Add(rows.Item(row)->key);
+		wasSelected.Add(row);
+		row = GetNextSelected(row);
+	}
+	row = GetFocusedItem();
+	if (row >= 0 && row < oldCount)
+		focusedKey = rows.Item(row)->key;
+
+	statusListRowArray oldRows = rows;
+	rows = newRows;
+	newRows.Clear();
+
+	// Changing the number of items repaints the whole list anyway
+	if (newCount != oldCount)
+		SetItemCount(newCount);
+
+	// Repaint the runs of changed rows
+	for (row = 0 ; row < oldCount && row < newCount ; row++)
+	{
+		if (!rows.Item(row)->SameAs(oldRows.Item(row)))
+		{
+			if (first < 0)
+				first = row;
+		}
+		else if (first >= 0)
+		{
+			RefreshItems(first, row - 1);
+			first = -1;
+		}
+	}
+	if (first >= 0)
+		RefreshItems(first, row - 1);
+
+	WX_CLEAR_ARRAY(oldRows);
+
+	if (!selectedKeys.GetCount() && focusedKey.IsEmpty())
+		return;
+
+	statusListKeyMap positions;
+	size_t i;
+
+	// Backwards, so that the first one of duplicate keys wins
+	for (row = newCount - 1 ; row >= 0 ; row--)
+		positions[rows.Item(row)->key] = row;
+
+	// Select the rows at their new positions, changing only the rows
+	// which have moved, so that no events are sent for the others
+	wxArrayLong nowSelected;
+	for (i = 0 ; i < selectedKeys.GetCount() ; i++)
+	{
+		statusListKeyMap::iterator it = positions.find(selectedKeys.Item(i));
+		if (it != positions.end())
+			nowSelected.Add(it->second);
+	}
+	for (i = 0 ; i < wasSelected.GetCount() ; i++)
+	{
+		if (wasSelected.Item(i) < newCount && nowSelected.Index(wasSelected.Item(i)) == wxNOT_FOUND)
+			Select(wasSelected.Item(i), false);
+	}
+	for (i = 0 ; i < nowSelected.GetCount() ; i++)
+	{
+		if (wasSelected.Index(nowSelected.Item(i)) == wxNOT_FOUND)
+			Select(nowSelected.Item(i), true);
+	}
+
+	if (!focusedKey.IsEmpty())
+	{
+		statusListKeyMap::iterator it = positions.find(focusedKey);
+		// Not Focus(), which would scroll the list to the row
+		if (it != positions.end() && it->second != GetFocusedItem())
+			SetItemState(it->second, wxLIST_STATE_FOCUSED, wxLIST_STATE_FOCUSED);
+	}
+}
+
+
+wxString ctlStatusList::GetText(long row, long col)
+{
+	return OnGetItemText(row, col);
+}
+
+
+wxString ctlStatusList::OnGetItemText(long item, long column) const
+{
+	if (item < 0 || item >= (long)rows.GetCount())
+		return wxEmptyString;
+
+	const wxArrayString &values = rows.Item(item)->values;
+	if (column < 0 || column >= (long)values.GetCount())
+		return wxEmptyString;
+
+	return values.Item(column);
+}
+
+
+int ctlStatusList::OnGetItemImage(long item) const
+{
+	// The image list holds the sort indicators of the columns only
+	return -1;
+}
+
+
+wxListItemAttr *ctlStatusList::OnGetItemAttr(long item) const
+{
+	if (item < 0 || item >= (long)rows.GetCount() || !rows.Item(item)->colour.Ok())
+		return NULL;
+
+	itemAttr->SetBackgroundColour(rows.Item(item)->colour);
+	return itemAttr;
+}
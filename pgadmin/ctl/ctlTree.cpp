@@ -15,6 +15,7 @@
 // App headers
 #include "pgAdmin3.h"
 #include "ctl/ctlTree.h"
+#include "ctl/ctlTreeLoader.h"
 
 #include "schema/pgObject.h"
 #include "schema/pgCollection.h"
@@ -177,7 +178,7 @@ void ctlTree::OnChar(wxKeyEvent &event)
 }
 
 ctlTree::ctlTree(wxWindow *parent, wxWindowID id, const wxPoint &pos, const wxSize &size, long style)
-	: wxTreeCtrl(parent, id, pos, size, style), m_findTimer(NULL)
+	: wxTreeCtrl(parent, id, pos, size, style), m_findTimer(NULL), m_loader(NULL)
 {
 }
 
@@ -186,6 +187,19 @@ ctlTree::~ctlTree()
 	if ( m_findTimer )
 		delete m_findTimer;
 	m_findTimer = NULL;
+
+	// The collections being loaded are still around at this point
+	if (m_loader)
+		delete m_loader;
+	m_loader = NULL;
+}
+
+
+ctlTreeLoader *ctlTree::GetLoader()
+{
+	if (!m_loader)
+		m_loader = new ctlTreeLoader(this);
+	return m_loader;
 }
 
 
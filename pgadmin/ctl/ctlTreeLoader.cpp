@@ -0,0 +1,492 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlTreeLoader.cpp - Loads the objects of the browser collections in the
+//                     background
+//
+//////////////////////////////////////////////////////////////////////////
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "pgAdmin3.h"
+#include "ctl/ctlTreeLoader.h"
+#include "db/pgQueryThread.h"
+#include "schema/pgCollection.h"
+
+// Objects appended to the tree per timer tick
+#define TREELOAD_BATCH_SIZE        200
+#define TREELOAD_APPEND_INTERVAL   50
+// Worker connections unused for this long are closed (in seconds)
+#define TREELOAD_IDLE_TIMEOUT      120
+
+enum
+{
+	TREELOAD_QUERY = 1000,
+	TREELOAD_APPEND_TIMER,
+	TREELOAD_IDLE_TIMER
+};
+
+BEGIN_EVENT_TABLE(ctlTreeLoader, wxEvtHandler)
+	EVT_PGQUERYRESULT(TREELOAD_QUERY, ctlTreeLoader::OnQueryComplete)
+	EVT_TIMER(TREELOAD_APPEND_TIMER,  ctlTreeLoader::OnAppendTimer)
+	EVT_TIMER(TREELOAD_IDLE_TIMER,    ctlTreeLoader::OnIdleTimer)
+END_EVENT_TABLE()
+
+
+ctlTreeLoader::ctlTreeLoader(ctlTree *browser)
+	: m_browser(browser), m_properties(NULL),
+	  m_appendTimer(this, TREELOAD_APPEND_TIMER),
+	  m_idleTimer(this, TREELOAD_IDLE_TIMER)
+{
+}
+
+
+ctlTreeLoader::~ctlTreeLoader()
+{
+	m_appendTimer.Stop();
+	m_idleTimer.Stop();
+
+	while (m_requests.GetCount())
+	{
+		treeLoadRequest *req = m_requests.Item(0);
+
+		StopThread(req);
+		if (req->conn)
+			delete req->conn;
+		req->collection->SetLoader(NULL);
+
+		m_requests.RemoveAt(0);
+		delete req;
+	}
+
+	while (m_idleConns.GetCount())
+	{
+		treeLoadConn *idle = m_idleConns.Item(0);
+
+		delete idle->conn;
+
+		m_idleConns.RemoveAt(0);
+		delete idle;
+	}
+}
+
+
+bool ctlTreeLoader::Load(pgCollection *collection)
+{
+	if (!settings->GetBackgroundTreeLoading() || !collection->GetFactory())
+		return false;
+
+	pgConn *conn = collection->GetConnection();
+	if (!conn || conn->GetStatus() != PGCONN_OK)
+		return false;
+
+	wxString query = collection->GetFactory()->GetObjectsQuery(collection);
+	if (query.IsEmpty())
+		return false;
+
+	wxString key = wxString::Format(wxT("%s:%d/%s/%s"), conn->GetHost().c_str(), conn->GetPort(),
+	                                conn->GetDbname().c_str(), conn->GetUser().c_str());
+
+	treeLoadRequest *req = new treeLoadRequest(collection, key, query);
+	req->placeholder = m_browser->AppendItem(collection->GetId(), _("Loading..."));
+	collection->SetLoader(this);
+	m_requests.Add(req);
+
+	StartQueued();
+
+	if (!m_appendTimer.IsRunning())
+		m_appendTimer.Start(TREELOAD_APPEND_INTERVAL);
+
+	return true;
+}
+
+
+bool ctlTreeLoader::IsLoading(pgCollection *collection)
+{
+	treeLoadRequest *req = FindRequest(collection);
+	if (!req)
+		return false;
+
+	// The children of the collection have been removed (i.e. refreshed)
+	// meanwhile, hence - this request is of no use any more
+	if (!HasPlaceholder(req))
+	{
+		Cancel(collection, false);
+		return false;
+	}
+	return true;
+}
+
+
+void ctlTreeLoader::Cancel(pgCollection *collection, bool updateTree)
+{
+	treeLoadRequest *req = FindRequest(collection);
+	if (!req)
+		return;
+
+	// The connection can be reused, only if the query has finished already
+	bool completed = (req->set != NULL);
+
+	StopThread(req);
+	if (req->conn)
+	{
+		if (completed)
+			ReleaseConnection(req->key, req->conn);
+		else
+			delete req->conn;
+		req->conn = NULL;
+	}
+
+	collection->SetLoader(NULL);
+	m_requests.Remove(req);
+	delete req;
+
+	if (updateTree)
+	{
+		// Throw away whatever has been appended so far, the collection will
+		// be loaded again, when expanded the next time.
+		m_browser->DeleteChildren(collection->GetId());
+		m_browser->AppendItem(collection->GetId(), wxT("Dummy"));
+		m_browser->SetItemText(collection->GetId(), wxGetTranslation(collection->GetName()));
+	}
+
+	// Queued requests will be started from the timer, as we may be called
+	// while the tree is being cleaned up
+}
+
+
+void ctlTreeLoader::CancelBelow(const wxTreeItemId &item)
+{
+	size_t i = 0;
+
+	while (i < m_requests.GetCount())
+	{
+		treeLoadRequest *req = m_requests.Item(i);
+		wxTreeItemId parent = req->collection->GetId();
+
+		while (parent && parent != item)
+			parent = m_browser->GetItemParent(parent);
+
+		if (parent)
+			Cancel(req->collection, true);
+		else
+			i++;
+	}
+}
+
+
+void ctlTreeLoader::OnQueryComplete(pgQueryResultEvent &ev)
+{
+	treeLoadRequest *req = (treeLoadRequest *)ev.GetClientData();
+	size_t i;
+
+	// The request may have been cancelled, before this event arrived
+	for (i = 0 ; i < m_requests.GetCount() ; i++)
+	{
+		if (m_requests.Item(i) == req)
+			break;
+	}
+	if (i == m_requests.GetCount() || !req->thread ||
+	        req->thread->GetId() != ev.GetThreadID())
+		return;
+
+	pgBatchQuery *qry = ev.GetQuery();
+
+	if (qry->ReturnCode() != PGRES_TUPLES_OK || !req->thread->DataSet())
+	{
+		wxLogError(_("Could not load the %s:\n%s"), wxGetTranslation(req->collection->GetName()),
+		           qry->GetErrorMessage().c_str());
+		Finish(req, false);
+		return;
+	}
+
+	req->set = req->thread->DataSet();
+	AppendRows(req);
+}
+
+
+void ctlTreeLoader::OnAppendTimer(wxTimerEvent &ev)
+{
+	size_t i = 0;
+
+	StartQueued();
+
+	while (i < m_requests.GetCount())
+	{
+		treeLoadRequest *req = m_requests.Item(i);
+
+		// AppendRows() removes the request, when it is finished
+		if (req->set)
+			AppendRows(req);
+
+		if (i < m_requests.GetCount() && m_requests.Item(i) == req)
+			i++;
+	}
+
+	if (!m_requests.GetCount())
+		m_appendTimer.Stop();
+}
+
+
+void ctlTreeLoader::OnIdleTimer(wxTimerEvent &ev)
+{
+	wxDateTime now = wxDateTime::Now();
+	size_t i = 0;
+
+	while (i < m_idleConns.GetCount())
+	{
+		treeLoadConn *idle = m_idleConns.Item(i);
+
+		if ((now - idle->lastUsed).GetSeconds() >= TREELOAD_IDLE_TIMEOUT)
+		{
+			delete idle->conn;
+
+			m_idleConns.RemoveAt(i);
+			delete idle;
+		}
+		else
+			i++;
+	}
+
+	if (!m_idleConns.GetCount())
+		m_idleTimer.Stop();
+}
+
+
+void ctlTreeLoader::StartQueued()
+{
+	size_t i = 0;
+
+	while (i < m_requests.GetCount())
+	{
+		treeLoadRequest *req = m_requests.Item(i);
+		bool busy = (req->thread != NULL);
+		size_t j;
+
+		// Only one query per database at a time
+		for (j = 0 ; !busy && j < m_requests.GetCount() ; j++)
+		{
+			treeLoadRequest *other = m_requests.Item(j);
+			if (other->thread && other->key == req->key)
+				busy = true;
+		}
+
+		if (busy || Start(req))
+		{
+			i++;
+			continue;
+		}
+
+		// We could not get a connection for the background query, let's
+		// populate the collection the usual way then.
+		pgCollection *collection = req->collection;
+
+		if (HasPlaceholder(req))
+			m_browser->Delete(req->placeholder);
+		collection->SetLoader(NULL);
+		m_requests.RemoveAt(i);
+		delete req;
+
+		collection->GetFactory()->CreateObjects(collection, m_browser);
+		collection->UpdateChildCount(m_browser);
+	}
+}
+
+
+bool ctlTreeLoader::Start(treeLoadRequest *req)
+{
+	req->conn = GetConnection(req->key, req->collection);
+	if (!req->conn)
+		return false;
+
+	req->thread = new pgQueryThread(req->conn, this);
+	req->thread->SetEventOnCancellation(false);
+
+	if (req->thread->Create() != wxTHREAD_NO_ERROR)
+	{
+		delete req->thread;
+		req->thread = NULL;
+
+		ReleaseConnection(req->key, req->conn);
+		req->conn = NULL;
+
+		return false;
+	}
+
+	req->thread->AddQuery(req->query, NULL, TREELOAD_QUERY, req);
+	req->thread->Run();
+
+	return true;
+}
+
+
+void ctlTreeLoader::AppendRows(treeLoadRequest *req)
+{
+	if (!HasPlaceholder(req))
+	{
+		// The collection has been refreshed meanwhile
+		Cancel(req->collection, false);
+		return;
+	}
+
+	pgaFactory *factory = req->collection->GetFactory();
+	long pageSize = settings->GetBrowserPageSize();
+	long count = 0;
+
+	m_browser->Freeze();
+	while (!req->set->Eof() && count < TREELOAD_BATCH_SIZE &&
+	        (pageSize <= 0 || req->appended + count < pageSize))
+	{
+		pgObject *obj = factory->CreateObjectFromSet(req->collection, req->set);
+		if (obj)
+			m_browser->AppendObject(req->collection, obj);
+
+		req->set->MoveNext();
+		count++;
+	}
+	m_browser->Thaw();
+
+	req->appended += count;
+
+	if (!req->set->Eof() && pageSize > 0 && req->appended >= pageSize)
+	{
+		// Keep the remaining rows with the collection, the worker
+		// connection is given back
+		pgSet *rest = req->thread->DetachDataSet();
+		rest->SetConnection(req->collection->GetConnection());
+		req->set = NULL;
+
+		req->collection->SetPendingObjects(m_browser, rest);
+		Finish(req, true);
+	}
+	else if (req->set->Eof())
+		Finish(req, true);
+}
+
+
+void ctlTreeLoader::Finish(treeLoadRequest *req, bool success)
+{
+	pgCollection *collection = req->collection;
+
+	StopThread(req);
+	if (req->conn)
+	{
+		ReleaseConnection(req->key, req->conn);
+		req->conn = NULL;
+	}
+
+	if (HasPlaceholder(req))
+		m_browser->Delete(req->placeholder);
+
+	collection->SetLoader(NULL);
+	m_requests.Remove(req);
+	delete req;
+
+	if (success)
+	{
+		collection->UpdateChildCount(m_browser);
+
+		if (m_properties && m_browser->GetSelection() == collection->GetId())
+			collection->ShowList(m_browser, m_properties);
+	}
+	else
+		m_browser->SetItemText(collection->GetId(), wxGetTranslation(collection->GetName()));
+}
+
+
+void ctlTreeLoader::StopThread(treeLoadRequest *req)
+{
+	if (req->thread)
+	{
+		// The data-set belongs to the thread
+		req->set = NULL;
+
+		req->thread->CancelExecution();
+		req->thread->Wait();
+
+		delete req->thread;
+		req->thread = NULL;
+	}
+}
+
+
+bool ctlTreeLoader::HasPlaceholder(treeLoadRequest *req)
+{
+	wxCookieType cookie;
+	wxTreeItemId item = m_browser->GetFirstChild(req->collection->GetId(), cookie);
+
+	while (item)
+	{
+		if (item == req->placeholder)
+			return true;
+		item = m_browser->GetNextChild(req->collection->GetId(), cookie);
+	}
+	return false;
+}
+
+
+treeLoadRequest *ctlTreeLoader::FindRequest(pgCollection *collection)
+{
+	size_t i;
+
+	for (i = 0 ; i < m_requests.GetCount() ; i++)
+	{
+		if (m_requests.Item(i)->collection == collection)
+			return m_requests.Item(i);
+	}
+	return NULL;
+}
+
+
+pgConn *ctlTreeLoader::GetConnection(const wxString &key, pgCollection *collection)
+{
+	size_t i;
+
+	for (i = 0 ; i < m_idleConns.GetCount() ; i++)
+	{
+		treeLoadConn *idle = m_idleConns.Item(i);
+		if (idle->key == key)
+		{
+			pgConn *conn = idle->conn;
+
+			m_idleConns.RemoveAt(i);
+			delete idle;
+
+			if (conn->GetStatus() == PGCONN_OK)
+				return conn;
+
+			delete conn;
+			break;
+		}
+	}
+
+	pgConn *conn = collection->GetConnection()->Duplicate(wxT("pgAdmin - Browser"));
+	if (conn->GetStatus() != PGCONN_OK)
+	{
+		wxLogInfo(wxT("Could not open a connection for loading the browser in the background"));
+		delete conn;
+		return NULL;
+	}
+	return conn;
+}
+
+
+void ctlTreeLoader::ReleaseConnection(const wxString &key, pgConn *conn)
+{
+	if (conn->GetStatus() != PGCONN_OK)
+	{
+		delete conn;
+		return;
+	}
+
+	m_idleConns.Add(new treeLoadConn(key, conn));
+
+	if (!m_idleTimer.IsRunning())
+		m_idleTimer.Start(TREELOAD_IDLE_TIMEOUT * 1000 / 4);
+}
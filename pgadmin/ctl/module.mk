@@ -16,14 +16,20 @@ pgadmin3_SOURCES += \
         ctl/ctlColourPicker.cpp \
         ctl/ctlComboBox.cpp \
         ctl/ctlListView.cpp \
+        ctl/ctlLogList.cpp \
+        ctl/ctlPaneLoader.cpp \
+        ctl/ctlServerConnector.cpp \
         ctl/ctlMenuToolbar.cpp \
         ctl/ctlSQLBox.cpp \
         ctl/ctlSQLGrid.cpp \
         ctl/ctlSQLResult.cpp \
+        ctl/ctlStatusGraph.cpp \
+        ctl/ctlStatusList.cpp \
         ctl/ctlDefaultSecurityPanel.cpp \
         ctl/ctlSeclabelPanel.cpp \
         ctl/ctlSecurityPanel.cpp \
         ctl/ctlTree.cpp \
+        ctl/ctlTreeLoader.cpp \
 		ctl/ctlProgressStatusBar.cpp \
         ctl/explainCanvas.cpp \
         ctl/explainShape.cpp \
@@ -11,8 +11,11 @@
 
 pgadmin3_SOURCES += \
 	db/keywords.c \
+	db/pgBinaryDecoder.cpp \
 	db/pgConn.cpp \
+	db/pgConnPool.cpp \
 	db/pgSet.cpp \
+	db/pgQueryExecutor.cpp \
 	db/pgQueryThread.cpp
 
 EXTRA_DIST += \
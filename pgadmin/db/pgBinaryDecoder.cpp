@@ -0,0 +1,468 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgBinaryDecoder.cpp - Decodes the values of binary format results
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "db/pgBinaryDecoder.h"
+#include "utils/pgDefs.h"
+
+#include <float.h>
+#include <locale.h>
+
+// Julian day of 2000-01-01, the epoch of the date and time types
+#define POSTGRES_EPOCH_JDATE    2451545
+// Seconds from 1970-01-01 to 2000-01-01
+#define POSTGRES_EPOCH_UNIX     946684800
+
+#define USECS_PER_DAY           wxLL(86400000000)
+#define USECS_PER_HOUR          wxLL(3600000000)
+#define USECS_PER_MINUTE        wxLL(60000000)
+#define USECS_PER_SEC           wxLL(1000000)
+
+// 'infinity' and '-infinity'
+#define DATE_NOBEGIN            ((wxInt32)0x80000000)
+#define DATE_NOEND              ((wxInt32)0x7FFFFFFF)
+#define TIMESTAMP_NOBEGIN       ((wxInt64)wxULL(0x8000000000000000))
+#define TIMESTAMP_NOEND         ((wxInt64)wxLL(0x7FFFFFFFFFFFFFFF))
+
+
+// The values are sent in network byte order
+static wxUint32 ReadUInt32(const char *val)
+{
+	const unsigned char *p = (const unsigned char *)val;
+
+	return ((wxUint32)p[0] << 24) | ((wxUint32)p[1] << 16) | ((wxUint32)p[2] << 8) | (wxUint32)p[3];
+}
+
+
+static wxInt64 ReadInt64(const char *val)
+{
+	return (wxInt64)(((wxUint64)ReadUInt32(val) << 32) | (wxUint64)ReadUInt32(val + 4));
+}
+
+
+// Julian day to the Gregorian calendar, the same way as j2date() of the
+// server
+static void JulianToDate(int jd, int &year, int &month, int &day)
+{
+	unsigned int julian = jd;
+	unsigned int quad, extra;
+	int y;
+
+	julian += 32044;
+	quad = julian / 146097;
+	extra = (julian - quad * 146097) * 4 + 3;
+	julian += 60 + quad * 3 + extra / 146097;
+	quad = julian / 1461;
+	julian -= quad * 1461;
+	y = julian * 4 / 1461;
+	julian = ((y != 0) ? ((julian + 305) % 365) : ((julian + 306) % 366)) + 123;
+	y += quad * 4;
+	year = y - 4800;
+	quad = julian * 2141 / 65536;
+	day = julian - 7834 * quad / 256;
+	month = (quad + 10) % 12 + 1;
+}
+
+
+// Microseconds since 2000-01-01 to the date and the time of day
+static void SplitTimestamp(wxInt64 t, int &year, int &month, int &day,
+                           int &hour, int &min, int &sec, int &usec)
+{
+	wxInt64 days = t / USECS_PER_DAY;
+	wxInt64 time = t - days * USECS_PER_DAY;
+
+	if (time < 0)
+	{
+		time += USECS_PER_DAY;
+		days--;
+	}
+
+	JulianToDate((int)(days + POSTGRES_EPOCH_JDATE), year, month, day);
+
+	hour = (int)(time / USECS_PER_HOUR);
+	time -= hour * USECS_PER_HOUR;
+	min = (int)(time / USECS_PER_MINUTE);
+	time -= min * USECS_PER_MINUTE;
+	sec = (int)(time / USECS_PER_SEC);
+	usec = (int)(time - sec * USECS_PER_SEC);
+}
+
+
+// The shortest text, which reads back as the same value (like the server
+// does with extra_float_digits = 1)
+static void FormatDouble(double value, bool isFloat4, char *buf)
+{
+	if (value != value)
+	{
+		strcpy(buf, "NaN");
+		return;
+	}
+	if (value > DBL_MAX)
+	{
+		strcpy(buf, "Infinity");
+		return;
+	}
+	if (value < -DBL_MAX)
+	{
+		strcpy(buf, "-Infinity");
+		return;
+	}
+
+	for (int digits = isFloat4 ? FLT_DIG : DBL_DIG ; digits <= (isFloat4 ? 9 : 17) ; digits++)
+	{
+		sprintf(buf, "%.*g", digits, value);
+
+		double back = strtod(buf, NULL);
+		if (isFloat4 ? ((float)back == (float)value) : (back == value))
+			break;
+	}
+
+	// Whatever the locale of the application is
+	char *point = strchr(buf, localeconv()->decimal_point[0]);
+	if (point)
+		*point = '.';
+}
+
+
+static void FormatDate(int year, int month, int day, char *buf)
+{
+	sprintf(buf, "%04d-%02d-%02d", year > 0 ? year : 1 - year, month, day);
+}
+
+
+bool pgBinaryDecoder::CanDecode(OID typOid)
+{
+	switch (typOid)
+	{
+		case PGOID_TYPE_BOOL:
+		case PGOID_TYPE_BYTEA:
+		case PGOID_TYPE_INT8:
+		case PGOID_TYPE_INT2:
+		case PGOID_TYPE_INT4:
+		case PGOID_TYPE_OID:
+		case PGOID_TYPE_FLOAT4:
+		case PGOID_TYPE_FLOAT8:
+		case PGOID_TYPE_DATE:
+		case PGOID_TYPE_TIMESTAMP:
+		case PGOID_TYPE_TIMESTAMPTZ:
+		case PGOID_TYPE_UUID:
+			return true;
+		default:
+			return IsTextual(typOid);
+	}
+}
+
+
+bool pgBinaryDecoder::IsTextual(OID typOid)
+{
+	switch (typOid)
+	{
+		case PGOID_TYPE_CHAR:
+		case PGOID_TYPE_NAME:
+		case PGOID_TYPE_TEXT:
+		case PGOID_TYPE_BPCHAR:
+		case PGOID_TYPE_VARCHAR:
+			return true;
+		default:
+			return false;
+	}
+}
+
+
+bool pgBinaryDecoder::IsDateTime(OID typOid)
+{
+	return typOid == PGOID_TYPE_DATE || typOid == PGOID_TYPE_TIMESTAMP || typOid == PGOID_TYPE_TIMESTAMPTZ;
+}
+
+
+bool pgBinaryDecoder::IsUtcZone(const char *timeZone)
+{
+	static const char *names[] =
+	{
+		"UTC", "UCT", "GMT", "GMT0", "GMT+0", "GMT-0", "Greenwich", "Universal", "Zulu",
+		"Etc/UTC", "Etc/UCT", "Etc/GMT", "Etc/GMT0", "Etc/GMT+0", "Etc/GMT-0",
+		"Etc/Greenwich", "Etc/Universal", "Etc/Zulu"
+	};
+
+	if (!timeZone)
+		return false;
+
+	wxString zone = wxString::FromAscii(timeZone);
+	for (size_t i = 0 ; i < WXSIZEOF(names) ; i++)
+	{
+		if (!zone.CmpNoCase(wxString::FromAscii(names[i])))
+			return true;
+	}
+	return false;
+}
+
+
+wxLongLong pgBinaryDecoder::GetLongLong(OID typOid, const char *val, int len)
+{
+	switch (typOid)
+	{
+		case PGOID_TYPE_BOOL:
+			return (len >= 1 && val[0]) ? 1 : 0;
+		case PGOID_TYPE_INT2:
+			if (len >= 2)
+				return (wxInt16)((((unsigned char)val[0]) << 8) | (unsigned char)val[1]);
+			break;
+		case PGOID_TYPE_INT4:
+			if (len >= 4)
+				return (wxInt32)ReadUInt32(val);
+			break;
+		case PGOID_TYPE_OID:
+			if (len >= 4)
+				return wxLongLong((wxInt64)ReadUInt32(val));
+			break;
+		case PGOID_TYPE_INT8:
+			if (len >= 8)
+				return wxLongLong(ReadInt64(val));
+			break;
+		case PGOID_TYPE_FLOAT4:
+		case PGOID_TYPE_FLOAT8:
+			return wxLongLong((wxInt64)GetDouble(typOid, val, len));
+	}
+
+	return 0;
+}
+
+
+double pgBinaryDecoder::GetDouble(OID typOid, const char *val, int len)
+{
+	switch (typOid)
+	{
+		case PGOID_TYPE_FLOAT4:
+			if (len >= 4)
+			{
+				wxUint32 bits = ReadUInt32(val);
+				float f;
+
+				memcpy(&f, &bits, sizeof(f));
+				return f;
+			}
+			break;
+		case PGOID_TYPE_FLOAT8:
+			if (len >= 8)
+			{
+				wxInt64 bits = ReadInt64(val);
+				double d;
+
+				memcpy(&d, &bits, sizeof(d));
+				return d;
+			}
+			break;
+		default:
+			return GetLongLong(typOid, val, len).ToDouble();
+	}
+
+	return 0;
+}
+
+
+bool pgBinaryDecoder::GetBool(OID typOid, const char *val, int len)
+{
+	return GetLongLong(typOid, val, len) != 0;
+}
+
+
+wxDateTime pgBinaryDecoder::GetDateTime(OID typOid, const char *val, int len)
+{
+	int year, month, day, hour, min, sec, usec;
+
+	switch (typOid)
+	{
+		case PGOID_TYPE_DATE:
+		{
+			if (len < 4)
+				break;
+
+			wxInt32 days = (wxInt32)ReadUInt32(val);
+			if (days == DATE_NOBEGIN || days == DATE_NOEND)
+				break;
+
+			JulianToDate(days + POSTGRES_EPOCH_JDATE, year, month, day);
+			return wxDateTime(day, (wxDateTime::Month)(month - 1), year);
+		}
+		case PGOID_TYPE_TIMESTAMP:
+		{
+			if (len < 8)
+				break;
+
+			wxInt64 t = ReadInt64(val);
+			if (t == TIMESTAMP_NOBEGIN || t == TIMESTAMP_NOEND)
+				break;
+
+			// Local time, like the text parsed by pgSet
+			SplitTimestamp(t, year, month, day, hour, min, sec, usec);
+			return wxDateTime(day, (wxDateTime::Month)(month - 1), year, hour, min, sec, usec / 1000);
+		}
+		case PGOID_TYPE_TIMESTAMPTZ:
+		{
+			if (len < 8)
+				break;
+
+			wxInt64 t = ReadInt64(val);
+			if (t == TIMESTAMP_NOBEGIN || t == TIMESTAMP_NOEND)
+				break;
+
+			// The point in time, however the time zones are set up
+			return wxDateTime(wxLongLong(t / 1000 + (wxInt64)POSTGRES_EPOCH_UNIX * 1000));
+		}
+	}
+
+	return wxDateTime();
+}
+
+
+wxCharBuffer pgBinaryDecoder::ToText(OID typOid, const char *val, int len)
+{
+	char buf[64];
+	int year, month, day, hour, min, sec, usec;
+
+	switch (typOid)
+	{
+		case PGOID_TYPE_BOOL:
+			return wxCharBuffer((len >= 1 && val[0]) ? "t" : "f");
+
+		case PGOID_TYPE_INT2:
+		case PGOID_TYPE_INT4:
+		case PGOID_TYPE_INT8:
+		case PGOID_TYPE_OID:
+			return GetLongLong(typOid, val, len).ToString().ToAscii();
+
+		case PGOID_TYPE_FLOAT4:
+		case PGOID_TYPE_FLOAT8:
+			FormatDouble(GetDouble(typOid, val, len), typOid == PGOID_TYPE_FLOAT4, buf);
+			return wxCharBuffer(buf);
+
+		case PGOID_TYPE_DATE:
+		{
+			if (len < 4)
+				break;
+
+			wxInt32 days = (wxInt32)ReadUInt32(val);
+			if (days == DATE_NOBEGIN)
+				return wxCharBuffer("-infinity");
+			if (days == DATE_NOEND)
+				return wxCharBuffer("infinity");
+
+			JulianToDate(days + POSTGRES_EPOCH_JDATE, year, month, day);
+			FormatDate(year, month, day, buf);
+			if (year <= 0)
+				strcat(buf, " BC");
+
+			return wxCharBuffer(buf);
+		}
+
+		case PGOID_TYPE_TIMESTAMP:
+		case PGOID_TYPE_TIMESTAMPTZ:
+		{
+			if (len < 8)
+				break;
+
+			wxInt64 t = ReadInt64(val);
+			if (t == TIMESTAMP_NOBEGIN)
+				return wxCharBuffer("-infinity");
+			if (t == TIMESTAMP_NOEND)
+				return wxCharBuffer("infinity");
+
+			SplitTimestamp(t, year, month, day, hour, min, sec, usec);
+			FormatDate(year, month, day, buf);
+			sprintf(buf + strlen(buf), " %02d:%02d:%02d", hour, min, sec);
+
+			if (usec)
+			{
+				char *end = buf + strlen(buf);
+
+				sprintf(end, ".%06d", usec);
+				end += strlen(end);
+				while (end[-1] == '0')
+					*--end = 0;
+			}
+
+			if (typOid == PGOID_TYPE_TIMESTAMPTZ)
+				strcat(buf, "+00");
+			if (year <= 0)
+				strcat(buf, " BC");
+
+			return wxCharBuffer(buf);
+		}
+
+		case PGOID_TYPE_UUID:
+		{
+			if (len < 16)
+				break;
+
+			char *p = buf;
+			for (int i = 0 ; i < 16 ; i++)
+			{
+				if (i == 4 || i == 6 || i == 8 || i == 10)
+					*p++ = '-';
+				sprintf(p, "%02x", (unsigned char)val[i]);
+				p += 2;
+			}
+
+			return wxCharBuffer(buf);
+		}
+
+		case PGOID_TYPE_BYTEA:
+		{
+			const unsigned char *bytes = (const unsigned char *)val;
+			size_t textLen = 0;
+			int i;
+
+			for (i = 0 ; i < len ; i++)
+			{
+				if (bytes[i] == '\\')
+					textLen += 2;
+				else if (bytes[i] < 0x20 || bytes[i] > 0x7e)
+					textLen += 4;
+				else
+					textLen++;
+			}
+
+			wxCharBuffer text(textLen);
+			char *p = text.data();
+
+			for (i = 0 ; i < len ; i++)
+			{
+				if (bytes[i] == '\\')
+				{
+					*p++ = '\\';
+					*p++ = '\\';
+				}
+				else if (bytes[i] < 0x20 || bytes[i] > 0x7e)
+				{
+					sprintf(p, "\\%03o", bytes[i]);
+					p += 4;
+				}
+				else
+					*p++ = bytes[i];
+			}
+			*p = 0;
+
+			return text;
+		}
+	}
+
+	// The text types, and anything the value is too short for
+	wxCharBuffer text((size_t)(len > 0 ? len : 0));
+	if (len > 0)
+		memcpy(text.data(), val, len);
+
+	return text;
+}
@@ -39,9 +39,14 @@ typedef u_long in_addr_t;
 #include "utils/misc.h"
 #include "utils/sysLogger.h"
 #include "db/pgConn.h"
+#include "db/pgConnPool.h"
 #include "utils/misc.h"
 #include "db/pgSet.h"
 
+// Prepared statements kept per connection at most, any other queries are
+// run unprepared
+#define MAX_PREPARED_STATEMENTS 100
+
 double pgConn::libpqVersion = 8.0;
 
 static void pgNoticeProcessor(void *arg, const char *message)
@@ -52,7 +57,7 @@ static void pgNoticeProcessor(void *arg, const char *message)
 pgConn::pgConn(const wxString &server, const wxString &service, const wxString &hostaddr, const wxString &database, const wxString &username, const wxString &password,
                int port, const wxString &rolename, int sslmode, OID oid, const wxString &applicationname,
                const wxString &sslcert, const wxString &sslkey, const wxString &sslrootcert, const wxString &sslcrl,
-               const bool sslcompression) : m_cancelConn(NULL)
+               const bool sslcompression, const bool connectAsync) : m_cancelConn(NULL)
 {
 	wxString msg;
 
@@ -79,6 +84,8 @@ pgConn::pgConn(const wxString &server, const wxString &service, const wxString &
 	conv = &wxConvLibc;
 	needColQuoting = false;
 	utfConnectString = false;
+	connectLibc = false;
+	lastPreparedStatement = 0;
 
 	// Check the hostname/ipaddress
 	conn = 0;
@@ -220,7 +227,10 @@ pgConn::pgConn(const wxString &server, const wxString &service, const wxString &
 	cleanConnStr.Replace(qtConnString(password), wxT("'XXXXXX'"));
 	wxLogInfo(wxT("Opening connection with connection string: %s"), cleanConnStr.c_str());
 
-	DoConnect();
+	if (connectAsync)
+		StartConnect(false);
+	else
+		DoConnect();
 }
 
 
@@ -253,17 +263,63 @@ bool pgConn::DoConnect()
 }
 
 
+bool pgConn::StartConnect(bool useLibc)
+{
+	connectLibc = useLibc;
+	conn = PQconnectStart(connstr.mb_str(useLibc ? (wxMBConv &)wxConvLibc : (wxMBConv &)wxConvUTF8));
+
+	return conn && PQstatus(conn) != CONNECTION_BAD;
+}
+
+
+int pgConn::PollConnect()
+{
+	if (!conn)
+		return PGRES_POLLING_FAILED;
+
+	PostgresPollingStatusType rc = PQconnectPoll(conn);
+
+	if (rc == PGRES_POLLING_FAILED && !connectLibc)
+	{
+		// Like DoConnect(), try again with the connection string in the
+		// local encoding, if that's different
+		wxCharBuffer cstrUTF = connstr.mb_str(wxConvUTF8);
+		wxCharBuffer cstrLibc = connstr.mb_str(wxConvLibc);
+
+		if (strcmp(cstrUTF, cstrLibc))
+		{
+			PQfinish(conn);
+			if (!StartConnect(true))
+				return PGRES_POLLING_FAILED;
+
+			// The new connection waits for the socket to become writable
+			return PGRES_POLLING_WRITING;
+		}
+	}
+	else if (rc == PGRES_POLLING_OK)
+	{
+		utfConnectString = !connectLibc;
+
+		if (!Initialize())
+			return PGRES_POLLING_FAILED;
+	}
+
+	return rc;
+}
+
+
 bool pgConn::Initialize()
 {
+	ClearTypeCache();
+	ClearPreparedStatements();
+
 	// Set client encoding to Unicode/Ascii, Datestyle to ISO, and ask for notices.
 	if (PQstatus(conn) == CONNECTION_OK)
 	{
 		connStatus = PGCONN_OK;
 		PQsetNoticeProcessor(conn, pgNoticeProcessor, this);
 
-		wxString sql = wxT("SET DateStyle=ISO;\nSET client_min_messages=notice;\n");
-		if (BackendMinimumVersion(9, 0))
-			sql += wxT("SET bytea_output=escape;\n");
+		wxString sql = GetSessionSettings();
 
 		sql += wxT("SELECT oid, pg_encoding_to_char(encoding) AS encoding, datlastsysoid\n")
 		       wxT("  FROM pg_database WHERE ");
@@ -297,6 +353,8 @@ bool pgConn::Initialize()
 			else
 				conv = &wxConvLibc;
 
+			clientEncoding = encoding;
+
 			wxLogInfo(wxT("Setting client_encoding to '%s'"), encoding.c_str());
 			if (PQsetClientEncoding(conn, encoding.ToAscii()))
 			{
@@ -325,6 +383,76 @@ bool pgConn::Initialize()
 }
 
 
+wxString pgConn::GetSessionSettings()
+{
+	wxString sql = wxT("SET DateStyle=ISO;\nSET client_min_messages=notice;\n");
+	if (BackendMinimumVersion(9, 0))
+		sql += wxT("SET bytea_output=escape;\n");
+
+	return sql;
+}
+
+
+bool pgConn::ResetSession()
+{
+	if (GetStatus() != PGCONN_OK || GetTxStatus() != PQTRANS_IDLE ||
+	        !BackendMinimumVersion(8, 3))
+		return false;
+
+	// Whatever the previous user has set up for the connection
+	PQsetnonblocking(conn, 0);
+	RegisterNoticeProcessor(0, 0);
+
+	pgNotify *notify;
+	while ((notify = PQnotifies(conn)) != NULL)
+		PQfreemem(notify);
+
+	// DISCARD ALL refuses to run in a transaction block, which a string
+	// of several statements is
+	if (!ExecuteVoid(wxT("DISCARD ALL"), false))
+		return false;
+	ClearPreparedStatements();
+
+	wxString sql = GetSessionSettings();
+	if (dbRole != wxEmptyString)
+		sql += wxT("SET ROLE TO ") + qtIdent(dbRole) + wxT(";\n");
+
+	if (!ExecuteVoid(sql, false))
+		return false;
+
+	// RESET ALL has restored the client encoding of the connection string
+	if (!clientEncoding.IsEmpty() && PQsetClientEncoding(conn, clientEncoding.ToAscii()))
+		return false;
+
+	return true;
+}
+
+
+bool pgConn::Reuse(const wxString &applicationname)
+{
+	if (GetStatus() != PGCONN_OK)
+		return false;
+
+	save_applicationname = applicationname;
+
+	// Either statement tells, whether the server is still there
+	wxString sql;
+	if (BackendMinimumVersion(9, 0))
+		sql = wxT("SET application_name = ") + qtDbString(applicationname);
+	else
+		sql = wxT("SELECT 1");
+
+	return ExecuteVoid(sql, false);
+}
+
+
+wxString pgConn::GetPoolKey()
+{
+	return pgConnPool::GetKey(save_server, save_service, save_hostaddr, save_port,
+	                          save_database, save_username, save_rolename, save_sslmode);
+}
+
+
 void pgConn::Close()
 {
 	if (conn)
@@ -334,6 +462,7 @@ void pgConn::Close()
 	}
 	conn = 0;
 	connStatus = PGCONN_BAD;
+	ClearPreparedStatements();
 }
 
 
@@ -851,11 +980,198 @@ pgSet *pgConn::ExecuteSet(const wxString &sql, bool reportError)
 	return new pgSet();
 }
 
+
+bool pgConn::ExecuteSets(const wxString &sql, pgSetArray &sets, bool reportError)
+{
+	if (GetStatus() != PGCONN_OK)
+		return false;
+
+	wxLogSql(wxT("Set queries (%s:%d): %s"), this->GetHost().c_str(), this->GetPort(), sql.c_str());
+
+	SetConnCancel();
+	if (!PQsendQuery(conn, sql.mb_str(*conv)))
+	{
+		ResetConnCancel();
+		SetLastResultError(NULL);
+		LogError(!reportError);
+		return false;
+	}
+
+	PGresult *qryRes;
+	bool failed = false;
+
+	// All the results have to be consumed, even after an error
+	while ((qryRes = PQgetResult(conn)) != NULL)
+	{
+		lastResultStatus = PQresultStatus(qryRes);
+
+		if (!failed && (lastResultStatus == PGRES_TUPLES_OK || lastResultStatus == PGRES_COMMAND_OK))
+		{
+			sets.Add(new pgSet(qryRes, this, *conv, needColQuoting));
+			continue;
+		}
+
+		if (!failed)
+		{
+			failed = true;
+			SetLastResultError(qryRes);
+		}
+		PQclear(qryRes);
+	}
+	ResetConnCancel();
+
+	if (failed)
+	{
+		LogError(!reportError);
+		WX_CLEAR_ARRAY(sets);
+		return false;
+	}
+	return true;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // COPY functions
 //////////////////////////////////////////////////////////////////////////
 
-bool pgConn::StartCopy(const wxString query)
+// Prepares the query, unless done already, and executes it. Returns the
+// result of whichever has failed, or NULL if a parameter can't be
+// converted to the client encoding (libpq would send it as a NULL).
+PGresult *pgConn::ExecPrepared(const wxString &sql, const wxArrayString &params)
+{
+	int nParams = (int)params.GetCount();
+	wxCharBuffer *buffers = new wxCharBuffer[nParams];
+	const char **values = new const char *[nParams];
+
+	for (int i = 0 ; i < nParams ; i++)
+	{
+		buffers[i] = params.Item(i).mb_str(*conv);
+		values[i] = buffers[i];
+
+		if (!values[i])
+		{
+			delete[] values;
+			delete[] buffers;
+			return NULL;
+		}
+	}
+
+	PGresult *qryRes;
+	pgPreparedStatementMap::iterator it = preparedStatements.find(sql);
+
+	// Before 8.3 the server does not replan a prepared statement after the
+	// objects it uses have changed
+	if (!BackendMinimumVersion(8, 3) ||
+	        (it == preparedStatements.end() && preparedStatements.size() >= MAX_PREPARED_STATEMENTS))
+		qryRes = PQexecParams(conn, sql.mb_str(*conv), nParams, NULL, values, NULL, NULL, 0);
+	else
+	{
+		bool retried = false;
+
+		while (true)
+		{
+			wxString name;
+
+			it = preparedStatements.find(sql);
+			if (it != preparedStatements.end())
+				name = it->second;
+			else
+			{
+				name = wxString::Format(wxT("pgadmin_stmt_%ld"), ++lastPreparedStatement);
+
+				qryRes = PQprepare(conn, name.ToAscii(), sql.mb_str(*conv), nParams, NULL);
+				if (PQresultStatus(qryRes) != PGRES_COMMAND_OK)
+					break;
+				PQclear(qryRes);
+
+				preparedStatements[sql] = name;
+			}
+
+			qryRes = PQexecPrepared(conn, name.ToAscii(), nParams, values, NULL, NULL, 0);
+
+			// The statement may have been dropped behind our back (by a
+			// DEALLOCATE run by the user), then it is prepared once again
+			const char *sqlState = PQresultErrorField(qryRes, PG_DIAG_SQLSTATE);
+			if (retried || PQresultStatus(qryRes) != PGRES_FATAL_ERROR ||
+			        !sqlState || strcmp(sqlState, "26000"))
+				break;
+
+			wxLogInfo(wxT("Prepared statement %s has vanished, preparing it again"), name.c_str());
+			PQclear(qryRes);
+			preparedStatements.erase(sql);
+			retried = true;
+		}
+	}
+
+	delete[] values;
+	delete[] buffers;
+
+	return qryRes;
+}
+
+
+pgSet *pgConn::ExecuteSetPrepared(const wxString &sql, const wxArrayString &params, bool reportError)
+{
+	if (GetStatus() == PGCONN_OK)
+	{
+		PGresult *qryRes;
+		wxLogSql(wxT("Prepared set query (%s:%d): %s"), this->GetHost().c_str(), this->GetPort(), sql.c_str());
+		for (size_t i = 0 ; i < params.GetCount() ; i++)
+			wxLogSql(wxT("Parameter $%d: %s"), (int)i + 1, params.Item(i).c_str());
+
+		SetConnCancel();
+		qryRes = ExecPrepared(sql, params);
+		ResetConnCancel();
+
+		if (!qryRes)
+		{
+			lastResultStatus = PGRES_FATAL_ERROR;
+			SetLastResultError(NULL, _("A parameter value cannot be converted to the client encoding."));
+			LogError(!reportError);
+			return new pgSet();
+		}
+
+		lastResultStatus = PQresultStatus(qryRes);
+		SetLastResultError(qryRes);
+
+		if (lastResultStatus == PGRES_TUPLES_OK || lastResultStatus == PGRES_COMMAND_OK)
+			return new pgSet(qryRes, this, *conv, needColQuoting);
+
+		LogError(!reportError);
+		PQclear(qryRes);
+	}
+	return new pgSet();
+}
+
+
+bool pgConn::ExecuteVoidPrepared(const wxString &sql, const wxArrayString &params, bool reportError)
+{
+	if (GetStatus() != PGCONN_OK)
+		return false;
+
+	pgSet *set = ExecuteSetPrepared(sql, params, reportError);
+	delete set;
+
+	return lastResultStatus == PGRES_TUPLES_OK || lastResultStatus == PGRES_COMMAND_OK;
+}
+
+
+wxString pgConn::ExecuteScalarPrepared(const wxString &sql, const wxArrayString &params, bool reportError)
+{
+	wxString result;
+	pgSet *set = ExecuteSetPrepared(sql, params, reportError);
+
+	if (set->NumRows() > 0)
+	{
+		result = set->GetVal(0);
+		wxLogSql(wxT("Query result: %s"), result.c_str());
+	}
+	delete set;
+
+	return result;
+}
+
+
+bool pgConn::StartCopy(const wxString query, bool reportError)
 {
 	if (GetStatus() != PGCONN_OK)
 		return false;
@@ -871,7 +1187,7 @@ bool pgConn::StartCopy(const wxString query)
 	// Check for errors
 	if (lastResultStatus != PGRES_COPY_IN)
 	{
-		LogError(false);
+		LogError(!reportError);
 		PQclear(qryRes);
 		return false;
 	}
@@ -901,18 +1217,19 @@ bool pgConn::EndPutCopy(const wxString errormsg)
 	return result == 1;
 }
 
-bool pgConn::GetCopyFinalStatus(void)
+bool pgConn::GetCopyFinalStatus(bool reportError)
 {
 	PGresult   *qryRes;
 
 	// Get status
 	qryRes = PQgetResult(conn);
 	lastResultStatus = PQresultStatus(qryRes);
+	SetLastResultError(qryRes);
 
 	// Check for errors
 	if (lastResultStatus != PGRES_COMMAND_OK)
 	{
-		LogError(false);
+		LogError(!reportError);
 		PQclear(qryRes);
 		return false;
 	}
@@ -1325,3 +1642,109 @@ void pgError::SetError(PGresult *_res, wxMBConv *_conv)
 	}
 	formatted_msg = errMsg;
 }
+
+
+static wxString FullTypeKey(OID typOid, long typmod)
+{
+	return NumToStr(typOid) + wxT(":") + NumToStr(typmod);
+}
+
+
+bool pgConn::CacheTypes(const PGresult *res)
+{
+	if (!res)
+		return false;
+
+	wxArrayString keys;
+	wxString sql;
+
+	{
+		wxCriticalSectionLocker lock(typeCacheLock);
+
+		for (int col = 0; col < PQnfields(res); col++)
+		{
+			OID typOid = PQftype(res, col);
+			long typmod = PQfmod(res, col);
+			wxString key = FullTypeKey(typOid, typmod);
+
+			if (keys.Index(key) != wxNOT_FOUND ||
+			        (typeCache.find(typOid) != typeCache.end() &&
+			         fullTypeNameCache.find(key) != fullTypeNameCache.end()))
+				continue;
+
+			keys.Add(key);
+
+			if (!sql.IsEmpty())
+				sql += wxT("\nUNION ALL\n");
+
+			sql += wxT("SELECT oid, CASE WHEN typbasetype=0 THEN oid ELSE typbasetype END AS basetype, ")
+			       wxT("format_type(oid, NULL) AS typname, format_type(oid, ") + NumToStr(typmod) + wxT(") AS fulltypname, ")
+			       + NumToStr(typmod) + wxT(" AS typmod\n")
+			       wxT("  FROM pg_type WHERE oid=") + NumToStr(typOid);
+		}
+	}
+
+	// Everything is known already
+	if (sql.IsEmpty())
+		return true;
+
+	if (GetStatus() != PGCONN_OK)
+		return false;
+
+	pgSet *set = ExecuteSet(sql, false);
+	if (!set)
+		return false;
+
+	wxCriticalSectionLocker lock(typeCacheLock);
+
+	while (!set->Eof())
+	{
+		OID typOid = set->GetOid(wxT("oid"));
+		pgTypeInfo &info = typeCache[typOid];
+
+		info.baseType = set->GetOid(wxT("basetype"));
+		info.name = set->GetVal(wxT("typname"));
+		fullTypeNameCache[FullTypeKey(typOid, set->GetLong(wxT("typmod")))] = set->GetVal(wxT("fulltypname"));
+
+		set->MoveNext();
+	}
+	delete set;
+
+	return true;
+}
+
+
+bool pgConn::GetCachedType(OID typOid, long typmod, pgTypeInfo &info, wxString &fullName)
+{
+	wxCriticalSectionLocker lock(typeCacheLock);
+
+	pgTypeInfoMap::iterator it = typeCache.find(typOid);
+	if (it == typeCache.end())
+		return false;
+
+	pgFullTypeNameMap::iterator fit = fullTypeNameCache.find(FullTypeKey(typOid, typmod));
+	if (fit == fullTypeNameCache.end())
+		return false;
+
+	info = it->second;
+	fullName = fit->second;
+
+	return true;
+}
+
+
+// Types may have been changed (or dropped) in the meantime, so the cache
+// does not survive a reconnection
+void pgConn::ClearTypeCache()
+{
+	wxCriticalSectionLocker lock(typeCacheLock);
+
+	typeCache.clear();
+	fullTypeNameCache.clear();
+}
+
+
+void pgConn::ClearPreparedStatements()
+{
+	preparedStatements.clear();
+}
@@ -0,0 +1,211 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgConnPool.cpp - Keeps the connections of the closed windows for reuse
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "db/pgConn.h"
+#include "db/pgConnPool.h"
+#include "utils/sysLogger.h"
+
+// Idle connections kept at most, in total and per key
+#define CONNPOOL_MAX_IDLE           8
+#define CONNPOOL_MAX_IDLE_PER_KEY   2
+
+// Connections unused for this long are closed (in seconds)
+#define CONNPOOL_IDLE_TIMEOUT       300
+
+enum
+{
+	CONNPOOL_IDLE_TIMER = 1000
+};
+
+BEGIN_EVENT_TABLE(pgConnPool, wxEvtHandler)
+	EVT_TIMER(CONNPOOL_IDLE_TIMER, pgConnPool::OnIdleTimer)
+END_EVENT_TABLE()
+
+pgConnPool *pgConnPool::ms_pool = NULL;
+
+
+pgConnPool::pgConnPool()
+	: m_idleTimer(this, CONNPOOL_IDLE_TIMER)
+{
+}
+
+
+pgConnPool::~pgConnPool()
+{
+	m_idleTimer.Stop();
+	Clear();
+}
+
+
+pgConnPool *pgConnPool::Get()
+{
+	if (!ms_pool)
+		ms_pool = new pgConnPool();
+
+	return ms_pool;
+}
+
+
+void pgConnPool::Shutdown()
+{
+	if (ms_pool)
+	{
+		delete ms_pool;
+		ms_pool = NULL;
+	}
+}
+
+
+wxString pgConnPool::GetKey(const wxString &server, const wxString &service, const wxString &hostaddr,
+                            int port, const wxString &database, const wxString &username,
+                            const wxString &rolename, int sslmode)
+{
+	// The database comes last, so that the connections to a server can be
+	// found by the prefix
+	return server + wxT("\n") + hostaddr + wxT("\n") + service + wxT("\n") +
+	       NumToStr((long)port) + wxT("\n") + NumToStr((long)sslmode) + wxT("\n") +
+	       username + wxT("\n") + rolename + wxT("\n") + database;
+}
+
+
+pgConn *pgConnPool::Acquire(const wxString &key, const wxString &applicationname)
+{
+	size_t i = m_idleConns.GetCount();
+
+	// Most recently used first, that one is the least likely to be dropped
+	while (i-- > 0)
+	{
+		pgPooledConn *idle = m_idleConns.Item(i);
+
+		if (idle->key != key)
+			continue;
+
+		pgConn *conn = idle->conn;
+
+		m_idleConns.RemoveAt(i);
+		delete idle;
+
+		if (conn->Reuse(applicationname))
+		{
+			wxLogInfo(wxT("Reusing the pooled connection to %s:%d/%s"),
+			          conn->GetHost().c_str(), conn->GetPort(), conn->GetDbname().c_str());
+			return conn;
+		}
+
+		wxLogInfo(wxT("Dropping the pooled connection to %s:%d/%s, which is not alive anymore"),
+		          conn->GetHost().c_str(), conn->GetPort(), conn->GetDbname().c_str());
+		delete conn;
+	}
+
+	return NULL;
+}
+
+
+void pgConnPool::Release(pgConn *conn)
+{
+	if (!conn)
+		return;
+
+	if (!conn->ResetSession())
+	{
+		delete conn;
+		return;
+	}
+
+	wxString key = conn->GetPoolKey();
+	size_t i, sameKey = 0;
+
+	for (i = 0 ; i < m_idleConns.GetCount() ; i++)
+	{
+		if (m_idleConns.Item(i)->key == key)
+			sameKey++;
+	}
+
+	// Make room by closing the least recently used ones
+	i = 0;
+	while (i < m_idleConns.GetCount() &&
+	        (m_idleConns.GetCount() >= CONNPOOL_MAX_IDLE || sameKey >= CONNPOOL_MAX_IDLE_PER_KEY))
+	{
+		pgPooledConn *idle = m_idleConns.Item(i);
+
+		if (m_idleConns.GetCount() < CONNPOOL_MAX_IDLE && idle->key != key)
+		{
+			i++;
+			continue;
+		}
+
+		if (idle->key == key)
+			sameKey--;
+
+		delete idle->conn;
+		m_idleConns.RemoveAt(i);
+		delete idle;
+	}
+
+	m_idleConns.Add(new pgPooledConn(key, conn));
+
+	if (!m_idleTimer.IsRunning())
+		m_idleTimer.Start(CONNPOOL_IDLE_TIMEOUT * 1000 / 4);
+}
+
+
+void pgConnPool::Clear(const wxString &prefix)
+{
+	size_t i = 0;
+
+	while (i < m_idleConns.GetCount())
+	{
+		pgPooledConn *idle = m_idleConns.Item(i);
+
+		if (!idle->key.StartsWith(prefix))
+		{
+			i++;
+			continue;
+		}
+
+		delete idle->conn;
+		m_idleConns.RemoveAt(i);
+		delete idle;
+	}
+
+	if (!m_idleConns.GetCount())
+		m_idleTimer.Stop();
+}
+
+
+void pgConnPool::OnIdleTimer(wxTimerEvent &ev)
+{
+	wxDateTime now = wxDateTime::Now();
+	size_t i = 0;
+
+	while (i < m_idleConns.GetCount())
+	{
+		pgPooledConn *idle = m_idleConns.Item(i);
+
+		if ((now - idle->lastUsed).GetSeconds() >= CONNPOOL_IDLE_TIMEOUT)
+		{
+			delete idle->conn;
+			m_idleConns.RemoveAt(i);
+			delete idle;
+		}
+		else
+			i++;
+	}
+
+	if (!m_idleConns.GetCount())
+		m_idleTimer.Stop();
+}
@@ -0,0 +1,377 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgQueryExecutor.cpp - Shared pool of worker threads running the queries
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "db/pgQueryExecutor.h"
+#include "utils/sysLogger.h"
+
+// Workers kept for the whole lifetime of the executor
+#define EXECUTOR_CORE_WORKERS   4
+
+// Additional workers end after being idle for this long (ms)
+#define EXECUTOR_IDLE_TIMEOUT   30000
+
+pgQueryExecutor *pgQueryExecutor::ms_executor = NULL;
+wxMutex pgQueryExecutor::ms_executorLock;
+
+static wxMutex s_jobIdLock;
+static unsigned long s_lastJobId = 0;
+
+
+class pgQueryWorker : public wxThread
+{
+public:
+	pgQueryWorker(pgQueryExecutor *_executor, bool _core)
+		: wxThread(wxTHREAD_JOINABLE), m_executor(_executor), m_core(_core) {}
+
+	virtual void *Entry();
+
+	bool IsCore() const
+	{
+		return m_core;
+	}
+
+private:
+	pgQueryExecutor *m_executor;
+	bool             m_core;
+};
+
+
+void *pgQueryWorker::Entry()
+{
+	pgQueryJob *job;
+
+	while ((job = m_executor->NextJob(this)) != NULL)
+	{
+		void *rc = job->Entry();
+		m_executor->JobDone(job, rc);
+	}
+
+	return NULL;
+}
+
+
+pgQueryJob::pgQueryJob()
+	: m_state(JOB_NEW), m_exitCode(NULL)
+{
+	wxMutexLocker lock(s_jobIdLock);
+
+	m_jobId = ++s_lastJobId;
+	if (!m_jobId)
+		m_jobId = ++s_lastJobId;
+}
+
+
+pgQueryJob::~pgQueryJob()
+{
+	// The job must have been waited for, before destroying it
+	wxASSERT(m_state == JOB_NEW || m_state == JOB_DONE);
+}
+
+
+wxThreadError pgQueryJob::Run()
+{
+	if (m_state != JOB_NEW)
+		return wxTHREAD_RUNNING;
+
+	return pgQueryExecutor::Get()->Submit(this) ? wxTHREAD_NO_ERROR : wxTHREAD_NO_RESOURCE;
+}
+
+
+void *pgQueryJob::Wait()
+{
+	if (m_state == JOB_NEW)
+		return m_exitCode;
+
+	return pgQueryExecutor::Get()->Wait(this);
+}
+
+
+bool pgQueryJob::IsRunning()
+{
+	if (m_state == JOB_NEW)
+		return false;
+
+	return pgQueryExecutor::Get()->IsRunning(this);
+}
+
+
+pgQueryExecutor::pgQueryExecutor()
+	: m_jobQueued(m_lock), m_jobDone(m_lock), m_idleWorkers(0), m_shuttingDown(false)
+{
+}
+
+
+pgQueryExecutor::~pgQueryExecutor()
+{
+	wxASSERT(m_workers.IsEmpty() && m_retired.IsEmpty());
+}
+
+
+pgQueryExecutor *pgQueryExecutor::Get()
+{
+	wxMutexLocker lock(ms_executorLock);
+
+	if (!ms_executor)
+	{
+		ms_executor = new pgQueryExecutor();
+
+		wxMutexLocker execLock(ms_executor->m_lock);
+		for (int i = 0 ; i < EXECUTOR_CORE_WORKERS ; i++)
+			ms_executor->StartWorker(true);
+	}
+
+	return ms_executor;
+}
+
+
+void pgQueryExecutor::Shutdown()
+{
+	pgQueryExecutor *executor;
+
+	{
+		wxMutexLocker lock(ms_executorLock);
+
+		executor = ms_executor;
+		ms_executor = NULL;
+	}
+
+	if (!executor)
+		return;
+
+	pgQueryWorkerArray workers;
+
+	{
+		wxMutexLocker lock(executor->m_lock);
+
+		executor->m_shuttingDown = true;
+
+		// Nobody is going to wait for the jobs not started yet
+		while (executor->m_queue.GetCount())
+		{
+			pgQueryJob *job = executor->m_queue.Item(0);
+
+			wxLogInfo(wxT("Dropping the query job (%ld) not started before exiting"), job->GetId());
+			job->m_state = pgQueryJob::JOB_DONE;
+			executor->m_queue.RemoveAt(0);
+		}
+
+		WX_APPEND_ARRAY(workers, executor->m_workers);
+		WX_APPEND_ARRAY(workers, executor->m_retired);
+		executor->m_workers.Clear();
+		executor->m_retired.Clear();
+
+		executor->m_jobQueued.Broadcast();
+		executor->m_jobDone.Broadcast();
+	}
+
+	// The workers finish the jobs they are running
+	for (size_t i = 0 ; i < workers.GetCount() ; i++)
+	{
+		workers.Item(i)->Wait();
+		delete workers.Item(i);
+	}
+
+	delete executor;
+}
+
+
+bool pgQueryExecutor::Submit(pgQueryJob *_job)
+{
+	wxMutexLocker lock(m_lock);
+
+	if (m_shuttingDown)
+		return false;
+
+	ReapRetired();
+
+	_job->m_state = pgQueryJob::JOB_QUEUED;
+	m_queue.Add(_job);
+
+	// Every job, which can be run now, needs a worker of its own
+	if ((size_t)CountRunnable() > m_idleWorkers)
+	{
+		if (!StartWorker(false) && m_workers.IsEmpty())
+		{
+			m_queue.Remove(_job);
+			_job->m_state = pgQueryJob::JOB_NEW;
+			return false;
+		}
+	}
+
+	m_jobQueued.Signal();
+
+	return true;
+}
+
+
+void *pgQueryExecutor::Wait(pgQueryJob *_job)
+{
+	wxMutexLocker lock(m_lock);
+
+	while (_job->m_state != pgQueryJob::JOB_DONE)
+		m_jobDone.Wait();
+
+	return _job->m_exitCode;
+}
+
+
+bool pgQueryExecutor::IsRunning(pgQueryJob *_job)
+{
+	wxMutexLocker lock(m_lock);
+
+	return _job->m_state == pgQueryJob::JOB_QUEUED || _job->m_state == pgQueryJob::JOB_RUNNING;
+}
+
+
+pgQueryJob *pgQueryExecutor::NextJob(pgQueryWorker *_worker)
+{
+	wxMutexLocker lock(m_lock);
+	wxLongLong idleSince = wxGetLocalTimeMillis();
+
+	while (!m_shuttingDown)
+	{
+		int idx = FindRunnable();
+
+		if (idx >= 0)
+		{
+			pgQueryJob *job = m_queue.Item(idx);
+			void *key = job->GetSerialKey();
+
+			m_queue.RemoveAt(idx);
+			if (key)
+				m_busyKeys.Add(key);
+			job->m_state = pgQueryJob::JOB_RUNNING;
+
+			return job;
+		}
+
+		if (!_worker->IsCore() &&
+		        wxGetLocalTimeMillis() - idleSince >= EXECUTOR_IDLE_TIMEOUT)
+		{
+			// Joined by the next Submit() (or the shutdown)
+			m_workers.Remove(_worker);
+			m_retired.Add(_worker);
+			break;
+		}
+
+		m_idleWorkers++;
+		m_jobQueued.WaitTimeout(_worker->IsCore() ? EXECUTOR_IDLE_TIMEOUT : EXECUTOR_IDLE_TIMEOUT / 4);
+		m_idleWorkers--;
+	}
+
+	return NULL;
+}
+
+
+void pgQueryExecutor::JobDone(pgQueryJob *_job, void *_exitCode)
+{
+	wxMutexLocker lock(m_lock);
+	void *key = _job->GetSerialKey();
+
+	if (key)
+		m_busyKeys.Remove(key);
+
+	_job->m_exitCode = _exitCode;
+	_job->m_state = pgQueryJob::JOB_DONE;
+
+	m_jobDone.Broadcast();
+
+	// A job queued behind this one may be run by another idle worker
+	// (this worker will look for one itself anyway)
+	if (key && FindRunnable() >= 0)
+		m_jobQueued.Signal();
+}
+
+
+int pgQueryExecutor::FindRunnable()
+{
+	for (size_t i = 0 ; i < m_queue.GetCount() ; i++)
+	{
+		void *key = m_queue.Item(i)->GetSerialKey();
+		bool busy = false;
+
+		if (key)
+		{
+			busy = (m_busyKeys.Index(key) != wxNOT_FOUND);
+
+			// Keep the order of the jobs with the same key
+			for (size_t j = 0 ; !busy && j < i ; j++)
+			{
+				if (m_queue.Item(j)->GetSerialKey() == key)
+					busy = true;
+			}
+		}
+
+		if (!busy)
+			return (int)i;
+	}
+
+	return -1;
+}
+
+
+int pgQueryExecutor::CountRunnable()
+{
+	wxArrayPtrVoid keys;
+	int count = 0;
+
+	for (size_t i = 0 ; i < m_queue.GetCount() ; i++)
+	{
+		void *key = m_queue.Item(i)->GetSerialKey();
+
+		if (key)
+		{
+			if (m_busyKeys.Index(key) != wxNOT_FOUND || keys.Index(key) != wxNOT_FOUND)
+				continue;
+			keys.Add(key);
+		}
+		count++;
+	}
+
+	return count;
+}
+
+
+bool pgQueryExecutor::StartWorker(bool _core)
+{
+	pgQueryWorker *worker = new pgQueryWorker(this, _core);
+
+	if (worker->Create() != wxTHREAD_NO_ERROR || worker->Run() != wxTHREAD_NO_ERROR)
+	{
+		wxLogError(wxT("Could not start a worker thread for running the queries"));
+		delete worker;
+		return false;
+	}
+
+	m_workers.Add(worker);
+
+	return true;
+}
+
+
+void pgQueryExecutor::ReapRetired()
+{
+	// These have left NextJob() already, and are just about to end
+	while (m_retired.GetCount())
+	{
+		pgQueryWorker *worker = m_retired.Item(0);
+
+		m_retired.RemoveAt(0);
+		worker->Wait();
+		delete worker;
+	}
+}
@@ -13,19 +13,46 @@
 
 // wxWindows headers
 #include <wx/wx.h>
+#include <wx/file.h>
 
 // PostgreSQL headers
 #include <libpq-fe.h>
 
+#ifdef __WXMSW__
+#include <winsock.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 // App headers
 #include "db/pgSet.h"
 #include "db/pgConn.h"
 #include "db/pgQueryThread.h"
+#include "db/pgBinaryDecoder.h"
 #include "db/pgQueryResultEvent.h"
 #include "utils/pgDefs.h"
 #include "utils/sysLogger.h"
 
 const wxEventType PGQueryResultEvent = wxNewEventType();
+const wxEventType PGQueryRowsEvent = wxNewEventType();
+
+// Minimum interval (ms) between the PGQueryRowsEvent in the streaming mode
+#define STREAM_NOTIFY_INTERVAL 200
+
+// The COPY data is written to the file in chunks of this size (bytes)
+#define COPY_OUT_BUFFER_SIZE (1024 * 1024)
+
+// Upper bound (ms) for a single wait on the server socket. The wait normally
+// ends as soon as the server sends data, or the query is cancelled. (Windows
+// can not wait on the wakeup pipe, hence the shorter interval there.)
+#ifdef __WXMSW__
+#define SOCKET_WAIT_INTERVAL 50
+#else
+#define SOCKET_WAIT_INTERVAL 1000
+#endif
 
 // default notice processor for the pgQueryThread
 // we do assume that the argument passed will be always the
@@ -45,11 +72,18 @@ void pgNoticeProcessor(void *_arg, const char *_message)
 // support for multiple queries support
 pgQueryThread::pgQueryThread(pgConn *_conn, wxEvtHandler *_caller,
                              PQnoticeProcessor _processor, void *_noticeHandler) :
-	wxThread(wxTHREAD_JOINABLE), m_currIndex(-1), m_conn(_conn),
-	m_cancelled(false), m_multiQueries(true), m_useCallable(false),
-	m_caller(_caller), m_processor(pgNoticeProcessor), m_noticeHandler(NULL),
-	m_eventOnCancellation(true)
+	pgQueryJob(), m_currIndex(-1), m_conn(_conn),
+	m_cancelled(false), m_eventOnCancellation(true), m_multiQueries(true), m_useCallable(false), m_pipelining(false),
+	m_binaryResults(false), m_caller(_caller), m_processor(pgNoticeProcessor), m_noticeHandler(NULL),
+	m_finished(false), m_streaming(false), m_rowsHandler(NULL),
+	m_streamBatchRows(0), m_streamMemoryLimit(0), m_streamMemoryPolicy(STREAM_MEMORY_STOP),
+	m_streamBatch(NULL), m_streamBatchResultNo(0), m_streamPending(false),
+	m_streamLastNotify(0), m_copyOutFile(NULL), m_copyOutConv(NULL), m_copyOutCrLf(false),
+	m_copyOutBufferRows(0), m_copyOutRows(0), m_copyOutBytes(0), m_copyOutSkipped(0),
+	m_copyOutFailed(false)
 {
+	InitWakeup();
+
 	// check if we can really use the enterprisedb callable statement and
 	// required
 #ifdef __WXMSW__
@@ -95,11 +129,18 @@ pgQueryThread::pgQueryThread(pgConn *_conn, wxEvtHandler *_caller,
 
 pgQueryThread::pgQueryThread(pgConn *_conn, const wxString &_qry,
                              int _resultToRetrieve, wxWindow *_caller, long _eventId, void *_data)
-	: wxThread(wxTHREAD_JOINABLE), m_currIndex(-1), m_conn(_conn),
-	  m_cancelled(false), m_multiQueries(false), m_useCallable(false),
-	  m_caller(NULL), m_processor(pgNoticeProcessor), m_noticeHandler(NULL),
-	  m_eventOnCancellation(true)
+	: pgQueryJob(), m_currIndex(-1), m_conn(_conn),
+	  m_cancelled(false), m_eventOnCancellation(true), m_multiQueries(false), m_useCallable(false), m_pipelining(false),
+	  m_binaryResults(false), m_caller(NULL), m_processor(pgNoticeProcessor), m_noticeHandler(NULL),
+	  m_finished(false), m_streaming(false), m_rowsHandler(NULL),
+	  m_streamBatchRows(0), m_streamMemoryLimit(0), m_streamMemoryPolicy(STREAM_MEMORY_STOP),
+	  m_streamBatch(NULL), m_streamBatchResultNo(0), m_streamPending(false),
+	  m_streamLastNotify(0), m_copyOutFile(NULL), m_copyOutConv(NULL), m_copyOutCrLf(false),
+	  m_copyOutBufferRows(0), m_copyOutRows(0), m_copyOutBytes(0), m_copyOutSkipped(0),
+	  m_copyOutFailed(false)
 {
+	InitWakeup();
+
 	if (m_conn && m_conn->conn)
 	{
 		PQsetnonblocking(m_conn->conn, 1);
@@ -122,6 +163,31 @@ void pgQueryThread::SetEventOnCancellation(bool eventOnCancelled)
 	m_eventOnCancellation = eventOnCancelled;
 }
 
+void pgQueryThread::SetStreaming(wxEvtHandler *_rowsHandler, long _batchRows,
+                                 long _memoryLimitKb, int _memoryPolicy)
+{
+	m_streaming = true;
+	m_rowsHandler = _rowsHandler;
+	m_streamBatchRows = _batchRows > 0 ? _batchRows : 1000L;
+	m_streamMemoryLimit = _memoryLimitKb > 0 ? (size_t)_memoryLimitKb * 1024 : 0;
+	m_streamMemoryPolicy = _memoryPolicy;
+}
+
+void pgQueryThread::SetCopyOutFile(wxFile *_file, wxMBConv *_fileConv, bool _crlf)
+{
+	m_copyOutFile = _file;
+	m_copyOutConv = _fileConv;
+	m_copyOutCrLf = _crlf;
+}
+
+void pgQueryThread::GetCopyOutProgress(long &_rows, wxLongLong &_bytes)
+{
+	wxCriticalSectionLocker lock(m_criticalSection);
+
+	_rows = m_copyOutRows;
+	_bytes = m_copyOutBytes;
+}
+
 void pgQueryThread::AddQuery(const wxString &_qry, pgParamsArray *_params,
                              long _eventId, void *_data, bool _useCallable, int _resultToRetrieve)
 {
@@ -131,6 +197,118 @@ void pgQueryThread::AddQuery(const wxString &_qry, pgParamsArray *_params,
 	                     m_useCallable && _useCallable, _resultToRetrieve));
 
 	wxLogInfo(wxT("queueing (%ld): %s"), GetId(), _qry.c_str());
+
+	m_queryQueued.Post();
+}
+
+
+void pgQueryThread::InitWakeup()
+{
+#ifndef __WXMSW__
+	if (pipe(m_wakeupPipe) == 0)
+	{
+		fcntl(m_wakeupPipe[0], F_SETFL, O_NONBLOCK);
+		fcntl(m_wakeupPipe[1], F_SETFL, O_NONBLOCK);
+	}
+	else
+	{
+		wxLogError(wxT("Could not create the wakeup pipe for the query thread"));
+		m_wakeupPipe[0] = m_wakeupPipe[1] = -1;
+	}
+#endif
+}
+
+
+void pgQueryThread::CancelExecution()
+{
+	m_cancelled = true;
+
+#ifndef __WXMSW__
+	if (m_wakeupPipe[1] >= 0)
+	{
+		char c = 0;
+		// Nothing to do if the pipe is full - the thread is awake anyway
+		if (write(m_wakeupPipe[1], &c, 1) < 0)
+			wxLogInfo(wxT("query thread (%ld) is already being woken up"), GetId());
+	}
+#endif
+
+	// The thread may be waiting for the next query
+	m_queryQueued.Post();
+}
+
+
+bool pgQueryThread::WaitForCompletion(unsigned long _timeoutMs)
+{
+	if (!m_finished)
+		m_finishedSignal.WaitTimeout(_timeoutMs);
+
+	return m_finished;
+}
+
+
+void pgQueryThread::WaitForSocket()
+{
+	int sock = PQsocket(m_conn->conn);
+
+	if (sock < 0)
+		return;
+
+	// The nonblocking connection may still hold the part of the query, which
+	// could not be sent yet - in that case, wait for the socket to become
+	// writable too.
+	int flushRc = PQflush(m_conn->conn);
+
+	if (flushRc < 0)
+		return;
+
+#ifdef __WXMSW__
+	fd_set readFds, writeFds;
+	struct timeval timeout;
+
+	FD_ZERO(&readFds);
+	FD_ZERO(&writeFds);
+	FD_SET(sock, &readFds);
+	if (flushRc == 1)
+		FD_SET(sock, &writeFds);
+
+	timeout.tv_sec = 0;
+	timeout.tv_usec = SOCKET_WAIT_INTERVAL * 1000;
+
+	select(sock + 1, &readFds, &writeFds, NULL, &timeout);
+#else
+	struct pollfd fds[2];
+	int nfds = 1;
+
+	fds[0].fd = sock;
+	fds[0].events = POLLIN | (flushRc == 1 ? POLLOUT : 0);
+	fds[0].revents = 0;
+
+	if (m_wakeupPipe[0] >= 0)
+	{
+		fds[1].fd = m_wakeupPipe[0];
+		fds[1].events = POLLIN;
+		fds[1].revents = 0;
+		nfds++;
+	}
+
+	int rc = poll(fds, nfds, SOCKET_WAIT_INTERVAL);
+
+	if (rc < 0 && errno != EINTR)
+	{
+		wxLogInfo(wxT("query thread (%ld) could not wait on the server socket (%d)"),
+		          GetId(), errno);
+		// Do not spin on a persistent error
+		wxMilliSleep(10);
+	}
+	else if (rc > 0 && nfds > 1 && (fds[1].revents & POLLIN))
+	{
+		char buf[16];
+
+		while (read(m_wakeupPipe[0], buf, sizeof(buf)) > 0)
+			;
+	}
+#endif
 }
 
 
@@ -138,6 +316,16 @@ pgQueryThread::~pgQueryThread()
 {
 	m_conn->RegisterNoticeProcessor(0, 0);
 	WX_CLEAR_ARRAY(m_queries);
+
+	if (m_streamBatch)
+		PQclear(m_streamBatch);
+
+#ifndef __WXMSW__
+	if (m_wakeupPipe[0] >= 0)
+		close(m_wakeupPipe[0]);
+	if (m_wakeupPipe[1] >= 0)
+		close(m_wakeupPipe[1]);
+#endif
 }
 
 
@@ -322,9 +510,16 @@ return_with_error:
 	}
 	else
 	{
+		int resultFormat = -1;
+
+		if (m_binaryResults && !useCallable)
+			resultFormat = PrepareBinaryResults(query, queryBuf);
+
 		// use the PQsendQuery api in case, we don't have any parameters to
-		// pass to the server
-		if (!PQsendQuery(m_conn->conn, queryBuf))
+		// pass to the server (or the query has been prepared already)
+		if (resultFormat >= 0 ?
+		        !PQsendQueryPrepared(m_conn->conn, "", 0, NULL, NULL, NULL, resultFormat) :
+		        !PQsendQuery(m_conn->conn, queryBuf))
 		{
 			rc = pgQueryResultEvent::PGQ_ERROR_SEND_QUERY;
 
@@ -336,7 +531,12 @@ return_with_error:
 	}
 
 continue_without_error:
+	// The single row mode must be selected right after sending the query.
+	// The callable statements return their results in a different way.
+	bool streaming = m_streaming && !useCallable && PQsetSingleRowMode(m_conn->conn);
+
 	int resultsRetrieved = 0;
+	int resultNo = 0;
 	PGresult *lastResult = 0;
 	bool connExecutionCancelled = false;
 
@@ -416,8 +616,11 @@ continue_without_error:
 
 		if (PQisBusy(m_conn->conn))
 		{
-			Yield();
-			this->Sleep(10);
+			// Hand over the rows received so far, while waiting for more
+			if (streaming)
+				FlushStreamBatch(false);
+
+			WaitForSocket();
 
 			continue;
 		}
@@ -430,6 +633,17 @@ continue_without_error:
 		if (!res)
 			break;
 
+		// In the single row mode, every row comes as a separate result,
+		// followed by an empty PGRES_TUPLES_OK result at the end of the set
+		if (PQresultStatus(res) == PGRES_SINGLE_TUPLE)
+		{
+			StreamRow(res, resultsRetrieved + 1);
+			continue;
+		}
+
+		if (streaming && PQresultStatus(res) == PGRES_TUPLES_OK)
+			FlushStreamBatch(true);
+
 		if((PQresultStatus(res) == PGRES_NONFATAL_ERROR) ||
 		        (PQresultStatus(res) == PGRES_FATAL_ERROR) ||
 		        (PQresultStatus(res) == PGRES_BAD_RESPONSE))
@@ -473,10 +687,7 @@ continue_without_error:
 				res = NULL;
 
 				if (PQisBusy(m_conn->conn))
-				{
-					Yield();
-					this->Sleep(10);
-				}
+					WaitForSocket();
 			}
 			while (true);
 
@@ -503,11 +714,11 @@ continue_without_error:
 			int copyRc;
 			char *buf;
 			int copyRows = 0;
-			int lastCopyRc = 0;
 
 			rc = PGRES_COPY_OUT;
 
-			AppendMessage(_("query returned copy data:\n"));
+			if (!m_copyOutFile)
+				AppendMessage(_("query returned copy data:\n"));
 
 			while((copyRc = PQgetCopyData(m_conn->conn, &buf, 1)) >= 0)
 			{
@@ -520,10 +731,30 @@ continue_without_error:
 						m_conn->CancelExecution();
 						connExecutionCancelled = true;
 					}
+					if (buf != NULL)
+						PQfreemem(buf);
+
+					// Wait for the server to acknowledge the cancellation
+					if (copyRc == 0)
+					{
+						WaitForSocket();
+						if (!PQconsumeInput(m_conn->conn))
+							break;
+					}
 					continue;
 				}
 
-				if (buf != NULL)
+				if (buf != NULL && m_copyOutFile)
+				{
+					if (!CopyOutRow(buf, copyRc, conv) && !connExecutionCancelled)
+					{
+						// No point in sending the rest of the data
+						m_conn->CancelExecution();
+						connExecutionCancelled = true;
+					}
+					PQfreemem(buf);
+				}
+				else if (buf != NULL)
 				{
 					if (copyRows < 100)
 					{
@@ -540,13 +771,10 @@ continue_without_error:
 				if (copyRc > 0)
 					copyRows++;
 
-				if (lastCopyRc == 0 && copyRc == 0)
-				{
-					Yield();
-					this->Sleep(10);
-				}
 				if (copyRc == 0)
 				{
+					WaitForSocket();
+
 					if (!PQconsumeInput(m_conn->conn))
 					{
 						// It might be the case - it is a result of the
@@ -581,9 +809,11 @@ continue_without_error:
 						return(RaiseEvent(rc));
 					}
 				}
-				lastCopyRc = copyRc;
 			}
 
+			if (m_copyOutFile && !m_cancelled)
+				FlushCopyOut();
+
 			res = PQgetResult(m_conn->conn);
 
 			if (!res)
@@ -597,12 +827,17 @@ continue_without_error:
 		if (!m_cancelled && resultsRetrieved == resultToRetrieve)
 		{
 			result = res;
+			resultNo = resultsRetrieved;
 			insertedOid = PQoidValue(res);
+
+			// The streamed rows are not part of the final result
+			int rows = streaming ? (int)m_queries[m_currIndex]->m_streamedRows : PQntuples(result);
+
 			if (insertedOid && insertedOid != (Oid) - 1)
 				AppendMessage(wxString::Format(_("query inserted one row with oid %d.\n"), insertedOid));
 			else
 				AppendMessage(wxString::Format(wxPLURAL("query result with %d row will be returned.\n", "query result with %d rows will be returned.\n",
-				                                        PQntuples(result)), PQntuples(result)));
+				                                        rows), rows));
 			continue;
 		}
 
@@ -635,14 +870,39 @@ out_of_consume_input_loop:
 	}
 
 	if (!result)
+	{
 		result = lastResult;
+		resultNo = resultsRetrieved;
+	}
 
 	err.SetError(result, &conv);
 
 	AppendMessage(wxT("\n"));
 
 	rc = PQresultStatus(result);
-	if (rc == PGRES_TUPLES_OK)
+	if (rc == PGRES_TUPLES_OK && streaming)
+	{
+		pgBatchQuery *query = m_queries[m_currIndex];
+
+		if (query->m_discardedRows > 0 && query->m_streamResultNo == resultNo)
+			AppendMessage(wxString::Format(
+			                  _("Memory limit reached: only the first %ld rows were kept, %ld rows discarded.\n"),
+			                  query->m_streamedRows, query->m_discardedRows));
+
+		insertedOid = PQoidValue(result);
+		if (insertedOid == (Oid) - 1)
+			insertedOid = 0;
+
+		// The rows have been handed over already, the final result only
+		// carries the columns and the command status.
+		{
+			wxCriticalSectionLocker lock(m_criticalSection);
+			query->m_streamChunks.Add(new pgStreamChunk(result, resultNo));
+		}
+
+		return(RaiseEvent(1));
+	}
+	else if (rc == PGRES_TUPLES_OK)
 	{
 		dataSet = new pgSet(result, m_conn, conv, m_conn->needColQuoting);
 		dataSet->MoveFirst();
@@ -678,6 +938,527 @@ out_of_consume_input_loop:
 	return(RaiseEvent(1));
 }
 
+// Executes the queued queries in the pipeline mode. Returns false, if
+// that is not possible, and they have to be executed one by one.
+bool pgQueryThread::ExecutePipeline()
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	// Streaming needs the single row mode, COPY is not allowed in a pipeline
+	if (!m_pipelining || m_streaming || m_copyOutFile)
+		return false;
+
+	int first = m_currIndex + 1, last = first;
+	int count = (int)m_queries.GetCount();
+
+	// The callable statements can not be pipelined
+	if (first >= count || m_queries[first]->m_useCallable)
+		return false;
+	while (last + 1 < count && !m_queries[last + 1]->m_useCallable)
+		last++;
+
+	if (last == first)
+		return false;
+
+	wxMutexLocker lock(m_queriesLock);
+	wxMBConv &conv = *(m_conn->conv);
+
+	if (PQstatus(m_conn->conn) != CONNECTION_OK || !PQenterPipelineMode(m_conn->conn))
+		return false;
+
+	// Every query is followed by a sync point, so that a failing query does
+	// not abort the others
+	int sent;
+	for (sent = first ; sent <= last ; sent++)
+	{
+		pgBatchQuery *query = m_queries[sent];
+		wxCharBuffer queryBuf = query->m_query.mb_str(conv);
+
+		// Executing it on its own reports the error
+		if (!queryBuf)
+			break;
+
+		int pCount = query->m_params ? (int)query->m_params->GetCount() : 0;
+		Oid *pOids = NULL;
+		const char **pParams = NULL;
+		int *pLens = NULL, *pFormats = NULL;
+
+		if (pCount)
+		{
+			pOids = (Oid *)malloc(pCount * sizeof(Oid));
+			pParams = (const char **)malloc(pCount * sizeof(const char *));
+			pLens = (int *)malloc(pCount * sizeof(int));
+			pFormats = (int *)malloc(pCount * sizeof(int));
+
+			for (int idx = 0 ; idx < pCount ; idx++)
+			{
+				pgParam *param = (*query->m_params)[idx];
+
+				pOids[idx] = param->m_type;
+				pParams[idx] = (const char *)param->m_val;
+				pLens[idx] = param->m_len;
+				pFormats[idx] = param->GetFormat();
+			}
+		}
+
+		bool ok = PQsendQueryParams(m_conn->conn, queryBuf, pCount, pOids, pParams, pLens, pFormats, 0) == 1;
+
+		free(pOids);
+		free(pParams);
+		free(pLens);
+		free(pFormats);
+
+		if (!ok)
+			break;
+
+		query->m_returnCode = -2;
+		query->m_rowsInserted = -1l;
+
+		wxLogSql(wxT("Thread sending query (%d:%s:%d): %s"),
+		         sent + 1, m_conn->GetHost().c_str(), m_conn->GetPort(),
+		         query->m_query.c_str());
+
+		if (!PQpipelineSync(m_conn->conn))
+		{
+			sent++;
+			break;
+		}
+	}
+
+	if (sent == first)
+	{
+		PQexitPipelineMode(m_conn->conn);
+		return false;
+	}
+
+	bool failed = false, cancelSent = false, stopped = false;
+	int idx;
+
+	for (idx = first ; idx < sent ; idx++)
+	{
+		PGresult *result = NULL, *res;
+
+		// The last result of the query counts, as in Execute()
+		while ((res = GetPipelineResult(failed, cancelSent)) != NULL)
+		{
+			if (result)
+				PQclear(result);
+			result = res;
+		}
+
+		// Followed by the sync point
+		if (!failed && (res = GetPipelineResult(failed, cancelSent)) != NULL)
+			PQclear(res);
+
+		// Once cancelled, the remaining results are only consumed
+		if (stopped)
+		{
+			if (result)
+				PQclear(result);
+			continue;
+		}
+
+		m_currIndex = idx;
+
+		int &rc = m_queries[idx]->m_returnCode;
+		pgError &err = m_queries[idx]->m_err;
+
+		if (m_cancelled)
+		{
+			if (result)
+				PQclear(result);
+
+			rc = pgQueryResultEvent::PGQ_EXECUTION_CANCELLED;
+			err.msg_primary = _("Execution Cancelled");
+
+			if (m_eventOnCancellation)
+				RaiseEvent(rc);
+
+			stopped = true;
+		}
+		else if (failed)
+		{
+			if (result)
+				PQclear(result);
+
+			if (PQstatus(m_conn->conn) == CONNECTION_BAD)
+			{
+				err.msg_primary = _("Connection to the database server lost");
+				rc = pgQueryResultEvent::PGQ_CONN_LOST;
+			}
+			else
+			{
+				err.msg_primary = wxString(PQerrorMessage(m_conn->conn), conv);
+				rc = pgQueryResultEvent::PGQ_ERROR_CONSUME_INPUT;
+			}
+			RaiseEvent(rc);
+		}
+		else
+			PipelineResult(result);
+	}
+
+	PQexitPipelineMode(m_conn->conn);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+#ifdef LIBPQ_HAS_PIPELINING
+// Waits for the next result of the pipeline. Like PQgetResult(), NULL
+// marks the end of the results of a query (or an error, if _failed is set).
+PGresult *pgQueryThread::GetPipelineResult(bool &_failed, bool &_cancelSent)
+{
+	while (true)
+	{
+		if (m_cancelled && !_cancelSent)
+		{
+			m_conn->CancelExecution();
+			_cancelSent = true;
+		}
+
+		if (PQconsumeInput(m_conn->conn) != 1)
+		{
+			_failed = true;
+			return NULL;
+		}
+
+		if (!PQisBusy(m_conn->conn))
+			return PQgetResult(m_conn->conn);
+
+		WaitForSocket();
+	}
+}
+
+
+// Hands over the result of the current query in the pipeline, the same
+// way Execute() does
+void pgQueryThread::PipelineResult(PGresult *_result)
+{
+	pgBatchQuery *query = m_queries[m_currIndex];
+	wxMBConv &conv = *(m_conn->conv);
+
+	query->m_err.SetError(_result, &conv);
+
+	if (!_result)
+	{
+		query->m_returnCode = PGRES_FATAL_ERROR;
+		AppendMessage(wxString(PQerrorMessage(m_conn->conn), conv));
+		RaiseEvent(query->m_returnCode);
+		return;
+	}
+
+	int rc = query->m_returnCode = PQresultStatus(_result);
+
+	if (rc == PGRES_PIPELINE_ABORTED)
+	{
+		// Should not happen with a sync point after every query
+		query->m_returnCode = PGRES_FATAL_ERROR;
+		query->m_err.msg_primary = _("The query was not executed, because an earlier query failed.");
+		AppendMessage(query->m_err.msg_primary);
+		PQclear(_result);
+		RaiseEvent(query->m_returnCode);
+		return;
+	}
+
+	if (rc != PGRES_TUPLES_OK && rc != PGRES_COMMAND_OK)
+	{
+		AppendMessage(wxString(PQresultErrorMessage(_result), conv));
+		PQclear(_result);
+		RaiseEvent(rc);
+		return;
+	}
+
+	query->m_insertedOid = PQoidValue(_result);
+	if (query->m_insertedOid == (Oid) - 1)
+		query->m_insertedOid = 0;
+
+	if (rc == PGRES_TUPLES_OK)
+	{
+		query->m_resultSet = new pgSet(_result, m_conn, conv, m_conn->needColQuoting);
+		query->m_resultSet->MoveFirst();
+	}
+	else
+	{
+		char *s = PQcmdTuples(_result);
+		if (*s)
+			query->m_rowsInserted = atol(s);
+		PQclear(_result);
+	}
+
+	RaiseEvent(1);
+}
+#endif
+
+
+// Prepares the query (as the unnamed statement), and returns the format of
+// the results to execute it with, or -1 if it has not been prepared. The
+// binary format is used only if all the columns can be decoded.
+int pgQueryThread::PrepareBinaryResults(const wxString &_query, const char *_queryBuf)
+{
+	PGconn *conn = m_conn->conn;
+
+	// Only the queries returning rows, the rest gain nothing. Also, a query
+	// failing to prepare (being a list of statements, for example) must not
+	// abort the transaction of the user, hence none may be open.
+	wxString keyword = _query.Strip(wxString::leading).BeforeFirst(' ').BeforeFirst('\t')
+	                   .BeforeFirst('\r').BeforeFirst('\n').Upper();
+	if ((keyword != wxT("SELECT") && keyword != wxT("WITH") && keyword != wxT("VALUES") &&
+	        keyword != wxT("TABLE")) || PQtransactionStatus(conn) != PQTRANS_IDLE)
+		return -1;
+
+	PGresult *res = PQprepare(conn, "", _queryBuf, 0, NULL);
+	bool prepared = (PQresultStatus(res) == PGRES_COMMAND_OK);
+	PQclear(res);
+
+	// Any errors are reported, when the query is run the usual way
+	if (!prepared)
+		return -1;
+
+	res = PQdescribePrepared(conn, "");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+	{
+		PQclear(res);
+		return 0;
+	}
+
+	const char *intDatetimes = PQparameterStatus(conn, "integer_datetimes");
+	bool canDecodeDatetimes = intDatetimes && !strcmp(intDatetimes, "on");
+	// The decoder shows timestamptz in UTC, the server in the session's
+	// time zone
+	bool isUtc = pgBinaryDecoder::IsUtcZone(PQparameterStatus(conn, "TimeZone"));
+	int format = PQnfields(res) > 0 ? 1 : 0;
+
+	for (int col = 0 ; format && col < PQnfields(res) ; col++)
+	{
+		OID typOid = PQftype(res, col);
+
+		if (!pgBinaryDecoder::CanDecode(typOid) ||
+		        (pgBinaryDecoder::IsDateTime(typOid) && !canDecodeDatetimes) ||
+		        (typOid == PGOID_TYPE_TIMESTAMPTZ && !isUtc))
+			format = 0;
+	}
+	PQclear(res);
+
+	return format;
+}
+
+
+void pgQueryThread::StreamRow(PGresult *_row, int _resultNo)
+{
+	pgBatchQuery *query = m_queries[m_currIndex];
+
+	// Only the rows of the requested result are of any interest
+	if (m_cancelled || PQnfields(_row) == 0 ||
+	        (query->m_resToRetrieve > 0 && _resultNo != query->m_resToRetrieve))
+	{
+		PQclear(_row);
+		return;
+	}
+
+	if (m_streamBatch && m_streamBatchResultNo != _resultNo)
+		FlushStreamBatch(true);
+
+	if (query->m_streamResultNo != _resultNo)
+	{
+		query->m_streamResultNo = _resultNo;
+		query->m_streamedRows = 0;
+		query->m_streamedBytes = 0;
+		query->m_discardedRows = 0;
+	}
+
+	size_t bytes = pgSet::ResultSize(_row);
+
+	if (m_streamMemoryPolicy == STREAM_MEMORY_STOP && m_streamMemoryLimit &&
+	        query->m_streamedBytes + bytes > m_streamMemoryLimit)
+	{
+		// Keep on reading, so that the query completes normally, but do
+		// not keep the rows.
+		query->m_discardedRows++;
+		PQclear(_row);
+		return;
+	}
+
+	if (!m_streamBatch)
+	{
+		m_streamBatch = pgSet::CopyResultAttrs(_row);
+		m_streamBatchResultNo = _resultNo;
+	}
+
+	int row = PQntuples(m_streamBatch),
+	    nCols = PQnfields(_row);
+
+	for (int col = 0; col < nCols; col++)
+	{
+		if (PQgetisnull(_row, 0, col))
+			PQsetvalue(m_streamBatch, row, col, NULL, -1);
+		else
+			PQsetvalue(m_streamBatch, row, col, PQgetvalue(_row, 0, col), PQgetlength(_row, 0, col));
+	}
+	PQclear(_row);
+
+	query->m_streamedRows++;
+	query->m_streamedBytes += bytes;
+
+	if (row + 1 >= m_streamBatchRows)
+		FlushStreamBatch(true);
+}
+
+
+void pgQueryThread::FlushStreamBatch(bool _force)
+{
+	wxLongLong now = wxGetLocalTimeMillis();
+	bool due = (now - m_streamLastNotify >= STREAM_NOTIFY_INTERVAL);
+	pgBatchQuery *query = m_queries[m_currIndex];
+
+	// A partial batch is handed over only from time to time, so that the
+	// first rows show up soon, without splitting the rest in tiny batches.
+	if (m_streamBatch && (_force || due))
+	{
+		{
+			wxCriticalSectionLocker lock(m_criticalSection);
+			query->m_streamChunks.Add(new pgStreamChunk(m_streamBatch, m_streamBatchResultNo));
+		}
+		m_streamBatch = NULL;
+		m_streamPending = true;
+	}
+
+	if (!m_streamPending || !due)
+		return;
+
+	m_streamPending = false;
+	m_streamLastNotify = now;
+
+#if !defined(PGSCLI)
+	if (m_rowsHandler)
+	{
+		pgQueryResultEvent rowsEvent(GetId(), query, query->m_eventID, PGQueryRowsEvent);
+
+		rowsEvent.SetClientData(query->m_data);
+		rowsEvent.SetInt((int)query->m_streamedRows);
+
+		m_rowsHandler->AddPendingEvent(rowsEvent);
+	}
+#endif
+}
+
+
+bool pgQueryThread::CopyOutRow(const char *_buf, int _len, wxMBConv &_conv)
+{
+	if (m_copyOutFailed)
+		return false;
+
+	// Every row arrives separately, terminated by a newline
+	bool crlf = m_copyOutCrLf && _len > 0 && _buf[_len - 1] == '\n';
+	if (crlf)
+		_len--;
+
+	if (m_copyOutConv)
+	{
+		wxString row(_buf, _conv, _len);
+		wxCharBuffer converted = row.mb_str(*m_copyOutConv);
+
+		if (!converted)
+		{
+			m_copyOutSkipped++;
+			return true;
+		}
+		m_copyOutBuffer.AppendData(converted.data(), strlen(converted.data()));
+	}
+	else
+		m_copyOutBuffer.AppendData(_buf, _len);
+
+	if (crlf)
+		m_copyOutBuffer.AppendData("\r\n", 2);
+	m_copyOutBufferRows++;
+
+	if (m_copyOutBuffer.GetDataLen() >= COPY_OUT_BUFFER_SIZE)
+		return FlushCopyOut();
+
+	return true;
+}
+
+
+bool pgQueryThread::FlushCopyOut()
+{
+	size_t len = m_copyOutBuffer.GetDataLen();
+
+	if (m_copyOutFailed)
+		return false;
+
+	if (len && m_copyOutFile->Write(m_copyOutBuffer.GetData(), len) != len)
+	{
+		m_copyOutFailed = true;
+		AppendMessage(_("Could not write to the export file, the export has been stopped.\n"));
+		return false;
+	}
+	m_copyOutBuffer.SetDataLen(0);
+
+	wxCriticalSectionLocker lock(m_criticalSection);
+	m_copyOutRows += m_copyOutBufferRows;
+	m_copyOutBytes += (wxLongLong)len;
+	m_copyOutBufferRows = 0;
+
+	return true;
+}
+
+
+bool pgQueryThread::FetchStreamedRows(int _idx)
+{
+	if (_idx == -1)
+		_idx = m_currIndex;
+
+	if (_idx < 0 || _idx > m_currIndex)
+		return false;
+
+	pgBatchQuery *query = m_queries[_idx];
+	pgStreamChunkArray chunks;
+
+	{
+		wxCriticalSectionLocker lock(m_criticalSection);
+
+		for (size_t i = 0; i < query->m_streamChunks.GetCount(); i++)
+			chunks.Add(query->m_streamChunks[i]);
+		query->m_streamChunks.Clear();
+	}
+
+	bool created = false;
+
+	for (size_t i = 0; i < chunks.GetCount(); i++)
+	{
+		pgStreamChunk *chunk = chunks[i];
+
+		// The rows of a later result replace the earlier one, unless a
+		// specific result was asked for (those are not streamed at all).
+		if (!query->m_resultSet || query->m_fetchedResultNo != chunk->resultNo)
+		{
+			if (query->m_resultSet)
+				delete query->m_resultSet;
+
+			query->m_resultSet = new pgSet(pgSet::CopyResultAttrs(chunk->res), m_conn,
+			                               *(m_conn->conv), m_conn->needColQuoting);
+			query->m_resultSet->SetDeferTypeLookups(true);
+			if (m_streamMemoryPolicy == STREAM_MEMORY_SPILL)
+				query->m_resultSet->SetMemoryLimit(m_streamMemoryLimit, true);
+
+			query->m_fetchedResultNo = chunk->resultNo;
+			created = true;
+		}
+
+		query->m_resultSet->AppendRows(chunk->res);
+		chunk->res = NULL;
+
+		delete chunk;
+	}
+
+	if (created)
+		query->m_resultSet->MoveFirst();
+
+	return created;
+}
+
+
 int pgQueryThread::RaiseEvent(int _retval)
 {
 #if !defined(PGSCLI)
@@ -705,20 +1486,34 @@ void *pgQueryThread::Entry()
 			// Create the PGcancel object to enable cancelling the running
 			// query
 			m_conn->SetConnCancel();
-			m_currIndex++;
-
-			m_queries[m_currIndex]->m_returnCode = -2;
-			m_queries[m_currIndex]->m_rowsInserted = -1l;
-
-			wxLogSql(wxT("Thread executing query (%d:%s:%d): %s"),
-			         m_currIndex + 1, m_conn->GetHost().c_str(), m_conn->GetPort(),
-			         m_queries[m_currIndex]->m_query.c_str());
 
 			// register the notice processor for the current query
 			m_conn->RegisterNoticeProcessor(m_processor, m_noticeHandler);
 
+			// Send all the queued queries at once, if possible, otherwise
 			// execute the current query now
-			Execute();
+			if (!ExecutePipeline())
+			{
+				m_currIndex++;
+
+				m_queries[m_currIndex]->m_returnCode = -2;
+				m_queries[m_currIndex]->m_rowsInserted = -1l;
+
+				wxLogSql(wxT("Thread executing query (%d:%s:%d): %s"),
+				         m_currIndex + 1, m_conn->GetHost().c_str(), m_conn->GetPort(),
+				         m_queries[m_currIndex]->m_query.c_str());
+
+				Execute();
+			}
+
+			// Rows of a failed or a cancelled query are not needed anymore
+			if (m_streamBatch)
+			{
+				PQclear(m_streamBatch);
+				m_streamBatch = NULL;
+			}
+			m_streamPending = false;
+			m_streamLastNotify = 0;
 
 			// remove the notice processor now
 			m_conn->RegisterNoticeProcessor(0, 0);
@@ -730,10 +1525,16 @@ void *pgQueryThread::Entry()
 		if (!m_multiQueries || m_cancelled)
 			break;
 
-		wxThread::Sleep(10);
+		// Sleep until the next query is queued (or the execution has been
+		// cancelled), instead of polling the queue.
+		if (m_currIndex >= (((int)m_queries.GetCount()) - 1))
+			m_queryQueued.WaitTimeout(100);
 	}
 	while (true);
 
+	m_finished = true;
+	m_finishedSignal.Post();
+
 	return(NULL);
 }
 
@@ -781,6 +1582,8 @@ const wxString &pgBatchQuery::GetErrorMessage()
 
 pgBatchQuery::~pgBatchQuery()
 {
+	WX_CLEAR_ARRAY(m_streamChunks);
+
 	if (m_resultSet)
 	{
 		delete m_resultSet;
@@ -824,8 +1627,8 @@ bool pgBatchQuery::Release()
 }
 
 pgQueryResultEvent::pgQueryResultEvent(
-    unsigned long _thrdId, pgBatchQuery *_qry, int _id) :
-	wxCommandEvent(PGQueryResultEvent, _id), m_thrdId(_thrdId),
+    unsigned long _thrdId, pgBatchQuery *_qry, int _id, wxEventType _type) :
+	wxCommandEvent(_type, _id), m_thrdId(_thrdId),
 	m_query(_qry) { }
 
 pgQueryResultEvent::pgQueryResultEvent(const pgQueryResultEvent &_ev)
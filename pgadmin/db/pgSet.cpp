@@ -13,6 +13,7 @@
 
 // wxWindows headers
 #include <wx/wx.h>
+#include <wx/filename.h>
 
 // PostgreSQL headers
 #include <libpq-fe.h>
@@ -20,6 +21,7 @@
 // App headers
 #include "db/pgSet.h"
 #include "db/pgConn.h"
+#include "db/pgBinaryDecoder.h"
 #include "utils/sysLogger.h"
 #include "utils/pgDefs.h"
 
@@ -31,6 +33,13 @@ pgSet::pgSet()
 	nCols = 0;
 	nRows = 0;
 	pos = 0;
+
+	curChunk = 0;
+	loadedBytes = 0;
+	memoryLimit = 0;
+	spillToDisk = false;
+	deferTypeLookups = false;
+	typesRequested = false;
 }
 
 pgSet::pgSet(PGresult *newRes, pgConn *newConn, wxMBConv &cnv, bool needColQt)
@@ -38,6 +47,13 @@ pgSet::pgSet(PGresult *newRes, pgConn *newConn, wxMBConv &cnv, bool needColQt)
 {
 	needColQuoting = needColQt;
 
+	curChunk = 0;
+	loadedBytes = 0;
+	memoryLimit = 0;
+	spillToDisk = false;
+	deferTypeLookups = false;
+	typesRequested = false;
+
 	conn = newConn;
 	res = newRes;
 
@@ -67,6 +83,256 @@ pgSet::pgSet(PGresult *newRes, pgConn *newConn, wxMBConv &cnv, bool needColQt)
 pgSet::~pgSet()
 {
 	PQclear(res);
+
+	for (size_t i = 0; i < chunks.GetCount(); i++)
+	{
+		if (chunks[i]->res)
+			PQclear(chunks[i]->res);
+	}
+	WX_CLEAR_ARRAY(chunks);
+
+	if (spillFile.IsOpened())
+	{
+		spillFile.Close();
+		wxRemoveFile(spillFileName);
+	}
+}
+
+
+PGresult *pgSet::CopyResultAttrs(const PGresult *src)
+{
+	int nFields = PQnfields(src);
+	PGresult *dst = PQmakeEmptyPGresult(NULL, PGRES_TUPLES_OK);
+
+	if (!dst || !nFields)
+		return dst;
+
+	PGresAttDesc *attrs = (PGresAttDesc *)malloc(nFields * sizeof(PGresAttDesc));
+
+	for (int col = 0; col < nFields; col++)
+	{
+		attrs[col].name = PQfname(src, col);
+		attrs[col].tableid = PQftable(src, col);
+		attrs[col].columnid = PQftablecol(src, col);
+		attrs[col].format = PQfformat(src, col);
+		attrs[col].typid = PQftype(src, col);
+		attrs[col].typlen = PQfsize(src, col);
+		attrs[col].atttypmod = PQfmod(src, col);
+	}
+
+	// PQsetResultAttrs copies the attribute names
+	PQsetResultAttrs(dst, nFields, attrs);
+	free(attrs);
+
+	return dst;
+}
+
+
+size_t pgSet::ResultSize(const PGresult *r)
+{
+	int rows = PQntuples(r),
+	    cols = PQnfields(r);
+	size_t bytes = (size_t)rows * (sizeof(void *) + cols * (sizeof(int) + sizeof(char *)));
+
+	for (int row = 0; row < rows; row++)
+	{
+		for (int col = 0; col < cols; col++)
+			bytes += PQgetlength(r, row, col) + 1;
+	}
+
+	return bytes;
+}
+
+
+void pgSet::AppendRows(PGresult *batch)
+{
+	long batchRows = PQntuples(batch);
+
+	if (!batchRows)
+	{
+		// The final result of the query carries the command status too
+		PQclear(res);
+		res = batch;
+
+		return;
+	}
+
+	pgSetChunk *chunk = new pgSetChunk;
+
+	chunk->res = batch;
+	chunk->firstRow = nRows;
+	chunk->rows = batchRows;
+	chunk->bytes = ResultSize(batch);
+	chunk->spillOffset = -1;
+	chunk->spillLength = 0;
+
+	chunks.Add(chunk);
+	loadedBytes += chunk->bytes;
+
+	if (!nRows)
+	{
+		nRows = batchRows;
+		MoveFirst();
+	}
+	else
+		nRows += batchRows;
+
+	if (spillToDisk && memoryLimit && loadedBytes > memoryLimit)
+		SpillChunks(chunks[curChunk]);
+}
+
+
+void pgSet::SetMemoryLimit(size_t maxBytes, bool spill)
+{
+	memoryLimit = maxBytes;
+	spillToDisk = spill;
+}
+
+
+PGresult *pgSet::LocateChunk(int &row) const
+{
+	long r = pos - 1;
+	pgSetChunk *chunk = chunks[curChunk];
+
+	if (r < chunk->firstRow || r >= chunk->firstRow + chunk->rows)
+	{
+		size_t lo = 0, hi = chunks.GetCount();
+
+		while (hi - lo > 1)
+		{
+			size_t mid = (lo + hi) / 2;
+
+			if (chunks[mid]->firstRow <= r)
+				lo = mid;
+			else
+				hi = mid;
+		}
+		curChunk = lo;
+		chunk = chunks[lo];
+	}
+
+	if (!chunk->res)
+		LoadChunk(chunk);
+
+	if (!chunk->res)
+	{
+		// Could not read the rows back, behave like an out-of-range row
+		row = -1;
+		return res;
+	}
+
+	row = r - chunk->firstRow;
+	return chunk->res;
+}
+
+
+void pgSet::LoadChunk(pgSetChunk *chunk) const
+{
+	char *buf = (char *)malloc(chunk->spillLength);
+
+	if (!buf || spillFile.Seek(chunk->spillOffset) == wxInvalidOffset ||
+	        spillFile.Read(buf, chunk->spillLength) != (ssize_t)chunk->spillLength)
+	{
+		wxLogError(__("Could not read the result rows back from %s"), spillFileName.c_str());
+		if (buf)
+			free(buf);
+		return;
+	}
+
+	PGresult *r = CopyResultAttrs(res);
+	char *ptr = buf;
+
+	for (int row = 0; row < chunk->rows; row++)
+	{
+		for (int col = 0; col < nCols; col++)
+		{
+			int len;
+			memcpy(&len, ptr, sizeof(int));
+			ptr += sizeof(int);
+
+			if (len < 0)
+				PQsetvalue(r, row, col, NULL, -1);
+			else
+			{
+				PQsetvalue(r, row, col, ptr, len);
+				ptr += len;
+			}
+		}
+	}
+	free(buf);
+
+	chunk->res = r;
+	loadedBytes += chunk->bytes;
+
+	SpillChunks(chunk);
+}
+
+
+void pgSet::SpillChunks(const pgSetChunk *keep) const
+{
+	while (loadedBytes > memoryLimit)
+	{
+		// Evict the loaded chunk farthest away from the one in use, as the
+		// grid is most likely to ask for the rows around it next.
+		pgSetChunk *victim = NULL;
+		long distance = -1;
+
+		for (size_t i = 0; i < chunks.GetCount(); i++)
+		{
+			pgSetChunk *chunk = chunks[i];
+			long d = labs(chunk->firstRow - keep->firstRow);
+
+			if (chunk != keep && chunk->res && d > distance)
+			{
+				victim = chunk;
+				distance = d;
+			}
+		}
+
+		if (!victim)
+			return;
+
+		if (victim->spillOffset < 0)
+		{
+			if (!spillFile.IsOpened())
+			{
+				spillFileName = wxFileName::CreateTempFileName(wxT("pgset"));
+				if (spillFileName.IsEmpty() || !spillFile.Open(spillFileName, wxFile::read_write))
+				{
+					wxLogError(__("Could not create a temporary file for the result rows, keeping them in memory"));
+					spillToDisk = false;
+					return;
+				}
+			}
+
+			wxMemoryBuffer buf;
+			for (int row = 0; row < victim->rows; row++)
+			{
+				for (int col = 0; col < nCols; col++)
+				{
+					int len = PQgetisnull(victim->res, row, col) ? -1 : PQgetlength(victim->res, row, col);
+
+					buf.AppendData(&len, sizeof(int));
+					if (len > 0)
+						buf.AppendData(PQgetvalue(victim->res, row, col), len);
+				}
+			}
+
+			wxFileOffset offset = spillFile.SeekEnd();
+			if (offset == wxInvalidOffset || spillFile.Write(buf.GetData(), buf.GetDataLen()) != buf.GetDataLen())
+			{
+				wxLogError(__("Could not write the result rows to %s, keeping them in memory"), spillFileName.c_str());
+				spillToDisk = false;
+				return;
+			}
+			victim->spillOffset = offset;
+			victim->spillLength = buf.GetDataLen();
+		}
+
+		PQclear(victim->res);
+		victim->res = NULL;
+		loadedBytes -= victim->bytes;
+	}
 }
 
 
@@ -96,22 +362,12 @@ long pgSet::GetInsertedCount() const
 }
 
 
-pgTypClass pgSet::ColTypClass(const int col) const
+pgTypClass pgSet::TypClassFromOid(OID typOid)
 {
-	wxASSERT(col < nCols && col >= 0);
-
-	if (colClasses[col] != 0)
-		return (pgTypClass)colClasses[col];
-
-	wxString typoid = ExecuteScalar(
-	                      wxT("SELECT CASE WHEN typbasetype=0 THEN oid else typbasetype END AS basetype\n")
-	                      wxT("  FROM pg_type WHERE oid=") + NumToStr(ColTypeOid(col)));
-
-	switch (StrToLong(typoid))
+	switch (typOid)
 	{
 		case PGOID_TYPE_BOOL:
-			colClasses[col] = PGTYPCLASS_BOOL;
-			break;
+			return PGTYPCLASS_BOOL;
 		case PGOID_TYPE_INT8:
 		case PGOID_TYPE_INT2:
 		case PGOID_TYPE_INT4:
@@ -124,27 +380,73 @@ pgTypClass pgSet::ColTypClass(const int col) const
 		case PGOID_TYPE_MONEY:
 		case PGOID_TYPE_BIT:
 		case PGOID_TYPE_NUMERIC:
-			colClasses[col] = PGTYPCLASS_NUMERIC;
-			break;
+			return PGTYPCLASS_NUMERIC;
 		case PGOID_TYPE_BYTEA:
 		case PGOID_TYPE_CHAR:
 		case PGOID_TYPE_NAME:
 		case PGOID_TYPE_TEXT:
 		case PGOID_TYPE_VARCHAR:
-			colClasses[col] = PGTYPCLASS_STRING;
-			break;
+			return PGTYPCLASS_STRING;
 		case PGOID_TYPE_TIMESTAMP:
 		case PGOID_TYPE_TIMESTAMPTZ:
 		case PGOID_TYPE_TIME:
 		case PGOID_TYPE_TIMETZ:
 		case PGOID_TYPE_INTERVAL:
-			colClasses[col] = PGTYPCLASS_DATE;
-			break;
+			return PGTYPCLASS_DATE;
 		default:
-			colClasses[col] = PGTYPCLASS_OTHER;
-			break;
+			return PGTYPCLASS_OTHER;
+	}
+}
+
+
+// Describe the column using the type cache of the connection. The types of
+// all the columns are fetched together on the first lookup.
+bool pgSet::LookupColType(const int col) const
+{
+	if (!conn)
+		return false;
+
+	pgTypeInfo info;
+	wxString fullName;
+
+	if (!conn->GetCachedType(ColTypeOid(col), ColTypeMod(col), info, fullName))
+	{
+		if (deferTypeLookups || typesRequested)
+			return false;
+
+		typesRequested = true;
+
+		if (!conn->CacheTypes(res) ||
+		        !conn->GetCachedType(ColTypeOid(col), ColTypeMod(col), info, fullName))
+			return false;
 	}
 
+	colClasses[col] = TypClassFromOid(info.baseType);
+	colTypes[col] = info.name;
+	colFullTypes[col] = fullName;
+
+	return true;
+}
+
+
+pgTypClass pgSet::ColTypClass(const int col) const
+{
+	wxASSERT(col < nCols && col >= 0);
+
+	if (colClasses[col] != 0 || LookupColType(col))
+		return (pgTypClass)colClasses[col];
+
+	// Domains can not be resolved without a query, but that will be done
+	// once the connection is available again
+	if (deferTypeLookups)
+		return TypClassFromOid(ColTypeOid(col));
+
+	wxString typoid = ExecuteScalar(
+	                      wxT("SELECT CASE WHEN typbasetype=0 THEN oid else typbasetype END AS basetype\n")
+	                      wxT("  FROM pg_type WHERE oid=") + NumToStr(ColTypeOid(col)));
+
+	colClasses[col] = TypClassFromOid((OID)StrToLong(typoid));
+
 	return (pgTypClass)colClasses[col];
 }
 
@@ -153,9 +455,12 @@ wxString pgSet::ColType(const int col) const
 {
 	wxASSERT(col < nCols && col >= 0);
 
-	if (!colTypes[col].IsEmpty())
+	if (!colTypes[col].IsEmpty() || LookupColType(col))
 		return colTypes[col];
 
+	if (deferTypeLookups)
+		return wxEmptyString;
+
 	wxString szSQL, szResult;
 	szSQL.Printf(wxT("SELECT format_type(oid,NULL) as typname FROM pg_type WHERE oid = %d"), (int)ColTypeOid(col));
 	szResult = ExecuteScalar(szSQL);
@@ -168,9 +473,12 @@ wxString pgSet::ColFullType(const int col) const
 {
 	wxASSERT(col < nCols && col >= 0);
 
-	if (!colFullTypes[col].IsEmpty())
+	if (!colFullTypes[col].IsEmpty() || LookupColType(col))
 		return colFullTypes[col];
 
+	if (deferTypeLookups)
+		return wxEmptyString;
+
 	wxString szSQL, szResult;
 	szSQL.Printf(wxT("SELECT format_type(oid,%d) as typname FROM pg_type WHERE oid = %d"), (int)ColTypeMod(col), (int)ColTypeOid(col));
 	szResult = ExecuteScalar(szSQL);
@@ -229,17 +537,55 @@ bool pgSet::HasColumn(const wxString &colname) const
 
 
 
+// Returns false, unless the (non-NULL) value of the column has been
+// received in the binary format, and needs to be decoded
+bool pgSet::GetBinaryValue(const int col, const char *&val, int &len) const
+{
+	if (col < 0 || PQfformat(res, col) != 1 || pgBinaryDecoder::IsTextual(ColTypeOid(col)))
+		return false;
+
+	int row;
+	PGresult *r = CurrentResult(row);
+
+	if (PQgetisnull(r, row, col))
+		return false;
+
+	val = PQgetvalue(r, row, col);
+	len = PQgetlength(r, row, col);
+
+	return val != NULL;
+}
+
+
 char *pgSet::GetCharPtr(const int col) const
 {
 	wxASSERT(col < nCols && col >= 0);
 
-	return PQgetvalue(res, pos - 1, col);
+	const char *val;
+	int len;
+
+	if (GetBinaryValue(col, val, len))
+	{
+		binaryText = pgBinaryDecoder::ToText(ColTypeOid(col), val, len);
+		return binaryText.data();
+	}
+
+	int row;
+	PGresult *r = CurrentResult(row);
+
+	return PQgetvalue(r, row, col);
 }
 
 
 char *pgSet::GetCharPtr(const wxString &col) const
 {
-	return PQgetvalue(res, pos - 1, ColNumber(col));
+	int row, colNo = ColNumber(col);
+	PGresult *r = CurrentResult(row);
+
+	if (colNo >= 0)
+		return GetCharPtr(colNo);
+
+	return PQgetvalue(r, row, colNo);
 }
 
 
@@ -261,7 +607,13 @@ long pgSet::GetLong(const int col) const
 {
 	wxASSERT(col < nCols && col >= 0);
 
-	char *c = PQgetvalue(res, pos - 1, col);
+	const char *val;
+	int len;
+
+	if (GetBinaryValue(col, val, len))
+		return (long)pgBinaryDecoder::GetLongLong(ColTypeOid(col), val, len).GetValue();
+
+	char *c = GetCharPtr(col);
 	if (c)
 		return atol(c);
 	else
@@ -271,7 +623,7 @@ long pgSet::GetLong(const int col) const
 
 long pgSet::GetLong(const wxString &col) const
 {
-	char *c = PQgetvalue(res, pos - 1, ColNumber(col));
+	char *c = GetCharPtr(col);
 	if (c)
 		return atol(c);
 	else
@@ -283,7 +635,13 @@ bool pgSet::GetBool(const int col) const
 {
 	wxASSERT(col < nCols && col >= 0);
 
-	char *c = PQgetvalue(res, pos - 1, col);
+	const char *val;
+	int len;
+
+	if (GetBinaryValue(col, val, len))
+		return pgBinaryDecoder::GetBool(ColTypeOid(col), val, len);
+
+	char *c = GetCharPtr(col);
 	if (c)
 	{
 		if (*c == 't' || *c == '1' || !strcmp(c, "on"))
@@ -303,6 +661,12 @@ wxDateTime pgSet::GetDateTime(const int col) const
 {
 	wxASSERT(col < nCols && col >= 0);
 
+	const char *val;
+	int len;
+
+	if (GetBinaryValue(col, val, len))
+		return pgBinaryDecoder::GetDateTime(ColTypeOid(col), val, len);
+
 	wxDateTime dt;
 	wxString str = GetVal(col);
 	/* This hasn't just been used. ( Is not infinity ) */
@@ -322,6 +686,17 @@ wxDateTime pgSet::GetDate(const int col) const
 {
 	wxASSERT(col < nCols && col >= 0);
 
+	const char *val;
+	int len;
+
+	if (GetBinaryValue(col, val, len))
+	{
+		wxDateTime dt = pgBinaryDecoder::GetDateTime(ColTypeOid(col), val, len);
+		if (dt.IsValid())
+			dt.ResetTime();
+		return dt;
+	}
+
 	wxDateTime dt;
 	wxString str = GetVal(col);
 	/* This hasn't just been used. ( Is not infinity ) */
@@ -341,6 +716,12 @@ double pgSet::GetDouble(const int col) const
 {
 	wxASSERT(col < nCols && col >= 0);
 
+	const char *val;
+	int len;
+
+	if (GetBinaryValue(col, val, len))
+		return pgBinaryDecoder::GetDouble(ColTypeOid(col), val, len);
+
 	return StrToDouble(GetVal(col));
 }
 
@@ -355,7 +736,13 @@ wxULongLong pgSet::GetLongLong(const int col) const
 {
 	wxASSERT(col < nCols && col >= 0);
 
-	char *c = PQgetvalue(res, pos - 1, col);
+	const char *val;
+	int len;
+
+	if (GetBinaryValue(col, val, len))
+		return wxULongLong((wxULongLong_t)pgBinaryDecoder::GetLongLong(ColTypeOid(col), val, len).GetValue());
+
+	char *c = GetCharPtr(col);
 	if (c)
 		return atolonglong(c);
 	else
@@ -372,7 +759,13 @@ OID pgSet::GetOid(const int col) const
 {
 	wxASSERT(col < nCols && col >= 0);
 
-	char *c = PQgetvalue(res, pos - 1, col);
+	const char *val;
+	int len;
+
+	if (GetBinaryValue(col, val, len))
+		return (OID)pgBinaryDecoder::GetLongLong(ColTypeOid(col), val, len).GetValue();
+
+	char *c = GetCharPtr(col);
 	if (c)
 		return (OID)strtoul(c, 0, 10);
 	else
@@ -413,6 +413,9 @@ bool dbgController::Start()
 	m_dbgThread = new pgQueryThread(
 	    m_dbgConn, this, &(dbgController::NoticeHandler), this);
 	m_dbgThread->SetEventOnCancellation(false);
+	// All the debugger commands are single statements, the breakpoints
+	// are set using a series of them
+	m_dbgThread->SetPipelining(true);
 
 	if (m_dbgThread->Create() != wxTHREAD_NO_ERROR)
 	{
@@ -19,6 +19,7 @@
 #include "pgAdmin3.h"
 #include "frm/frmMain.h"
 #include "db/pgConn.h"
+#include "db/pgConnPool.h"
 #include "schema/pgObject.h"
 #include "schema/pgDatabase.h"
 #include "utils/sysProcess.h"
@@ -461,7 +462,7 @@ void ExecutionDialog::OnClose(wxCloseEvent &event)
 	if(bIsExecutionStarted && !bIsExecutionCompleted)
 		return;
 
-	delete conn;
+	pgConnPool::Get()->Release(conn);
 	if (IsModal())
 		EndModal(-1);
 	else
@@ -480,7 +481,7 @@ void ExecutionDialog::OnCancel(wxCommandEvent &ev)
 	}
 	else
 	{
-		delete conn;
+		pgConnPool::Get()->Release(conn);
 		if (IsModal())
 			EndModal(-1);
 		else
@@ -542,7 +543,7 @@ void ExecutionDialog::OnOK(wxCommandEvent &ev)
 
 		while (thread && thread->IsRunning())
 		{
-			wxMilliSleep(10);
+			thread->WaitForCompletion(10);
 			// here could be the animation
 			if (txtMessages)
 			{
@@ -597,7 +598,7 @@ void ExecutionDialog::OnOK(wxCommandEvent &ev)
 	else
 	{
 		Abort();
-		delete conn;
+		pgConnPool::Get()->Release(conn);
 		Destroy();
 	}
 }
@@ -29,6 +29,7 @@
 #include "frm/frmOptions.h"
 #include "ctl/ctlSQLBox.h"
 #include "ctl/ctlMenuToolbar.h"
+#include "ctl/ctlTreeLoader.h"
 #include "db/pgConn.h"
 #include "schema/pgDatabase.h"
 #include "db/pgSet.h"
@@ -260,9 +261,16 @@ void frmMain::OnCollapse(wxTreeEvent &event)
 	// connecting the server and expanding the tree.
 	// Possibly not necessary
 	if (event.GetItem() == denyCollapseItem)
+	{
 		event.Veto();
+		denyCollapseItem = wxTreeItemId();
+		return;
+	}
 #endif
 	denyCollapseItem = wxTreeItemId();
+
+	// Nobody is going to look at the collections below anymore
+	browser->GetLoader()->CancelBelow(event.GetItem());
 }
 
 
@@ -394,6 +402,8 @@ void frmMain::OnTreeSelChanged(wxTreeEvent &event)
 // Reset the list controls
 void frmMain::ResetLists()
 {
+	paneLoader->Supersede();
+
 	properties->ClearAll();
 	properties->AddColumn(_("Properties"), properties->GetSize().GetWidth() - 10);
 	properties->InsertItem(0, _("No properties are available for the current selection"), PGICON_PROPERTY);
@@ -615,7 +625,13 @@ void frmMain::OnSelActivated(wxTreeEvent &event)
 	wxTreeItemId item = event.GetItem();
 	pgObject *data = browser->GetObject(item);
 	if (!data)
+	{
+		// The "Show next" item of a large collection
+		pgCollection *collection = browser->GetParentCollection(item);
+		if (collection && collection->IsMoreItem(item))
+			collection->AppendMoreObjects(browser);
 		return;
+	}
 	pgServer *server;
 	wxCommandEvent nullEvent;
 
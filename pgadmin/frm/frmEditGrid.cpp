@@ -19,6 +19,7 @@
 #include "frm/frmMain.h"
 #include "frm/menu.h"
 #include "db/pgQueryThread.h"
+#include "db/pgConnPool.h"
 
 #include <wx/generic/gridctrl.h>
 #include <wx/clipbrd.h>
@@ -50,6 +51,23 @@
 
 #define CTRLID_LIMITCOMBO       4226
 
+// Rows deleted by a single statement at most
+#define EDITGRID_DELETE_BATCH   1000
+
+// Rows read from the cursor at once, and the number of such pages kept
+#define EDITGRID_PAGE_ROWS      1000
+#define EDITGRID_CURSOR_PAGES   10
+
+// Numbers the cursors, so that a table never reads from the one of another
+static int editGridCursors = 0;
+
+// Reads the rows of the page, from wherever the cursor is positioned
+static wxString PageQuery(const wxString &cursor, int pageNo)
+{
+	return wxString::Format(wxT("MOVE ABSOLUTE %d IN %s; FETCH FORWARD %d FROM %s"),
+	                        pageNo * EDITGRID_PAGE_ROWS, cursor.c_str(), EDITGRID_PAGE_ROWS, cursor.c_str());
+}
+
 
 BEGIN_EVENT_TABLE(frmEditGrid, pgFrame)
 	EVT_ERASE_BACKGROUND(       frmEditGrid::OnEraseBackground)
@@ -1223,35 +1241,27 @@ void frmEditGrid::OnDelete(wxCommandEvent &event)
 
 	sqlGrid->BeginBatch();
 
-	// Sort the grid so we always delete last->first, otherwise we
-	// could end up deleting anything because the array returned by
-	// GetSelectedRows is in the order that rows were selected by
-	// the user.
+	// The array returned by GetSelectedRows is in the order that rows
+	// were selected by the user, the table wants them in their order.
 	delrows.Sort(ArrayCmp);
 
-	// don't care a lot about optimizing here; doing it line by line
-	// just as sqlTable::DeleteRows does
-	bool show_continue_message = true;
-	while (i--)
-	{
-		if (!sqlGrid->DeleteRows(delrows.Item(i), 1) &&
-		        i > 0 &&
-		        show_continue_message)
-		{
-			wxMessageDialog msg(this, wxString::Format(wxPLURAL(
-			                        "There was an error deleting the previous record.\nAre you sure you wish to delete the remaining %d row?",
-			                        "There was an error deleting the previous record.\nAre you sure you wish to delete the remaining %d rows?",
-			                        i), i), _("Delete more records ?"), wxYES_NO | wxICON_QUESTION);
-			if (msg.ShowModal() != wxID_YES)
-				break;
-			else
-				show_continue_message = false;
-		}
-	}
-
+	wxArrayInt failedRows;
+	wxString error;
+	sqlGrid->GetTable()->DeleteRowSet(delrows, failedRows, error);
 
 	sqlGrid->EndBatch();
 
+	// Leave the rows not deleted selected
+	if (!failedRows.IsEmpty())
+	{
+		sqlGrid->ClearSelection();
+		for (i = 0 ; i < (int)failedRows.GetCount() ; i++)
+			sqlGrid->SelectRow(failedRows.Item(i), true);
+
+		wxLogError(wxPLURAL("%d row could not be deleted:\n%s", "%d rows could not be deleted:\n%s",
+		                    (int)failedRows.GetCount()), (int)failedRows.GetCount(), error.c_str());
+	}
+
 	SetStatusText(wxString::Format(wxPLURAL("%d row.", "%d rows.", sqlGrid->GetTable()->GetNumberStoredRows()), sqlGrid->GetTable()->GetNumberStoredRows()), 0);
 }
 
@@ -1385,16 +1395,12 @@ void frmEditGrid::Go()
 
 	SetStatusText(_("Refreshing data, please wait."), 0);
 
-	toolBar->EnableTool(MNU_REFRESH, false);
-	viewMenu->Enable(MNU_REFRESH, false);
-	toolBar->EnableTool(MNU_OPTIONS, false);
-	toolsMenu->Enable(MNU_OPTIONS, false);
-	toolsMenu->Enable(MNU_INCLUDEFILTER, false);
-	toolsMenu->Enable(MNU_EXCLUDEFILTER, false);
-	toolsMenu->Enable(MNU_REMOVEFILTERS, false);
-	toolsMenu->Enable(MNU_ASCSORT, false);
-	toolsMenu->Enable(MNU_DESCSORT, false);
-	toolsMenu->Enable(MNU_REMOVESORT, false);
+	EnableRefresh(false);
+
+	// The rows shown until then must not be read from the connection
+	// anymore, while the query thread is using it
+	if (sqlGrid->GetTable())
+		sqlGrid->GetTable()->CloseCursor();
 
 	wxString qry = wxT("SELECT ");
 	if (hasOids)
@@ -1411,68 +1417,69 @@ void frmEditGrid::Go()
 	if (limit > 0)
 		qry += wxT(" LIMIT ") + wxString::Format(wxT("%i"), limit);
 
-	thread = new pgQueryThread(connection, qry);
-	if (thread->Create() != wxTHREAD_NO_ERROR)
+	// More rows than the pages kept in memory are read through a cursor,
+	// as they are scrolled to. The cursor holds the rows on the server
+	// after the DECLARE has run the query to its end.
+	wxString cursorName;
+	if (limit <= 0 || limit > EDITGRID_PAGE_ROWS * EDITGRID_CURSOR_PAGES)
 	{
-		Abort();
-		toolBar->EnableTool(MNU_REFRESH, true);
-		viewMenu->Enable(MNU_REFRESH, true);
-		toolBar->EnableTool(MNU_OPTIONS, true);
-		toolsMenu->Enable(MNU_OPTIONS, true);
-		toolsMenu->Enable(MNU_INCLUDEFILTER, true);
-		toolsMenu->Enable(MNU_EXCLUDEFILTER, true);
-		toolsMenu->Enable(MNU_REMOVEFILTERS, true);
-		toolsMenu->Enable(MNU_ASCSORT, true);
-		toolsMenu->Enable(MNU_DESCSORT, true);
-		toolsMenu->Enable(MNU_REMOVESORT, true);
+		cursorName = wxString::Format(wxT("pgadmin_editgrid_%d"), ++editGridCursors);
+		qry = wxT("DECLARE ") + cursorName + wxT(" SCROLL CURSOR WITH HOLD FOR\n") + qry;
+	}
 
+	if (!RunQuery(qry))
+	{
+		// Brute force check to ensure the user didn't get bored and close the window
+		if (!closing)
+			EnableRefresh(true);
 		return;
 	}
 
-	thread->Run();
+	pgSet *set;
+	int rows;
 
-	while (thread && thread->IsRunning())
+	if (cursorName.IsEmpty())
 	{
-		wxTheApp->Yield(true);
-		wxMilliSleep(10);
+		set = thread->DetachDataSet();
+		rows = set->NumRows();
 	}
+	else
+	{
+		delete thread;
+		thread = 0;
 
-	// Brute force check to ensure the user didn't get bored and close the window
-	if (closing)
-		return;
+		// The number of rows, which the cursor is positioned after
+		if (!RunQuery(wxT("MOVE FORWARD ALL IN ") + cursorName))
+		{
+			if (!closing)
+			{
+				connection->ExecuteVoid(wxT("CLOSE ") + cursorName, false);
+				EnableRefresh(true);
+			}
+			return;
+		}
+		rows = (int)thread->RowsInserted();
 
-	if (!thread)
-	{
-		toolBar->EnableTool(MNU_REFRESH, true);
-		viewMenu->Enable(MNU_REFRESH, true);
-		toolBar->EnableTool(MNU_OPTIONS, true);
-		toolsMenu->Enable(MNU_OPTIONS, true);
-		toolsMenu->Enable(MNU_INCLUDEFILTER, true);
-		toolsMenu->Enable(MNU_EXCLUDEFILTER, true);
-		toolsMenu->Enable(MNU_REMOVEFILTERS, true);
-		toolsMenu->Enable(MNU_ASCSORT, true);
-		toolsMenu->Enable(MNU_DESCSORT, true);
-		toolsMenu->Enable(MNU_REMOVESORT, true);
-		return;
-	}
+		delete thread;
+		thread = 0;
 
-	if (!thread->DataValid())
-	{
-		Abort();
-		toolBar->EnableTool(MNU_REFRESH, true);
-		viewMenu->Enable(MNU_REFRESH, true);
-		toolBar->EnableTool(MNU_OPTIONS, true);
-		toolsMenu->Enable(MNU_OPTIONS, true);
-		toolsMenu->Enable(MNU_INCLUDEFILTER, true);
-		toolsMenu->Enable(MNU_EXCLUDEFILTER, true);
-		toolsMenu->Enable(MNU_REMOVEFILTERS, true);
-		toolsMenu->Enable(MNU_ASCSORT, true);
-		toolsMenu->Enable(MNU_DESCSORT, true);
-		toolsMenu->Enable(MNU_REMOVESORT, true);
-		return;
+		set = connection->ExecuteSet(PageQuery(cursorName, 0));
+		if (connection->GetLastResultStatus() != PGRES_TUPLES_OK)
+		{
+			delete set;
+			connection->ExecuteVoid(wxT("CLOSE ") + cursorName, false);
+			Abort();
+			EnableRefresh(true);
+			return;
+		}
 	}
 
-	SetStatusText(wxString::Format(wxPLURAL("%d row.", "%d rows.", (int)thread->DataSet()->NumRows()), (int)thread->DataSet()->NumRows()), 0);
+	// Set the thread variable to zero so we don't try to
+	// abort it if the user cancels now.
+	delete thread;
+	thread = 0;
+
+	SetStatusText(wxString::Format(wxPLURAL("%d row.", "%d rows.", rows), rows), 0);
 
 	sqlGrid->BeginBatch();
 
@@ -1483,30 +1490,63 @@ void frmEditGrid::Go()
 	// !!! Is it still required?
 	//sqlGrid->SetSize(10, 10);
 
-	sqlGrid->SetTable(new sqlTable(connection, thread, tableName, relid, hasOids, primaryKeyColNumbers, relkind), true);
+	sqlGrid->SetTable(new sqlTable(connection, set, cursorName, rows, tableName, relid, hasOids, primaryKeyColNumbers, relkind), true);
 	sqlGrid->AutoSizeColumns(false);
 
 	sqlGrid->EndBatch();
 
-	toolBar->EnableTool(MNU_REFRESH, true);
-	viewMenu->Enable(MNU_REFRESH, true);
-	toolBar->EnableTool(MNU_OPTIONS, true);
-	toolsMenu->Enable(MNU_OPTIONS, true);
-	toolsMenu->Enable(MNU_INCLUDEFILTER, true);
-	toolsMenu->Enable(MNU_EXCLUDEFILTER, true);
-	toolsMenu->Enable(MNU_REMOVEFILTERS, true);
-	toolsMenu->Enable(MNU_ASCSORT, true);
-	toolsMenu->Enable(MNU_DESCSORT, true);
-	toolsMenu->Enable(MNU_REMOVESORT, true);
+	EnableRefresh(true);
 
 	manager.Update();
 
 	if (!hasOids && primaryKeyColNumbers.IsEmpty() && relkind == 'r')
 		frmHint::ShowHint(this, HINT_READONLY_NOPK, tableName);
+}
 
-	// Set the thread variable to zero so we don't try to
-	// abort it if the user cancels now.
-	thread = 0;
+
+bool frmEditGrid::RunQuery(const wxString &qry)
+{
+	thread = new pgQueryThread(connection, qry);
+	if (thread->Create() != wxTHREAD_NO_ERROR)
+	{
+		Abort();
+		return false;
+	}
+
+	thread->Run();
+
+	while (thread && thread->IsRunning())
+	{
+		// Returns as soon as the query is done
+		thread->WaitForCompletion(10);
+		wxTheApp->Yield(true);
+	}
+
+	if (closing || !thread)
+		return false;
+
+	if (thread->ReturnCode() != PGRES_TUPLES_OK && thread->ReturnCode() != PGRES_COMMAND_OK)
+	{
+		Abort();
+		return false;
+	}
+
+	return true;
+}
+
+
+void frmEditGrid::EnableRefresh(bool enable)
+{
+	toolBar->EnableTool(MNU_REFRESH, enable);
+	viewMenu->Enable(MNU_REFRESH, enable);
+	toolBar->EnableTool(MNU_OPTIONS, enable);
+	toolsMenu->Enable(MNU_OPTIONS, enable);
+	toolsMenu->Enable(MNU_INCLUDEFILTER, enable);
+	toolsMenu->Enable(MNU_EXCLUDEFILTER, enable);
+	toolsMenu->Enable(MNU_REMOVEFILTERS, enable);
+	toolsMenu->Enable(MNU_ASCSORT, enable);
+	toolsMenu->Enable(MNU_DESCSORT, enable);
+	toolsMenu->Enable(MNU_REMOVESORT, enable);
 }
 
 
@@ -1520,7 +1560,7 @@ frmEditGrid::~frmEditGrid()
 	manager.UnInit();
 
 	if (connection)
-		delete connection;
+		pgConnPool::Get()->Release(connection);
 }
 
 
@@ -2270,7 +2310,7 @@ wxString sqlGridBoolEditor::GetValue() const
 //////////////////////////////////////////////////////////////////////
 
 
-sqlTable::sqlTable(pgConn *conn, pgQueryThread *_thread, const wxString &tabName, const OID _relid, bool _hasOid, const wxString &_pkCols, char _relkind)
+sqlTable::sqlTable(pgConn *conn, pgSet *set, const wxString &cursor, int rows, const wxString &tabName, const OID _relid, bool _hasOid, const wxString &_pkCols, char _relkind)
 {
 	connection = conn;
 	primaryKeyColNumbers = _pkCols;
@@ -2278,25 +2318,29 @@ sqlTable::sqlTable(pgConn *conn, pgQueryThread *_thread, const wxString &tabName
 	relkind = _relkind;
 	tableName = tabName;
 	hasOids = _hasOid;
-	thread = _thread;
+	cursorName = cursor;
+	cursorFailed = false;
 
-	rowsCached = 0;
 	rowsAdded = 0;
 	rowsStored = 0;
 	rowsDeleted = 0;
 
 
-	dataPool = 0;
 	addPool = new cacheLinePool(500);       // arbitrary initial size
 	lastRow = -1;
 	int i;
-	lineIndex = 0;
 
-	nRows = thread->DataSet()->NumRows();
-	nCols = thread->DataSet()->NumCols();
+	nRows = rows;
+	nCols = set->NumCols();
+
+	if (cursorName.IsEmpty())
+		pageRows = wxMax(nRows, 1);
+	else
+		pageRows = EDITGRID_PAGE_ROWS;
 
 	columns = new sqlCellAttr[nCols];
 	savedLine.cols = new wxString[nCols];
+	binaryCols = new bool[nCols];
 
 	// Get the "real" column list, including any dropped columns, as
 	// key positions etc do not ignore these.
@@ -2517,17 +2561,19 @@ sqlTable::sqlTable(pgConn *conn, pgQueryThread *_thread, const wxString &tabName
 		// *if* we reach here, namespace info is missing.
 		for (i = 0 ; i < nCols ; i++)
 		{
-			columns[i].typeName = thread->DataSet()->ColType(i);
-			columns[i].name = thread->DataSet()->ColName(i);
+			columns[i].typeName = set->ColType(i);
+			columns[i].name = set->ColName(i);
 		}
 	}
 
-	if (nRows)
+	for (i = 0 ; i < nCols ; i++)
+		binaryCols[i] = (set->ColType(i) == wxT("bytea"));
+
+	// The first page, or all the rows
+	if (StorePage(0, set) && cursorName.IsEmpty())
 	{
-		dataPool = new cacheLinePool(nRows);
-		lineIndex = new int[nRows];
-		for (i = 0 ; i < nRows ; i++)
-			lineIndex[i] = i;
+		// Rows not read (out of memory) are left out
+		nRows = pages[0]->GetRowCount();
 	}
 
 	if (canInsert)
@@ -2540,17 +2586,20 @@ sqlTable::sqlTable(pgConn *conn, pgQueryThread *_thread, const wxString &tabName
 
 sqlTable::~sqlTable()
 {
-	if (thread)
-		delete thread;
-	if (dataPool)
-		delete dataPool;
+	CloseCursor();
+
+	sqlColumnStoreMap::iterator page;
+	for (page = pages.begin(); page != pages.end(); ++page)
+		delete page->second;
+
+	cacheLineMap::iterator it;
+	for (it = editedLines.begin(); it != editedLines.end(); ++it)
+		delete it->second;
 
 	delete addPool;
 
 	delete[] columns;
-
-	if (lineIndex)
-		delete[] lineIndex;
+	delete[] binaryCols;
 }
 
 
@@ -2638,33 +2687,185 @@ void sqlTable::SetNumberEditor(int col, int len)
 }
 
 
+void sqlTable::CloseCursor()
+{
+	if (!cursorName.IsEmpty() && connection->GetStatus() == PGCONN_OK)
+		connection->ExecuteVoid(wxT("CLOSE ") + cursorName, false);
+
+	cursorName = wxEmptyString;
+}
+
+
+// The rows not read yet are read from the cursor when asked for, hence only
+// the rows beyond the end of the table are missing
 bool sqlTable::CheckInCache(int row)
 {
-	if (row > nRows - rowsDeleted + rowsAdded)
-		return false;
-	if (row >= nRows - rowsDeleted)
-		return true;
+	return row <= nRows - rowsDeleted + rowsAdded;
+}
+
+
+// Copy the rows of the data-set into the column store of the page, the
+// data-set is not needed anymore afterwards.
+sqlColumnStore *sqlTable::StorePage(int pageNo, pgSet *set)
+{
+	sqlColumnStore *store = 0;
+
+	if (set->NumRows())
+	{
+		store = new sqlColumnStore(nCols, pageRows);
+
+		set->MoveFirst();
+		while (!set->Eof())
+		{
+			if (!store->AppendRow(set, binaryCols))
+			{
+				wxLogError(__("Out of Memory for sqlColumnStore"));
+				break;
+			}
+			set->MoveNext();
+		}
 
-	return dataPool->IsFilled(row);
+		pages[pageNo] = store;
+
+		wxLogInfo(wxT("Edit grid data stored: page %d, %d rows, %lu bytes"),
+		          pageNo, store->GetRowCount(), (unsigned long)store->GetMemoryUsage());
+	}
+
+	delete set;
+	return store;
 }
 
 
-cacheLine *sqlTable::GetLine(int row)
+sqlColumnStore *sqlTable::LoadPage(int pageNo)
+{
+	// All the rows are there already without a cursor, and reading from a
+	// broken one would fail for every cell shown
+	if (cursorName.IsEmpty() || cursorFailed)
+		return 0;
+
+	// Make room by dropping the page farthest from the one needed, that is
+	// from the rows shown
+	if (pages.size() >= EDITGRID_CURSOR_PAGES)
+	{
+		sqlColumnStoreMap::iterator it, farthest = pages.end();
+		for (it = pages.begin(); it != pages.end(); ++it)
+		{
+			if (farthest == pages.end() || abs(it->first - pageNo) > abs(farthest->first - pageNo))
+				farthest = it;
+		}
+
+		delete farthest->second;
+		pages.erase(farthest);
+	}
+
+	pgSet *set = connection->ExecuteSet(PageQuery(cursorName, pageNo), false);
+	if (connection->GetLastResultStatus() != PGRES_TUPLES_OK)
+	{
+		cursorFailed = true;
+		wxLogError(_("Could not read the rows from the server:\n%s"), connection->GetLastError().c_str());
+		delete set;
+		return 0;
+	}
+
+	return StorePage(pageNo, set);
+}
+
+
+sqlColumnStore *sqlTable::GetPage(int dataRow, int &pageRow)
+{
+	int pageNo = dataRow / pageRows;
+	pageRow = dataRow % pageRows;
+
+	sqlColumnStoreMap::iterator it = pages.find(pageNo);
+	if (it != pages.end())
+		return it->second;
+
+	return LoadPage(pageNo);
+}
+
+
+wxString sqlTable::GetStoredValue(int dataRow, int col)
+{
+	if (binaryCols[col])
+		return _("<binary data>");
+
+	int pageRow;
+	sqlColumnStore *page = GetPage(dataRow, pageRow);
+	if (!page || pageRow >= page->GetRowCount())
+		return wxEmptyString;
+
+	wxString val(page->GetCharPtr(pageRow, col), *connection->GetConv());
+
+	if (val.IsEmpty())
+	{
+		if (!page->IsNull(pageRow, col))
+			val = wxT("''");
+	}
+	else if (val == wxT("''"))
+		val = wxT("\\'\\'");
+	else if (columns[col].type == PGOID_TYPE_BOOL)
+		val = (StrToBool(val) ? wxT("TRUE") : wxT("FALSE"));
+
+	return val;
+}
+
+
+int sqlTable::GetDataRow(int row)
+{
+	// The number of rows deleted up to the row: the nth deleted row has
+	// deletedRows[n] - n rows before it, which are still shown
+	int lo = 0, hi = deletedRows.GetCount();
+
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (deletedRows.Item(mid) - mid <= row)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return row + lo;
+}
+
+
+cacheLine *sqlTable::FindLine(int row)
 {
-	cacheLine *line;
 	if (row < nRows - rowsDeleted)
-		line = dataPool->Get(lineIndex[row]);
-	else
-		line = addPool->Get(row - (nRows - rowsDeleted));
+	{
+		cacheLineMap::iterator it = editedLines.find(GetDataRow(row));
+		return it == editedLines.end() ? 0 : it->second;
+	}
+
+	return addPool->Get(row - (nRows - rowsDeleted));
+}
+
+
+cacheLine *sqlTable::GetLine(int row)
+{
+	cacheLine *line = FindLine(row);
+
+	if (!line && row >= 0 && row < nRows - rowsDeleted)
+	{
+		int dataRow = GetDataRow(row);
+
+		line = new cacheLine();
+		line->cols = new wxString[nCols];
+		line->stored = true;
+
+		for (int i = 0 ; i < nCols ; i++)
+			line->cols[i] = GetStoredValue(dataRow, i);
+
+		editedLines[dataRow] = line;
+	}
 
 	return line;
 }
 
 
 
-wxString sqlTable::MakeKey(cacheLine *line)
+void sqlTable::GetKeyCols(wxArrayInt &keyCols)
 {
-	wxString whereClause;
 	if (!primaryKeyColNumbers.IsEmpty())
 	{
 		wxStringTokenizer collist(primaryKeyColNumbers, wxT(","));
@@ -2683,26 +2884,74 @@ wxString sqlTable::MakeKey(cacheLine *line)
 			// Translate the column location to the real location in the actual columns still present
 			cn = colMap[cn - 1];
 
-			wxString colval = line->cols[cn - offset];
-			if (colval.IsEmpty())
-				return wxEmptyString;
+			keyCols.Add(cn - offset);
+		}
+	}
+	else if (hasOids)
+		keyCols.Add(0);
+}
+
+
+bool sqlTable::GetKeyValues(cacheLine *line, const wxArrayInt &keyCols, wxArrayString &values)
+{
+	if (keyCols.IsEmpty())
+		return false;
+
+	// The values of several lines are appended to the same array, so
+	// nothing is appended for a line without a complete key
+	wxArrayString lineValues;
+
+	for (size_t i = 0 ; i < keyCols.GetCount() ; i++)
+	{
+		int col = keyCols.Item(i);
+		wxString colval = line->cols[col];
+
+		if (colval.IsEmpty())
+			return false;
+
+		if (colval == wxT("''") && columns[col].typeName == wxT("text"))
+			colval = wxEmptyString;
+
+		lineValues.Add(colval);
+	}
 
-			if (colval == wxT("''") && columns[cn - offset].typeName == wxT("text"))
-				colval = wxEmptyString;
+	WX_APPEND_ARRAY(values, lineValues);
+	return true;
+}
+
+
+wxString sqlTable::MakeKey(cacheLine *line, wxArrayString &params)
+{
+	wxArrayInt keyCols;
+	wxArrayString values;
+	wxString whereClause;
 
-			if (!whereClause.IsEmpty())
-				whereClause += wxT(" AND ");
-			whereClause += qtIdent(columns[cn - offset].name) + wxT(" = ") + connection->qtDbString(colval);
+	GetKeyCols(keyCols);
+	if (!GetKeyValues(line, keyCols, values))
+		return wxEmptyString;
 
-			if (columns[cn - offset].typeName != wxT(""))
+	for (size_t i = 0 ; i < keyCols.GetCount() ; i++)
+	{
+		sqlCellAttr &column = columns[keyCols.Item(i)];
+
+		params.Add(values.Item(i));
+
+		if (!whereClause.IsEmpty())
+			whereClause += wxT(" AND ");
+
+		if (primaryKeyColNumbers.IsEmpty())
+			whereClause += wxT("oid = $") + NumToStr((long)params.GetCount()) + wxT("::oid");
+		else
+		{
+			whereClause += qtIdent(column.name) + wxT(" = $") + NumToStr((long)params.GetCount());
+
+			if (column.typeName != wxT(""))
 			{
 				whereClause += wxT("::");
-				whereClause += columns[cn - offset].displayTypeName;
+				whereClause += column.displayTypeName;
 			}
 		}
 	}
-	else if (hasOids)
-		whereClause = wxT("oid = ") + line->cols[0];
 
 	return whereClause;
 }
@@ -2752,6 +3001,7 @@ bool sqlTable::StoreLine()
 		if (line->stored)
 		{
 			// UPDATE
+			wxArrayString params;
 
 			for (i = (hasOids ? 1 : 0) ; i < nCols ; i++)
 			{
@@ -2759,7 +3009,7 @@ bool sqlTable::StoreLine()
 				{
 					if (!valList.IsNull())
 						valList += wxT(", ");
-					valList += qtIdent(columns[i].name) + wxT("=") + columns[i].Quote(connection, line->cols[i]);
+					valList += qtIdent(columns[i].name) + wxT("=") + columns[i].QuoteParam(line->cols[i], params);
 				}
 			}
 
@@ -2767,17 +3017,18 @@ bool sqlTable::StoreLine()
 				done = true;
 			else
 			{
-				wxString key = MakeKey(&savedLine);
+				wxString key = MakeKey(&savedLine, params);
 				wxASSERT(!key.IsEmpty());
-				done = connection->ExecuteVoid(wxT(
-				                                   "UPDATE ") + tableName + wxT(
-				                                   " SET ") + valList + wxT(
-				                                   " WHERE ") + key);
+				done = connection->ExecuteVoidPrepared(wxT(
+				                                           "UPDATE ") + tableName + wxT(
+				                                           " SET ") + valList + wxT(
+				                                           " WHERE ") + key, params);
 			}
 		}
 		else
 		{
 			// INSERT
+			wxArrayString params;
 
 			for (i = 0 ; i < nCols ; i++)
 			{
@@ -2790,59 +3041,68 @@ bool sqlTable::StoreLine()
 					}
 					colList += qtIdent(columns[i].name);
 
-					valList += columns[i].Quote(connection, line->cols[i]);
+					valList += columns[i].QuoteParam(line->cols[i], params);
 				}
 			}
 
 			if (!valList.IsEmpty())
 			{
-				pgSet *set = connection->ExecuteSet(
-				                 wxT("INSERT INTO ") + tableName
-				                 + wxT("(") + colList
-				                 + wxT(") VALUES (") + valList
-				                 + wxT(")"));
-				if (set)
+				// Get the default values along with the row inserted, where
+				// possible (views may be made updatable by rules without
+				// RETURNING)
+				bool returning = (relkind == 'r') && connection->BackendMinimumVersion(8, 2);
+				wxString sql = wxT("INSERT INTO ") + tableName
+				               + wxT("(") + colList
+				               + wxT(") VALUES (") + valList
+				               + wxT(")");
+				if (returning)
+					sql += wxT(" RETURNING *");
+
+				pgSet *set = connection->ExecuteSetPrepared(sql, params);
+				if (set->GetInsertedCount() > 0)
 				{
-					if (set->GetInsertedCount() > 0)
-					{
-						if (hasOids)
-							line->cols[0] = NumToStr((long)set->GetInsertedOid());
-						delete set;
+					if (hasOids)
+						line->cols[0] = NumToStr((long)set->GetInsertedOid());
 
-						done = true;
-						rowsStored++;
-						((wxFrame *)GetView()->GetParent())->SetStatusText(wxString::Format(wxT("%d rows."), GetNumberStoredRows()));
-						if (rowsAdded == rowsStored)
-							GetView()->AppendRows();
+					done = true;
+					rowsStored++;
+					((wxFrame *)GetView()->GetParent())->SetStatusText(wxString::Format(wxT("%d rows."), GetNumberStoredRows()));
+					if (rowsAdded == rowsStored)
+						GetView()->AppendRows();
 
+					if (!returning)
+					{
 						// Read back what we inserted to get default vals
-						wxString key = MakeKey(line);
+						wxArrayString keyParams;
+						wxString key = MakeKey(line, keyParams);
 
-						if (key.IsEmpty())
-						{
-							// That's a problem: obviously, the key generated isn't present
-							// because it's serial or default or otherwise generated in the backend
-							// we don't get.
-							// That's why the whole line is declared readonly.
+						delete set;
+						set = NULL;
 
-							line->readOnly = true;
-						}
-						else
-						{
-							set = connection->ExecuteSet(
+						if (!key.IsEmpty())
+							set = connection->ExecuteSetPrepared(
 							          wxT("SELECT * FROM ") + tableName +
-							          wxT(" WHERE ") + key);
-							if (set)
-							{
-								for (i = (hasOids ? 1 : 0) ; i < nCols ; i++)
-								{
-									line->cols[i] = set->GetVal(columns[i].name);
-								}
-								delete set;
-							}
+							          wxT(" WHERE ") + key, keyParams);
+					}
+
+					if (set && set->NumRows() > 0)
+					{
+						for (i = (hasOids ? 1 : 0) ; i < nCols ; i++)
+						{
+							line->cols[i] = set->GetVal(columns[i].name);
 						}
 					}
+
+					// That's a problem: obviously, the key isn't present
+					// because it's serial or default or otherwise generated in the backend
+					// we don't get.
+					// That's why the whole line is declared readonly.
+					wxArrayString keyParams;
+					if (MakeKey(line, keyParams).IsEmpty())
+						line->readOnly = true;
 				}
+				if (set)
+					delete set;
 			}
 		}
 		if (done)
@@ -2905,11 +3165,16 @@ void sqlTable::SetValue(int row, int col, const wxString &value)
 wxString sqlTable::GetValue(int row, int col)
 {
 	wxString val;
-	cacheLine *line;
+
+	// Unchanged rows are read straight from the store
 	if (row < nRows - rowsDeleted)
-		line = dataPool->Get(lineIndex[row]);
-	else
-		line = addPool->Get(row - (nRows - rowsDeleted));
+	{
+		int dataRow = GetDataRow(row);
+		if (editedLines.find(dataRow) == editedLines.end())
+			return GetStoredValue(dataRow, col);
+	}
+
+	cacheLine *line = FindLine(row);
 
 	if (!line)
 	{
@@ -2918,48 +3183,8 @@ wxString sqlTable::GetValue(int row, int col)
 	}
 
 	if (!line->cols)
-	{
 		line->cols = new wxString[nCols];
-		if (row < nRows - rowsDeleted)
-		{
-			if (!thread)
-			{
-				wxLogError(__("Unexpected empty cache line: dataSet already closed."));
-				return val;
-			}
-
-			line->stored = true;
-			if (lineIndex[row] != thread->DataSet()->CurrentPos() - 1)
-				thread->DataSet()->Locate(lineIndex[row] + 1);
-
-			int i;
-			for (i = 0 ; i < nCols ; i++)
-			{
-				wxString val;
-				if (thread->DataSet()->ColType(i) == wxT("bytea"))
-					val = _("<binary data>");
-				else
-				{
-					val = thread->DataSet()->GetVal(i);
-					if (val.IsEmpty())
-					{
-						if (!thread->DataSet()->IsNull(i))
-							val = wxT("''");
-					}
-					else if (val == wxT("''"))
-						val = wxT("\\'\\'");
-				}
-				line->cols[i] = val;
-			}
-			rowsCached++;
 
-			if (rowsCached == nRows)
-			{
-				delete thread;
-				thread = 0;
-			}
-		}
-	}
 	if (columns[col].type == PGOID_TYPE_BOOL)
 	{
 		if (line->cols[col] != wxEmptyString)
@@ -2984,62 +3209,291 @@ bool sqlTable::AppendRows(size_t rows)
 
 bool sqlTable::DeleteRows(size_t pos, size_t rows)
 {
-	size_t i = pos;
-	size_t rowsDone = 0;
+	wxArrayInt rowList, failedRows;
+	wxString error;
+
+	for (size_t i = pos ; i < pos + rows ; i++)
+		rowList.Add(i);
+
+	int rowsDone = DeleteRowSet(rowList, failedRows, error);
+
+	if (!failedRows.IsEmpty())
+		wxLogError(wxT("%s"), error.c_str());
+
+	return (rowsDone != 0);
+}
+
+
+int sqlTable::DeleteRowSet(const wxArrayInt &rows, wxArrayInt &failedRows, wxString &error)
+{
+	wxArrayInt keyCols, keyedRows, deletedRows, failed;
+	wxArrayString keyValues;
+	size_t i, k;
 
-	while (i < pos + rows)
+	GetKeyCols(keyCols);
+
+	// The keys are passed as arrays, which need a type
+	bool batched = !keyCols.IsEmpty();
+	for (k = 0 ; k < keyCols.GetCount() ; k++)
+	{
+		if (!primaryKeyColNumbers.IsEmpty() && columns[keyCols.Item(k)].typeName == wxT(""))
+			batched = false;
+	}
+
+	for (i = 0 ; i < rows.GetCount() ; i++)
 	{
-		cacheLine *line = GetLine(pos);
+		int row = rows.Item(i);
+		cacheLine *line = GetLine(row);
 		if (!line)
-			break;
+			continue;
 
 		// If line->cols is null, it probably means we need to force the cacheline to be populated.
 		if (!line->cols)
 		{
-			GetValue(pos, 0);
-			line = GetLine(pos);
+			GetValue(row, 0);
+			line = GetLine(row);
 		}
 
-		if (line->stored)
+		if (!line->stored)
 		{
-			wxString key = MakeKey(line);
-			wxASSERT(!key.IsEmpty());
-			bool done = connection->ExecuteVoid(wxT(
-			                                        "DELETE FROM ") + tableName + wxT(" WHERE ") + key);
-			if (!done)
-				break;
+			// last empty line won't be deleted, just cleared
+			for (int j = 0 ; j < nCols ; j++)
+				line->cols[j] = wxT("");
+		}
+		else if (GetKeyValues(line, keyCols, keyValues))
+			keyedRows.Add(row);
+		else
+		{
+			if (error.IsEmpty())
+				error = _("The row can not be identified, it has no primary key value.");
+			failed.Add(row);
+		}
+	}
 
-			if ((int)pos < nRows - rowsDeleted)
+	if (!keyedRows.IsEmpty())
+	{
+		wxString keyList, arrayList, sql, rowSql;
+		wxArrayString params;
+
+		for (k = 0 ; k < keyCols.GetCount() ; k++)
+		{
+			sqlCellAttr &column = columns[keyCols.Item(k)];
+			wxString name, type;
+
+			if (primaryKeyColNumbers.IsEmpty())
 			{
-				rowsDeleted++;
-				if ((int)pos < nRows - rowsDeleted)
-					memmove(lineIndex + pos, lineIndex + pos + 1, sizeof(*lineIndex) * (nRows - rowsDeleted - pos));
+				name = wxT("oid");
+				type = wxT("oid");
 			}
 			else
 			{
-				rowsAdded--;
-				if (GetLine(pos)->stored)
-					rowsStored--;
-				addPool->Delete(pos - (nRows - rowsDeleted));
+				name = qtIdent(column.name);
+				type = column.displayTypeName;
+			}
+
+			if (k)
+			{
+				keyList += wxT(", ");
+				arrayList += wxT(", ");
+				rowSql += wxT(" AND ");
 			}
-			rowsDone++;
+			keyList += name;
+			arrayList += wxT("($") + NumToStr((long)k + 1) + wxT("::") + type + wxT("[])[i]");
+
+			rowSql += name + wxT(" = $") + NumToStr((long)k + 1);
+			if (primaryKeyColNumbers.IsEmpty() || column.typeName != wxT(""))
+				rowSql += wxT("::") + type;
 		}
+
+		rowSql = wxT("DELETE FROM ") + tableName + wxT(" WHERE ") + rowSql;
+
+		if (keyCols.GetCount() == 1)
+			sql = wxT("DELETE FROM ") + tableName + wxT(" WHERE ") + keyList + wxT(" = ANY($1::") +
+			      (primaryKeyColNumbers.IsEmpty() ? wxString(wxT("oid")) : columns[keyCols.Item(0)].displayTypeName) +
+			      wxT("[])");
 		else
+			sql = wxT("DELETE FROM ") + tableName + wxT(" WHERE (") + keyList + wxT(") IN (SELECT ") + arrayList +
+			      wxT(" FROM generate_series(1, array_upper($1::") + columns[keyCols.Item(0)].displayTypeName +
+			      wxT("[], 1)) AS i)");
+
+		// A batch the server refuses is retried row by row. The rows that
+		// can be deleted are committed (or left to the transaction already
+		// open), the refused ones stay selected and are reported.
+		bool ownTransaction = (connection->GetTxStatus() == PQTRANS_IDLE);
+		if (ownTransaction && !connection->ExecuteVoid(wxT("BEGIN"), false))
 		{
-			// last empty line won't be deleted, just cleared
-			int j;
-			for (j = 0 ; j < nCols ; j++)
-				line->cols[j] = wxT("");
+			error = connection->GetLastError();
+			WX_APPEND_ARRAY(failed, keyedRows);
+			keyedRows.Clear();
+			ownTransaction = false;
+		}
+
+		size_t nKeys = keyCols.GetCount();
+
+		for (size_t first = 0 ; first < keyedRows.GetCount() ; first += EDITGRID_DELETE_BATCH)
+		{
+			size_t count = wxMin((size_t)EDITGRID_DELETE_BATCH, keyedRows.GetCount() - first);
+
+			if (batched && count > 1)
+			{
+				params.Clear();
+				for (k = 0 ; k < nKeys ; k++)
+				{
+					wxString array = wxT("{");
+					for (i = first ; i < first + count ; i++)
+					{
+						wxString value = keyValues.Item(i * nKeys + k);
+						value.Replace(wxT("\\"), wxT("\\\\"));
+						value.Replace(wxT("\""), wxT("\\\""));
+
+						if (i > first)
+							array += wxT(",");
+						array += wxT("\"") + value + wxT("\"");
+					}
+					params.Add(array + wxT("}"));
+				}
+
+				if (DeleteKeys(sql, params, error))
+				{
+					for (i = first ; i < first + count ; i++)
+						deletedRows.Add(keyedRows.Item(i));
+					continue;
+				}
+			}
+
+			// Row by row, to tell the failing ones
+			for (i = first ; i < first + count ; i++)
+			{
+				params.Clear();
+				for (k = 0 ; k < nKeys ; k++)
+					params.Add(keyValues.Item(i * nKeys + k));
+
+				if (DeleteKeys(rowSql, params, error))
+					deletedRows.Add(keyedRows.Item(i));
+				else
+					failed.Add(keyedRows.Item(i));
+			}
+		}
+
+		if (ownTransaction && !connection->ExecuteVoid(wxT("COMMIT"), false))
+		{
+			error = connection->GetLastError();
+			WX_APPEND_ARRAY(failed, deletedRows);
+			deletedRows.Clear();
 		}
-		i++;
 	}
 
-	if (rowsDone > 0 && GetView())
+	RemoveLines(deletedRows);
+
+	// Where the failed rows are now
+	failed.Sort(ArrayCmp);
+	size_t d = 0;
+	for (i = 0 ; i < failed.GetCount() ; i++)
 	{
-		wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_DELETED, pos, rowsDone);
+		while (d < deletedRows.GetCount() && deletedRows.Item(d) < failed.Item(i))
+			d++;
+		failedRows.Add(failed.Item(i) - d);
+	}
+
+	return deletedRows.GetCount();
+}
+
+
+// Runs the DELETE within a savepoint, so that the rows deleted before
+// are kept, if it fails
+bool sqlTable::DeleteKeys(const wxString &sql, const wxArrayString &params, wxString &error)
+{
+	if (!connection->ExecuteVoid(wxT("SAVEPOINT pgadmin_delete"), false))
+	{
+		if (error.IsEmpty())
+			error = connection->GetLastError();
+		return false;
+	}
+
+	if (connection->ExecuteVoidPrepared(sql, params, false))
+	{
+		connection->ExecuteVoid(wxT("RELEASE SAVEPOINT pgadmin_delete"), false);
+		return true;
+	}
+
+	if (error.IsEmpty())
+		error = connection->GetLastError();
+	connection->ExecuteVoid(wxT("ROLLBACK TO SAVEPOINT pgadmin_delete"), false);
+	connection->ExecuteVoid(wxT("RELEASE SAVEPOINT pgadmin_delete"), false);
+
+	return false;
+}
+
+
+void sqlTable::RemoveLines(const wxArrayInt &rows)
+{
+	int firstAdded = nRows - rowsDeleted;
+	int i = rows.GetCount() - 1;
+
+	// The rows added in this session first, from the last one, as their
+	// position in the pool depends on the number of rows deleted
+	for ( ; i >= 0 && rows.Item(i) >= firstAdded ; i--)
+	{
+		int pos = rows.Item(i);
+
+		rowsAdded--;
+		if (GetLine(pos)->stored)
+			rowsStored--;
+		addPool->Delete(pos - firstAdded);
+	}
+
+	// Then the rows read from the table, merged into the deleted ones in
+	// one pass
+	int storedRows = i + 1;
+	if (storedRows > 0)
+	{
+		wxArrayInt merged;
+		size_t old = 0;
+
+		merged.Alloc(deletedRows.GetCount() + storedRows);
+
+		for (i = 0 ; i < storedRows ; i++)
+		{
+			// The rows deleted before are skipped by the same number of
+			// rows, as they are ascending
+			int dataRow = rows.Item(i) + (int)old;
+			while (old < deletedRows.GetCount() && deletedRows.Item(old) <= dataRow)
+			{
+				merged.Add(deletedRows.Item(old++));
+				dataRow++;
+			}
+			merged.Add(dataRow);
+
+			cacheLineMap::iterator it = editedLines.find(dataRow);
+			if (it != editedLines.end())
+			{
+				delete it->second;
+				editedLines.erase(it);
+			}
+		}
+		while (old < deletedRows.GetCount())
+			merged.Add(deletedRows.Item(old++));
+
+		deletedRows = merged;
+		rowsDeleted += storedRows;
+	}
+
+	if (!GetView())
+		return;
+
+	// Consecutive rows at once, from the last ones
+	size_t end = rows.GetCount();
+	while (end > 0)
+	{
+		size_t start = end - 1;
+		while (start > 0 && rows.Item(start - 1) == rows.Item(start) - 1)
+			start--;
+
+		wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_DELETED, rows.Item(start), end - start);
 		GetView()->ProcessTableMessage(msg);
+
+		end = start;
 	}
-	return (rowsDone != 0);
 }
 
 
@@ -3167,7 +3621,7 @@ bool sqlTable::Paste()
 
 wxGridCellAttr *sqlTable::GetAttr(int row, int col, wxGridCellAttr::wxAttrKind  kind)
 {
-	cacheLine *line = GetLine(row);
+	cacheLine *line = FindLine(row);
 	if (line && line->readOnly)
 	{
 		wxGridCellAttr *attr = new wxGridCellAttr(columns[col].attr);
@@ -3183,29 +3637,28 @@ wxGridCellAttr *sqlTable::GetAttr(int row, int col, wxGridCellAttr::wxAttrKind
 
 
 
-wxString sqlCellAttr::Quote(pgConn *conn, const wxString &value)
+wxString sqlCellAttr::QuoteParam(const wxString &value, wxArrayString &params)
 {
-	wxString str;
 	if (value.IsEmpty())
-		str = wxT("NULL");
-	else if (numeric)
-		str = conn->qtDbString(value);
+		return wxT("NULL::") + displayTypeName;
+
+	if (numeric)
+		params.Add(value);
 	else if (value == wxT("\\'\\'"))
-		str = conn->qtDbString(wxT("''"));
+		params.Add(wxT("''"));
 	else if (value == wxT("''"))
-		str = wxT("''");
-	else if (type == PGOID_TYPE_BOOL)
-		str = value;
-	else if (type == PGOID_TYPE_BIT)
-		// Don't cast this one
-		return wxT("B'") + value + wxT("'");
+		params.Add(wxEmptyString);
 	else
-		str = conn->qtDbString(value);
+		params.Add(value);
 
-	return str + wxT("::") + displayTypeName;
-}
+	wxString str = wxT("$") + NumToStr((long)params.GetCount());
 
+	// Don't cast this one
+	if (type == PGOID_TYPE_BIT)
+		return str;
 
+	return str + wxT("::") + displayTypeName;
+}
 
 
 int sqlCellAttr::size()
@@ -3308,7 +3761,7 @@ cacheLine *cacheLinePool::Get(int lineNo)
 				memcpy(ptr, old, sizeof(cacheLine *)*oldAnz);
 				delete[] old;
 			}
-			memset(ptr + oldAnz, 0, anzLines - oldAnz);
+			memset(ptr + oldAnz, 0, sizeof(cacheLine *) * (anzLines - oldAnz));
 		}
 	}
 
@@ -3328,6 +3781,91 @@ bool cacheLinePool::IsFilled(int lineNo)
 }
 
 
+sqlColumnStore::sqlColumnStore(int cols, int rows)
+{
+	colCount = cols;
+	rowCount = 0;
+	maxRows = rows;
+
+	columns = new storeColumn[colCount];
+	for (int i = 0 ; i < colCount ; i++)
+	{
+		columns[i].data = 0;
+		columns[i].used = 0;
+		columns[i].allocated = 0;
+		columns[i].offsets = new size_t[maxRows];
+		columns[i].nulls = new unsigned char[(maxRows + 7) / 8];
+		memset(columns[i].nulls, 0, (maxRows + 7) / 8);
+	}
+}
+
+
+sqlColumnStore::~sqlColumnStore()
+{
+	for (int i = 0 ; i < colCount ; i++)
+	{
+		if (columns[i].data)
+			free(columns[i].data);
+		delete[] columns[i].offsets;
+		delete[] columns[i].nulls;
+	}
+	delete[] columns;
+}
+
+
+bool sqlColumnStore::AppendRow(pgSet *set, const bool *skipCols)
+{
+	if (rowCount >= maxRows)
+		return false;
+
+	for (int i = 0 ; i < colCount ; i++)
+	{
+		storeColumn &column = columns[i];
+		const char *val = "";
+
+		if (set->IsNull(i))
+			column.nulls[rowCount >> 3] |= (1 << (rowCount & 7));
+		else if (!skipCols || !skipCols[i])
+			val = set->GetCharPtr(i);
+
+		size_t len = strlen(val) + 1;
+
+		if (column.used + len > column.allocated)
+		{
+			// Grow geometrically, to keep the number of copies low
+			size_t newSize = column.allocated ? column.allocated * 2 : 4096;
+			while (newSize < column.used + len)
+				newSize *= 2;
+
+			char *data = (char *)realloc(column.data, newSize);
+			if (!data)
+				return false;
+
+			column.data = data;
+			column.allocated = newSize;
+		}
+
+		memcpy(column.data + column.used, val, len);
+		column.offsets[rowCount] = column.used;
+		column.used += len;
+	}
+
+	rowCount++;
+	return true;
+}
+
+
+size_t sqlColumnStore::GetMemoryUsage() const
+{
+	size_t size = 0;
+
+	for (int i = 0 ; i < colCount ; i++)
+		size += columns[i].allocated + maxRows * sizeof(size_t) + (maxRows + 7) / 8;
+
+	return size;
+}
+
+
 bool editGridFactoryBase::CheckEnable(pgObject *obj)
 {
 	if (obj)
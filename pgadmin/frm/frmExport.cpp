@@ -18,6 +18,8 @@
 #include "utils/sysSettings.h"
 #include "utils/misc.h"
 #include "ctl/ctlSQLResult.h"
+#include "db/pgConn.h"
+#include "db/pgQueryThread.h"
 
 #define txtFilename     CTRL_TEXT("txtFilename")
 #define btnOK           CTRL_BUTTON("wxID_OK")
@@ -49,6 +51,7 @@ END_EVENT_TABLE()
 frmExport::frmExport(wxWindow *p)
 {
 	parent = p;
+	copyFile = NULL;
 
 	SetFont(settings->GetSystemFont());
 	LoadResource(p, wxT("frmExport"));
@@ -91,6 +94,9 @@ frmExport::frmExport(wxWindow *p)
 frmExport::~frmExport()
 {
 	SavePosition();
+
+	if (copyFile)
+		delete copyFile;
 }
 
 
@@ -298,6 +304,198 @@ bool frmExport::Export(pgSet *set)
 }
 
 
+// Returns the query without the trailing semicolon, if it is a single
+// SELECT (or VALUES, TABLE, WITH) statement COPY can run, otherwise an
+// empty string.
+static wxString GetSingleSelect(const wxString &query)
+{
+	// Leading white space is kept, so that error positions still match
+	wxString stmt = query;
+	stmt.Trim(true);
+	while (stmt.EndsWith(wxT(";")))
+	{
+		stmt.RemoveLast();
+		stmt.Trim(true);
+	}
+
+	// Look for another statement, skipping the literals and comments
+	size_t pos = 0, len = stmt.Length();
+	while (pos < len)
+	{
+		wxChar c = stmt[pos];
+
+		if (c == ';')
+			return wxEmptyString;
+
+		if (c == '\'' || c == '"')
+		{
+			size_t end = stmt.find(c, pos + 1);
+			if (end == wxString::npos)
+				return wxEmptyString;
+			pos = end + 1;
+		}
+		else if (c == '-' && pos + 1 < len && stmt[pos + 1] == '-')
+		{
+			size_t end = stmt.find('\n', pos);
+			if (end == wxString::npos)
+			{
+				// The closing bracket of COPY would end up in the comment
+				stmt.Append(wxT("\n"));
+				break;
+			}
+			pos = end + 1;
+		}
+		else if (c == '/' && pos + 1 < len && stmt[pos + 1] == '*')
+		{
+			size_t end = stmt.find(wxT("*/"), pos + 2);
+			if (end == wxString::npos)
+				return wxEmptyString;
+			pos = end + 2;
+		}
+		else if (c == '$')
+		{
+			// Dollar quoting: $tag$ ... $tag$
+			size_t tagEnd = pos + 1;
+			while (tagEnd < len && (wxIsalnum(stmt[tagEnd]) || stmt[tagEnd] == '_'))
+				tagEnd++;
+
+			if (tagEnd < len && stmt[tagEnd] == '$' && (tagEnd == pos + 1 || !wxIsdigit(stmt[pos + 1])))
+			{
+				wxString tag = stmt.Mid(pos, tagEnd - pos + 1);
+				size_t end = stmt.find(tag, tagEnd + 1);
+				if (end == wxString::npos)
+					return wxEmptyString;
+				pos = end + tag.Length();
+			}
+			else
+				pos++;
+		}
+		else if (wxIsalpha(c) || c == '_')
+		{
+			size_t end = pos + 1;
+			while (end < len && (wxIsalnum(stmt[end]) || stmt[end] == '_' || stmt[end] == '$'))
+				end++;
+
+			// COPY rejects SELECT ... INTO, and the statements modifying
+			// data in a WITH. These words may be column names as well,
+			// such a query is exported the old way too.
+			wxString word = stmt.Mid(pos, end - pos).Upper();
+			if (word == wxT("INTO") || word == wxT("INSERT") || word == wxT("UPDATE") ||
+			        word == wxT("DELETE") || word == wxT("MERGE"))
+				return wxEmptyString;
+
+			pos = end;
+		}
+		else
+			pos++;
+	}
+
+	// The first keyword, behind any leading comments
+	wxString rest = stmt;
+	while (true)
+	{
+		rest.Trim(false);
+		if (rest.StartsWith(wxT("--")))
+			rest = rest.AfterFirst('\n');
+		else if (rest.StartsWith(wxT("/*")))
+			rest = rest.Mid(rest.Find(wxT("*/")) + 2);
+		else
+			break;
+	}
+
+	wxString keyword;
+	for (pos = 0 ; pos < rest.Length() && wxIsalpha(rest[pos]) ; pos++)
+		keyword += rest[pos];
+	keyword.MakeUpper();
+
+	if (keyword != wxT("SELECT") && keyword != wxT("WITH") &&
+	        keyword != wxT("VALUES") && keyword != wxT("TABLE"))
+		return wxEmptyString;
+
+	return stmt;
+}
+
+
+wxString frmExport::GetCopyQuery(pgConn *conn, const wxString &query)
+{
+	// COPY (...) TO STDOUT WITH (option list) appeared in 9.0. Its CSV
+	// format knows single character separators only, and always quotes
+	// the values containing the separator or quote character, so that
+	// "no quoting" can't be done.
+	if (!conn->BackendMinimumVersion(9, 0))
+		return wxEmptyString;
+
+	wxString sep = cbColSeparator->GetValue();
+	wxString qc = cbQuoteChar->GetValue();
+
+	if (sep.Length() != 1 || qc.Length() != 1 || rbQuoteNone->GetValue())
+		return wxEmptyString;
+
+	wxString stmt = GetSingleSelect(query);
+	if (stmt.IsEmpty())
+		return wxEmptyString;
+
+	wxString options = wxT("FORMAT csv, DELIMITER ") + conn->qtDbString(sep) +
+	                   wxT(", QUOTE ") + conn->qtDbString(qc);
+
+	if (chkColnames->GetValue())
+		options += wxT(", HEADER");
+	// With "quote strings", only the values needing it are quoted
+	if (rbQuoteAll->GetValue())
+		options += wxT(", FORCE_QUOTE *");
+
+	return wxT("COPY (") + stmt + wxT(") TO STDOUT WITH (") + options + wxT(")");
+}
+
+
+bool frmExport::StartCopy(pgQueryThread *thread)
+{
+	wxLogInfo(wxT("Exporting data using COPY"));
+
+	copyFile = new wxFile(txtFilename->GetValue(), wxFile::write);
+	if (!copyFile->IsOpened())
+	{
+		wxLogError(__("Failed to open file %s."), txtFilename->GetValue().c_str());
+		delete copyFile;
+		copyFile = NULL;
+		return false;
+	}
+
+	// The data arrives in the encoding of the connection
+	wxMBConv *fileConv = rbUnicode->GetValue() ? (wxMBConv *)&wxConvUTF8 : (wxMBConv *)&wxConvLibc;
+	if (fileConv == thread->GetConn()->GetConv())
+		fileConv = NULL;
+
+	thread->SetCopyOutFile(copyFile, fileConv, rbCRLF->GetValue());
+	return true;
+}
+
+
+bool frmExport::FinishCopy(pgQueryThread *thread, bool success)
+{
+	if (!copyFile)
+		return false;
+
+	copyFile->Close();
+	delete copyFile;
+	copyFile = NULL;
+
+	if (!success || thread->CopyOutFailed())
+		return false;
+
+	long skipped = thread->CopyOutSkippedRows();
+	if (skipped)
+		wxLogError(wxPLURAL(
+		               "Data export incomplete.\n\n%d row contained characters that could not be converted to the local charset.\n\nPlease correct the data or try using UTF8 instead.",
+		               "Data export incomplete.\n\n%d rows contained characters that could not be converted to the local charset.\n\nPlease correct the data or try using UTF8 instead.",
+		               skipped), skipped);
+	else
+		wxMessageBox(_("Data export completed successfully."), _("Export data"), wxICON_INFORMATION | wxOK);
+
+	return true;
+}
+
+
 void frmExport::OnCancel(wxCommandEvent &ev)
 {
 	if (IsModal())
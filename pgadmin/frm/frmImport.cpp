@@ -14,6 +14,8 @@
 #include <wx/wx.h>
 #include <wx/settings.h>
 #include <wx/filepicker.h>
+#include <wx/wfstream.h>
+#include <wx/zstream.h>
 
 
 // App headers
@@ -45,10 +47,24 @@
 #define lstIgnoreForColumns			  CTRL_CHECKLISTBOX("lstIgnoreForColumns")
 
 
+// Minimum interval (ms) between the progress events
+#define IMPORT_PROGRESS_INTERVAL 100
+
+enum
+{
+	IMPORT_PROGRESS = 1000,
+	IMPORT_DONE
+};
+
+
 BEGIN_EVENT_TABLE(frmImport, pgDialog)
 	EVT_COMBOBOX(XRCID("cbFormat"),   frmImport::OnChangeFormat)
 	EVT_BUTTON(wxID_OK,               frmImport::OnOK)
 	EVT_BUTTON (wxID_HELP,            frmImport::OnHelp)
+	EVT_BUTTON(wxID_CANCEL,           frmImport::OnCancel)
+	EVT_CLOSE(                        frmImport::OnClose)
+	EVT_MENU(IMPORT_PROGRESS,         frmImport::OnImportProgress)
+	EVT_MENU(IMPORT_DONE,             frmImport::OnImportDone)
 END_EVENT_TABLE()
 
 
@@ -58,6 +74,7 @@ frmImport::frmImport(frmMain *form, pgObject *_object, pgConn *_conn)
 	connection = _conn;
 	object = _object;
 	done = false;
+	thread = NULL;
 
 	// Set-up window
 	SetFont(settings->GetSystemFont());
@@ -135,6 +152,7 @@ frmImport::frmImport(frmMain *form, pgObject *_object, pgConn *_conn)
 
 frmImport::~frmImport()
 {
+	StopImport();
 	SavePosition();
 }
 
@@ -162,10 +180,9 @@ void frmImport::OnOK(wxCommandEvent &ev)
 	bool allColumnsToImport = true;
 	bool someColumnsToIgnoreForNulls = false;
 	wxFileName fn;
-	wxFile *file;
-	bool copydone = false;
-	bool goterror = false;
-	int nCount = 8192;
+
+	if (thread)
+		return;
 
 	if (!done)
 	{
@@ -276,83 +293,278 @@ void frmImport::OnOK(wxCommandEvent &ev)
 			return;
 		}
 
-		// Open CSV file
+		// The data is sent by a separate thread, which reports back the
+		// progress and the result
 		fn = wxFileName(pickerImportfile->GetPath());
-		file = new wxFile(fn.GetFullPath(), wxFile::read);
-
-		// Set range for gauge
-		gauge->SetRange(file->Length());
-
-		// Start COPY
-		if (!connection->StartCopy(query))
+		thread = new importThread(this, connection, fn.GetFullPath(), query);
+		if (thread->Create() != wxTHREAD_NO_ERROR)
 		{
-			goterror = true;
+			wxLogError(_("Could not start the import."));
+			delete thread;
+			thread = NULL;
+			return;
 		}
 
-		// Send COPY data
-		while (!copydone && !goterror)
+		gauge->SetRange(1000);
+		gauge->SetValue(0);
+		btnOK->Disable();
+		thread->Run();
+	}
+	else
+	{
+		Close();
+	}
+}
+
+
+void frmImport::OnImportProgress(wxCommandEvent &ev)
+{
+	if (thread)
+		gauge->SetValue(ev.GetInt());
+}
+
+
+void frmImport::OnImportDone(wxCommandEvent &ev)
+{
+	if (!thread)
+		return;
+
+	thread->Wait();
+
+	if (ev.GetInt())
+	{
+		gauge->SetValue(gauge->GetRange());
+		btnOK->SetLabel(wxT("Done"));
+		done = true;
+	}
+	else if (thread->IsCancelled())
+	{
+		gauge->SetValue(0);
+		wxLogInfo(wxT("Import cancelled"));
+	}
+	else
+	{
+		wxString msg = thread->GetErrorMessage();
+		if (msg.IsEmpty())
+			msg = connection->GetLastError();
+		wxLogError(_("Copy failed!\n") + msg);
+	}
+
+	delete thread;
+	thread = NULL;
+	btnOK->Enable();
+}
+
+
+// Cancels the import, and waits for the thread to finish
+void frmImport::StopImport()
+{
+	if (!thread)
+		return;
+
+	thread->Cancel();
+	thread->Wait();
+	delete thread;
+	thread = NULL;
+}
+
+
+void frmImport::OnCancel(wxCommandEvent &ev)
+{
+	// Stop the import first, the dialog is closed by a second click
+	if (thread)
+	{
+		thread->Cancel();
+		return;
+	}
+	pgDialog::OnCancel(ev);
+}
+
+
+void frmImport::OnClose(wxCloseEvent &ev)
+{
+	StopImport();
+	pgDialog::OnClose(ev);
+}
+
+
+importThread::importThread(wxEvtHandler *_caller, pgConn *_conn, const wxString &_filename, const wxString &_query)
+	: wxThread(wxTHREAD_JOINABLE), caller(_caller), conn(_conn), filename(_filename), query(_query),
+	  cancelled(false), readError(false), stopReading(false), freeBuffers(IMPORT_BUFFER_COUNT), filledBuffers(0),
+	  fileLength(0), lastProgress(0)
+{
+	for (int i = 0 ; i < IMPORT_BUFFER_COUNT ; i++)
+	{
+		buffers[i] = new char[IMPORT_BUFFER_SIZE];
+		lengths[i] = 0;
+		positions[i] = 0;
+	}
+}
+
+
+importThread::~importThread()
+{
+	for (int i = 0 ; i < IMPORT_BUFFER_COUNT ; i++)
+		delete[] buffers[i];
+}
+
+
+void importThread::Cancel()
+{
+	cancelled = true;
+}
+
+
+void importThread::PostProgress(wxFileOffset pos, bool force)
+{
+	wxLongLong now = wxGetLocalTimeMillis();
+
+	if (!force && now - lastProgress < IMPORT_PROGRESS_INTERVAL)
+		return;
+	lastProgress = now;
+
+	wxCommandEvent ev(wxEVT_COMMAND_MENU_SELECTED, IMPORT_PROGRESS);
+	ev.SetInt(fileLength > 0 ? (int)(pos * 1000 / fileLength) : 0);
+	caller->AddPendingEvent(ev);
+}
+
+
+void *importThread::Entry()
+{
+	bool ok = false;
+	wxFileInputStream fileStream(filename);
+
+	if (!fileStream.IsOk())
+	{
+		errorMessage = wxString::Format(_("Could not open the file %s."), filename.c_str());
+	}
+	else
+	{
+		fileLength = fileStream.GetLength();
+
+		// gzip compressed files start with 0x1f 0x8b
+		unsigned char magic[2] = {0, 0};
+		bool compressed = fileStream.Read(magic, 2).LastRead() == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+		fileStream.SeekI(0);
+
+		wxZlibInputStream *zlibStream = NULL;
+		wxInputStream *stream = &fileStream;
+		if (compressed)
+			stream = zlibStream = new wxZlibInputStream(fileStream, wxZLIB_GZIP);
+
+		// Errors are reported by the dialog
+		if (conn->StartCopy(query, false))
 		{
-			// Read a buffer
-			char *buffer = new char[nCount + 4];
-			memset(buffer, 0, nCount + 4);
-			off_t len = file->Read(buffer, nCount);
+			importReaderThread *reader = new importReaderThread(this, stream, &fileStream);
+			bool sendError = false;
 
-			// If we read something, send it to the server
-			if (len > 0)
+			if (reader->Create() != wxTHREAD_NO_ERROR)
 			{
-				if (!connection->PutCopyData(buffer, len))
-				{
-					goterror = true;
-				}
+				delete reader;
+				reader = NULL;
+				errorMessage = _("Could not start reading the file.");
+				sendError = true;
+			}
+			else
+				reader->Run();
+
+			int idx = 0;
+			while (reader && !sendError && !cancelled)
+			{
+				filledBuffers.Wait();
+
+				// An empty buffer marks the end of the file
+				if (!lengths[idx] || cancelled)
+					break;
+
+				if (!conn->PutCopyData(buffers[idx], lengths[idx]))
+					sendError = true;
 				else
+					PostProgress(positions[idx], false);
+
+				idx = (idx + 1) % IMPORT_BUFFER_COUNT;
+				freeBuffers.Post();
+			}
+
+			if (reader)
+			{
+				// Let the reader see, that it has to stop
+				if (sendError || cancelled)
 				{
-					gauge->SetValue(gauge->GetValue() + len);
-					Update();
+					stopReading = true;
+					freeBuffers.Post();
 				}
+				reader->Wait();
+				delete reader;
+
+				if (readError && errorMessage.IsEmpty())
+					errorMessage = compressed ? _("Could not read or decompress the file.") : _("Could not read the file.");
 			}
 
-			// If we read nothing, we're done
-			copydone = len == 0;
+			if (sendError || readError || cancelled)
+				conn->EndPutCopy(_("Copy failed!"));
+			else
+				ok = conn->EndPutCopy(wxEmptyString);
 
-			// Clean the buffer
-			delete[] buffer;
+			// Get final status of the COPY command
+			if (!conn->GetCopyFinalStatus(false))
+				ok = false;
 		}
 
-		// Close CSV file
-		file->Close();
+		if (zlibStream)
+			delete zlibStream;
 
-		// End COPY
-		if (goterror)
-		{
-			connection->EndPutCopy(_("Copy failed!"));
-		}
-		else
-		{
-			goterror = !connection->EndPutCopy(wxT(""));
-		}
+		if (ok)
+			PostProgress(fileLength, true);
+	}
 
-		// Get final status of the COPY command
-		if (!connection->GetCopyFinalStatus())
-		{
-			goterror = true;
-		}
+	wxCommandEvent ev(wxEVT_COMMAND_MENU_SELECTED, IMPORT_DONE);
+	ev.SetInt(ok ? 1 : 0);
+	caller->AddPendingEvent(ev);
 
-		if (goterror)
-		{
-			wxLogError(_("Copy failed!\n") + connection->GetLastError());
-		}
-		else
+	return NULL;
+}
+
+
+importReaderThread::importReaderThread(importThread *_sender, wxInputStream *_stream, wxInputStream *_file)
+	: wxThread(wxTHREAD_JOINABLE), sender(_sender), stream(_stream), file(_file)
+{
+}
+
+
+void *importReaderThread::Entry()
+{
+	int idx = 0;
+
+	while (true)
+	{
+		sender->freeBuffers.Wait();
+		if (sender->stopReading || sender->cancelled)
+			break;
+
+		size_t len;
+		do
 		{
-			btnOK->SetLabel(wxT("Done"));
-			done = true;
+			len = stream->Read(sender->buffers[idx], IMPORT_BUFFER_SIZE).LastRead();
 		}
+		while (!len && stream->GetLastError() == wxSTREAM_NO_ERROR);
+
+		if (!len && stream->GetLastError() != wxSTREAM_EOF)
+			sender->readError = true;
+
+		sender->lengths[idx] = len;
+		sender->positions[idx] = file->TellI();
+		sender->filledBuffers.Post();
+
+		if (!len)
+			break;
+		idx = (idx + 1) % IMPORT_BUFFER_COUNT;
 	}
-	else
-	{
-		Close();
-	}
+
+	return NULL;
 }
 
+
 importFactory::importFactory(menuFactoryList *list, wxMenu *mnu, ctlMenuToolbar *toolbar) : contextActionFactory(list)
 {
 	mnu->Append(id, _("&Import..."), _("Import CSV file into a relation"));
@@ -42,6 +42,9 @@
 #include "frm/frmMain.h"
 #include "ctl/ctlMenuToolbar.h"
 #include "ctl/ctlSQLBox.h"
+#include "ctl/ctlTreeLoader.h"
+#include "ctl/ctlPaneLoader.h"
+#include "ctl/ctlServerConnector.h"
 #include "db/pgConn.h"
 #include "db/pgSet.h"
 #include "agent/pgaJob.h"
@@ -166,6 +169,14 @@ frmMain::frmMain(const wxString &title)
 	dependencies = new ctlListView(listViews, CTL_DEPVIEW, wxDefaultPosition, wxDefaultSize, wxSIMPLE_BORDER);
 	dependents = new ctlListView(listViews, CTL_REFVIEW, wxDefaultPosition, wxDefaultSize, wxSIMPLE_BORDER);
 
+	browser->GetLoader()->SetPropertiesView(properties);
+
+	paneLoader = new ctlPaneLoader();
+	statistics->SetPaneLoader(paneLoader);
+	dependencies->SetPaneLoader(paneLoader);
+	dependents->SetPaneLoader(paneLoader);
+	serverConnector = new ctlServerConnector(this);
+
 
 
 	// Switch back to the native list control.
@@ -247,6 +258,10 @@ frmMain::~frmMain()
 	// Store the servers, to ensure we store the last database/schema etc
 	StoreServers();
 
+	// The servers still connecting are about to go away
+	delete serverConnector;
+	serverConnector = NULL;
+
 	settings->Write(wxT("frmMain/Perspective-") + wxString(FRMMAIN_PERSPECTIVE_VER), manager.SavePerspective());
 	manager.UnInit();
 
@@ -256,6 +271,11 @@ frmMain::~frmMain()
 	if (treeContextMenu)
 		delete treeContextMenu;
 
+	statistics->SetPaneLoader(NULL);
+	dependencies->SetPaneLoader(NULL);
+	dependents->SetPaneLoader(NULL);
+	delete paneLoader;
+
 #if defined(HAVE_OPENSSL_CRYPTO) || defined(HAVE_GCRYPT)
 	if(pgadminTunnelThread && pgadminTunnelThread->IsAlive())
 	{
@@ -786,6 +806,7 @@ void frmMain::ShowObjStatistics(pgObject *data, wxWindow *ctrl)
 
 	if ((!ctrl && statistics->IsShownOnScreen()) || ctrl == statistics)
 	{
+		paneLoader->Supersede(statistics);
 		statistics->Freeze();
 		data->ShowStatistics(this, statistics);
 		statistics->Thaw();
@@ -793,6 +814,7 @@ void frmMain::ShowObjStatistics(pgObject *data, wxWindow *ctrl)
 
 	if ((!ctrl && dependencies->IsShownOnScreen()) || ctrl == dependencies)
 	{
+		paneLoader->Supersede(dependencies);
 		dependencies->Freeze();
 		data->ShowDependencies(this, dependencies);
 		dependencies->Thaw();
@@ -800,6 +822,7 @@ void frmMain::ShowObjStatistics(pgObject *data, wxWindow *ctrl)
 
 	if ((!ctrl && dependents->IsShownOnScreen()) || ctrl == dependents)
 	{
+		paneLoader->Supersede(dependents);
 		dependents->Freeze();
 		data->ShowDependents(this, dependents);
 		dependents->Thaw();
@@ -851,7 +874,8 @@ bool frmMain::CheckAlive()
 			{
 				pgServer *server = (pgServer *)browser->GetObject(serverItem);
 
-				if (server && server->IsCreatedBy(serverFactory) && server->connection())
+				if (server && server->IsCreatedBy(serverFactory) && server->connection() &&
+				        !serverConnector->IsConnecting(server))
 				{
 					if (server->connection()->IsAlive())
 					{
@@ -1057,6 +1081,9 @@ wxTreeItemId frmMain::RestoreEnvironment(pgServer *server)
 
 int frmMain::ReconnectServer(pgServer *server, bool restore)
 {
+	// Don't wait for the background connect, if the user has asked already
+	serverConnector->Cancel(server);
+
 	// Create a server object and connect it.
 	wxBusyInfo waiting(wxString::Format(_("Connecting to server %s (%s:%d)"),
 	                                    server->GetDescription().c_str(), server->GetName().c_str(), server->GetPort()), this);
@@ -1224,6 +1251,7 @@ void frmMain::StoreServers()
 					settings->WriteBool(key + wxT("StorePwd"), server->GetStorePwd());
 					settings->Write(key + wxT("Rolename"), server->GetRolename());
 					settings->WriteBool(key + wxT("Restore"), server->GetRestore());
+					settings->WriteBool(key + wxT("Connected"), server->GetConnected());
 					settings->Write(key + wxT("Database"), server->GetDatabaseName());
 					settings->Write(key + wxT("Username"), server->GetUsername());
 					settings->Write(key + wxT("LastDatabase"), server->GetLastDatabase());
@@ -1291,6 +1319,28 @@ void frmMain::RetrieveServers()
 		browser->SetItemText(groupitem, label);
 		browser->SortChildren(groupitem);
 		browser->Expand(groupitem);
+
+		if (settings->GetReconnectServers())
+		{
+			// Connect to all of them at once, rather than one after another
+			wxTreeItemIdValue servercookie;
+			wxTreeItemId serveritem = browser->GetFirstChild(groupitem, servercookie);
+			while (serveritem)
+			{
+				pgServer *server = (pgServer *)browser->GetObject(serveritem);
+				bool wasConnected = false;
+
+				if (server && server->IsCreatedBy(serverFactory))
+				{
+					settings->Read(wxString::Format(wxT("Servers/%ld/Connected"), server->GetServerIndex()),
+					               &wasConnected, false);
+					if (wasConnected)
+						serverConnector->Connect(server);
+				}
+				serveritem = browser->GetNextChild(groupitem, servercookie);
+			}
+		}
+
 		groupitem = browser->GetNextChild(browser->GetRootItem(), groupcookie);
 	}
 }
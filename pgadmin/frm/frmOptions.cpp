@@ -880,6 +880,9 @@ void frmOptions::OnOK(wxCommandEvent &ev)
 
 	settings->SetOptionsLastTreeItem(menuSelection);
 
+	// The windows open pick up the new settings
+	settings->PublishSnapshot();
+
 	// Did any display options change? Display this message last, so it's
 	// in the selected language.
 	if (changed)
@@ -32,6 +32,7 @@
 #include "frm/menu.h"
 #include "ctl/explainCanvas.h"
 #include "db/pgConn.h"
+#include "db/pgConnPool.h"
 
 #include "ctl/ctlMenuToolbar.h"
 #include "ctl/ctlSQLResult.h"
@@ -170,6 +171,7 @@ BEGIN_EVENT_TABLE(frmQuery, pgFrame)
 	EVT_TIMER(CTL_TIMERFRM,         frmQuery::OnTimer)
 // These fire when the queries complete
 	EVT_PGQUERYRESULT(QUERY_COMPLETE, frmQuery::OnQueryComplete)
+	EVT_PGQUERYROWS(QUERY_COMPLETE, frmQuery::OnQueryRows)
 	EVT_MENU(PGSCRIPT_COMPLETE,     frmQuery::OnScriptComplete)
 	EVT_AUINOTEBOOK_PAGE_CHANGED(CTL_NTBKCENTER, frmQuery::OnChangeNotebook)
 	EVT_AUINOTEBOOK_PAGE_CHANGED(CTL_SQLQUERYBOOK, frmQuery::OnSqlBookPageChanged)
@@ -689,7 +691,7 @@ frmQuery::~frmQuery()
 
 	while (cbConnection->GetCount() > 1)
 	{
-		delete (pgConn *)cbConnection->GetClientData(0);
+		pgConnPool::Get()->Release((pgConn *)cbConnection->GetClientData(0));
 		cbConnection->Delete(0);
 	}
 
@@ -2558,7 +2560,29 @@ void frmQuery::execQuery(const wxString &query, int resultToRetrieve, bool singl
 	if (!queryMenu->IsChecked(MNU_AUTOCOMMIT) && conn->GetTxStatus() == PQTRANS_IDLE && !isBeginNotRequired(query))
 		conn->ExecuteVoid(wxT("BEGIN;"));
 
-	if (sqlResult->Execute(query, resultToRetrieve, this, QUERY_COMPLETE, qi) >= 0)
+	// Single queries are exported using COPY, so that the result does not
+	// have to be kept in memory
+	wxString copyQuery;
+	if (toFile)
+		copyQuery = qi->toFileExportForm->GetCopyQuery(conn, query);
+
+	// Results exported to a file, or used for the graphical explain, are
+	// needed completely
+	bool stream = settings->GetStreamResults() && !toFile && !explain;
+	int rc;
+
+	if (!copyQuery.IsEmpty())
+	{
+		qi->copyToFile = true;
+		// Do not count the "COPY (" in front of the query
+		qi->queryOffset += 6;
+
+		rc = sqlResult->ExecuteCopy(copyQuery, qi->toFileExportForm, this, QUERY_COMPLETE, qi);
+	}
+	else
+		rc = sqlResult->Execute(query, resultToRetrieve, this, QUERY_COMPLETE, qi, stream);
+
+	if (rc >= 0)
 	{
 		// Return and wait for the result
 		return;
@@ -2750,6 +2774,25 @@ bool frmQuery::isBeginNotRequired(wxString query)
 	return false;
 }
 
+// While streaming, the result grid shows the rows as they arrive, and
+// passes the event on to us.
+void frmQuery::OnQueryRows(pgQueryResultEvent &ev)
+{
+	if (aborted)
+		return;
+
+	if (sqlResult->NumRows() > 0 && outputPane->GetSelection() != 0)
+		outputPane->SetSelection(0);
+
+	SetStatusText(
+	    wxString::Format(
+	        wxPLURAL(
+	            "Retrieving data: %d row.",
+	            "Retrieving data: %d rows.",
+	            (int)sqlResult->NumRows()), (int)sqlResult->NumRows()),
+	    STATUSPOS_MSGS);
+}
+
 // When the query completes, it raises an event which we process here.
 void frmQuery::OnQueryComplete(pgQueryResultEvent &ev)
 {
@@ -2780,6 +2823,7 @@ void frmQuery::OnQueryComplete(pgQueryResultEvent &ev)
 
 	if (sqlResult->RunStatus() != PGRES_TUPLES_OK)
 	{
+		sqlResult->DiscardStreamedData();
 		outputPane->SetSelection(2);
 		if (sqlResult->RunStatus() == PGRES_COMMAND_OK)
 		{
@@ -2996,6 +3040,14 @@ void frmQuery::OnQueryComplete(pgQueryResultEvent &ev)
 		}
 	}
 
+	if (qi->copyToFile)
+	{
+		if (sqlResult->CopyFinished(qi->toFileExportForm))
+			SetStatusText(_("Data written to file."), STATUSPOS_MSGS);
+		else
+			SetStatusText(_("Data export aborted."), STATUSPOS_MSGS);
+	}
+
 	if (sqlResult->RunStatus() == PGRES_TUPLES_OK || sqlResult->RunStatus() == PGRES_COMMAND_OK)
 	{
 		// Get the executed query
@@ -3215,6 +3267,14 @@ void frmQuery::OnTimer(wxTimerEvent &event)
 		msgHistory->AppendText(str + wxT("\n"));
 	}
 
+	long copyRows;
+	wxLongLong copyBytes;
+	if (sqlResult->GetCopyProgress(copyRows, copyBytes))
+	{
+		SetStatusText(wxString::Format(wxPLURAL("%ld row.", "%ld rows.", copyRows), copyRows), STATUSPOS_ROWS);
+		SetStatusText(wxString::Format(_("Writing data: %s kB."), (copyBytes / 1024).ToString().c_str()), STATUSPOS_MSGS);
+	}
+
 	// Increase the granularity for longer running queries
 	if (timer.IsRunning())
 	{
@@ -28,6 +28,8 @@
 #include "frm/frmHint.h"
 #include "frm/frmMain.h"
 #include "db/pgConn.h"
+#include "db/pgConnPool.h"
+#include "db/pgQueryThread.h"
 #include "frm/frmQuery.h"
 #include "utils/pgfeatures.h"
 #include "schema/pgServer.h"
@@ -52,6 +54,22 @@
 
 #define CTRLID_DATABASE         4200
 
+// Bytes of the logfile read at once
+#define LOG_CHUNK_SIZE          1048576L
+
+
+// The value of a hex digit of a bytea
+static inline int HexValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return 0;
+}
+
 
 BEGIN_EVENT_TABLE(frmStatus, pgFrame)
 	EVT_MENU(MNU_EXIT,                            frmStatus::OnExit)
@@ -65,6 +83,8 @@ BEGIN_EVENT_TABLE(frmStatus, pgFrame)
 	EVT_MENU(MNU_LOCKPAGE,                        frmStatus::OnToggleLockPane)
 	EVT_MENU(MNU_XACTPAGE,                        frmStatus::OnToggleXactPane)
 	EVT_MENU(MNU_LOGPAGE,                         frmStatus::OnToggleLogPane)
+	EVT_MENU(MNU_HISTORYPAGE,                     frmStatus::OnToggleHistoryPane)
+	EVT_MENU(MNU_SAVEHISTORY,                     frmStatus::OnSaveHistory)
 	EVT_MENU(MNU_TOOLBAR,                         frmStatus::OnToggleToolBar)
 	EVT_MENU(MNU_DEFAULTVIEW,                     frmStatus::OnDefaultView)
 	EVT_MENU(MNU_HIGHLIGHTSTATUS,                 frmStatus::OnHighlightStatus)
@@ -95,6 +115,10 @@ BEGIN_EVENT_TABLE(frmStatus, pgFrame)
 	EVT_LIST_COL_CLICK(CTL_LOCKLIST,              frmStatus::OnSortLockGrid)
 	EVT_LIST_COL_RIGHT_CLICK(CTL_LOCKLIST,        frmStatus::OnRightClickLockGrid)
 	EVT_LIST_COL_END_DRAG(CTL_LOCKLIST,           frmStatus::OnChgColSizeLockGrid)
+	EVT_CHOICE(CTL_LOCKVIEW,                      frmStatus::OnLockView)
+	EVT_LIST_ITEM_SELECTED(CTL_BLOCKLIST,         frmStatus::OnSelLockItem)
+	EVT_LIST_ITEM_DESELECTED(CTL_BLOCKLIST,       frmStatus::OnSelLockItem)
+	EVT_LIST_ITEM_ACTIVATED(CTL_BLOCKLIST,        frmStatus::OnBlockItemActivated)
 
 	EVT_TIMER(TIMER_XACT_ID,                      frmStatus::OnRefreshXactTimer)
 	EVT_LIST_ITEM_SELECTED(CTL_XACTLIST,          frmStatus::OnSelXactItem)
@@ -106,6 +130,15 @@ BEGIN_EVENT_TABLE(frmStatus, pgFrame)
 	EVT_TIMER(TIMER_LOG_ID,                       frmStatus::OnRefreshLogTimer)
 	EVT_LIST_ITEM_SELECTED(CTL_LOGLIST,           frmStatus::OnSelLogItem)
 	EVT_LIST_ITEM_DESELECTED(CTL_LOGLIST,         frmStatus::OnSelLogItem)
+	EVT_PGQUERYRESULT(QUERY_LOG_ID,               frmStatus::OnLogResult)
+	EVT_CHOICE(CTL_LOGLEVEL,                      frmStatus::OnLogFilter)
+	EVT_TEXT(CTL_LOGFILTER,                       frmStatus::OnLogFilter)
+
+	EVT_PGQUERYRESULT(QUERY_REFRESH_ID,           frmStatus::OnRefreshResult)
+
+	EVT_TIMER(TIMER_HISTORY_ID,                   frmStatus::OnRefreshHistoryTimer)
+	EVT_PGQUERYRESULT(QUERY_HISTORY_ID,           frmStatus::OnHistoryResult)
+	EVT_CHOICE(CTL_HISTORYSPAN,                   frmStatus::OnHistorySpan)
 
 	EVT_COMBOBOX(CTRLID_DATABASE,                 frmStatus::OnChangeDatabase)
 
@@ -173,7 +206,6 @@ wxString frmStatus::rateToCboString(int rate)
 
 frmStatus::frmStatus(frmMain *form, const wxString &_title, pgConn *conn) : pgFrame(NULL, _title)
 {
-	wxString initquery;
 	bool highlight = false;
 
 	dlgName = wxT("frmStatus");
@@ -184,29 +216,40 @@ frmStatus::frmStatus(frmMain *form, const wxString &_title, pgConn *conn) : pgFr
 	connection = conn;
 	locks_connection = conn;
 
+	refresh_connection = NULL;
+	refresh_pid = 0;
+	refreshFailed = false;
+	for (int pane = 0; pane <= PANE_XACT; pane++)
+	{
+		refreshThreads[pane] = NULL;
+		refreshAgain[pane] = false;
+	}
+
+	refreshBlocking = false;
+	lockGraph = new waitForGraph();
+
+	history = new statusHistory();
+	history_connection = NULL;
+	historyThread = NULL;
+	history_pid = 0;
+	historyFailed = false;
+
+	log_connection = NULL;
+	logThread = NULL;
+	log_pid = 0;
+	logFailed = false;
+	logSkipFirst = false;
+
 	statusTimer = 0;
 	locksTimer = 0;
 	xactTimer = 0;
 	logTimer = 0;
+	historyTimer = 0;
 
 	logHasTimestamp = false;
 	logFormatKnown = false;
 
-	// Only superusers can set these parameters...
-	pgUser *user = new pgUser(connection->GetUser());
-	if (user)
-	{
-		if (user->GetSuperuser())
-		{
-			// Make the connection quiet on the logs
-			if (connection->BackendMinimumVersion(8, 0))
-				initquery = wxT("SET log_statement='none';SET log_duration='off';SET log_min_duration_statement=-1;");
-			else
-				initquery = wxT("SET log_statement='off';SET log_duration='off';SET log_min_duration_statement=-1;");
-			connection->ExecuteVoid(initquery, false);
-		}
-		delete user;
-	}
+	SetQuietLogging(connection);
 
 	// Notify wxAUI which frame to use
 	manager.SetManagedWindow(this);
@@ -223,6 +266,8 @@ frmStatus::frmStatus(frmMain *form, const wxString &_title, pgConn *conn) : pgFr
 	menuBar = new wxMenuBar();
 
 	fileMenu = new wxMenu();
+	fileMenu->Append(MNU_SAVEHISTORY, _("Save activity &history..."), _("Save the activity history as CSV file"));
+	fileMenu->AppendSeparator();
 	fileMenu->Append(MNU_EXIT, _("E&xit\tCtrl-W"), _("Exit query window"));
 
 	menuBar->Append(fileMenu, _("&File"));
@@ -249,6 +294,7 @@ frmStatus::frmStatus(frmMain *form, const wxString &_title, pgConn *conn) : pgFr
 	viewMenu->Append(MNU_LOCKPAGE, _("&Locks\tCtrl-Alt-L"), _("Show or hide the locks tab."), wxITEM_CHECK);
 	viewMenu->Append(MNU_XACTPAGE, _("Prepared &Transactions\tCtrl-Alt-T"), _("Show or hide the prepared transactions tab."), wxITEM_CHECK);
 	viewMenu->Append(MNU_LOGPAGE, _("Log&file\tCtrl-Alt-F"), _("Show or hide the logfile tab."), wxITEM_CHECK);
+	viewMenu->Append(MNU_HISTORYPAGE, _("Activity &history\tCtrl-Alt-H"), _("Show or hide the activity history tab."), wxITEM_CHECK);
 	viewMenu->AppendSeparator();
 	viewMenu->Append(MNU_TOOLBAR, _("Tool&bar\tCtrl-Alt-B"), _("Show or hide the toolbar."), wxITEM_CHECK);
 	viewMenu->Append(MNU_HIGHLIGHTSTATUS, _("Highlight items of the activity list"), _("Highlight or not the items of the activity list."), wxITEM_CHECK);
@@ -349,6 +395,7 @@ frmStatus::frmStatus(frmMain *form, const wxString &_title, pgConn *conn) : pgFr
 	AddLockPane();
 	AddXactPane();
 	AddLogPane();
+	AddHistoryPane();
 	manager.AddPane(toolBar, wxAuiPaneInfo().Name(wxT("toolBar")).Caption(_("Tool bar")).ToolbarPane().Top().LeftDockable(false).RightDockable(false));
 
 	// Now load the layout
@@ -362,6 +409,7 @@ frmStatus::frmStatus(frmMain *form, const wxString &_title, pgConn *conn) : pgFr
 	manager.GetPane(wxT("Locks")).Caption(_("Locks"));
 	manager.GetPane(wxT("Transactions")).Caption(_("Prepared Transactions"));
 	manager.GetPane(wxT("Logfile")).Caption(_("Logfile"));
+	manager.GetPane(wxT("History")).Caption(_("Activity history"));
 
 	// Tell the manager to "commit" all the changes just made
 	manager.Update();
@@ -371,6 +419,7 @@ frmStatus::frmStatus(frmMain *form, const wxString &_title, pgConn *conn) : pgFr
 	viewMenu->Check(MNU_LOCKPAGE, manager.GetPane(wxT("Locks")).IsShown());
 	viewMenu->Check(MNU_XACTPAGE, manager.GetPane(wxT("Transactions")).IsShown());
 	viewMenu->Check(MNU_LOGPAGE, manager.GetPane(wxT("Logfile")).IsShown());
+	viewMenu->Check(MNU_HISTORYPAGE, manager.GetPane(wxT("History")).IsShown());
 	viewMenu->Check(MNU_TOOLBAR, manager.GetPane(wxT("toolBar")).IsShown());
 
 	// Read the highlight status checkbox
@@ -417,6 +466,7 @@ frmStatus::~frmStatus()
 	settings->WriteInt(wxT("frmStatus/RefreshStatusRate"), statusRate);
 	delete statusTimer;
 	settings->WriteInt(wxT("frmStatus/RefreshLockRate"), locksRate);
+	settings->WriteInt(wxT("frmStatus/LockView"), cbLockView->GetSelection());
 	delete locksTimer;
 	if (viewMenu->IsEnabled(MNU_XACTPAGE))
 	{
@@ -438,17 +488,40 @@ frmStatus::~frmStatus()
 		}
 	}
 
-	// If connection is still available, delete it
-	if (locks_connection && locks_connection != connection)
+	settings->WriteInt(wxT("frmStatus/HistorySpan"), cbHistorySpan->GetSelection());
+	if (historyTimer)
 	{
-		if (locks_connection->IsAlive())
-			delete locks_connection;
+		delete historyTimer;
+		historyTimer = NULL;
 	}
-	if (connection)
+
+	// The refreshes still running must not outlive the connections
+	StopRefresh(PANE_STATUS);
+	StopRefresh(PANE_LOCKS);
+	StopRefresh(PANE_XACT);
+	if (refresh_connection)
+		delete refresh_connection;
+	if (historyThread)
 	{
-		if (connection->IsAlive())
-			delete connection;
+		historyThread->CancelExecution();
+		historyThread->Wait();
+		delete historyThread;
+		historyThread = NULL;
 	}
+	if (history_connection)
+		delete history_connection;
+	stopLogRead();
+	if (log_connection)
+		delete log_connection;
+
+	// Keep the connections for the next window, if still available
+	if (locks_connection && locks_connection != connection)
+		pgConnPool::Get()->Release(locks_connection);
+	if (connection)
+		pgConnPool::Get()->Release(connection);
+
+	delete history;
+	delete lockGraph;
 }
 
 
@@ -487,6 +560,14 @@ void frmStatus::Go()
 	// Refresh all pages
 	wxCommandEvent nullEvent;
 	OnRefresh(nullEvent);
+
+	// The history is sampled as long as the window is open, shown or not
+	if (historyTimer)
+	{
+		wxTimerEvent evt;
+		historyTimer->Start(1000);
+		OnRefreshHistoryTimer(evt);
+	}
 }
 
 
@@ -504,7 +585,7 @@ void frmStatus::OnExit(wxCommandEvent &event)
 
 void frmStatus::OnChangeDatabase(wxCommandEvent &ev)
 {
-	wxString initquery;
+	StopRefresh(PANE_LOCKS);
 
 	if (locks_connection != connection)
 	{
@@ -516,16 +597,26 @@ void frmStatus::OnChangeDatabase(wxCommandEvent &ev)
 	                              0, connection->GetApplicationName(), connection->GetSSLCert(), connection->GetSSLKey(), connection->GetSSLRootCert(), connection->GetSSLCrl(),
 	                              connection->GetSSLCompression());
 
-	pgUser *user = new pgUser(locks_connection->GetUser());
+	SetQuietLogging(locks_connection);
+}
+
+
+void frmStatus::SetQuietLogging(pgConn *conn)
+{
+	wxString initquery;
+
+	// Only superusers can set these parameters...
+	pgUser *user = new pgUser(conn->GetUser());
 	if (user)
 	{
 		if (user->GetSuperuser())
 		{
-			if (locks_connection->BackendMinimumVersion(8, 0))
+			// Make the connection quiet on the logs
+			if (conn->BackendMinimumVersion(8, 0))
 				initquery = wxT("SET log_statement='none';SET log_duration='off';SET log_min_duration_statement=-1;");
 			else
 				initquery = wxT("SET log_statement='off';SET log_duration='off';SET log_min_duration_statement=-1;");
-			locks_connection->ExecuteVoid(initquery, false);
+			conn->ExecuteVoid(initquery, false);
 		}
 		delete user;
 	}
@@ -548,12 +639,12 @@ void frmStatus::AddStatusPane()
 	// Disable sort on Mac.
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), true);
 #endif
-	wxListCtrl *lstStatus = new wxListCtrl(pnlActivity, CTL_STATUSLIST, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxSUNKEN_BORDER);
+	statusList = new ctlStatusList(pnlActivity, CTL_STATUSLIST, wxDefaultPosition, wxDefaultSize, wxSUNKEN_BORDER);
 	// Now switch back
 #ifdef __WXMAC__
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), false);
 #endif
-	grdActivity->Add(lstStatus, 0, wxGROW, 3);
+	grdActivity->Add(statusList, 0, wxGROW, 3);
 
 	// Add the panel to the notebook
 	manager.AddPane(pnlActivity,
@@ -567,7 +658,6 @@ void frmStatus::AddStatusPane()
 	grdActivity->Fit(pnlActivity);
 
 	// Add each column to the list control
-	statusList = (ctlListView *)lstStatus;
 	statusList->AddColumn(_("PID"), 35);
 	if (connection->BackendMinimumVersion(8, 5))
 		statusList->AddColumn(_("Application name"), 70);
@@ -642,22 +732,44 @@ void frmStatus::AddLockPane()
 	wxPanel *pnlLock = new wxPanel(this);
 
 	// Create flex grid
-	wxFlexGridSizer *grdLock = new wxFlexGridSizer(1, 1, 5, 5);
+	wxFlexGridSizer *grdLock = new wxFlexGridSizer(2, 1, 5, 5);
 	grdLock->AddGrowableCol(0);
-	grdLock->AddGrowableRow(0);
+	grdLock->AddGrowableRow(1);
 
-	// Add the list control
+	// All the locks, or only who blocks whom
+	wxBoxSizer *sizView = new wxBoxSizer(wxHORIZONTAL);
+	cbLockView = new wxChoice(pnlLock, CTL_LOCKVIEW);
+	cbLockView->Append(_("All locks"));
+	// The blockers are found by comparing the locks of the sessions
+	if (locks_connection->BackendMinimumVersion(8, 3))
+		cbLockView->Append(_("Blocking chains"));
+	int lockView = LOCKVIEW_ALL;
+	settings->Read(wxT("frmStatus/LockView"), &lockView, LOCKVIEW_ALL);
+	cbLockView->SetSelection(lockView < (int)cbLockView->GetCount() ? lockView : LOCKVIEW_ALL);
+	stLockSummary = new wxStaticText(pnlLock, -1, wxEmptyString);
+	sizView->Add(new wxStaticText(pnlLock, -1, _("Show:")), 0, wxALL | wxALIGN_CENTER_VERTICAL, 3);
+	sizView->Add(cbLockView, 0, wxALL, 3);
+	sizView->Add(stLockSummary, 1, wxALL | wxALIGN_CENTER_VERTICAL, 3);
+	grdLock->Add(sizView, 0, wxGROW, 3);
+
+	// Add the list controls, only one of them being shown
 #ifdef __WXMAC__
 	// Switch to the generic list control.
 	// Disable sort on Mac.
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), true);
 #endif
-	wxListCtrl *lstLocks = new wxListCtrl(pnlLock, CTL_LOCKLIST, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxSUNKEN_BORDER);
+	lockList = new ctlStatusList(pnlLock, CTL_LOCKLIST, wxDefaultPosition, wxDefaultSize, wxSUNKEN_BORDER);
+	blockList = new ctlStatusList(pnlLock, CTL_BLOCKLIST, wxDefaultPosition, wxDefaultSize, wxSUNKEN_BORDER);
 	// Now switch back
 #ifdef __WXMAC__
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), false);
 #endif
-	grdLock->Add(lstLocks, 0, wxGROW, 3);
+	wxBoxSizer *sizLists = new wxBoxSizer(wxVERTICAL);
+	sizLists->Add(lockList, 1, wxGROW);
+	sizLists->Add(blockList, 1, wxGROW);
+	grdLock->Add(sizLists, 0, wxGROW, 3);
+	sizLists->Show(lockList, !IsBlockingView());
+	sizLists->Show(blockList, IsBlockingView());
 
 	// Add the panel to the notebook
 	manager.AddPane(pnlLock,
@@ -671,7 +783,6 @@ void frmStatus::AddLockPane()
 	grdLock->Fit(pnlLock);
 
 	// Add each column to the list control
-	lockList = (ctlListView *)lstLocks;
 	lockList->AddColumn(wxT("PID"), 35);
 	lockList->AddColumn(_("Database"), 50);
 	lockList->AddColumn(_("Relation"), 50);
@@ -685,6 +796,17 @@ void frmStatus::AddLockPane()
 		lockList->AddColumn(_("Start"), 50);
 	lockList->AddColumn(_("Query"), 500);
 
+	// The sessions below the one they wait for, and the number of
+	// sessions waiting behind each one
+	blockList->AddColumn(wxT("PID"), 80);
+	blockList->AddColumn(_("Blocked"), 50);
+	blockList->AddColumn(_("Waiting"), 60);
+	blockList->AddColumn(_("User"), 50);
+	blockList->AddColumn(_("Database"), 50);
+	blockList->AddColumn(_("Mode"), 50);
+	blockList->AddColumn(_("Relation"), 50);
+	blockList->AddColumn(_("Query"), 500);
+
 	// Get through the list of columns to build the popup menu
 	lockPopupMenu = new wxMenu();
 	wxListItem item;
@@ -741,12 +863,12 @@ void frmStatus::AddXactPane()
 	// Disable sort on Mac.
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), true);
 #endif
-	wxListCtrl *lstXacts = new wxListCtrl(pnlXacts, CTL_XACTLIST, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxSUNKEN_BORDER);
+	xactList = new ctlStatusList(pnlXacts, CTL_XACTLIST, wxDefaultPosition, wxDefaultSize, wxSUNKEN_BORDER);
 	// Now switch back
 #ifdef __WXMAC__
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), false);
 #endif
-	grdXacts->Add(lstXacts, 0, wxGROW, 3);
+	grdXacts->Add(xactList, 0, wxGROW, 3);
 
 	// Add the panel to the notebook
 	manager.AddPane(pnlXacts,
@@ -759,9 +881,6 @@ void frmStatus::AddXactPane()
 	pnlXacts->SetSizer(grdXacts);
 	grdXacts->Fit(pnlXacts);
 
-	// Add the xact list
-	xactList = (ctlListView *)lstXacts;
-
 	// We don't need this report if server release is less than 8.1
 	// GPDB doesn't have external global transactions.
 	// Perhaps we should use this display to show our
@@ -769,9 +888,14 @@ void frmStatus::AddXactPane()
 	if (!connection->BackendMinimumVersion(8, 1) || connection->GetIsGreenplum())
 	{
 		// manager.GetPane(wxT("Transactions")).Show(false);
-		lstXacts->InsertColumn(lstXacts->GetColumnCount(), _("Message"), wxLIST_FORMAT_LEFT, 800);
-		lstXacts->InsertItem(lstXacts->GetItemCount(), _("Prepared transactions not available on this server."), -1);
-		lstXacts->Enable(false);
+		statusListRowArray rows;
+		statusListRow *row = new statusListRow(wxEmptyString);
+		row->values.Add(_("Prepared transactions not available on this server."));
+		rows.Add(row);
+
+		xactList->InsertColumn(xactList->GetColumnCount(), _("Message"), wxLIST_FORMAT_LEFT, 800);
+		xactList->SetRows(rows);
+		xactList->Enable(false);
 		xactTimer = NULL;
 
 		// We're done
@@ -834,9 +958,28 @@ void frmStatus::AddLogPane()
 	wxPanel *pnlLog = new wxPanel(this);
 
 	// Create flex grid
-	wxFlexGridSizer *grdLog = new wxFlexGridSizer(1, 1, 5, 5);
+	wxFlexGridSizer *grdLog = new wxFlexGridSizer(2, 1, 5, 5);
 	grdLog->AddGrowableCol(0);
-	grdLog->AddGrowableRow(0);
+	grdLog->AddGrowableRow(1);
+
+	// The filter of the lines shown
+	wxBoxSizer *sizFilter = new wxBoxSizer(wxHORIZONTAL);
+	cbLogLevel = new wxChoice(pnlLog, CTL_LOGLEVEL);
+	cbLogLevel->Append(_("All"));
+	cbLogLevel->Append(wxT("LOG"));
+	cbLogLevel->Append(wxT("INFO"));
+	cbLogLevel->Append(wxT("NOTICE"));
+	cbLogLevel->Append(wxT("WARNING"));
+	cbLogLevel->Append(wxT("ERROR"));
+	cbLogLevel->Append(wxT("FATAL"));
+	cbLogLevel->Append(wxT("PANIC"));
+	cbLogLevel->SetSelection(0);
+	txtLogFilter = new wxTextCtrl(pnlLog, CTL_LOGFILTER);
+	sizFilter->Add(new wxStaticText(pnlLog, -1, _("Minimum level:")), 0, wxALL | wxALIGN_CENTER_VERTICAL, 3);
+	sizFilter->Add(cbLogLevel, 0, wxALL, 3);
+	sizFilter->Add(new wxStaticText(pnlLog, -1, _("Containing:")), 0, wxALL | wxALIGN_CENTER_VERTICAL, 3);
+	sizFilter->Add(txtLogFilter, 1, wxALL, 3);
+	grdLog->Add(sizFilter, 0, wxGROW, 3);
 
 	// Add the list control
 #ifdef __WXMAC__
@@ -844,12 +987,12 @@ void frmStatus::AddLogPane()
 	// Disable sort on Mac.
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), true);
 #endif
-	wxListCtrl *lstLog = new wxListCtrl(pnlLog, CTL_LOGLIST, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxSUNKEN_BORDER);
+	logList = new ctlLogList(pnlLog, CTL_LOGLIST, wxDefaultPosition, wxDefaultSize, wxSUNKEN_BORDER);
 	// Now switch back
 #ifdef __WXMAC__
 	wxSystemOptions::SetOption(wxT("mac.listctrl.always_use_generic"), false);
 #endif
-	grdLog->Add(lstLog, 0, wxGROW, 3);
+	grdLog->Add(logList, 0, wxGROW, 3);
 
 	// Add the panel to the notebook
 	manager.AddPane(pnlLog,
@@ -862,8 +1005,11 @@ void frmStatus::AddLogPane()
 	pnlLog->SetSizer(grdLog);
 	grdLog->Fit(pnlLog);
 
-	// Add the log list
-	logList = (ctlListView *)lstLog;
+	// The number of lines kept
+	long logLines;
+	settings->Read(wxT("frmStatus/LogLines"), &logLines, LOGLIST_CAPACITY);
+	if (logLines != LOGLIST_CAPACITY && logLines > 0)
+		logList->SetCapacity(logLines);
 
 	// We don't need this report (but we need the pane)
 	// if server release is less than 8.0 or if server has no adminpack
@@ -891,8 +1037,11 @@ void frmStatus::AddLogPane()
 		if (!connection->HasFeature(FEATURE_FILEREAD, true))
 		{
 			logList->InsertColumn(logList->GetColumnCount(), _("Message"), wxLIST_FORMAT_LEFT, 800);
-			logList->InsertItem(logList->GetItemCount(), _("Logs are not available for this server."), -1);
+			logList->AddRow()->SetText(0, _("Logs are not available for this server."));
+			logList->ShowAddedRows();
 			logList->Enable(false);
+			cbLogLevel->Enable(false);
+			txtLogFilter->Enable(false);
 			logTimer = NULL;
 			// We're done
 			return;
@@ -943,6 +1092,12 @@ void frmStatus::AddLogPane()
 		logList->AddColumn(_("Log entry"), 800);
 	}
 
+	// Continuation lines get the level of the line before them
+	if (logFormatKnown)
+		logList->SetLevelColumn(logHasTimestamp ? 1 : 0);
+	else
+		cbLogLevel->Enable(false);
+
 	if (!connection->HasFeature(FEATURE_ROTATELOG))
 		btnRotateLog->Disable();
 
@@ -957,25 +1112,98 @@ void frmStatus::AddLogPane()
 }
 
 
+void frmStatus::AddHistoryPane()
+{
+	// Create panel
+	wxPanel *pnlHistory = new wxPanel(this);
+
+	// Create flex grid
+	wxFlexGridSizer *grdHistory = new wxFlexGridSizer(2, 1, 5, 5);
+	grdHistory->AddGrowableCol(0);
+	grdHistory->AddGrowableRow(1);
+
+	// The time span shown, and the graphs
+	cbHistorySpan = new wxChoice(pnlHistory, CTL_HISTORYSPAN);
+	cbHistorySpan->Append(_("Last 5 minutes"));
+	cbHistorySpan->Append(_("Last hour"));
+	cbHistorySpan->Append(_("Last 24 hours"));
+	grdHistory->Add(cbHistorySpan, 0, wxALL, 3);
+
+	historyGraph = new ctlStatusGraph(pnlHistory, -1, history);
+	grdHistory->Add(historyGraph, 0, wxGROW, 3);
+
+	// Add the panel to the notebook
+	manager.AddPane(pnlHistory,
+	                wxAuiPaneInfo().
+	                Name(wxT("History")).Caption(_("Activity history")).
+	                CaptionVisible(true).CloseButton(true).MaximizeButton(true).
+	                Dockable(true).Movable(true));
+
+	// Auto-sizing
+	pnlHistory->SetSizer(grdHistory);
+	grdHistory->Fit(pnlHistory);
+
+	// Read the span configuration
+	int span;
+	settings->Read(wxT("frmStatus/HistorySpan"), &span, 0);
+	if (span < 0 || span >= (int)cbHistorySpan->GetCount())
+		span = 0;
+	cbHistorySpan->SetSelection(span);
+	wxCommandEvent ev;
+	OnHistorySpan(ev);
+
+	// The tuples read and written are counted since 8.3
+	if (!connection->BackendMinimumVersion(8, 3))
+	{
+		historyGraph->SetMessage(_("The activity history is not available on this server."));
+		cbHistorySpan->Enable(false);
+		fileMenu->Enable(MNU_SAVEHISTORY, false);
+		historyTimer = NULL;
+
+		// We're done
+		return;
+	}
+
+	// All the readings of a sample at once, the counters summed up over
+	// the databases
+	wxString pidcol = connection->BackendMinimumVersion(9, 2) ? wxT("pid") : wxT("procpid");
+	wxString active = connection->BackendMinimumVersion(9, 2) ? wxT("state='active'") : wxT("current_query NOT LIKE '<IDLE>%'");
+
+	historyQuery = wxT("SELECT sum(xact_commit + xact_rollback)::int8 AS xacts, ")
+	               wxT("sum(tup_returned)::int8 AS tup_read, ")
+	               wxT("sum(tup_inserted + tup_updated + tup_deleted)::int8 AS tup_written, ")
+	               wxT("sum(blks_hit)::int8 AS blks_hit, sum(blks_read)::int8 AS blks_read,\n")
+	               wxT("(SELECT count(*) FROM pg_stat_activity WHERE ") + active +
+	               wxT(" AND ") + pidcol + wxT("<>pg_backend_pid()) AS active,\n")
+	               wxT("(SELECT count(DISTINCT pid) FROM pg_locks WHERE NOT granted) AS waiting\n")
+	               wxT("FROM pg_stat_database");
+
+	// Create the timer
+	historyTimer = new wxTimer(this, TIMER_HISTORY_ID);
+}
+
+
 void frmStatus::OnCopy(wxCommandEvent &ev)
 {
 	ctlListView *list;
+	ctlStatusList *rows = NULL;
+	ctlLogList *logRows = NULL;
 	int row, col;
 	wxString text;
 
 	switch(currentPane)
 	{
 		case PANE_STATUS:
-			list = statusList;
+			list = rows = statusList;
 			break;
 		case PANE_LOCKS:
-			list = lockList;
+			list = rows = GetLockList();
 			break;
 		case PANE_XACT:
-			list = xactList;
+			list = rows = xactList;
 			break;
 		case PANE_LOG:
-			list = logList;
+			list = logRows = logList;
 			break;
 		default:
 			// This shouldn't happen.
@@ -990,7 +1218,8 @@ void frmStatus::OnCopy(wxCommandEvent &ev)
 	{
 		for (col = 0; col < list->GetColumnCount(); col++)
 		{
-			text.Append(list->GetText(row, col) + wxT("\t"));
+			// The virtual lists know only the rows they show
+			text.Append((rows ? rows->GetText(row, col) : logRows->GetText(row, col)) + wxT("\t"));
 		}
 #ifdef __WXMSW__
 		text.Append(wxT("\r\n"));
@@ -1010,7 +1239,7 @@ void frmStatus::OnCopy(wxCommandEvent &ev)
 
 void frmStatus::OnCopyQuery(wxCommandEvent &ev)
 {
-	ctlListView *list;
+	ctlStatusList *list;
 	int row, col;
 	wxString text = wxT("");
 	wxString dbname = wxT("");
@@ -1021,12 +1250,13 @@ void frmStatus::OnCopyQuery(wxCommandEvent &ev)
 
 	// Get the database
 	row = list->GetFirstSelected();
+	if (row < 0)
+		return;
 	col = connection->BackendMinimumVersion(9, 0) ? 2 : 1;
 	dbname.Append(list->GetText(row, col));
 
-	// Get the actual query
-	row = list->GetFirstSelected();
-	text.Append(queries.Item(row));
+	// Get the actual query, which is the last column
+	text.Append(list->GetText(row, list->GetColumnCount() - 1));
 
 	// Check if we have a query whose length is maximum
 	maxlength = 1024;
@@ -1091,6 +1321,8 @@ void frmStatus::OnPaneClose(wxAuiManagerEvent &evt)
 		if (logTimer)
 			logTimer->Stop();
 	}
+	if (evt.pane->name == wxT("History"))
+		viewMenu->Check(MNU_HISTORYPAGE, false);
 }
 
 
@@ -1176,6 +1408,16 @@ void frmStatus::OnToggleLogPane(wxCommandEvent &event)
 }
 
 
+void frmStatus::OnToggleHistoryPane(wxCommandEvent &event)
+{
+	// Sampling goes on while hidden
+	manager.GetPane(wxT("History")).Show(viewMenu->IsChecked(MNU_HISTORYPAGE));
+
+	// Tell the manager to "commit" all the changes just made
+	manager.Update();
+}
+
+
 void frmStatus::OnToggleToolBar(wxCommandEvent &event)
 {
 	if (viewMenu->IsChecked(MNU_TOOLBAR))
@@ -1202,6 +1444,7 @@ void frmStatus::OnDefaultView(wxCommandEvent &event)
 	manager.GetPane(wxT("Locks")).Caption(_("Locks"));
 	manager.GetPane(wxT("Transactions")).Caption(_("Prepared Transactions"));
 	manager.GetPane(wxT("Logfile")).Caption(_("Logfile"));
+	manager.GetPane(wxT("History")).Caption(_("Activity history"));
 
 	// tell the manager to "commit" all the changes just made
 	manager.Update();
@@ -1212,6 +1455,7 @@ void frmStatus::OnDefaultView(wxCommandEvent &event)
 	viewMenu->Check(MNU_LOCKPAGE, manager.GetPane(wxT("Locks")).IsShown());
 	viewMenu->Check(MNU_XACTPAGE, manager.GetPane(wxT("Transactions")).IsShown());
 	viewMenu->Check(MNU_LOGPAGE, manager.GetPane(wxT("Logfile")).IsShown());
+	viewMenu->Check(MNU_HISTORYPAGE, manager.GetPane(wxT("History")).IsShown());
 }
 
 
@@ -1315,10 +1559,6 @@ void frmStatus::OnRefreshUITimer(wxTimerEvent &event)
 
 void frmStatus::OnRefreshStatusTimer(wxTimerEvent &event)
 {
-	long pid = 0;
-	wxString pidcol = connection->BackendMinimumVersion(9, 2) ? wxT("p.pid") : wxT("p.procpid");
-	wxString querycol = connection->BackendMinimumVersion(9, 2) ? wxT("query") : wxT("current_query");
-
 	if (! viewMenu->IsChecked(MNU_STATUSPAGE))
 		return;
 
@@ -1334,9 +1574,15 @@ void frmStatus::OnRefreshStatusTimer(wxTimerEvent &event)
 		return;
 	}
 
-	wxCriticalSectionLocker lock(gs_critsect);
+	// Don't pile up the queries on a busy server
+	if (refreshThreads[PANE_STATUS])
+	{
+		refreshAgain[PANE_STATUS] = true;
+		return;
+	}
 
-	long row = 0;
+	wxString pidcol = connection->BackendMinimumVersion(9, 2) ? wxT("p.pid") : wxT("p.procpid");
+	wxString querycol = connection->BackendMinimumVersion(9, 2) ? wxT("query") : wxT("current_query");
 	wxString q = wxT("SELECT ");
 
 	// PID
@@ -1419,119 +1665,99 @@ void frmStatus::OnRefreshStatusTimer(wxTimerEvent &event)
 	q += wxT("FROM pg_stat_activity p ")
 	     wxT("ORDER BY ") + NumToStr((long)statusSortColumn) + wxT(" ") + statusSortOrder;
 
-	pgSet *dataSet1 = connection->ExecuteSet(q);
-	if (dataSet1)
-	{
-		statusBar->SetStatusText(_("Refreshing status list."));
-		statusList->Freeze();
+	statusBar->SetStatusText(_("Refreshing status list."));
+	RunRefresh(PANE_STATUS, q);
+}
 
-		// Clear the queries array content
-		queries.Clear();
 
-		while (!dataSet1->Eof())
-		{
-			pid = dataSet1->GetLong(wxT("pid"));
+void frmStatus::FillStatusList(pgSet *dataSet1)
+{
+	statusListRowArray rows;
+	long pid = 0;
 
-			// Update the UI
-			if (pid != backend_pid)
-			{
-				// Add the query content to the queries array
-				queries.Add(dataSet1->GetVal(wxT("query")));
+	// The colours are the same for all the rows
+	bool highlight = viewMenu->IsChecked(MNU_HIGHLIGHTSTATUS);
+	wxColour activeColour(settings->GetActiveProcessColour());
+	wxColour idleColour(settings->GetIdleProcessColour());
+	wxColour blockedColour(settings->GetBlockedProcessColour());
+	wxColour slowColour(settings->GetSlowProcessColour());
 
-				if (row >= statusList->GetItemCount())
-				{
-					statusList->InsertItem(row, NumToStr(pid), -1);
-					row = statusList->GetItemCount() - 1;
-				}
-				else
-				{
-					statusList->SetItem(row, 0, NumToStr(pid));
-				}
+	while (!dataSet1->Eof())
+	{
+		pid = dataSet1->GetLong(wxT("pid"));
 
-				wxString qry = dataSet1->GetVal(wxT("query"));
+		if (!IsOwnBackend(pid))
+		{
+			statusListRow *row = new statusListRow(NumToStr(pid));
+			wxArrayString &values = row->values;
+			wxString qry = dataSet1->GetVal(wxT("query"));
 
-				int colpos = 1;
-				if (connection->BackendMinimumVersion(8, 5))
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("application_name")));
-				statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("datname")));
-				statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("usename")));
+			values.Add(NumToStr(pid));
+			if (connection->BackendMinimumVersion(8, 5))
+				values.Add(dataSet1->GetVal(wxT("application_name")));
+			values.Add(dataSet1->GetVal(wxT("datname")));
+			values.Add(dataSet1->GetVal(wxT("usename")));
 
-				if (connection->BackendMinimumVersion(8, 1))
-				{
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("client")));
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("backend_start")));
-				}
-				if (connection->BackendMinimumVersion(7, 4))
-				{
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("query_start")));
-				}
+			if (connection->BackendMinimumVersion(8, 1))
+			{
+				values.Add(dataSet1->GetVal(wxT("client")));
+				values.Add(dataSet1->GetVal(wxT("backend_start")));
+			}
+			if (connection->BackendMinimumVersion(7, 4))
+			{
+				values.Add(dataSet1->GetVal(wxT("query_start")));
+			}
 
-				if (connection->BackendMinimumVersion(8, 3))
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("xact_start")));
+			if (connection->BackendMinimumVersion(8, 3))
+				values.Add(dataSet1->GetVal(wxT("xact_start")));
 
-				if (connection->BackendMinimumVersion(9, 2))
-				{
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("state")));
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("state_change")));
-				}
+			if (connection->BackendMinimumVersion(9, 2))
+			{
+				values.Add(dataSet1->GetVal(wxT("state")));
+				values.Add(dataSet1->GetVal(wxT("state_change")));
+			}
 
-				if (connection->BackendMinimumVersion(9, 4))
-				{
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("backend_xid")));
-					statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("backend_xmin")));
-				}
+			if (connection->BackendMinimumVersion(9, 4))
+			{
+				values.Add(dataSet1->GetVal(wxT("backend_xid")));
+				values.Add(dataSet1->GetVal(wxT("backend_xmin")));
+			}
 
-				statusList->SetItem(row, colpos++, dataSet1->GetVal(wxT("blockedby")));
-				statusList->SetItem(row, colpos, qry);
+			values.Add(dataSet1->GetVal(wxT("blockedby")));
+			values.Add(qry);
 
-				// Colorize the new line
-				if (viewMenu->IsChecked(MNU_HIGHLIGHTSTATUS))
+			// Colorize the line
+			if (highlight)
+			{
+				row->colour = activeColour;
+				if (qry == wxT("<IDLE>") || qry == wxT("<IDLE> in transaction0"))
+					row->colour = idleColour;
+				if (connection->BackendMinimumVersion(9, 2))
 				{
-					statusList->SetItemBackgroundColour(row,
-					                                    wxColour(settings->GetActiveProcessColour()));
-					if (qry == wxT("<IDLE>") || qry == wxT("<IDLE> in transaction0"))
-						statusList->SetItemBackgroundColour(row,
-						                                    wxColour(settings->GetIdleProcessColour()));
-					if (connection->BackendMinimumVersion(9, 2))
-					{
-						if (dataSet1->GetVal(wxT("state")) != wxT("active"))
-							statusList->SetItemBackgroundColour(row,
-							                                    wxColour(settings->GetIdleProcessColour()));
-					}
-
-					if (dataSet1->GetVal(wxT("blockedby")).Length() > 0)
-						statusList->SetItemBackgroundColour(row,
-						                                    wxColour(settings->GetBlockedProcessColour()));
-					if (dataSet1->GetBool(wxT("slowquery")))
-						statusList->SetItemBackgroundColour(row,
-						                                    wxColour(settings->GetSlowProcessColour()));
+					if (dataSet1->GetVal(wxT("state")) != wxT("active"))
+						row->colour = idleColour;
 				}
-				else
-					statusList->SetItemBackgroundColour(row, *wxWHITE);
 
-				row++;
+				if (dataSet1->GetVal(wxT("blockedby")).Length() > 0)
+					row->colour = blockedColour;
+				if (dataSet1->GetBool(wxT("slowquery")))
+					row->colour = slowColour;
 			}
-			dataSet1->MoveNext();
+
+			rows.Add(row);
 		}
-		delete dataSet1;
+		dataSet1->MoveNext();
+	}
 
-		while (row < statusList->GetItemCount())
-			statusList->DeleteItem(row);
+	statusList->SetRows(rows);
 
-		statusList->Thaw();
-		wxListEvent ev;
-		OnSelStatusItem(ev);
-		statusBar->SetStatusText(_("Done."));
-	}
-	else
-		checkConnection();
+	wxListEvent ev;
+	OnSelStatusItem(ev);
 }
 
 
 void frmStatus::OnRefreshLocksTimer(wxTimerEvent &event)
 {
-	long pid = 0;
-
 	if (! viewMenu->IsChecked(MNU_LOCKPAGE))
 		return;
 
@@ -1547,7 +1773,20 @@ void frmStatus::OnRefreshLocksTimer(wxTimerEvent &event)
 		return;
 	}
 
-	wxCriticalSectionLocker lock(gs_critsect);
+	// Don't pile up the queries on a busy server
+	if (refreshThreads[PANE_LOCKS])
+	{
+		refreshAgain[PANE_LOCKS] = true;
+		return;
+	}
+
+	refreshBlocking = IsBlockingView();
+	if (refreshBlocking)
+	{
+		statusBar->SetStatusText(_("Refreshing blocking chains."));
+		RunRefresh(PANE_LOCKS, GetBlockingQuery());
+		return;
+	}
 
 	// There are no sort operator for xid before 8.3
 	if (!connection->BackendMinimumVersion(8, 3) && lockSortColumn == 5)
@@ -1556,7 +1795,6 @@ void frmStatus::OnRefreshLocksTimer(wxTimerEvent &event)
 		lockSortColumn = 1;
 	}
 
-	long row = 0;
 	wxString sql;
 	if (locks_connection->BackendMinimumVersion(8, 3))
 	{
@@ -1600,70 +1838,236 @@ void frmStatus::OnRefreshLocksTimer(wxTimerEvent &event)
 		      wxT("ORDER BY ") + NumToStr((long)lockSortColumn) + wxT(" ") + lockSortOrder;
 	}
 
-	pgSet *dataSet2 = locks_connection->ExecuteSet(sql);
-	if (dataSet2)
+	statusBar->SetStatusText(_("Refreshing locks list."));
+	RunRefresh(PANE_LOCKS, sql);
+}
+
+
+wxString frmStatus::GetBlockingQuery()
+{
+	wxString waits, waitStart;
+
+	// When each session started to wait, or else its query
+	if (locks_connection->BackendMinimumVersion(14, 0))
+		waitStart = wxT("waitstart");
+	else
+		waitStart = wxT("NULL::timestamptz AS waitstart");
+
+	if (locks_connection->BackendMinimumVersion(9, 6))
+	{
+		// The server knows best, including who is ahead in the queue. A
+		// prepared transaction shows as pid 0.
+		waits = wxT("SELECT pid, array_to_string(pg_blocking_pids(pid), ',') AS blockers, mode, ")
+		        wxT("coalesce(relation::regclass::text, locktype) AS class, ") + waitStart + wxT(" ")
+		        wxT("FROM pg_locks WHERE NOT granted");
+	}
+	else
+	{
+		// The sessions holding the same lock in a conflicting mode
+		waits = wxT("SELECT w.pid, array_to_string(ARRAY(SELECT DISTINCT coalesce(h.pid, 0) FROM pg_locks h ")
+		        wxT("WHERE h.granted AND h.pid IS DISTINCT FROM w.pid AND h.locktype = w.locktype ")
+		        wxT("AND h.database IS NOT DISTINCT FROM w.database AND h.relation IS NOT DISTINCT FROM w.relation ")
+		        wxT("AND h.page IS NOT DISTINCT FROM w.page AND h.tuple IS NOT DISTINCT FROM w.tuple ")
+		        wxT("AND h.virtualxid IS NOT DISTINCT FROM w.virtualxid ")
+		        wxT("AND h.transactionid IS NOT DISTINCT FROM w.transactionid ")
+		        wxT("AND h.classid IS NOT DISTINCT FROM w.classid AND h.objid IS NOT DISTINCT FROM w.objid ")
+		        wxT("AND h.objsubid IS NOT DISTINCT FROM w.objsubid ")
+		        wxT("AND h.mode = ANY (CASE w.mode ")
+		        wxT("WHEN 'AccessShareLock' THEN ARRAY['AccessExclusiveLock'] ")
+		        wxT("WHEN 'RowShareLock' THEN ARRAY['ExclusiveLock', 'AccessExclusiveLock'] ")
+		        wxT("WHEN 'RowExclusiveLock' THEN ARRAY['ShareLock', 'ShareRowExclusiveLock', ")
+		        wxT("'ExclusiveLock', 'AccessExclusiveLock'] ")
+		        wxT("WHEN 'ShareUpdateExclusiveLock' THEN ARRAY['ShareUpdateExclusiveLock', 'ShareLock', ")
+		        wxT("'ShareRowExclusiveLock', 'ExclusiveLock', 'AccessExclusiveLock'] ")
+		        wxT("WHEN 'ShareLock' THEN ARRAY['RowExclusiveLock', 'ShareUpdateExclusiveLock', ")
+		        wxT("'ShareRowExclusiveLock', 'ExclusiveLock', 'AccessExclusiveLock'] ")
+		        wxT("WHEN 'ShareRowExclusiveLock' THEN ARRAY['RowExclusiveLock', 'ShareUpdateExclusiveLock', ")
+		        wxT("'ShareLock', 'ShareRowExclusiveLock', 'ExclusiveLock', 'AccessExclusiveLock'] ")
+		        wxT("WHEN 'ExclusiveLock' THEN ARRAY['RowShareLock', 'RowExclusiveLock', 'ShareUpdateExclusiveLock', ")
+		        wxT("'ShareLock', 'ShareRowExclusiveLock', 'ExclusiveLock', 'AccessExclusiveLock'] ")
+		        wxT("ELSE ARRAY['AccessShareLock', 'RowShareLock', 'RowExclusiveLock', 'ShareUpdateExclusiveLock', ")
+		        wxT("'ShareLock', 'ShareRowExclusiveLock', 'ExclusiveLock', 'AccessExclusiveLock'] END)), ',') AS blockers, ")
+		        wxT("w.mode, coalesce(w.relation::regclass::text, w.locktype) AS class, ") + waitStart + wxT(" ")
+		        wxT("FROM pg_locks w WHERE NOT w.granted");
+	}
+
+	// One snapshot of the waits, along with the sessions
+	return wxT("SELECT pg_stat_get_backend_pid(svrid) AS pid, w.blockers, ")
+	       wxT("CASE WHEN w.pid IS NOT NULL THEN date_trunc('second', now() - ")
+	       wxT("coalesce(w.waitstart, pg_stat_get_backend_activity_start(svrid))) END AS waiting, ")
+	       wxT("pg_get_userbyid(pg_stat_get_backend_userid(svrid)) AS user, ")
+	       wxT("(SELECT datname FROM pg_database WHERE oid = pg_stat_get_backend_dbid(svrid)) AS dbname, ")
+	       wxT("w.mode, w.class, pg_stat_get_backend_activity(svrid) AS query ")
+	       wxT("FROM pg_stat_get_backend_idset() svrid ")
+	       wxT("LEFT JOIN (") + waits + wxT(") w ON w.pid = pg_stat_get_backend_pid(svrid) ")
+	       wxT("ORDER BY 1");
+}
+
+
+void frmStatus::FillLockList(pgSet *dataSet2)
+{
+	statusListRowArray rows;
+	long pid = 0;
+
+	while (!dataSet2->Eof())
 	{
-		statusBar->SetStatusText(_("Refreshing locks list."));
-		lockList->Freeze();
+		pid = dataSet2->GetLong(wxT("pid"));
 
-		while (!dataSet2->Eof())
+		if (!IsOwnBackend(pid))
 		{
-			pid = dataSet2->GetLong(wxT("pid"));
+			// A backend holds many locks, which differ in the object, the
+			// transaction or the mode
+			wxString key = NumToStr(pid) + wxT("\t") + dataSet2->GetVal(wxT("dbname")) + wxT("\t") +
+			               dataSet2->GetVal(wxT("class")) + wxT("\t") + dataSet2->GetVal(wxT("transaction")) + wxT("\t") +
+			               dataSet2->GetVal(wxT("mode"));
+			if (locks_connection->BackendMinimumVersion(8, 3))
+				key += wxT("\t") + dataSet2->GetVal(wxT("virtualxid"));
+
+			statusListRow *row = new statusListRow(key);
+			wxArrayString &values = row->values;
+
+			values.Add(NumToStr(pid));
+			values.Add(dataSet2->GetVal(wxT("dbname")));
+			values.Add(dataSet2->GetVal(wxT("class")));
+			values.Add(dataSet2->GetVal(wxT("user")));
+			if (locks_connection->BackendMinimumVersion(8, 3))
+				values.Add(dataSet2->GetVal(wxT("virtualxid")));
+			values.Add(dataSet2->GetVal(wxT("transaction")));
+			values.Add(dataSet2->GetVal(wxT("mode")));
+
+			if (dataSet2->GetVal(wxT("granted")) == wxT("t"))
+				values.Add(_("Yes"));
+			else
+				values.Add(_("No"));
 
-			if (pid != backend_pid)
+			wxString qry = dataSet2->GetVal(wxT("query"));
+
+			if (locks_connection->BackendMinimumVersion(7, 4))
 			{
-				if (row >= lockList->GetItemCount())
-				{
-					lockList->InsertItem(row, NumToStr(pid), -1);
-					row = lockList->GetItemCount() - 1;
-				}
+				if (qry.IsEmpty() || qry == wxT("<IDLE>"))
+					values.Add(wxEmptyString);
 				else
-				{
-					lockList->SetItem(row, 0, NumToStr(pid));
-				}
+					values.Add(dataSet2->GetVal(wxT("query_start")));
+			}
+			values.Add(qry.Left(250));
 
-				int colpos = 1;
-				lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("dbname")));
-				lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("class")));
-				lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("user")));
-				if (locks_connection->BackendMinimumVersion(8, 3))
-					lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("virtualxid")));
-				lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("transaction")));
-				lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("mode")));
-
-				if (dataSet2->GetVal(wxT("granted")) == wxT("t"))
-					lockList->SetItem(row, colpos++, _("Yes"));
-				else
-					lockList->SetItem(row, colpos++, _("No"));
+			rows.Add(row);
+		}
+		dataSet2->MoveNext();
+	}
 
-				wxString qry = dataSet2->GetVal(wxT("query"));
+	lockList->SetRows(rows);
 
-				if (locks_connection->BackendMinimumVersion(7, 4))
-				{
-					if (qry.IsEmpty() || qry == wxT("<IDLE>"))
-						lockList->SetItem(row, colpos++, wxEmptyString);
-					else
-						lockList->SetItem(row, colpos++, dataSet2->GetVal(wxT("query_start")));
-				}
-				lockList->SetItem(row, colpos++, qry.Left(250));
+	wxListEvent ev;
+	OnSelLockItem(ev);
+}
 
-				row++;
-			}
-			dataSet2->MoveNext();
+
+void frmStatus::FillBlockList(pgSet *dataSet2)
+{
+	lockGraph->Clear();
+
+	// First the waits, then what is known about the sessions involved
+	while (!dataSet2->Eof())
+	{
+		long pid = dataSet2->GetLong(wxT("pid"));
+		wxStringTokenizer blockers(dataSet2->GetVal(wxT("blockers")), wxT(","));
+
+		while (blockers.HasMoreTokens())
+			lockGraph->AddWait(pid, StrToLong(blockers.GetNextToken()));
+		dataSet2->MoveNext();
+	}
+
+	dataSet2->MoveFirst();
+	while (!dataSet2->Eof())
+	{
+		waitForSession *session = lockGraph->FindSession(dataSet2->GetLong(wxT("pid")));
+		if (session)
+		{
+			session->values.Add(dataSet2->GetVal(wxT("waiting")));
+			session->values.Add(dataSet2->GetVal(wxT("user")));
+			session->values.Add(dataSet2->GetVal(wxT("dbname")));
+			session->values.Add(dataSet2->GetVal(wxT("mode")));
+			session->values.Add(dataSet2->GetVal(wxT("class")));
+			session->values.Add(dataSet2->GetVal(wxT("query")).Left(250));
 		}
+		dataSet2->MoveNext();
+	}
 
-		delete dataSet2;
+	waitForSession *prepared = lockGraph->FindSession(0);
+	if (prepared)
+	{
+		prepared->values.Add(wxEmptyString, 5);
+		prepared->values.Add(_("(prepared transaction)"));
+	}
 
-		while (row < lockList->GetItemCount())
-			lockList->DeleteItem(row);
+	lockGraph->Analyze();
 
-		lockList->Thaw();
-		wxListEvent ev;
-		OnSelLockItem(ev);
-		statusBar->SetStatusText(_("Done."));
+	// Forget about the sessions which are gone
+	size_t i = collapsedPids.GetCount();
+	while (i-- > 0)
+	{
+		if (!lockGraph->FindSession(collapsedPids.Item(i)))
+			collapsedPids.RemoveAt(i);
+	}
+
+	ShowBlockingChains();
+}
+
+
+void frmStatus::ShowBlockingChains()
+{
+	wxColour blockedColour(settings->GetBlockedProcessColour());
+	statusListRowArray rows;
+	size_t i = 0;
+
+	while (i < lockGraph->GetCount())
+	{
+		const waitForSession &session = lockGraph->GetSession(i);
+		bool collapsed = session.behind && collapsedPids.Index(session.pid) != wxNOT_FOUND;
+		wxString tree(wxT(' '), session.depth * 4);
+
+		if (!session.behind)
+			tree += wxT("    ");
+		else if (collapsed)
+			tree += wxT("[+] ");
+		else
+			tree += wxT("[-] ");
+
+		statusListRow *row = new statusListRow(NumToStr(session.pid));
+		row->values.Add(tree + NumToStr(session.pid));
+		row->values.Add(session.behind ? NumToStr((long)session.behind) : wxString(wxEmptyString));
+		WX_APPEND_ARRAY(row->values, session.values);
+
+		// Deadlocked, until the server notices
+		if (session.inCycle)
+			row->colour = blockedColour;
+
+		rows.Add(row);
+
+		// The sessions below a collapsed one follow it
+		i += collapsed ? session.behind + 1 : 1;
 	}
+
+	blockList->SetRows(rows);
+
+	// The roots of the cycles are waiting too
+	wxString summary;
+	if (!lockGraph->GetCount())
+		summary = _("No session is waiting for a lock.");
 	else
-		checkConnection();
+	{
+		summary = wxString::Format(_("%ld sessions waiting, %ld root blockers"),
+		                           (long)(lockGraph->GetCount() - lockGraph->GetRootCount() + lockGraph->GetCycleCount()),
+		                           (long)(lockGraph->GetRootCount() - lockGraph->GetCycleCount()));
+		if (lockGraph->GetCycleCount())
+			summary += wxString::Format(_(", %ld deadlocks"), (long)lockGraph->GetCycleCount());
+	}
+	if (stLockSummary->GetLabel() != summary)
+		stLockSummary->SetLabel(summary);
+
+	wxListEvent ev;
+	OnSelLockItem(ev);
 }
 
 
@@ -1683,7 +2087,12 @@ void frmStatus::OnRefreshXactTimer(wxTimerEvent &event)
 		return;
 	}
 
-	wxCriticalSectionLocker lock(gs_critsect);
+	// Don't pile up the queries on a busy server
+	if (refreshThreads[PANE_XACT])
+	{
+		refreshAgain[PANE_XACT] = true;
+		return;
+	}
 
 	// There are no sort operator for xid before 8.3
 	if (!connection->BackendMinimumVersion(8, 3) && xactSortColumn == 1)
@@ -1692,7 +2101,6 @@ void frmStatus::OnRefreshXactTimer(wxTimerEvent &event)
 		xactSortColumn = 2;
 	}
 
-	long row = 0;
 	wxString sql;
 	if (connection->BackendMinimumVersion(8, 3))
 		sql = wxT("SELECT transaction::text, gid, prepared, owner, database ")
@@ -1703,67 +2111,321 @@ void frmStatus::OnRefreshXactTimer(wxTimerEvent &event)
 		      wxT("FROM pg_prepared_xacts ")
 		      wxT("ORDER BY ") + NumToStr((long)xactSortColumn) + wxT(" ") + xactSortOrder;
 
-	pgSet *dataSet3 = connection->ExecuteSet(sql);
-	if (dataSet3)
-	{
-		statusBar->SetStatusText(_("Refreshing transactions list."));
-		xactList->Freeze();
+	statusBar->SetStatusText(_("Refreshing transactions list."));
+	RunRefresh(PANE_XACT, sql);
+}
 
-		while (!dataSet3->Eof())
-		{
-			long xid = dataSet3->GetLong(wxT("transaction"));
 
-			if (row >= xactList->GetItemCount())
-			{
-				xactList->InsertItem(row, NumToStr(xid), -1);
-				row = xactList->GetItemCount() - 1;
-			}
-			else
-			{
-				xactList->SetItem(row, 0, NumToStr(xid));
-			}
+void frmStatus::FillXactList(pgSet *dataSet3)
+{
+	statusListRowArray rows;
 
-			int colpos = 1;
-			xactList->SetItem(row, colpos++, dataSet3->GetVal(wxT("gid")));
-			xactList->SetItem(row, colpos++, dataSet3->GetVal(wxT("prepared")));
-			xactList->SetItem(row, colpos++, dataSet3->GetVal(wxT("owner")));
-			xactList->SetItem(row, colpos++, dataSet3->GetVal(wxT("database")));
+	while (!dataSet3->Eof())
+	{
+		long xid = dataSet3->GetLong(wxT("transaction"));
 
-			row++;
-			dataSet3->MoveNext();
-		}
-		delete dataSet3;
+		// The global id is unique
+		statusListRow *row = new statusListRow(dataSet3->GetVal(wxT("gid")));
+		wxArrayString &values = row->values;
 
-		while (row < xactList->GetItemCount())
-			xactList->DeleteItem(row);
+		values.Add(NumToStr(xid));
+		values.Add(dataSet3->GetVal(wxT("gid")));
+		values.Add(dataSet3->GetVal(wxT("prepared")));
+		values.Add(dataSet3->GetVal(wxT("owner")));
+		values.Add(dataSet3->GetVal(wxT("database")));
 
-		xactList->Thaw();
-		wxListEvent ev;
-		OnSelXactItem(ev);
-		statusBar->SetStatusText(_("Done."));
+		rows.Add(row);
+		dataSet3->MoveNext();
 	}
-	else
-		checkConnection();
+
+	xactList->SetRows(rows);
+
+	wxListEvent ev;
+	OnSelXactItem(ev);
 }
 
 
-void frmStatus::OnRefreshLogTimer(wxTimerEvent &event)
+pgConn *frmStatus::GetRefreshConnection(int pane)
 {
-	if (! viewMenu->IsEnabled(MNU_LOGPAGE) || ! viewMenu->IsChecked(MNU_LOGPAGE) || !logTimer)
-		return;
+	// The locks of another database are queried on its own connection
+	if (pane == PANE_LOCKS && locks_connection != connection)
+		return locks_connection;
 
-	checkConnection();
-	if (!connection)
+	// Replace a broken connection, once no refresh is using it anymore
+	if (refresh_connection && refresh_connection->GetStatus() != PGCONN_OK)
 	{
-		statusTimer->Stop();
-		locksTimer->Stop();
-		if (xactTimer)
-			xactTimer->Stop();
-		logTimer->Stop();
-		return;
+		for (int p = PANE_STATUS; p <= PANE_XACT; p++)
+		{
+			if (refreshThreads[p] && refreshThreads[p]->GetConn() == refresh_connection)
+				return NULL;
+		}
+
+		delete refresh_connection;
+		refresh_connection = NULL;
 	}
 
-	wxCriticalSectionLocker lock(gs_critsect);
+	if (!refresh_connection && !refreshFailed)
+	{
+		refresh_connection = connection->Duplicate();
+		if (refresh_connection->GetStatus() != PGCONN_OK)
+		{
+			// Probably out of connections, so don't try again each time
+			wxLogInfo(wxT("Could not open a connection for refreshing the server status in the background"));
+			delete refresh_connection;
+			refresh_connection = NULL;
+			refreshFailed = true;
+			return NULL;
+		}
+
+		SetQuietLogging(refresh_connection);
+		refresh_pid = refresh_connection->GetBackendPID();
+	}
+
+	return refresh_connection;
+}
+
+
+void frmStatus::RunRefresh(int pane, const wxString &sql)
+{
+	pgConn *conn = GetRefreshConnection(pane);
+
+	if (conn)
+	{
+		pgQueryThread *thread = new pgQueryThread(conn, sql, -1, this, QUERY_REFRESH_ID);
+
+		if (thread->Create() == wxTHREAD_NO_ERROR && thread->Run() == wxTHREAD_NO_ERROR)
+		{
+			refreshThreads[pane] = thread;
+			return;
+		}
+		delete thread;
+	}
+
+	// No worker connection, let's do it the old way then
+	pgConn *baseConn = (pane == PANE_LOCKS ? locks_connection : connection);
+	RefreshDone(pane, baseConn->ExecuteSetPrepared(sql, wxArrayString()));
+}
+
+
+void frmStatus::StopRefresh(int pane)
+{
+	pgQueryThread *thread = refreshThreads[pane];
+
+	refreshAgain[pane] = false;
+	if (!thread)
+		return;
+
+	thread->CancelExecution();
+	thread->Wait();
+	delete thread;
+	refreshThreads[pane] = NULL;
+}
+
+
+void frmStatus::OnRefreshResult(pgQueryResultEvent &ev)
+{
+	int pane;
+
+	for (pane = PANE_STATUS; pane <= PANE_XACT; pane++)
+	{
+		if (refreshThreads[pane] && refreshThreads[pane]->GetId() == ev.GetThreadID())
+			break;
+	}
+
+	// Stopped meanwhile
+	if (pane > PANE_XACT)
+		return;
+
+	pgQueryThread *thread = refreshThreads[pane];
+	pgSet *set = NULL;
+
+	if (thread->ReturnCode() == PGRES_TUPLES_OK)
+		set = thread->DetachDataSet();
+	else
+		wxLogInfo(wxT("Refreshing the server status failed: %s"), ev.GetQuery()->GetErrorMessage().c_str());
+
+	thread->Wait();
+	delete thread;
+	refreshThreads[pane] = NULL;
+
+	RefreshDone(pane, set);
+
+	if (refreshAgain[pane])
+	{
+		wxTimerEvent evt;
+
+		refreshAgain[pane] = false;
+		if (pane == PANE_STATUS)
+			OnRefreshStatusTimer(evt);
+		else if (pane == PANE_LOCKS)
+			OnRefreshLocksTimer(evt);
+		else
+			OnRefreshXactTimer(evt);
+	}
+}
+
+
+void frmStatus::RefreshDone(int pane, pgSet *set)
+{
+	if (!set)
+	{
+		checkConnection();
+		return;
+	}
+
+	// The connection has been lost meanwhile
+	if (!connection)
+	{
+		delete set;
+		return;
+	}
+
+	if (pane == PANE_STATUS)
+		FillStatusList(set);
+	else if (pane == PANE_LOCKS && refreshBlocking)
+		FillBlockList(set);
+	else if (pane == PANE_LOCKS)
+		FillLockList(set);
+	else
+		FillXactList(set);
+	delete set;
+
+	statusBar->SetStatusText(_("Done."));
+}
+
+
+bool frmStatus::IsOwnBackend(long pid)
+{
+	return pid == backend_pid || (refresh_connection && pid == refresh_pid) ||
+	       (history_connection && pid == history_pid) || (log_connection && pid == log_pid);
+}
+
+
+void frmStatus::OnRefreshHistoryTimer(wxTimerEvent &event)
+{
+	// Skip the sample, if the previous one is still running
+	if (!connection || !historyTimer || historyThread)
+		return;
+
+	// Replace a broken connection
+	if (history_connection && history_connection->GetStatus() != PGCONN_OK)
+	{
+		delete history_connection;
+		history_connection = NULL;
+	}
+
+	if (!history_connection)
+	{
+		if (historyFailed)
+			return;
+
+		history_connection = connection->Duplicate();
+		if (history_connection->GetStatus() != PGCONN_OK)
+		{
+			// Probably out of connections, so don't try again each second
+			wxLogInfo(wxT("Could not open a connection for sampling the server's activity"));
+			delete history_connection;
+			history_connection = NULL;
+			historyFailed = true;
+			historyGraph->SetMessage(_("Could not connect for sampling the server's activity."));
+			return;
+		}
+
+		SetQuietLogging(history_connection);
+		history_pid = history_connection->GetBackendPID();
+	}
+
+	historyStarted = wxGetLocalTimeMillis();
+	historyThread = new pgQueryThread(history_connection, historyQuery, -1, this, QUERY_HISTORY_ID);
+	if (historyThread->Create() != wxTHREAD_NO_ERROR || historyThread->Run() != wxTHREAD_NO_ERROR)
+	{
+		delete historyThread;
+		historyThread = NULL;
+	}
+}
+
+
+void frmStatus::OnHistoryResult(pgQueryResultEvent &ev)
+{
+	if (!historyThread || historyThread->GetId() != ev.GetThreadID())
+		return;
+
+	pgSet *set = historyThread->DataSet();
+	if (historyThread->ReturnCode() == PGRES_TUPLES_OK && set && !set->Eof())
+	{
+		wxLongLong readings[HISTORY_METRICS];
+
+		readings[HISTORY_XACTS] = StrToLongLong(set->GetVal(wxT("xacts")));
+		readings[HISTORY_TUP_READ] = StrToLongLong(set->GetVal(wxT("tup_read")));
+		readings[HISTORY_TUP_WRITTEN] = StrToLongLong(set->GetVal(wxT("tup_written")));
+		readings[HISTORY_BLKS_HIT] = StrToLongLong(set->GetVal(wxT("blks_hit")));
+		readings[HISTORY_BLKS_READ] = StrToLongLong(set->GetVal(wxT("blks_read")));
+		readings[HISTORY_ACTIVE] = StrToLongLong(set->GetVal(wxT("active")));
+		readings[HISTORY_WAITING] = StrToLongLong(set->GetVal(wxT("waiting")));
+
+		// Taken when the query has been sent, which is closest to the
+		// time the server has read the statistics
+		history->AddReading(historyStarted, readings);
+
+		if (manager.GetPane(wxT("History")).IsShown())
+			historyGraph->Refresh();
+	}
+	else
+		wxLogInfo(wxT("Sampling the server's activity failed: %s"), ev.GetQuery()->GetErrorMessage().c_str());
+
+	historyThread->Wait();
+	delete historyThread;
+	historyThread = NULL;
+}
+
+
+void frmStatus::OnHistorySpan(wxCommandEvent &event)
+{
+	static const long spans[] = { 300, 3600, 86400 };
+	int sel = cbHistorySpan->GetSelection();
+
+	if (sel >= 0 && sel < (int)(sizeof(spans) / sizeof(spans[0])))
+		historyGraph->SetSpan(spans[sel]);
+}
+
+
+void frmStatus::OnSaveHistory(wxCommandEvent &event)
+{
+#ifdef __WXMSW__
+	wxFileDialog *dlg = new wxFileDialog(this, _("Save activity history"), wxEmptyString, wxT("activity.csv"),
+	                                     _("CSV files (*.csv)|*.csv|All files (*.*)|*.*"), wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+#else
+	wxFileDialog *dlg = new wxFileDialog(this, _("Save activity history"), wxEmptyString, wxT("activity.csv"),
+	                                     _("CSV files (*.csv)|*.csv|All files (*)|*"), wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+#endif
+	if (dlg->ShowModal() == wxID_OK)
+	{
+		if (!FileWrite(dlg->GetPath(), history->GetCsv(), false))
+		{
+			wxLogError(__("Could not write the file %s: Errcode=%d."), dlg->GetPath().c_str(), wxSysErrorCode());
+		}
+	}
+	delete dlg;
+}
+
+
+void frmStatus::OnRefreshLogTimer(wxTimerEvent &event)
+{
+	if (! viewMenu->IsEnabled(MNU_LOGPAGE) || ! viewMenu->IsChecked(MNU_LOGPAGE) || !logTimer)
+		return;
+
+	checkConnection();
+	if (!connection)
+	{
+		statusTimer->Stop();
+		locksTimer->Stop();
+		if (xactTimer)
+			xactTimer->Stop();
+		logTimer->Stop();
+		return;
+	}
+
+	wxCriticalSectionLocker lock(gs_critsect);
 
 	if (connection->GetLastResultError().sql_state == wxT("42501"))
 	{
@@ -1776,8 +2438,6 @@ void frmStatus::OnRefreshLogTimer(wxTimerEvent &event)
 		return;
 	}
 
-	long newlen = 0;
-
 	if (logDirectory.IsEmpty())
 	{
 		// freshly started
@@ -1794,7 +2454,6 @@ void frmStatus::OnRefreshLogTimer(wxTimerEvent &event)
 		}
 		if (fillLogfileCombo())
 		{
-			savedPartialLine.Clear();
 			cbLogfiles->SetSelection(0);
 			wxCommandEvent ev;
 			OnLoadLogfile(ev);
@@ -1804,9 +2463,10 @@ void frmStatus::OnRefreshLogTimer(wxTimerEvent &event)
 		{
 			logDirectory = wxT("-");
 			if (connection->BackendMinimumVersion(8, 3))
-				logList->AppendItem(-1, wxString(_("logging_collector not enabled or log_filename misconfigured")));
+				logList->AddRow()->SetText(0, _("logging_collector not enabled or log_filename misconfigured"));
 			else
-				logList->AppendItem(-1, wxString(_("redirect_stderr not enabled or log_filename misconfigured")));
+				logList->AddRow()->SetText(0, _("redirect_stderr not enabled or log_filename misconfigured"));
+			logList->ShowAddedRows();
 			cbLogfiles->Disable();
 			btnRotateLog->Disable();
 		}
@@ -1815,33 +2475,21 @@ void frmStatus::OnRefreshLogTimer(wxTimerEvent &event)
 	if (logDirectory == wxT("-"))
 		return;
 
+	// Still reading
+	if (logThread)
+		return;
+
+	// The current logfile might have grown, an older one has been read
+	// completely already
 	if (isCurrent)
-	{
-		// check if the current logfile changed
-		pgSet *set = connection->ExecuteSet(wxT("SELECT pg_file_length(") + connection->qtDbString(logfileName) + wxT(") AS len"));
-		if (set)
-		{
-			newlen = set->GetLong(wxT("len"));
-			delete set;
-		}
-		else
-		{
-			checkConnection();
-			return;
-		}
-		if (newlen > logfileLength)
-		{
-			statusBar->SetStatusText(_("Refreshing log list."));
-			addLogFile(logfileName, logfileTimestamp, newlen, logfileLength, false);
-			statusBar->SetStatusText(_("Done."));
+		readLogChunk();
+	else
+		checkLogRotation();
+}
 
-			// as long as there was new data, the logfile is probably the current
-			// one so we don't need to check for rotation
-			return;
-		}
-	}
 
-	//
+void frmStatus::checkLogRotation()
+{
 	wxString newDirectory = connection->ExecuteScalar(wxT("SHOW log_directory"));
 
 	int newfiles = 0;
@@ -1850,28 +2498,33 @@ void frmStatus::OnRefreshLogTimer(wxTimerEvent &event)
 
 	newfiles = fillLogfileCombo();
 
-	if (newfiles)
+	if (!isCurrent)
+		return;
+
+	if (!showCurrent)
 	{
-		if (!showCurrent)
+		if (newfiles)
 			isCurrent = false;
+		return;
+	}
 
-		if (isCurrent)
+	// Continue with the next logfile, one after the other if there are
+	// several new ones
+	pgSet *set = connection->ExecuteSet(
+	                 wxT("SELECT filetime, filename\n")
+	                 wxT("  FROM pg_logdir_ls() AS A(filetime timestamp, filename text)\n")
+	                 wxT(" WHERE filetime > '") + DateToAnsiStr(logfileTimestamp) + wxT("'::timestamp\n")
+	                 wxT(" ORDER BY filetime LIMIT 1"));
+	if (set)
+	{
+		if (!set->Eof())
 		{
-			int pos = cbLogfiles->GetCount() - newfiles;
-			bool skipFirst = true;
-
-			while (newfiles--)
-			{
-				addLogLine(_("pgadmin:Logfile rotated."), false);
-				wxDateTime *ts = (wxDateTime *)cbLogfiles->wxItemContainer::GetClientData(pos++);
-				wxASSERT(ts != 0);
-
-				addLogFile(ts, skipFirst);
-				skipFirst = false;
+			addLogLine(_("pgadmin:Logfile rotated."), false);
+			logList->ShowAddedRows();
 
-				pos++;
-			}
+			addLogFile(set->GetVal(wxT("filename")), set->GetDateTime(wxT("filetime")), false);
 		}
+		delete set;
 	}
 }
 
@@ -1889,7 +2542,10 @@ void frmStatus::OnRefresh(wxCommandEvent &event)
 
 void frmStatus::checkConnection()
 {
-	if (!locks_connection->IsAlive())
+	// Not while a refresh is using it
+	bool locksBusy = refreshThreads[PANE_LOCKS] && refreshThreads[PANE_LOCKS]->GetConn() == locks_connection;
+
+	if (!locksBusy && !locks_connection->IsAlive())
 	{
 		locks_connection = connection;
 	}
@@ -1903,6 +2559,8 @@ void frmStatus::checkConnection()
 			xactTimer->Stop();
 		if (logTimer)
 			logTimer->Stop();
+		if (historyTimer)
+			historyTimer->Stop();
 		actionMenu->Enable(MNU_REFRESH, false);
 		toolBar->EnableTool(MNU_REFRESH, false);
 		statusBar->SetStatusText(_("Connection broken."));
@@ -1913,205 +2571,354 @@ void frmStatus::checkConnection()
 void frmStatus::addLogFile(wxDateTime *dt, bool skipFirst)
 {
 	pgSet *set = connection->ExecuteSet(
-	                 wxT("SELECT filetime, filename, pg_file_length(filename) AS len ")
+	                 wxT("SELECT filetime, filename ")
 	                 wxT("  FROM pg_logdir_ls() AS A(filetime timestamp, filename text) ")
 	                 wxT(" WHERE filetime = '") + DateToAnsiStr(*dt) + wxT("'::timestamp"));
 	if (set)
 	{
-		logfileName = set->GetVal(wxT("filename"));
-		logfileTimestamp = set->GetDateTime(wxT("filetime"));
-		long len = set->GetLong(wxT("len"));
-
-		logfileLength = 0;
-		addLogFile(logfileName, logfileTimestamp, len, logfileLength, skipFirst);
+		if (!set->Eof())
+			addLogFile(set->GetVal(wxT("filename")), set->GetDateTime(wxT("filetime")), skipFirst);
 
 		delete set;
 	}
 }
 
 
-void frmStatus::addLogFile(const wxString &filename, const wxDateTime timestamp, long len, long &read, bool skipFirst)
+void frmStatus::addLogFile(const wxString &filename, const wxDateTime timestamp, bool skipFirst)
 {
-	wxString line;
+	// Whatever is still being read of the previous logfile
+	stopLogRead();
+
+	logfileName = filename;
+	logfileTimestamp = timestamp;
+	logfileLength = 0;
+	logPending = wxMemoryBuffer();
+	logSkipFirst = false;
 
 	if (skipFirst)
 	{
 		long maxServerLogSize = settings->GetMaxServerLogSize();
 
-		if (!logfileLength && maxServerLogSize && logfileLength > maxServerLogSize)
+		if (maxServerLogSize)
 		{
-			long maxServerLogSize = settings->GetMaxServerLogSize();
-			len = read - maxServerLogSize;
+			wxString len;
+			if (connection->BackendMinimumVersion(8, 1))
+				len = connection->ExecuteScalar(wxT("SELECT (pg_stat_file(") + connection->qtDbString(filename) + wxT(")).size"));
+			else
+				len = connection->ExecuteScalar(wxT("SELECT pg_file_length(") + connection->qtDbString(filename) + wxT(")"));
+
+			// Only the end of the logfile, without its first line, which
+			// could be truncated
+			wxLongLong size = StrToLongLong(len);
+			if (size > maxServerLogSize)
+			{
+				logfileLength = size - maxServerLogSize;
+				logSkipFirst = true;
+			}
 		}
-		else
-			skipFirst = false;
 	}
 
-	// If GPDB 3.3 and later, log is normally in CSV format.  Let's get a whole log line before calling addLogLine,
-	// so we can do things smarter.
+	readLogChunk();
+}
 
-	// PostgreSQL can log in CSV format, as well as regular format.  Normally, we'd only see
-	// the regular format logs here, because pg_logdir_ls only returns those.  But if pg_logdir_ls is
-	// changed to return the csv format log files, we should handle it.
 
-	bool csv_log_format = filename.Right(4) == wxT(".csv");
+wxString frmStatus::logChunkQuery()
+{
+	// The binary read returns the bytes as they are in the logfile, which
+	// are converted once whole lines are there
+	if (connection->BackendMinimumVersion(9, 1))
+		return wxT("SELECT encode(pg_read_binary_file(") + connection->qtDbString(logfileName) + wxT(", ") +
+		       NumToStr(logfileLength) + wxT(", ") + NumToStr(LOG_CHUNK_SIZE) + wxT("), 'hex')");
+
+	return wxT("SELECT pg_file_read(") + connection->qtDbString(logfileName) + wxT(", ") +
+	       NumToStr(logfileLength) + wxT(", ") + NumToStr(LOG_CHUNK_SIZE) + wxT(")");
+}
+
+
+void frmStatus::readLogChunk()
+{
+	if (!connection || logThread)
+		return;
 
-	if (csv_log_format && savedPartialLine.length() > 0)
+	// Replace a broken connection
+	if (log_connection && log_connection->GetStatus() != PGCONN_OK)
 	{
-		if (read == 0)  // Starting at beginning of log file
-			savedPartialLine.clear();
+		delete log_connection;
+		log_connection = NULL;
+	}
+
+	if (!log_connection && !logFailed)
+	{
+		log_connection = connection->Duplicate();
+		if (log_connection->GetStatus() != PGCONN_OK)
+		{
+			// Probably out of connections, so don't try again each time
+			wxLogInfo(wxT("Could not open a connection for reading the server log in the background"));
+			delete log_connection;
+			log_connection = NULL;
+			logFailed = true;
+		}
 		else
-			line = savedPartialLine;
+		{
+			SetQuietLogging(log_connection);
+			log_pid = log_connection->GetBackendPID();
+		}
+	}
+
+	statusBar->SetStatusText(_("Reading log from server..."));
+
+	if (log_connection)
+	{
+		logThread = new pgQueryThread(log_connection, logChunkQuery(), -1, this, QUERY_LOG_ID);
+		if (logThread->Create() == wxTHREAD_NO_ERROR && logThread->Run() == wxTHREAD_NO_ERROR)
+			return;
+
+		delete logThread;
+		logThread = NULL;
 	}
 
-	while (len > read)
+	// No connection of its own, so read it all now, the old way
+	pgSet *set;
+	do
 	{
-		statusBar->SetStatusText(_("Reading log from server..."));
-		pgSet *set = connection->ExecuteSet(wxT("SELECT pg_file_read(") +
-		                                    connection->qtDbString(filename) + wxT(", ") + NumToStr(read) + wxT(", 50000)"));
+		set = connection->ExecuteSet(logChunkQuery());
 		if (!set)
 		{
 			connection->IsAlive();
 			return;
 		}
-		char *raw = set->GetCharPtr(0);
+	}
+	while (logChunkRead(set));
+}
 
-		if (!raw || !*raw)
-		{
+
+void frmStatus::stopLogRead()
+{
+	if (!logThread)
+		return;
+
+	logThread->CancelExecution();
+	logThread->Wait();
+	delete logThread;
+	logThread = NULL;
+}
+
+
+void frmStatus::OnLogResult(pgQueryResultEvent &ev)
+{
+	if (!logThread || logThread->GetId() != ev.GetThreadID())
+		return;
+
+	pgSet *set = NULL;
+
+	if (logThread->ReturnCode() == PGRES_TUPLES_OK)
+		set = logThread->DetachDataSet();
+	else
+		wxLogInfo(wxT("Reading the server log failed: %s"), ev.GetQuery()->GetErrorMessage().c_str());
+
+	logThread->Wait();
+	delete logThread;
+	logThread = NULL;
+
+	// The connection has been lost meanwhile
+	if (!set || !connection)
+	{
+		if (set)
 			delete set;
-			break;
-		}
+		statusBar->SetStatusText(_("Done."));
+		return;
+	}
+
+	if (logChunkRead(set))
+		readLogChunk();
+}
 
-		read += strlen(raw);
 
-		wxString str;
-		if (wxString(wxString(raw, wxConvLibc).wx_str(), wxConvUTF8).Len() > 0)
-			str = line + wxString(wxString(raw, wxConvLibc).wx_str(), wxConvUTF8);
+bool frmStatus::logChunkRead(pgSet *set)
+{
+	bool binary = connection->BackendMinimumVersion(9, 1);
+	char *raw = set->GetCharPtr(0);
+	size_t len = raw ? strlen(raw) : 0, read, i;
+
+	if (binary)
+	{
+		// Two hex digits per byte
+		read = len / 2;
+		char *buf = (char *)logPending.GetAppendBuf(read);
+		for (i = 0 ; i < read ; i++)
+			buf[i] = (char)((HexValue(raw[i * 2]) << 4) | HexValue(raw[i * 2 + 1]));
+		logPending.UngetAppendBuf(read);
+	}
+	else
+	{
+		read = len;
+		logPending.AppendData(raw, len);
+	}
+	delete set;
+
+	logfileLength += (long)read;
+
+	// A short read is the end of the logfile, for now
+	bool more = binary ? read >= (size_t)LOG_CHUNK_SIZE : read > 0;
+
+	// Only whole lines, so that no character is split, unless the logfile
+	// isn't written to anymore
+	const char *data = (const char *)logPending.GetData();
+	size_t avail = logPending.GetDataLen(), start = 0, end = avail;
+
+	if (logSkipFirst)
+	{
+		// Could be truncated
+		const char *nl = (const char *)memchr(data, '\n', avail);
+		if (nl)
+		{
+			start = nl + 1 - data;
+			logSkipFirst = false;
+		}
 		else
-			str = line + wxTextBuffer::Translate(wxString(raw, set->GetConversion()), wxTextFileType_Unix);
+			start = avail;
+	}
 
-		delete set;
+	if (logfileName.Right(4) == wxT(".csv"))
+	{
+		// The CSV lines are taken from the bytes directly, and may contain
+		// line ends in quoted strings
+		end = start + addCsvLog(data + start, avail - start);
 
-		if (str.Len() == 0)
+		// An unterminated quoted string, we'll never find the end of
+		if (end == start && avail - start > 4 * (size_t)LOG_CHUNK_SIZE)
 		{
-			wxString msgstr = _("The server log contains entries in multiple encodings and cannot be displayed by pgAdmin.");
-			wxMessageBox(msgstr);
-			return;
+			wxLogNotice(wxT("Skipping %d bytes of the log without a complete line"), (int)(avail - start));
+			end = avail;
 		}
 
-		if (csv_log_format)
+		// The last record of a logfile that isn't written to anymore may
+		// have no line end
+		if (!more && !isCurrent && end < avail)
+		{
+			if (data[end] != '\n' && data[end] != '\r')
+			{
+				CSVSpan line;
+				line.data = data + end;
+				line.len = avail - end;
+				addCsvLogLine(line);
+			}
+			end = avail;
+		}
+	}
+	else
+	{
+		if (more || isCurrent)
 		{
-			// This will work for any DB using CSV format logs
+			while (end > start && data[end - 1] != '\n')
+				end--;
+		}
 
-			if (logHasTimestamp)
+		if (end > start)
+		{
+			wxString str(data + start, wxConvUTF8, end - start);
+			if (str.IsEmpty())
+				str = wxTextBuffer::Translate(wxString(data + start, wxConvLibc, end - start), wxTextFileType_Unix);
+
+			if (str.IsEmpty())
 			{
-				// Right now, csv format logs from GPDB and PostgreSQL always start with a timestamp, so we count on that.
+				wxString msgstr = _("The server log contains entries in multiple encodings and cannot be displayed by pgAdmin.");
+				wxMessageBox(msgstr);
+			}
+			else
+				addLogText(str);
+		}
+	}
+	logList->ShowAddedRows();
 
-				// And the only reason we need to do that is to make sure we are in sync.
+	// Keep the rest for the next chunk
+	wxMemoryBuffer rest;
+	if (avail > end)
+		rest.AppendData(data + end, avail - end);
+	logPending = rest;
 
-				// Bad things happen if we start in the middle of a
-				// double-quoted string, as we would never find a correct line terminator!
+	if (more)
+		return true;
 
-				// In CSV logs, the first field must be a Timestamp, so must start with "2009" or "201" or "202" (at least for the next 20 years).
-				if (str.length() > 4 && str.Left(4) != wxT("2009") && str.Left(3) != wxT("201") && str.Left(3) != wxT("202"))
-				{
-					wxLogNotice(wxT("Log line does not start with timestamp: %s \n"), str.Mid(0, 100).c_str());
-					// Something isn't right, as we are not at the beginning of a csv log record.
-					// We should never get here, but if we do, try to handle it in a smart way.
-					str = str.Mid(str.Find(wxT("\n20")) + 1); // Try to re-sync.
-				}
-			}
+	statusBar->SetStatusText(_("Done."));
 
-			CSVLineTokenizer tk(str);
+	// As long as there was new data, the logfile is probably the current
+	// one so we don't need to check for rotation
+	if (!read)
+		checkLogRotation();
 
-			logList->Freeze();
+	return false;
+}
 
-			while (tk.HasMoreLines())
-			{
-				line.Clear();
 
-				bool partial;
-				str = tk.GetNextLine(partial);
-				if (partial)
-				{
-					line = str; // Start of a log line, but not complete.  Loop back, Read more data.
-					break;
-				}
+void frmStatus::addLogText(const wxString &text)
+{
+	// Non-csv format log file, whole lines only
+	wxStringTokenizer tk(text, wxT("\n"));
 
-				// Some extra debug checking, assuming csv logs line start with timestamps.
-				// Not really necessary, but it is good for debugging if something isn't right.
-				if (logHasTimestamp)
-				{
-					// The first field must be a Timestamp, so must start with "2009" or "201" or "202" (at least for the next 20 years).
-					// This is just an extra check to make sure we haven't gotten out of sync with the log.
-					if (str.length() > 5 && str.Left(4) != wxT("2009") && str.Left(3) != wxT("201") && str.Left(3) != wxT("202"))
-					{
-						// BUG:  We are out of sync on the log
-						wxLogNotice(wxT("Log line does not start with timestamp: %s\n"), str.c_str());
-					}
-					else if (str.length() < 20)
-					{
-						// BUG:  We are out of sync on the log, or the log is garbled
-						wxLogNotice(wxT("Log line too short: %s\n"), str.c_str());
-					}
-				}
+	while (tk.HasMoreTokens())
+		addLogLine(tk.GetNextToken().Trim());
+}
 
-				// Looks like we have a good complete CSV log record.
-				addLogLine(str.Trim(), true, true);
-			}
 
-			logList->Thaw();
-		}
-		else
-		{
-			// Non-csv format log file
+size_t frmStatus::addCsvLog(const char *data, size_t len)
+{
+	// If GPDB 3.3 and later, log is normally in CSV format.  Let's get a whole log line before calling addCsvLogLine,
+	// so we can do things smarter.
 
-			bool hasCr = (str.Right(1) == wxT("\n"));
+	// PostgreSQL can log in CSV format, as well as regular format.  Normally, we'd only see
+	// the regular format logs here, because pg_logdir_ls only returns those.  But if pg_logdir_ls is
+	// changed to return the csv format log files, we should handle it.
 
-			wxStringTokenizer tk(str, wxT("\n"));
+	size_t skip = 0;
 
-			logList->Freeze();
+	if (logHasTimestamp && len > 4)
+	{
+		// Right now, csv format logs from GPDB and PostgreSQL always start with a timestamp, so we count on that.
 
-			while (tk.HasMoreTokens())
+		// And the only reason we need to do that is to make sure we are in sync.
+
+		// Bad things happen if we start in the middle of a
+		// double-quoted string, as we would never find a correct line terminator!
+
+		// In CSV logs, the first field must be a Timestamp, so must start with "2009" or "201" or "202" (at least for the next 20 years).
+		if (strncmp(data, "2009", 4) && strncmp(data, "201", 3) && strncmp(data, "202", 3))
+		{
+			wxLogNotice(wxT("Log line does not start with timestamp: %s \n"), wxString(data, wxConvUTF8, len < 100 ? len : 100).c_str());
+			// Something isn't right, as we are not at the beginning of a csv log record.
+			// We should never get here, but if we do, try to handle it in a smart way.
+			for (size_t pos = 0 ; pos + 2 < len ; pos++)
 			{
-				str = tk.GetNextToken();
-				if (skipFirst)
+				if (data[pos] == '\n' && data[pos + 1] == '2' && data[pos + 2] == '0')
 				{
-					// could be truncated
-					skipFirst = false;
-					continue;
+					skip = pos + 1; // Try to re-sync.
+					break;
 				}
-
-				if (tk.HasMoreTokens() || hasCr)
-					addLogLine(str.Trim());
-				else
-					line = str;
 			}
-
-			logList->Thaw();
 		}
 	}
 
-	savedPartialLine.clear();
+	CSVBufferTokenizer tk(data + skip, len - skip);
+	CSVSpan line;
 
-	if (!line.IsEmpty())
+	while (tk.GetNextLine(line))
 	{
-		// We finished reading to the end of the log file, but still have some data left
-		if (csv_log_format)
-		{
-			savedPartialLine = line;    // Save partial log line for next read of the data file.
-			line.Clear();
-		}
-		else
-			addLogLine(line.Trim());
+		// Nothing but the line end
+		if (line.data[0] == '\n' || line.data[0] == '\r')
+			continue;
+
+		// Looks like we have a good complete CSV log record.
+		addCsvLogLine(line);
 	}
 
+	// The start of a log line, but not complete, waits for the next chunk
+	return skip + tk.GetPosition();
 }
 
 
-void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_format)
+void frmStatus::addLogLine(const wxString &str, bool formatted)
 {
-	int row = logList->GetItemCount();
+	logListRow *row;
 
 	int idxTimeStampCol = -1, idxLevelCol = -1;
 	int idxLogEntryCol = 0;
@@ -2132,216 +2939,31 @@ void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_for
 	}
 
 	if (!logFormatKnown)
-		logList->AppendItem(-1, str);
-	else if ((!csv_log_format) && str.Find(':') < 0)
+		logList->AddRow()->SetText(0, str);
+	else if (str.Find(':') < 0)
 	{
 		// Must be a continuation of a previous line.
-		logList->InsertItem(row, wxEmptyString, -1);
-		logList->SetItem(row, idxLogEntryCol, str);
+		row = logList->AddRow();
+		row->SetText(idxLogEntryCol, str);
 	}
 	else if (!formatted)
 	{
 		// Not from a log, from pgAdmin itself.
 		if (logHasTimestamp)
 		{
-			logList->InsertItem(row, wxEmptyString, -1);
-			logList->SetItem(row, idxLevelCol, str.BeforeFirst(':'));
+			row = logList->AddRow();
+			row->SetText(idxLevelCol, str.BeforeFirst(':'));
 		}
 		else
 		{
-			logList->InsertItem(row, str.BeforeFirst(':'), -1);
+			row = logList->AddRow();
+			row->SetText(0, str.BeforeFirst(':'));
 		}
-		logList->SetItem(row, idxLogEntryCol, str.AfterFirst(':'));
+		row->SetText(idxLogEntryCol, str.AfterFirst(':'));
 	}
 	else // formatted log
 	{
-		if (csv_log_format)
-		{
-			// Log is in CSV format (GPDB 3.3 and later, or Postgres if only csv log enabled)
-			// In this case, we are always supposed to have a complete log line in csv format in str when called.
-
-			if (logHasTimestamp && (str.Length() < 20 || (logHasTimestamp && (str[0] != wxT('2') || str[1] != wxT('0')))))
-			{
-				// Log line too short or does not start with an expected timestamp...
-				// Must be a continuation of the previous line or garbage,
-				// or we are out of sync in our CSV handling.
-				// We shouldn't ever get here.
-				logList->InsertItem(row, wxEmptyString, -1);
-				logList->SetItem(row, 2, str);
-			}
-			else
-			{
-				CSVTokenizer tk(str);
-
-				bool gpdb = connection->GetIsGreenplum();
-
-				// Get the fields from the CSV log.
-				wxString logTime = tk.GetNextToken();
-				wxString logUser = tk.GetNextToken();
-				wxString logDatabase = tk.GetNextToken();
-				wxString logPid = tk.GetNextToken();
-
-				wxString logSession;
-				wxString logCmdcount;
-				wxString logSegment;
-
-				if (gpdb)
-				{
-					wxString logThread =  tk.GetNextToken();        // GPDB specific
-					wxString logHost = tk.GetNextToken();
-					wxString logPort = tk.GetNextToken();           // GPDB (Postgres puts port with Host)
-					wxString logSessiontime = tk.GetNextToken();
-					wxString logTransaction = tk.GetNextToken();
-					logSession = tk.GetNextToken();
-					logCmdcount = tk.GetNextToken();
-					logSegment = tk.GetNextToken();
-					wxString logSlice = tk.GetNextToken();
-					wxString logDistxact = tk.GetNextToken();
-					wxString logLocalxact = tk.GetNextToken();
-					wxString logSubxact = tk.GetNextToken();
-				}
-				else
-				{
-					wxString logHost = tk.GetNextToken();       // Postgres puts port with Hostname
-					logSession = tk.GetNextToken();
-					wxString logLineNumber = tk.GetNextToken();
-					wxString logPsDisplay = tk.GetNextToken();
-					wxString logSessiontime = tk.GetNextToken();
-					wxString logVXid = tk.GetNextToken();
-					wxString logTransaction = tk.GetNextToken();
-				}
-
-				wxString logSeverity = tk.GetNextToken();
-				wxString logState = tk.GetNextToken();
-				wxString logMessage = tk.GetNextToken();
-				wxString logDetail = tk.GetNextToken();
-				wxString logHint = tk.GetNextToken();
-				wxString logQuery = tk.GetNextToken();
-				wxString logQuerypos = tk.GetNextToken();
-				wxString logContext = tk.GetNextToken();
-				wxString logDebug = tk.GetNextToken();
-				wxString logCursorpos = tk.GetNextToken();
-
-				wxString logStack;
-				if (gpdb)
-				{
-					wxString logFunction = tk.GetNextToken();       // GPDB.  Postgres puts func, file, and line together
-					wxString logFile = tk.GetNextToken();
-					wxString logLine = tk.GetNextToken();
-					logStack = tk.GetNextToken();                   // GPDB only.
-				}
-				else
-					wxString logFuncFileLine = tk.GetNextToken();
-
-				logList->InsertItem(row, logTime, -1);      // Insert timestamp (with time zone)
-
-				logList->SetItem(row, 1, logSeverity);
-
-				// Display the logMessage, breaking it into lines
-				wxStringTokenizer lm(logMessage, wxT("\n"));
-				logList->SetItem(row, 2, lm.GetNextToken());
-
-				logList->SetItem(row, 3, logSession);
-				logList->SetItem(row, 4, logCmdcount);
-				logList->SetItem(row, 5, logDatabase);
-				if ((!gpdb) || (logSegment.length() > 0 && logSegment != wxT("seg-1")))
-				{
-					logList->SetItem(row, 6, logSegment);
-				}
-				else
-				{
-					// If we are reading the masterDB log only, the logSegment won't
-					// have anything useful in it.  Look in the logMessage, and see if the
-					// segment info exists in there.  It will always be at the end.
-					if (logMessage.length() > 0 && logMessage[logMessage.length() - 1] == wxT(')'))
-					{
-						int segpos = -1;
-						segpos = logMessage.Find(wxT("(seg"));
-						if (segpos <= 0)
-							segpos = logMessage.Find(wxT("(mir"));
-						if (segpos > 0)
-						{
-							logSegment = logMessage.Mid(segpos + 1);
-							if (logSegment.Find(wxT(' ')) > 0)
-								logSegment = logSegment.Mid(0, logSegment.Find(wxT(' ')));
-							logList->SetItem(row, 6, logSegment);
-						}
-					}
-				}
-
-				// The rest of the lines from the logMessage
-				while (lm.HasMoreTokens())
-				{
-					int controw = logList->GetItemCount();
-					logList->InsertItem(controw, wxEmptyString, -1);
-					logList->SetItem(controw, 2, lm.GetNextToken());
-				}
-
-				// Add the detail
-				wxStringTokenizer ld(logDetail, wxT("\n"));
-				while (ld.HasMoreTokens())
-				{
-					int controw = logList->GetItemCount();
-					logList->InsertItem(controw, wxEmptyString, -1);
-					logList->SetItem(controw, 2, ld.GetNextToken());
-				}
-
-				// And the hint
-				wxStringTokenizer lh(logHint, wxT("\n"));
-				while (lh.HasMoreTokens())
-				{
-					int controw = logList->GetItemCount();
-					logList->InsertItem(controw, wxEmptyString, -1);
-					logList->SetItem(controw, 2, lh.GetNextToken());
-				}
-
-				if (logDebug.length() > 0)
-				{
-					wxString logState3 = logState.Mid(0, 3);
-					if (logState3 == wxT("426") || logState3 == wxT("22P") || logState3 == wxT("427")
-					        || logState3 == wxT("42P") || logState3 == wxT("458")
-					        || logMessage.Mid(0, 9) == wxT("duration:") || logSeverity == wxT("FATAL") || logSeverity == wxT("PANIC"))
-					{
-						// If not redundant, add the statement from the debug_string
-						wxStringTokenizer lh(logDebug, wxT("\n"));
-						if (lh.HasMoreTokens())
-						{
-							int controw = logList->GetItemCount();
-							logList->InsertItem(controw, wxEmptyString, -1);
-							logList->SetItem(controw, 2, wxT("statement: ") + lh.GetNextToken());
-						}
-						while (lh.HasMoreTokens())
-						{
-							int controw = logList->GetItemCount();
-							logList->InsertItem(controw, wxEmptyString, -1);
-							logList->SetItem(controw, 2, lh.GetNextToken());
-						}
-					}
-				}
-
-				if (gpdb)
-					if (logSeverity == wxT("PANIC") ||
-					        (logSeverity == wxT("FATAL") && logState != wxT("57P03") && logState != wxT("53300")))
-					{
-						// If this is a severe error, add the stack trace.
-						wxStringTokenizer ls(logStack, wxT("\n"));
-						if (ls.HasMoreTokens())
-						{
-							int controw = logList->GetItemCount();
-							logList->InsertItem(controw, wxEmptyString, -1);
-							logList->SetItem(controw, 1, wxT("STACK"));
-							logList->SetItem(controw, 2, ls.GetNextToken());
-						}
-						while (ls.HasMoreTokens())
-						{
-							int controw = logList->GetItemCount();
-							logList->InsertItem(controw, wxEmptyString, -1);
-							logList->SetItem(controw, 2, ls.GetNextToken());
-						}
-					}
-			}
-		}
-		else if (connection->GetIsGreenplum())
+		if (connection->GetIsGreenplum())
 		{
 			// Greenplum 3.2 and before.  log_line_prefix =  "%m|%u|%d|%p|%I|%X|:-"
 
@@ -2364,21 +2986,22 @@ void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_for
 			{
 				// No Timestamp?  Must be a continuation of a previous line?
 				// Not sure if it is possible to get here.
-				logList->InsertItem(row, wxEmptyString, -1);
-				logList->SetItem(row, 2, rest);
+				row = logList->AddRow();
+				row->SetText(2, rest);
 			}
 			else if (logSeverity.Length() > 1)
 			{
 				// Normal case:  Start of a new log record.
-				logList->InsertItem(row, ts, -1);
-				logList->SetItem(row, 1, logSeverity);
-				logList->SetItem(row, 2, rest);
+				row = logList->AddRow();
+				row->SetText(0, ts);
+				row->SetText(1, logSeverity);
+				row->SetText(2, rest);
 			}
 			else
 			{
 				// Continuation of previous line
-				logList->InsertItem(row, wxEmptyString, -1);
-				logList->SetItem(row, 2, rest);
+				row = logList->AddRow();
+				row->SetText(2, rest);
 			}
 		}
 		else
@@ -2395,15 +3018,16 @@ void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_for
 					wxString ts = str.Mid(logFmtPos, str.Length() - rest.Length() - logFmtPos - 1);
 
 					int pos = ts.Find(logFormat.c_str()[logFmtPos + 2], true);
-					logList->InsertItem(row, ts.Left(pos), -1);
-					logList->SetItem(row, idxLevelCol, ts.Mid(pos + logFormat.Length() - logFmtPos - 2));
-					logList->SetItem(row, idxLogEntryCol, rest.Mid(2));
+					row = logList->AddRow();
+					row->SetText(0, ts.Left(pos));
+					row->SetText(idxLevelCol, ts.Mid(pos + logFormat.Length() - logFmtPos - 2));
+					row->SetText(idxLogEntryCol, rest.Mid(2));
 				}
 				else
 				{
-					logList->InsertItem(row, wxEmptyString, -1);
-					logList->SetItem(row, idxLevelCol, str.BeforeFirst(':'));
-					logList->SetItem(row, idxLogEntryCol, str.AfterFirst(':').Mid(2));
+					row = logList->AddRow();
+					row->SetText(idxLevelCol, str.BeforeFirst(':'));
+					row->SetText(idxLogEntryCol, str.AfterFirst(':').Mid(2));
 				}
 			}
 			else
@@ -2416,11 +3040,15 @@ void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_for
 				int pos = rest.Find(':');
 
 				if (pos < 0)
-					logList->InsertItem(row, rest, -1);
+				{
+					row = logList->AddRow();
+					row->SetText(0, rest);
+				}
 				else
 				{
-					logList->InsertItem(row, rest.BeforeFirst(':'), -1);
-					logList->SetItem(row, idxLogEntryCol, rest.AfterFirst(':').Mid(2));
+					row = logList->AddRow();
+					row->SetText(0, rest.BeforeFirst(':'));
+					row->SetText(idxLogEntryCol, rest.AfterFirst(':').Mid(2));
 				}
 			}
 		}
@@ -2428,6 +3056,162 @@ void frmStatus::addLogLine(const wxString &str, bool formatted, bool csv_log_for
 }
 
 
+void frmStatus::addCsvLogLine(const CSVSpan &line)
+{
+	logListRow *row;
+
+	// Log is in CSV format (GPDB 3.3 and later, or Postgres if only csv log enabled)
+	// In this case, we are always supposed to have a complete log line in csv format when called.
+
+	if (logHasTimestamp && (line.len < 20 || line.data[0] != '2' || line.data[1] != '0'))
+	{
+		// Log line too short or does not start with an expected timestamp...
+		// Must be a continuation of the previous line or garbage,
+		// or we are out of sync in our CSV handling.
+		// We shouldn't ever get here.
+		wxString str = line.ToString().Trim();
+		wxLogNotice(wxT("Log line does not start with timestamp: %s\n"), str.c_str());
+		row = logList->AddRow();
+		row->SetText(2, str);
+		return;
+	}
+
+	CSVFields fields(line);
+
+	bool gpdb = connection->GetIsGreenplum();
+
+	// Get the fields from the CSV log, only those shown being converted.
+	// Both start with time, user, database and pid.
+	// Postgres: host (with port), session, line number, ps display,
+	//   session time, vxid, transaction, then severity (11)...
+	// GPDB: thread, host, port, session time, transaction, session, cmd
+	//   count, segment, slice, dist xact, local xact, sub xact, then
+	//   severity (16)...
+	// ... followed by state, message, detail, hint, query, query pos,
+	// context, debug (the statement), cursor pos, and then either
+	// function, file, line and stack (GPDB), or func/file/line together.
+	size_t severity = gpdb ? 16 : 11;
+
+	wxString logTime = fields.GetField(0);
+	wxString logDatabase = fields.GetField(2);
+	wxString logSession = fields.GetField(gpdb ? 9 : 5);
+
+	wxString logCmdcount;
+	wxString logSegment;
+	if (gpdb)
+	{
+		logCmdcount = fields.GetField(10);
+		logSegment = fields.GetField(11);
+	}
+
+	wxString logSeverity = fields.GetField(severity);
+	wxString logState = fields.GetField(severity + 1);
+	wxString logMessage = fields.GetField(severity + 2);
+	wxString logDetail = fields.GetField(severity + 3);
+	wxString logHint = fields.GetField(severity + 4);
+	wxString logDebug = fields.GetField(severity + 8);
+
+	wxString logStack;
+	if (gpdb)
+		logStack = fields.GetField(severity + 13);      // GPDB only.
+
+	row = logList->AddRow();
+	row->SetText(0, logTime);      // Insert timestamp (with time zone)
+
+	row->SetText(1, logSeverity);
+
+	// Display the logMessage, breaking it into lines
+	wxStringTokenizer lm(logMessage, wxT("\n"));
+	row->SetText(2, lm.GetNextToken());
+
+	row->SetText(3, logSession);
+	row->SetText(4, logCmdcount);
+	row->SetText(5, logDatabase);
+	if ((!gpdb) || (logSegment.length() > 0 && logSegment != wxT("seg-1")))
+	{
+		row->SetText(6, logSegment);
+	}
+	else
+	{
+		// If we are reading the masterDB log only, the logSegment won't
+		// have anything useful in it.  Look in the logMessage, and see if the
+		// segment info exists in there.  It will always be at the end.
+		if (logMessage.length() > 0 && logMessage[logMessage.length() - 1] == wxT(')'))
+		{
+			int segpos = -1;
+			segpos = logMessage.Find(wxT("(seg"));
+			if (segpos <= 0)
+				segpos = logMessage.Find(wxT("(mir"));
+			if (segpos > 0)
+			{
+				logSegment = logMessage.Mid(segpos + 1);
+				if (logSegment.Find(wxT(' ')) > 0)
+					logSegment = logSegment.Mid(0, logSegment.Find(wxT(' ')));
+				row->SetText(6, logSegment);
+			}
+		}
+	}
+
+	// The rest of the lines from the logMessage
+	while (lm.HasMoreTokens())
+	{
+		logList->AddRow()->SetText(2, lm.GetNextToken());
+	}
+
+	// Add the detail
+	wxStringTokenizer ld(logDetail, wxT("\n"));
+	while (ld.HasMoreTokens())
+	{
+		logList->AddRow()->SetText(2, ld.GetNextToken());
+	}
+
+	// And the hint
+	wxStringTokenizer lh(logHint, wxT("\n"));
+	while (lh.HasMoreTokens())
+	{
+		logList->AddRow()->SetText(2, lh.GetNextToken());
+	}
+
+	if (logDebug.length() > 0)
+	{
+		wxString logState3 = logState.Mid(0, 3);
+		if (logState3 == wxT("426") || logState3 == wxT("22P") || logState3 == wxT("427")
+		        || logState3 == wxT("42P") || logState3 == wxT("458")
+		        || logMessage.Mid(0, 9) == wxT("duration:") || logSeverity == wxT("FATAL") || logSeverity == wxT("PANIC"))
+		{
+			// If not redundant, add the statement from the debug_string
+			wxStringTokenizer lh(logDebug, wxT("\n"));
+			if (lh.HasMoreTokens())
+			{
+				logList->AddRow()->SetText(2, wxT("statement: ") + lh.GetNextToken());
+			}
+			while (lh.HasMoreTokens())
+			{
+				logList->AddRow()->SetText(2, lh.GetNextToken());
+			}
+		}
+	}
+
+	if (gpdb)
+		if (logSeverity == wxT("PANIC") ||
+		        (logSeverity == wxT("FATAL") && logState != wxT("57P03") && logState != wxT("53300")))
+		{
+			// If this is a severe error, add the stack trace.
+			wxStringTokenizer ls(logStack, wxT("\n"));
+			if (ls.HasMoreTokens())
+			{
+				row = logList->AddRow();
+				row->SetText(1, wxT("STACK"));
+				row->SetText(2, ls.GetNextToken());
+			}
+			while (ls.HasMoreTokens())
+			{
+				logList->AddRow()->SetText(2, ls.GetNextToken());
+			}
+		}
+}
+
+
 void frmStatus::emptyLogfileCombo()
 {
 	if (cbLogfiles->GetCount()) // first entry has no client data
@@ -2497,13 +3281,21 @@ void frmStatus::OnLoadLogfile(wxCommandEvent &event)
 
 		if (ts != NULL && (!logfileTimestamp.IsValid() || *ts != logfileTimestamp))
 		{
-			logList->DeleteAllItems();
+			logList->Clear();
 			addLogFile(ts, true);
 		}
 	}
 }
 
 
+void frmStatus::OnLogFilter(wxCommandEvent &event)
+{
+	// The choices are the levels, starting with all of them
+	logList->SetFilter(cbLogLevel->GetSelection() > 0 ? cbLogLevel->GetSelection() : LOGLEVEL_DEBUG,
+	                   txtLogFilter->GetValue());
+}
+
+
 void frmStatus::OnRotateLogfile(wxCommandEvent &event)
 {
 	if (wxMessageBox(_("Are you sure the logfile should be rotated?"), _("Logfile rotation"), wxYES_NO | wxNO_DEFAULT | wxICON_QUESTION) == wxYES)
@@ -2539,7 +3331,7 @@ void frmStatus::OnStatusCancelBtn(wxCommandEvent &event)
 
 	while  (item >= 0)
 	{
-		wxString pid = statusList->GetItemText(item);
+		wxString pid = statusList->GetText(item);
 		wxString sql = wxT("SELECT pg_cancel_backend(") + pid + wxT(");");
 		connection->ExecuteScalar(sql);
 
@@ -2555,7 +3347,8 @@ void frmStatus::OnStatusCancelBtn(wxCommandEvent &event)
 
 void frmStatus::OnLocksCancelBtn(wxCommandEvent &event)
 {
-	long item = lockList->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+	ctlStatusList *list = GetLockList();
+	long item = list->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
 	if (item < 0)
 		return;
 
@@ -2564,11 +3357,11 @@ void frmStatus::OnLocksCancelBtn(wxCommandEvent &event)
 
 	while  (item >= 0)
 	{
-		wxString pid = lockList->GetItemText(item);
+		wxString pid = GetLockPid(item);
 		wxString sql = wxT("SELECT pg_cancel_backend(") + pid + wxT(");");
 		connection->ExecuteScalar(sql);
 
-		item = lockList->GetNextItem(item, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+		item = list->GetNextItem(item, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
 	}
 
 	wxMessageBox(_("A cancel signal was sent to the selected server process(es)."), _("Cancel query"), wxOK | wxICON_INFORMATION);
@@ -2606,7 +3399,7 @@ void frmStatus::OnStatusTerminateBtn(wxCommandEvent &event)
 
 	while  (item >= 0)
 	{
-		wxString pid = statusList->GetItemText(item);
+		wxString pid = statusList->GetText(item);
 		wxString sql = wxT("SELECT pg_terminate_backend(") + pid + wxT(");");
 		connection->ExecuteScalar(sql);
 
@@ -2622,7 +3415,8 @@ void frmStatus::OnStatusTerminateBtn(wxCommandEvent &event)
 
 void frmStatus::OnLocksTerminateBtn(wxCommandEvent &event)
 {
-	long item = lockList->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+	ctlStatusList *list = GetLockList();
+	long item = list->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
 	if (item < 0)
 		return;
 
@@ -2631,11 +3425,11 @@ void frmStatus::OnLocksTerminateBtn(wxCommandEvent &event)
 
 	while  (item >= 0)
 	{
-		wxString pid = lockList->GetItemText(item);
+		wxString pid = GetLockPid(item);
 		wxString sql = wxT("SELECT pg_terminate_backend(") + pid + wxT(");");
 		connection->ExecuteScalar(sql);
 
-		item = lockList->GetNextItem(item, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+		item = list->GetNextItem(item, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
 	}
 
 	wxMessageBox(_("A terminate signal was sent to the selected server process(es)."), _("Terminate process"), wxOK | wxICON_INFORMATION);
@@ -2908,7 +3702,7 @@ void frmStatus::OnSelLockItem(wxListEvent &event)
 	cbRate->SetValue(rateToCboString(locksRate));
 	if (connection && connection->BackendMinimumVersion(8, 0))
 	{
-		if(lockList->GetSelectedItemCount() > 0)
+		if(GetLockList()->GetSelectedItemCount() > 0)
 		{
 			toolBar->EnableTool(MNU_CANCEL, true);
 			actionMenu->Enable(MNU_CANCEL, true);
@@ -2933,12 +3727,71 @@ void frmStatus::OnSelLockItem(wxListEvent &event)
 	cbLogfiles->Enable(false);
 	btnRotateLog->Enable(false);
 
-	editMenu->Enable(MNU_COPY, lockList->GetFirstSelected() >= 0);
+	editMenu->Enable(MNU_COPY, GetLockList()->GetFirstSelected() >= 0);
 	actionMenu->Enable(MNU_COPY_QUERY, false);
 	toolBar->EnableTool(MNU_COPY_QUERY, false);
 }
 
 
+bool frmStatus::IsBlockingView()
+{
+	return cbLockView->GetSelection() == LOCKVIEW_BLOCKING;
+}
+
+
+ctlStatusList *frmStatus::GetLockList()
+{
+	return IsBlockingView() ? blockList : lockList;
+}
+
+
+wxString frmStatus::GetLockPid(long item)
+{
+	// The first column of the blocking chains is indented
+	if (IsBlockingView())
+		return blockList->GetRow(item)->key;
+	return lockList->GetText(item);
+}
+
+
+void frmStatus::OnLockView(wxCommandEvent &event)
+{
+	// The result of the other view would be shown in this one
+	StopRefresh(PANE_LOCKS);
+
+	wxSizer *sizer = lockList->GetContainingSizer();
+	sizer->Show(lockList, !IsBlockingView());
+	sizer->Show(blockList, IsBlockingView());
+	stLockSummary->SetLabel(wxEmptyString);
+	sizer->Layout();
+
+	wxTimerEvent evt;
+	OnRefreshLocksTimer(evt);
+}
+
+
+void frmStatus::OnBlockItemActivated(wxListEvent &event)
+{
+	long item = event.GetIndex();
+	if (item < 0 || item >= blockList->GetRowCount())
+		return;
+
+	// Only the sessions with others behind them can be collapsed
+	if (blockList->GetText(item, 1).IsEmpty())
+		return;
+
+	long pid = StrToLong(blockList->GetRow(item)->key);
+	int index = collapsedPids.Index(pid);
+	if (index == wxNOT_FOUND)
+		collapsedPids.Add(pid);
+	else
+		collapsedPids.RemoveAt(index);
+
+	// No need to ask the server again
+	ShowBlockingChains();
+}
+
+
 void frmStatus::OnSelXactItem(wxListEvent &event)
 {
 #ifdef __WXGTK__
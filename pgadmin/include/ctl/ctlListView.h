@@ -18,6 +18,7 @@
 #include "utils/misc.h"
 
 class frmMain;
+class ctlPaneLoader;
 
 class ctlListView : public wxListView
 {
@@ -69,6 +70,19 @@ public:
 	{
 		DeleteItem(GetSelection());
 	}
+
+	// When set, the list is filled in the background
+	void SetPaneLoader(ctlPaneLoader *loader)
+	{
+		paneLoader = loader;
+	}
+	ctlPaneLoader *GetPaneLoader() const
+	{
+		return paneLoader;
+	}
+
+private:
+	ctlPaneLoader *paneLoader;
 };
 
 
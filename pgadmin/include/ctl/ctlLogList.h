@@ -0,0 +1,109 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlLogList.h - Virtual list view showing the tail of the server log
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef CTLLOGLIST_H
+#define CTLLOGLIST_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+
+#include "ctl/ctlListView.h"
+
+// Lines kept by default
+#define LOGLIST_CAPACITY    100000
+
+// The severities, from the least to the most important one
+enum
+{
+	LOGLEVEL_UNKNOWN = -1,
+	LOGLEVEL_DEBUG = 0,
+	LOGLEVEL_LOG,
+	LOGLEVEL_INFO,
+	LOGLEVEL_NOTICE,
+	LOGLEVEL_WARNING,
+	LOGLEVEL_ERROR,
+	LOGLEVEL_FATAL,
+	LOGLEVEL_PANIC
+};
+
+// A line of the list
+class logListRow
+{
+public:
+	void SetText(int col, const wxString &text);
+
+	// One value per column, as far as there is one
+	wxArrayString values;
+	// Of the log entry the line belongs to
+	int level;
+};
+
+// The lines are kept in a ring, the oldest one being replaced by the
+// newest one when full. The list shows the lines which pass the filter.
+class ctlLogList : public ctlListView
+{
+public:
+	ctlLogList(wxWindow *p, int id, wxPoint pos, wxSize siz, long attr = 0);
+	~ctlLogList();
+
+	// Removes all the lines
+	void SetCapacity(size_t _capacity);
+	void Clear();
+
+	// The column holding the severity, -1 if none
+	void SetLevelColumn(int col)
+	{
+		levelColumn = col;
+	}
+
+	// The lines added are shown by ShowAddedRows()
+	logListRow *AddRow();
+	void ShowAddedRows();
+
+	// Only the lines of at least the level, and containing the text in
+	// any column (ignoring the case)
+	void SetFilter(int _minLevel, const wxString &_filterText);
+
+	long GetRowCount() const
+	{
+		return (long)visible.GetCount();
+	}
+	wxString GetText(long row, long col = 0);
+
+	static int ParseLevel(const wxString &text);
+
+protected:
+	wxString OnGetItemText(long item, long column) const;
+	int OnGetItemImage(long item) const;
+
+private:
+	logListRow &Row(size_t i) const
+	{
+		return rows[(first + i) % capacity];
+	}
+	bool Matches(const logListRow &row) const;
+
+	logListRow *rows;
+	size_t capacity, first, count;
+
+	// The lines added and removed since the last ShowAddedRows()
+	size_t added, removed;
+
+	// The lines shown, numbered from the oldest line kept (0)
+	wxArrayLong visible;
+
+	int levelColumn, lastLevel;
+	int minLevel;
+	wxString filterText;
+};
+
+#endif
@@ -0,0 +1,108 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlPaneLoader.h - Fills the list panes of a window with the results of
+//                   queries run in the background
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef CTLPANELOADER_H
+#define CTLPANELOADER_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/timer.h>
+
+#include "db/pgQueryResultEvent.h"
+
+class ctlListView;
+class pgConn;
+class pgSet;
+class pgQueryThread;
+
+// Adds the rows of a query to a list view
+class ctlListFiller
+{
+public:
+	virtual ~ctlListFiller() {}
+	virtual void Fill(ctlListView *list, pgSet *set) = 0;
+};
+
+class paneLoadRequest
+{
+public:
+	paneLoadRequest(ctlListView *_list, const wxString &_key, pgConn *_baseConn,
+	                const wxString &_query, ctlListFiller *_filler)
+		: list(_list), key(_key), baseConn(_baseConn), query(_query), filler(_filler),
+		  conn(NULL), thread(NULL), superseded(false) {}
+	~paneLoadRequest()
+	{
+		delete filler;
+	}
+
+	ctlListView   *list;
+	wxString       key;
+	// Connection of the object, the worker connection is a copy of it
+	pgConn        *baseConn;
+	wxString       query;
+	ctlListFiller *filler;
+
+	pgConn        *conn;
+	pgQueryThread *thread;
+	// The list has been refilled meanwhile, the result is not wanted
+	bool           superseded;
+};
+WX_DEFINE_ARRAY_PTR(paneLoadRequest *, paneLoadRequestArray);
+
+class paneLoadConn
+{
+public:
+	paneLoadConn(const wxString &_key, pgConn *_conn)
+		: key(_key), conn(_conn), lastUsed(wxDateTime::Now()) {}
+
+	wxString    key;
+	pgConn     *conn;
+	wxDateTime  lastUsed;
+};
+WX_DEFINE_ARRAY_PTR(paneLoadConn *, paneLoadConnArray);
+
+// Requests are run one at a time per database on a separate connection,
+// in the order they have been added. When the object shown in a list
+// changes, the requests of the previous object are dropped (or cancelled,
+// if running already), so that quickly moving through the browser does
+// not pile up queries on the server.
+class ctlPaneLoader : public wxEvtHandler
+{
+public:
+	ctlPaneLoader();
+	~ctlPaneLoader();
+
+	// Runs the query against (a copy of) conn, and hands the rows over to
+	// the filler, which is owned by the loader from now on.
+	void Add(ctlListView *list, pgConn *conn, const wxString &query, ctlListFiller *filler);
+	// Drops the requests of the list, or all the lists if NULL
+	void Supersede(ctlListView *list = NULL);
+
+private:
+	void OnQueryComplete(pgQueryResultEvent &ev);
+	void OnIdleTimer(wxTimerEvent &ev);
+
+	void StartQueued();
+	bool Start(paneLoadRequest *req);
+	void Remove(paneLoadRequest *req);
+	pgConn *GetConnection(const wxString &key, pgConn *baseConn);
+	void ReleaseConnection(const wxString &key, pgConn *conn);
+
+	paneLoadRequestArray m_requests;
+	paneLoadConnArray    m_idleConns;
+	wxTimer              m_idleTimer;
+
+	DECLARE_EVENT_TABLE()
+	DECLARE_NO_COPY_CLASS(ctlPaneLoader)
+};
+
+#endif
@@ -17,6 +17,7 @@
 
 #include "db/pgSet.h"
 #include "db/pgConn.h"
+#include "db/pgQueryResultEvent.h"
 #include "ctlSQLGrid.h"
 #include "frm/frmExport.h"
 
@@ -29,7 +30,9 @@ public:
 	~ctlSQLResult();
 
 
-	int Execute(const wxString &query, int resultToDisplay = 0, wxWindow *caller = 0, long eventId = 0, void *data = 0); // > 0: resultset to display, <=0: last result
+	int Execute(const wxString &query, int resultToDisplay = 0, wxWindow *caller = 0, long eventId = 0, void *data = 0, bool stream = false); // > 0: resultset to display, <=0: last result
+	// Runs the COPY ... TO STDOUT, writing the data to the file of frm
+	int ExecuteCopy(const wxString &copyQuery, frmExport *frm, wxWindow *caller = 0, long eventId = 0, void *data = 0);
 	void SetConnection(pgConn *conn);
 	long NumRows() const;
 	long InsertedCount() const;
@@ -40,6 +43,8 @@ public:
 	bool Export();
 	bool ToFile();
 	bool ToFile(frmExport *frm);
+	bool CopyFinished(frmExport *frm);
+	bool GetCopyProgress(long &rows, wxLongLong &bytes);
 	bool CanExport()
 	{
 		return NumRows() > 0 && colNames.GetCount() > 0;
@@ -58,6 +63,7 @@ public:
 	pgError GetResultError();
 
 	void DisplayData(bool single = false);
+	void DiscardStreamedData();
 
 	bool GetRowCountSuppressed()
 	{
@@ -73,11 +79,58 @@ public:
 	wxArrayLong colTypClasses;
 
 private:
+	void ClearGrid();
+	void SetupColumns(bool single);
+	void AppendRows();
+	void OnRowsAvailable(pgQueryResultEvent &ev);
+	void OnSettingsChanged(wxCommandEvent &event);
+
 	pgQueryThread *thread;
 	pgConn *conn;
 	bool rowcountSuppressed;
+	// The grid shows the rows, which have been streamed in so far
+	bool streamDisplayed;
 };
 
+WX_DECLARE_HASH_MAP(wxLongLong_t, int, wxIntegerHash, wxIntegerEqual, sqlCellCacheMap);
+
+// The cells formatted last, the least recently used one is dropped first.
+// This holds the cells shown (and some around them), so that repainting
+// them or scrolling back and forth needs no conversion.
+class sqlCellCache
+{
+public:
+	sqlCellCache(int _size);
+	~sqlCellCache();
+
+	// NULL, if the cell is not there
+	const wxString *Find(int row, int col);
+	void Add(int row, int col, const wxString &value);
+	void Clear();
+
+private:
+	static wxLongLong_t Key(int row, int col)
+	{
+		return ((wxLongLong_t)row << 32) | (unsigned int)col;
+	}
+	void Unlink(int entry);
+	void LinkFirst(int entry);
+
+	typedef struct
+	{
+		wxLongLong_t key;
+		wxString value;
+		int prev, next;         // list from the most recently used one
+	} cacheEntry;
+
+	cacheEntry *entries;
+	int size, used, first, last;
+	sqlCellCacheMap index;      // entries by their key
+};
+
+// The values are formatted the way chosen for their column, when the
+// result arrives (numbers with the decimal mark and thousands separator
+// set, long texts cut off, ...)
 class sqlResultTable : public wxGridTableBase
 {
 public:
@@ -97,7 +150,11 @@ public:
 	void SetThread(pgQueryThread *t)
 	{
 		thread = t;
+		Reset();
 	}
+	// Forgets the formats and the cells formatted, after the result, its
+	// types or the settings have changed
+	void Reset();
 	bool DeleteRows(size_t pos = 0, size_t numRows = 1)
 	{
 		return true;
@@ -108,7 +165,24 @@ public:
 	}
 
 private:
+	enum
+	{
+		RESULT_FORMAT_PLAIN = 0,    // as received (booleans, numbers)
+		RESULT_FORMAT_TEXT,         // cut off after the maximum column size
+		RESULT_FORMAT_NUMBER        // with the decimal mark and separator
+	};
+
+	void SetupFormats();
+	wxString FormatValue(int row, int col);
+
 	pgQueryThread *thread;
+
+	wxArrayInt colFormats;
+	bool indicateNull;
+	wxString decimalMark, thousandsSeparator;
+	long maxColSize;
+
+	sqlCellCache cellCache;
 };
 
 #endif
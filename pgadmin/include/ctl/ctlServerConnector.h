@@ -0,0 +1,68 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlServerConnector.h - Connects to several servers at once in the
+//                        background
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef CTLSERVERCONNECTOR_H
+#define CTLSERVERCONNECTOR_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/timer.h>
+
+class frmMain;
+class pgServer;
+
+// A server, whose connection is being established
+class serverConnectRequest
+{
+public:
+	serverConnectRequest(pgServer *_server);
+
+	pgServer   *server;
+	// What PQconnectPoll() has asked to wait for
+	int         pollStatus;
+	wxLongLong  deadline;
+};
+WX_DEFINE_ARRAY_PTR(serverConnectRequest *, serverConnectRequestArray);
+
+// The connections are opened without blocking, and all of them are driven
+// by a single timer, which checks their sockets and moves each one on as
+// soon as the server has answered. Hence the servers not answering at all
+// only take the connect timeout once, no matter how many there are. Only
+// servers, which can be connected to without asking the user anything
+// (stored password, no SSH tunnel), are handled here.
+class ctlServerConnector : public wxEvtHandler
+{
+public:
+	ctlServerConnector(frmMain *form);
+	~ctlServerConnector();
+
+	// Starts connecting to the server. Returns false, if the server needs
+	// to be connected to the usual way.
+	bool Connect(pgServer *server);
+	bool IsConnecting(pgServer *server);
+	// Stops connecting to the server, the (half open) connection stays with
+	// the server object, whose Connect() or destructor disposes of it.
+	void Cancel(pgServer *server);
+
+private:
+	void OnPollTimer(wxTimerEvent &ev);
+	void Finish(serverConnectRequest *req, bool success);
+
+	frmMain                  *m_form;
+	serverConnectRequestArray m_requests;
+	wxTimer                   m_pollTimer;
+
+	DECLARE_EVENT_TABLE()
+	DECLARE_NO_COPY_CLASS(ctlServerConnector)
+};
+
+#endif
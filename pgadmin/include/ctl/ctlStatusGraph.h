@@ -0,0 +1,49 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlStatusGraph.h - Draws the history of the server's activity
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef CTLSTATUSGRAPH_H
+#define CTLSTATUSGRAPH_H
+
+// wxWindows headers
+#include <wx/wx.h>
+
+class statusHistory;
+
+// One graph per metric, stacked. Each pixel column shows the average of
+// the samples in its part of the time span, the newest ones on the right.
+class ctlStatusGraph : public wxWindow
+{
+public:
+	ctlStatusGraph(wxWindow *parent, wxWindowID id, statusHistory *_history);
+
+	// In seconds
+	void SetSpan(long _span);
+	long GetSpan() const
+	{
+		return span;
+	}
+
+	// Shown instead of the graphs
+	void SetMessage(const wxString &_message);
+
+private:
+	void OnPaint(wxPaintEvent &event);
+	void OnSize(wxSizeEvent &event);
+	void OnEraseBackground(wxEraseEvent &event);
+
+	statusHistory *history;
+	long span;
+	wxString message;
+
+	DECLARE_EVENT_TABLE()
+};
+
+#endif
@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlStatusList.h - Virtual list view showing a snapshot of keyed rows
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef CTLSTATUSLIST_H
+#define CTLSTATUSLIST_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+
+#include "ctl/ctlListView.h"
+
+// A row of the list, identified by its key (e.g. the pid of a backend)
+class statusListRow
+{
+public:
+	statusListRow(const wxString &_key) : key(_key) {}
+
+	bool SameAs(const statusListRow *row) const
+	{
+		return colour == row->colour && values == row->values;
+	}
+
+	wxString      key;
+	// One value per column
+	wxArrayString values;
+	// Background of the row, wxNullColour for the default one
+	wxColour      colour;
+};
+WX_DEFINE_ARRAY_PTR(statusListRow *, statusListRowArray);
+
+// The rows are not stored in the control, which asks for the text of the
+// visible ones only. Each new snapshot is compared to the previous one
+// row by row, and only the rows, which have changed, are repainted.
+class ctlStatusList : public ctlListView
+{
+public:
+	ctlStatusList(wxWindow *p, int id, wxPoint pos, wxSize siz, long attr = 0);
+	~ctlStatusList();
+
+	// Takes over the rows (the array is emptied). The selected rows stay
+	// selected, as long as their keys are still there.
+	void SetRows(statusListRowArray &newRows);
+
+	long GetRowCount() const
+	{
+		return (long)rows.GetCount();
+	}
+	statusListRow *GetRow(long row) const
+	{
+		return rows.Item(row);
+	}
+	wxString GetText(long row, long col = 0);
+
+protected:
+	wxString OnGetItemText(long item, long column) const;
+	int OnGetItemImage(long item) const;
+	wxListItemAttr *OnGetItemAttr(long item) const;
+
+private:
+	statusListRowArray rows;
+	// Handed out by OnGetItemAttr()
+	wxListItemAttr *itemAttr;
+};
+
+#endif
@@ -21,6 +21,7 @@ class pgObject;
 class pgCollection;
 class pgaFactory;
 class ctlTreeFindTimer;
+class ctlTreeLoader;
 
 class ctlTree : public wxTreeCtrl
 {
@@ -41,6 +42,8 @@ public:
 	pgCollection *FindCollection(pgaFactory &factory, wxTreeItemId parent);
 	wxTreeItemId FindItem(const wxTreeItemId &item, const wxString &str);
 	void NavigateTree(int keyCode);
+	// Loads the collections in the background
+	ctlTreeLoader *GetLoader();
 	virtual ~ctlTree();
 
 	DECLARE_EVENT_TABLE()
@@ -49,6 +52,7 @@ private:
 	void OnChar(wxKeyEvent &event);
 	wxString m_findPrefix;
 	ctlTreeFindTimer *m_findTimer;
+	ctlTreeLoader *m_loader;
 
 	friend class ctlTreeFindTimer;
 };
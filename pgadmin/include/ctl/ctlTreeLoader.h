@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// ctlTreeLoader.h - Loads the objects of the browser collections in the
+//                   background
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef CTLTREELOADER_H
+#define CTLTREELOADER_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/timer.h>
+#include <wx/treectrl.h>
+
+#include "db/pgQueryResultEvent.h"
+
+class ctlTree;
+class ctlListView;
+class pgCollection;
+class pgConn;
+class pgSet;
+class pgQueryThread;
+
+// A collection, whose objects are being fetched
+class treeLoadRequest
+{
+public:
+	treeLoadRequest(pgCollection *_collection, const wxString &_key, const wxString &_query)
+		: collection(_collection), key(_key), query(_query), conn(NULL), thread(NULL),
+		  set(NULL), appended(0) {}
+
+	pgCollection  *collection;
+	// Identifies the database, the query has to be run against
+	wxString       key;
+	wxString       query;
+	// The "Loading..." item shown below the collection meanwhile
+	wxTreeItemId   placeholder;
+
+	pgConn        *conn;
+	pgQueryThread *thread;
+	// Result of the query, when it has been completed
+	pgSet         *set;
+	long           appended;
+};
+WX_DEFINE_ARRAY_PTR(treeLoadRequest *, treeLoadRequestArray);
+
+// A worker connection not in use at the moment
+class treeLoadConn
+{
+public:
+	treeLoadConn(const wxString &_key, pgConn *_conn)
+		: key(_key), conn(_conn), lastUsed(wxDateTime::Now()) {}
+
+	wxString    key;
+	pgConn     *conn;
+	wxDateTime  lastUsed;
+};
+WX_DEFINE_ARRAY_PTR(treeLoadConn *, treeLoadConnArray);
+
+// Runs the query of a collection on a separate connection, and appends the
+// objects to the tree in small batches, so that the user can continue to
+// work with the browser. Only one query per database is run at a time, the
+// others are queued.
+class ctlTreeLoader : public wxEvtHandler
+{
+public:
+	ctlTreeLoader(ctlTree *browser);
+	~ctlTreeLoader();
+
+	// Starts loading the objects of the collection. Returns false, if the
+	// collection has to be populated synchronously instead.
+	bool Load(pgCollection *collection);
+	bool IsLoading(pgCollection *collection);
+	// Stops loading the collection. With updateTree, the collection is
+	// reset, so that it gets loaded again when expanded.
+	void Cancel(pgCollection *collection, bool updateTree = true);
+	// Cancels loading all the collections below the item
+	void CancelBelow(const wxTreeItemId &item);
+
+	void SetPropertiesView(ctlListView *properties)
+	{
+		m_properties = properties;
+	}
+
+private:
+	void OnQueryComplete(pgQueryResultEvent &ev);
+	void OnAppendTimer(wxTimerEvent &ev);
+	void OnIdleTimer(wxTimerEvent &ev);
+
+	void StartQueued();
+	bool Start(treeLoadRequest *req);
+	void AppendRows(treeLoadRequest *req);
+	void Finish(treeLoadRequest *req, bool success);
+	void StopThread(treeLoadRequest *req);
+	bool HasPlaceholder(treeLoadRequest *req);
+
+	treeLoadRequest *FindRequest(pgCollection *collection);
+	pgConn *GetConnection(const wxString &key, pgCollection *collection);
+	void ReleaseConnection(const wxString &key, pgConn *conn);
+
+	ctlTree             *m_browser;
+	ctlListView         *m_properties;
+	treeLoadRequestArray m_requests;
+	treeLoadConnArray    m_idleConns;
+	wxTimer              m_appendTimer;
+	wxTimer              m_idleTimer;
+
+	DECLARE_EVENT_TABLE()
+	DECLARE_NO_COPY_CLASS(ctlTreeLoader)
+};
+
+#endif
@@ -16,6 +16,9 @@ pgadmin3_SOURCES += \
 	include/ctl/ctlColourPicker.h \
 	include/ctl/ctlComboBox.h \
 	include/ctl/ctlListView.h \
+	include/ctl/ctlLogList.h \
+	include/ctl/ctlPaneLoader.h \
+	include/ctl/ctlServerConnector.h \
 	include/ctl/ctlMenuToolbar.h \
 	include/ctl/ctlDefaultSecurityPanel.h \
 	include/ctl/ctlSeclabelPanel.h \
@@ -23,8 +26,11 @@ pgadmin3_SOURCES += \
 	include/ctl/ctlSQLBox.h \
 	include/ctl/ctlSQLGrid.h \
 	include/ctl/ctlSQLResult.h \
+	include/ctl/ctlStatusGraph.h \
+	include/ctl/ctlStatusList.h \
 	include/ctl/ctlProgressStatusBar.h \
 	include/ctl/ctlTree.h \
+	include/ctl/ctlTreeLoader.h \
 	include/ctl/explainCanvas.h \
 	include/ctl/timespin.h \
 	include/ctl/wxgridsel.h \
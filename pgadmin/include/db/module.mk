@@ -10,7 +10,10 @@
 #######################################################################
 
 pgadmin3_SOURCES += \
+	  include/db/pgBinaryDecoder.h \
 	  include/db/pgConn.h \
+	  include/db/pgConnPool.h \
+	  include/db/pgQueryExecutor.h \
 	  include/db/pgQueryThread.h \
 	  include/db/pgQueryResultEvent.h \
 	  include/db/pgSet.h
@@ -0,0 +1,52 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgBinaryDecoder.h - Decodes the values of binary format results
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PGBINARYDECODER_H
+#define PGBINARYDECODER_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/datetime.h>
+
+// PostgreSQL headers
+#include <libpq-fe.h>
+
+#include "utils/misc.h"
+
+// The values are passed as received from the server (PQgetvalue() and
+// PQgetlength()), in the send format of their type. The date and time
+// types are expected to use the integer format (integer_datetimes on).
+class pgBinaryDecoder
+{
+public:
+	// Can the values of the type be decoded, and shown as text?
+	static bool CanDecode(OID typOid);
+	// The binary format is the text itself
+	static bool IsTextual(OID typOid);
+	// Depends on the integer_datetimes setting of the server
+	static bool IsDateTime(OID typOid);
+	// Is the TimeZone reported by the server UTC under any of its names?
+	// timestamptz may only be decoded then.
+	static bool IsUtcZone(const char *timeZone);
+
+	static wxLongLong GetLongLong(OID typOid, const char *val, int len);
+	static double GetDouble(OID typOid, const char *val, int len);
+	static bool GetBool(OID typOid, const char *val, int len);
+	// Invalid for infinity, and for the types not being dates
+	static wxDateTime GetDateTime(OID typOid, const char *val, int len);
+
+	// Formats the value the way the server does with DateStyle ISO and
+	// bytea_output escape (as set for every connection). timestamptz is
+	// shown in UTC, which is what the server shows only in a UTC session.
+	static wxCharBuffer ToText(OID typOid, const char *val, int len);
+};
+
+#endif
@@ -82,6 +82,19 @@ typedef struct pgError
 	void SetError(PGresult *_res = NULL, wxMBConv *_conv = NULL);
 } pgError;
 
+// Cached description of a data type, used for the columns of the result sets
+typedef struct pgTypeInfo
+{
+	OID baseType;           // The type itself, or the base type of a domain
+	wxString name;          // format_type(oid, NULL)
+} pgTypeInfo;
+
+WX_DECLARE_HASH_MAP(OID, pgTypeInfo, wxIntegerHash, wxIntegerEqual, pgTypeInfoMap);
+// format_type(oid, typmod) by "oid:typmod"
+WX_DECLARE_STRING_HASH_MAP(wxString, pgFullTypeNameMap);
+// Name of the prepared statement by its SQL text
+WX_DECLARE_STRING_HASH_MAP(wxString, pgPreparedStatementMap);
+
 class pgConn
 {
 public:
@@ -90,7 +103,7 @@ public:
 	       int port = 5432, const wxString &rolename = wxT(""), int sslmode = 0, OID oid = 0,
 	       const wxString &applicationname = wxT("pgAdmin"),
 	       const wxString &sslcert = wxT(""), const wxString &sslkey = wxT(""), const wxString &sslrootcert = wxT(""), const wxString &sslcrl = wxT(""),
-	       const bool sslcompression = true);
+	       const bool sslcompression = true, const bool connectAsync = false);
 	~pgConn();
 
 	bool IsSuperuser();
@@ -128,9 +141,28 @@ public:
 
 	void Close();
 	bool Reconnect();
+	// With connectAsync, the constructor only starts connecting. Call
+	// PollConnect() whenever GetSocket() is ready for what it has asked
+	// for the last time (PGRES_POLLING_READING or _WRITING), until it
+	// returns PGRES_POLLING_OK or _FAILED. GetStatus() is not meaningful
+	// before that.
+	int PollConnect();
+	int GetSocket() const
+	{
+		return conn ? PQsocket(conn) : -1;
+	}
 	bool ExecuteVoid(const wxString &sql, bool reportError = true);
 	wxString ExecuteScalar(const wxString &sql, bool reportError = true);
 	pgSet *ExecuteSet(const wxString &sql, bool reportError = true);
+	// Runs several statements (separated by semicolons) in one round trip,
+	// and returns a set for each of them
+	bool ExecuteSets(const wxString &sql, pgSetArray &sets, bool reportError = true);
+	// Runs the query with the parameters ($1, $2, ...) passed separately,
+	// so they need no quoting. The query is prepared the first time it is
+	// run on the connection, and only executed later on.
+	bool ExecuteVoidPrepared(const wxString &sql, const wxArrayString &params, bool reportError = true);
+	pgSet *ExecuteSetPrepared(const wxString &sql, const wxArrayString &params, bool reportError = true);
+	wxString ExecuteScalarPrepared(const wxString &sql, const wxArrayString &params, bool reportError = true);
 	void CancelExecution(void);
 
 	wxString GetHostAddr() const
@@ -254,13 +286,40 @@ public:
 
 	void Reset();
 
-	bool StartCopy(const wxString query);
+	// Connection pooling
+	//
+	// Discards the state of the session (temporary tables, prepared
+	// statements, settings, LISTENs, ...) and sets it up again like after
+	// connecting, so that the connection can be reused by another window.
+	// Returns false, if the connection can not be reused (closed, in a
+	// transaction, or the server is older than 8.3).
+	bool ResetSession();
+	// Checks the connection kept in the pool is still alive, and sets the
+	// application name of the new user.
+	bool Reuse(const wxString &applicationname);
+	// Identifies the connection in the pgConnPool
+	wxString GetPoolKey();
+
+	bool StartCopy(const wxString query, bool reportError = true);
 	bool PutCopyData(const char *data, long count);
 	bool EndPutCopy(const wxString errormsg);
-	bool GetCopyFinalStatus(void);
+	bool GetCopyFinalStatus(bool reportError = true);
 
 	bool TableHasColumn(wxString schemaname, wxString tblname, const wxString &colname);
 
+	// Type metadata cache
+	//
+	// Looks up all the column types of the result, which are not cached yet,
+	// in a single query. Returns false, if they could not be looked up.
+	bool CacheTypes(const PGresult *res);
+	// Returns false, if the type (with the given modifier) is not cached
+	bool GetCachedType(OID typOid, long typmod, pgTypeInfo &info, wxString &fullName);
+	void ClearTypeCache();
+
+	// Forgets the prepared statements, which the server has dropped (with
+	// the session)
+	void ClearPreparedStatements();
+
 protected:
 	PGconn   *conn;
 	PGcancel *m_cancelConn;
@@ -280,6 +339,10 @@ protected:
 	OID lastSystemOID;
 	OID dbOid;
 
+	pgTypeInfoMap typeCache;
+	pgFullTypeNameMap fullTypeNameCache;
+	wxCriticalSection typeCacheLock;
+
 	void *noticeArg;
 	PQnoticeProcessor noticeProc;
 	static double libpqVersion;
@@ -288,7 +351,10 @@ protected:
 
 private:
 	bool DoConnect();
+	bool StartConnect(bool useLibc);
 	bool Initialize();
+	wxString GetSessionSettings();
+	PGresult *ExecPrepared(const wxString &sql, const wxArrayString &params);
 
 	wxString qtString(const wxString &value);
 
@@ -300,6 +366,12 @@ private:
 
 	wxString reservedNamespaces;
 	wxString connstr;
+	wxString clientEncoding;
+	// The asynchronous connect is being retried with the local encoding
+	bool connectLibc;
+
+	pgPreparedStatementMap preparedStatements;
+	long lastPreparedStatement;
 
 	wxString save_server, save_service, save_hostaddr, save_database, save_username, save_password, save_rolename, save_applicationname;
 	wxString save_sslcert, save_sslkey, save_sslrootcert, save_sslcrl;
@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgConnPool.h - Keeps the connections of the closed windows for reuse
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PGCONNPOOL_H
+#define PGCONNPOOL_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/timer.h>
+
+class pgConn;
+
+// An idle connection, with the session reset already
+class pgPooledConn
+{
+public:
+	pgPooledConn(const wxString &_key, pgConn *_conn)
+		: key(_key), conn(_conn), lastUsed(wxDateTime::Now()) {}
+
+	wxString    key;
+	pgConn     *conn;
+	wxDateTime  lastUsed;
+};
+WX_DEFINE_ARRAY_PTR(pgPooledConn *, pgPooledConnArray);
+
+// Opening a connection takes a TCP (and SSL) handshake and the
+// authentication, which may be slow, esp. through an SSH tunnel. So the
+// connection of a window being closed is reset and kept for a while, and
+// handed out to the next window opened on the same database as the same
+// user and role. All the methods are to be called by the GUI thread.
+class pgConnPool : public wxEvtHandler
+{
+public:
+	static pgConnPool *Get();
+	// Closes all the connections, called when the application ends
+	static void Shutdown();
+
+	// Identifies the connections, which may stand in for each other
+	static wxString GetKey(const wxString &server, const wxString &service, const wxString &hostaddr,
+	                       int port, const wxString &database, const wxString &username,
+	                       const wxString &rolename, int sslmode);
+
+	// Returns a connection with the given key, which has been checked to be
+	// alive, or NULL if there is none
+	pgConn *Acquire(const wxString &key, const wxString &applicationname);
+	// Takes over the connection, which is either kept or closed
+	void Release(pgConn *conn);
+	// Closes the connections, whose key starts with the prefix (all of
+	// them, if empty)
+	void Clear(const wxString &prefix = wxEmptyString);
+
+private:
+	pgConnPool();
+	~pgConnPool();
+
+	void OnIdleTimer(wxTimerEvent &ev);
+
+	pgPooledConnArray m_idleConns;
+	wxTimer           m_idleTimer;
+
+	static pgConnPool *ms_pool;
+
+	DECLARE_EVENT_TABLE()
+	DECLARE_NO_COPY_CLASS(pgConnPool)
+};
+
+#endif
@@ -0,0 +1,148 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// pgQueryExecutor.h - Shared pool of worker threads running the queries
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PGQUERYEXECUTOR_H
+#define PGQUERYEXECUTOR_H
+
+#include "wx/wx.h"
+#include "wx/thread.h"
+#include "wx/dynarray.h"
+
+class pgQueryExecutor;
+class pgQueryWorker;
+
+// Something to be run by one of the worker threads of the executor. It
+// offers the part of the wxThread interface, the callers of the query
+// threads have always been using (Create, Run, Wait, IsRunning and GetId),
+// so that a job can be used the same way a joinable thread was.
+class pgQueryJob
+{
+public:
+	pgQueryJob();
+	virtual ~pgQueryJob();
+
+	// Run by a worker thread
+	virtual void *Entry() = 0;
+
+	// Jobs returning the same key are run one after another, in the order
+	// they have been submitted (e.g. those using the same connection).
+	// NULL for jobs, which may run at any time.
+	virtual void *GetSerialKey()
+	{
+		return NULL;
+	}
+
+	// Nothing to prepare - kept for the callers written for wxThread
+	wxThreadError Create()
+	{
+		return wxTHREAD_NO_ERROR;
+	}
+	// Submits the job to the executor
+	wxThreadError Run();
+	// Blocks until the job has finished, and returns the result of Entry()
+	void *Wait();
+	// Submitted, and not finished yet
+	bool IsRunning();
+	bool IsAlive()
+	{
+		return IsRunning();
+	}
+
+	// Unique in the process, never 0
+	unsigned long GetId() const
+	{
+		return m_jobId;
+	}
+
+private:
+	enum
+	{
+		JOB_NEW = 0,
+		JOB_QUEUED,
+		JOB_RUNNING,
+		JOB_DONE
+	};
+
+	unsigned long m_jobId;
+	// Protected by the lock of the executor
+	int           m_state;
+	void         *m_exitCode;
+
+	// Do not allow copy construction and '=' operator
+	pgQueryJob(const pgQueryJob &)
+	{
+		wxASSERT(0);
+	}
+	pgQueryJob &operator= (const pgQueryJob &)
+	{
+		wxASSERT(0);
+		return *this;
+	}
+
+	friend class pgQueryExecutor;
+};
+WX_DEFINE_ARRAY_PTR(pgQueryJob *, pgQueryJobArray);
+WX_DEFINE_ARRAY_PTR(pgQueryWorker *, pgQueryWorkerArray);
+
+// A fixed number of worker threads is started on first use, and kept until
+// the application ends, so that running a query does not involve creating
+// a thread. Some jobs stay on a worker for a long time though (a query
+// thread waiting for the next query, the debugger waiting for the target),
+// hence more workers are started when all of them are busy; these end
+// again after having been idle for a while.
+class pgQueryExecutor
+{
+public:
+	static pgQueryExecutor *Get();
+	// Stops the workers, called when the application ends
+	static void Shutdown();
+
+	bool Submit(pgQueryJob *_job);
+	void *Wait(pgQueryJob *_job);
+	bool IsRunning(pgQueryJob *_job);
+
+private:
+	pgQueryExecutor();
+	~pgQueryExecutor();
+
+	// Called by the workers
+	pgQueryJob *NextJob(pgQueryWorker *_worker);
+	void JobDone(pgQueryJob *_job, void *_exitCode);
+
+	// Index of the first queued job, whose key is not in use, or -1
+	int FindRunnable();
+	int CountRunnable();
+	bool StartWorker(bool _core);
+	void ReapRetired();
+
+	wxMutex            m_lock;
+	// Signalled, when a job can be run
+	wxCondition        m_jobQueued;
+	// Broadcasted, whenever a job has finished
+	wxCondition        m_jobDone;
+
+	pgQueryJobArray    m_queue;
+	// Keys of the jobs being run at the moment
+	wxArrayPtrVoid     m_busyKeys;
+	pgQueryWorkerArray m_workers;
+	// Workers, which have ended themselves (to be joined)
+	pgQueryWorkerArray m_retired;
+	size_t             m_idleWorkers;
+	bool               m_shuttingDown;
+
+	static pgQueryExecutor *ms_executor;
+	static wxMutex          ms_executorLock;
+
+	friend class pgQueryWorker;
+	DECLARE_NO_COPY_CLASS(pgQueryExecutor)
+};
+
+#endif
@@ -15,11 +15,13 @@
 #include "wx/wx.h"
 #include "wx/event.h"
 #include "db/pgConn.h"
+#include "db/pgQueryExecutor.h"
 
 // Forward declaration
 class pgSet;
 class pgQueryThread;
 class pgBatchQuery;
+class wxFile;
 
 // Support for the IN & INOUT parameters type
 class pgParam : public wxObject
@@ -89,6 +91,25 @@ protected:
 
 WX_DEFINE_ARRAY_PTR(pgParam *, pgParamsArray);
 
+// A batch of rows received in the streaming mode, which has not been
+// picked up by the caller yet
+class pgStreamChunk
+{
+public:
+	pgStreamChunk(PGresult *_res, int _resultNo)
+		: res(_res), resultNo(_resultNo) {}
+	~pgStreamChunk()
+	{
+		if (res)
+			PQclear(res);
+	}
+
+	PGresult *res;
+	// Which result of the query these rows belong to (1 based)
+	int       resultNo;
+};
+WX_DEFINE_ARRAY_PTR(pgStreamChunk *, pgStreamChunkArray);
+
 class pgBatchQuery : public wxObject
 {
 public:
@@ -97,7 +118,9 @@ public:
 	             int _resultToRetrieve = 0)
 		: m_query(_query), m_params(_params), m_eventID(_eventId), m_data(_data),
 		  m_useCallable(_useCallable), m_resToRetrieve(_resultToRetrieve),
-		  m_returnCode(-1), m_resultSet(NULL), m_rowsInserted(-1), m_insertedOid(-1)
+		  m_returnCode(-1), m_resultSet(NULL), m_rowsInserted(-1), m_insertedOid(-1),
+		  m_streamResultNo(0), m_streamedRows(0), m_streamedBytes(0), m_discardedRows(0),
+		  m_fetchedResultNo(0)
 	{
 		// Do not honour the empty query string
 		wxASSERT(!_query.IsEmpty());
@@ -142,6 +165,14 @@ protected:
 	wxString           m_message;       // Message generated during query execution
 	pgError            m_err;           // Error
 
+	// Streaming mode
+	pgStreamChunkArray m_streamChunks;  // Rows received, not picked up yet
+	int                m_streamResultNo;  // Result being streamed
+	long               m_streamedRows;    // Rows streamed from that result
+	size_t             m_streamedBytes;   // Memory used by those rows
+	long               m_discardedRows;   // Rows over the memory limit
+	int                m_fetchedResultNo; // Result the data-set belongs to
+
 private:
 	// Do not allow copy construction and '=' operator (shadow copying)
 	// to avoid ownership of parameters and result-set
@@ -161,7 +192,9 @@ private:
 };
 WX_DEFINE_ARRAY_PTR(pgBatchQuery *, pgBatchQueryArray);
 
-class pgQueryThread : public wxThread
+// Runs the queries on a worker thread of the pgQueryExecutor. The queries
+// of the query threads sharing a connection are run one after another.
+class pgQueryThread : public pgQueryJob
 {
 public:
 	// For running a single query (Used by few components)
@@ -186,12 +219,86 @@ public:
 
 	void SetEventOnCancellation(bool eventOnCancelled);
 
+	// Send all the queued queries to the server at once (libpq pipeline
+	// mode), instead of waiting for the result of each one before sending
+	// the next. Every query still runs in its own implicit transaction, and
+	// the results are handed back in the same order and way as before.
+	// Only for queries consisting of a single statement. When cancelled,
+	// the queries sent already are still run by the server, only their
+	// results are discarded. Without pipeline support in libpq, the
+	// queries are run one after another.
+	void SetPipelining(bool _pipelining)
+	{
+		m_pipelining = _pipelining;
+	}
+
+	// Receive the rows of the queries in the binary format, if all their
+	// columns are of the types pgBinaryDecoder knows about. The values are
+	// then handed out by the data-set as they are (GetLong(), GetDouble(),
+	// GetDateTime() ...), and turned into text only when asked for by
+	// GetVal(). Takes an additional round trip for each query, and applies
+	// to the single SELECTs run outside of a transaction block (and not
+	// pipelined) only.
+	void SetBinaryResults(bool _binaryResults)
+	{
+		m_binaryResults = _binaryResults;
+	}
+
+	// What to do with the rows streamed in beyond the memory limit
+	enum
+	{
+		STREAM_MEMORY_STOP = 0,  // Keep the rows up to the limit only
+		STREAM_MEMORY_SPILL      // Write the older rows to a temporary file
+	};
+
+	// Hand over the rows in batches (of _batchRows) while they are being
+	// received, instead of waiting for the complete result. A
+	// PGQueryRowsEvent is sent to _rowsHandler whenever new rows are
+	// available, which are then picked up using FetchStreamedRows().
+	void SetStreaming(wxEvtHandler *_rowsHandler, long _batchRows,
+	                  long _memoryLimitKb, int _memoryPolicy);
+	bool IsStreaming() const
+	{
+		return m_streaming;
+	}
+	// Move the rows received so far into the data-set of the query. This
+	// must be called by the thread using the data-set (i.e. the GUI).
+	// Returns true, when a new data-set has been created for the rows.
+	bool FetchStreamedRows(int _idx = -1);
+
+	// Write the data of a COPY ... TO STDOUT into the file, instead of
+	// showing the first rows as messages. The rows are converted from the
+	// connection's encoding to _fileConv (if given), and their line ends
+	// to CR/LF with _crlf. The file must stay open until the thread ends.
+	void SetCopyOutFile(wxFile *_file, wxMBConv *_fileConv = NULL, bool _crlf = false);
+	bool IsCopyingOut() const
+	{
+		return m_copyOutFile != NULL;
+	}
+	// Rows and bytes written to the file so far
+	void GetCopyOutProgress(long &_rows, wxLongLong &_bytes);
+	// Rows, which could not be converted to _fileConv
+	long CopyOutSkippedRows() const
+	{
+		return m_copyOutSkipped;
+	}
+	// Writing to the file failed, and the COPY has been cancelled
+	bool CopyOutFailed() const
+	{
+		return m_copyOutFailed;
+	}
+
 	void AddQuery(
 	    const wxString &_qry, pgParamsArray *_params = NULL,
 	    long _eventId = 0, void *_data = NULL, bool _useCallable = false,
 	    int _resultToRetrieve = -1);
 
 	virtual void *Entry();
+	virtual void *GetSerialKey()
+	{
+		return m_conn;
+	}
+
 	bool DataValid(int _idx = -1) const
 	{
 		if (_idx == -1)
@@ -211,6 +318,15 @@ public:
 		return (_idx >= 0 && _idx > m_currIndex ? NULL : m_queries[_idx]->m_resultSet);
 	}
 
+	// Hands over the data-set to the caller, who has to delete it
+	pgSet *DetachDataSet(int _idx = -1)
+	{
+		pgSet *set = DataSet(_idx);
+		if (set)
+			m_queries[_idx == -1 ? m_currIndex : _idx]->m_resultSet = NULL;
+		return set;
+	}
+
 	int ReturnCode(int _idx = -1) const
 	{
 		if (_idx == -1)
@@ -232,10 +348,13 @@ public:
 		return (_idx >= 0 && _idx > m_currIndex ? -1L : m_queries[_idx]->m_insertedOid);
 	}
 
-	inline void CancelExecution()
-	{
-		m_cancelled = true;
-	}
+	// Cancel the running query, and wake up the thread if it is waiting
+	// for the server
+	void CancelExecution();
+
+	// Wait (up to _timeoutMs) for the thread to finish all the queries.
+	// Returns true, when the thread has finished.
+	bool WaitForCompletion(unsigned long _timeoutMs);
 
 	inline size_t GetNumberQueries()
 	{
@@ -258,6 +377,23 @@ private:
 	int Execute();
 	int RaiseEvent(int _retval = 0);
 
+	bool ExecutePipeline();
+	int PrepareBinaryResults(const wxString &_query, const char *_queryBuf);
+#ifdef LIBPQ_HAS_PIPELINING
+	PGresult *GetPipelineResult(bool &_failed, bool &_cancelSent);
+	void PipelineResult(PGresult *_result);
+#endif
+
+	void StreamRow(PGresult *_row, int _resultNo);
+	void FlushStreamBatch(bool _force);
+
+	bool CopyOutRow(const char *_buf, int _len, wxMBConv &_conv);
+	bool FlushCopyOut();
+
+	// Block until the server sends more data, or the query is cancelled
+	void WaitForSocket();
+	void InitWakeup();
+
 	// Queries to be executed
 	pgBatchQueryArray  m_queries;
 	// Current running query index
@@ -274,6 +410,10 @@ private:
 	bool               m_useCallable;
 	// Is executing a query
 	bool               m_executing;
+	// Send the queued queries in the pipeline mode
+	bool               m_pipelining;
+	// Ask for the results in the binary format
+	bool               m_binaryResults;
 	// Queries are being accessed at this time
 	wxMutex            m_queriesLock;
 	// When one thread is accesing messages, other should not be able to access it
@@ -284,7 +424,41 @@ private:
 	PQnoticeProcessor  m_processor;
 	// Notice Handler
 	void              *m_noticeHandler;
-
+#ifndef __WXMSW__
+	// Wakes up WaitForSocket() on cancellation
+	int                m_wakeupPipe[2];
+#endif
+	// Posted, whenever a new query has been queued
+	wxSemaphore        m_queryQueued;
+	// Posted, when the thread is about to finish
+	wxSemaphore        m_finishedSignal;
+	bool               m_finished;
+
+	// Streaming mode
+	bool               m_streaming;
+	// Receives the PGQueryRowsEvent
+	wxEvtHandler      *m_rowsHandler;
+	long               m_streamBatchRows;
+	size_t             m_streamMemoryLimit;
+	int                m_streamMemoryPolicy;
+	// Rows collected for the next batch
+	PGresult          *m_streamBatch;
+	int                m_streamBatchResultNo;
+	// Batches queued since the last event
+	bool               m_streamPending;
+	wxLongLong         m_streamLastNotify;
+
+	// COPY ... TO STDOUT into a file
+	wxFile            *m_copyOutFile;
+	wxMBConv          *m_copyOutConv;
+	bool               m_copyOutCrLf;
+	// Rows not written to the file yet
+	wxMemoryBuffer     m_copyOutBuffer;
+	long               m_copyOutBufferRows;
+	long               m_copyOutRows;
+	wxLongLong         m_copyOutBytes;
+	long               m_copyOutSkipped;
+	bool               m_copyOutFailed;
 };
 
 #endif
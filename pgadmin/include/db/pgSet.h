@@ -15,6 +15,7 @@
 // wxWindows headers
 #include <wx/wx.h>
 #include <wx/datetime.h>
+#include <wx/file.h>
 
 // PostgreSQL headers
 #include <libpq-fe.h>
@@ -32,6 +33,19 @@ typedef enum
 
 class pgConn;
 
+// A block of rows of a streamed result set
+class pgSetChunk
+{
+public:
+	PGresult     *res;          // NULL while the rows are spilled to disk
+	long          firstRow;     // Index of the first row in the set (0 based)
+	long          rows;
+	size_t        bytes;        // Approximate memory used by the rows
+	wxFileOffset  spillOffset;  // Position in the spill file, -1 if not written
+	size_t        spillLength;
+};
+WX_DEFINE_ARRAY_PTR(pgSetChunk *, pgSetChunkArray);
+
 // Class declarations
 class pgSet
 {
@@ -99,7 +113,9 @@ public:
 	}
 	bool IsNull(const int col) const
 	{
-		return (PQgetisnull(res, pos - 1, col) != 0);
+		int row;
+		PGresult *r = CurrentResult(row);
+		return (PQgetisnull(r, row, col) != 0);
 	}
 	int ColScale(const int col) const;
 	int ColNumber(const wxString &colName) const;
@@ -123,6 +139,8 @@ public:
 	OID GetOid(const int col) const;
 	OID GetOid(const wxString &col) const;
 
+	// The values of the columns received in the binary format are turned
+	// into text, which is valid until the next call
 	char *GetCharPtr(const int col) const;
 	char *GetCharPtr(const wxString &col) const;
 
@@ -130,6 +148,12 @@ public:
 	{
 		return conv;
 	}
+	// Used for the type lookups, when the set outlives the connection it
+	// has been fetched with
+	void SetConnection(pgConn *newConn)
+	{
+		conn = newConn;
+	}
 
 	wxString GetCommandStatus() const
 	{
@@ -140,6 +164,33 @@ public:
 		return wxEmptyString;
 	}
 
+	// Streaming support
+	//
+	// Rows of a streamed result arrive in batches, each one being a separate
+	// PGresult. The set takes the ownership of the batch. A batch without
+	// any rows is the final result of the query, and replaces the header.
+	void AppendRows(PGresult *batch);
+	// Keep at most maxBytes of rows in memory, older rows are written to a
+	// temporary file and read back on demand, when spill is true.
+	void SetMemoryLimit(size_t maxBytes, bool spill);
+	size_t GetMemoryUsage() const
+	{
+		return loadedBytes;
+	}
+	// The connection is busy while the rows are still streaming in, hence
+	// the type names can not be looked up from pg_type until it is done.
+	void SetDeferTypeLookups(bool defer)
+	{
+		deferTypeLookups = defer;
+	}
+
+	// Create an empty (PGRES_TUPLES_OK) result with the columns of src
+	static PGresult *CopyResultAttrs(const PGresult *src);
+	// Approximate memory used by the rows of a result
+	static size_t ResultSize(const PGresult *r);
+	// Type class of the built-in types, which does not require a lookup
+	static pgTypClass TypClassFromOid(OID typOid);
+
 protected:
 	pgConn *conn;
 	PGresult *res;
@@ -149,7 +200,39 @@ protected:
 	bool needColQuoting;
 	mutable wxArrayString colTypes, colFullTypes;
 	wxArrayInt colClasses;
+
+	// Returns the result holding the current row, and its index in it
+	PGresult *CurrentResult(int &row) const
+	{
+		if (chunks.IsEmpty())
+		{
+			row = pos - 1;
+			return res;
+		}
+		return LocateChunk(row);
+	}
+
+private:
+	PGresult *LocateChunk(int &row) const;
+	void LoadChunk(pgSetChunk *chunk) const;
+	void SpillChunks(const pgSetChunk *keep) const;
+	bool LookupColType(const int col) const;
+	bool GetBinaryValue(const int col, const char *&val, int &len) const;
+
+	pgSetChunkArray chunks;
+	mutable size_t curChunk;
+	mutable size_t loadedBytes;
+	size_t memoryLimit;
+	mutable bool spillToDisk;
+	bool deferTypeLookups;
+	mutable bool typesRequested;
+	mutable wxFile spillFile;
+	mutable wxString spillFileName;
+
+	// Text of the binary value asked for the last time
+	mutable wxCharBuffer binaryText;
 };
+WX_DEFINE_ARRAY_PTR(pgSet *, pgSetArray);
 
 
 
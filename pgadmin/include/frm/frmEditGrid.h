@@ -73,6 +73,53 @@ private:
 	int anzLines;
 };
 
+WX_DECLARE_HASH_MAP(int, cacheLine *, wxIntegerHash, wxIntegerEqual, cacheLineMap);
+
+class sqlColumnStore;
+WX_DECLARE_HASH_MAP(int, sqlColumnStore *, wxIntegerHash, wxIntegerEqual, sqlColumnStoreMap);
+
+
+// The rows read from the table, stored column by column. The values of a
+// column are kept back to back in one buffer, in the client encoding, along
+// with their offsets and a null bitmap. This takes a fraction of the memory
+// of a wxString per cell, and needs no allocation when reading the values.
+class sqlColumnStore
+{
+public:
+	sqlColumnStore(int cols, int rows);
+	~sqlColumnStore();
+
+	// Copy the current row of the set; the columns flagged in skipCols are
+	// stored as empty values
+	bool AppendRow(pgSet *set, const bool *skipCols);
+
+	int GetRowCount() const
+	{
+		return rowCount;
+	}
+	bool IsNull(int row, int col) const
+	{
+		return (columns[col].nulls[row >> 3] & (1 << (row & 7))) != 0;
+	}
+	const char *GetCharPtr(int row, int col) const
+	{
+		return columns[col].data + columns[col].offsets[row];
+	}
+	size_t GetMemoryUsage() const;
+
+private:
+	typedef struct
+	{
+		char *data;             // NUL terminated values
+		size_t used, allocated;
+		size_t *offsets;        // start of each value in data
+		unsigned char *nulls;   // one bit per row
+	} storeColumn;
+
+	storeColumn *columns;
+	int colCount, rowCount, maxRows;
+};
+
 
 class sqlCell
 {
@@ -129,7 +176,9 @@ public:
 	int precision();
 
 	wxGridCellAttr *attr;
-	wxString Quote(pgConn *conn, const wxString &value);
+	// Appends the value (as entered in the grid) to the parameters of the
+	// statement, and returns the expression referring to it
+	wxString QuoteParam(const wxString &value, wxArrayString &params);
 	OID type;
 	long typlen, typmod;
 	wxString name, typeName, displayTypeName;
@@ -155,10 +204,14 @@ public:
 	virtual bool IsColText(int col);
 };
 
+// The rows are either all read at once (passed as set), or read from the
+// cursor (holding rows rows) a page at a time, when they are shown. Only a
+// few pages around the rows shown last are kept then, so that the memory
+// used does not depend on the size of the table.
 class sqlTable : public wxGridTableBase
 {
 public:
-	sqlTable(pgConn *conn, pgQueryThread *thread, const wxString &tabName, const OID relid, bool _hasOid, const wxString &_pkCols, char _relkind);
+	sqlTable(pgConn *conn, pgSet *set, const wxString &cursor, int rows, const wxString &tabName, const OID relid, bool _hasOid, const wxString &_pkCols, char _relkind);
 	~sqlTable();
 	bool StoreLine();
 	void UndoLine(int row);
@@ -184,6 +237,12 @@ public:
 	}
 	bool AppendRows(size_t rows);
 	bool DeleteRows(size_t pos, size_t rows);
+	// Deletes the rows (in ascending order) in a single transaction, the
+	// keys being passed as arrays, many rows at a time. The rows, which
+	// could not be deleted, are returned in failedRows (at their position
+	// after the deletion) along with the first error, all the others are
+	// deleted. Returns the number of rows deleted.
+	int DeleteRowSet(const wxArrayInt &rows, wxArrayInt &failedRows, wxString &error);
 	int  LastRow()
 	{
 		return lastRow;
@@ -194,33 +253,63 @@ public:
 	bool CheckInCache(int row);
 	bool IsLineSaved(int row)
 	{
-		return GetLine(row)->stored;
+		cacheLine *line = FindLine(row);
+		return line ? line->stored : true;
 	}
 
 	bool Paste();
+	// The rows not read from the cursor yet are shown empty afterwards
+	void CloseCursor();
 
 private:
-	pgQueryThread *thread;
 	pgConn *connection;
+	wxString cursorName;
+	bool cursorFailed;
 	bool hasOids;
 	char relkind;
 	wxString tableName;
 	OID relid;
 	wxString primaryKeyColNumbers;
 
+	// Returns the line of the row, creating an editable copy of a row read
+	// from the table when needed
 	cacheLine *GetLine(int row);
-	wxString MakeKey(cacheLine *line);
+	// Returns the line of the row, or NULL if it is an unchanged row read
+	// from the table
+	cacheLine *FindLine(int row);
+	wxString GetStoredValue(int dataRow, int col);
+	// The row of the query result shown in the row of the grid
+	int GetDataRow(int row);
+	// Returns the page holding the row of the query result, reading it
+	// from the cursor if needed
+	sqlColumnStore *GetPage(int dataRow, int &pageRow);
+	sqlColumnStore *LoadPage(int pageNo);
+	sqlColumnStore *StorePage(int pageNo, pgSet *set);
+	// Columns (in columns) identifying the rows, the primary key or the oid
+	void GetKeyCols(wxArrayInt &keyCols);
+	// Appends the key values of the line, only if all of them are there
+	bool GetKeyValues(cacheLine *line, const wxArrayInt &keyCols, wxArrayString &values);
+	// The WHERE clause for the line, with the key values appended to the
+	// parameters. Empty, if the line has no key (yet).
+	wxString MakeKey(cacheLine *line, wxArrayString &params);
+	bool DeleteKeys(const wxString &sql, const wxArrayString &params, wxString &error);
+	// Takes the rows (in ascending order) deleted from the table off the
+	// grid
+	void RemoveLines(const wxArrayInt &rows);
 	void SetNumberEditor(int col, int len);
 
-	cacheLinePool *dataPool, *addPool;
+	sqlColumnStoreMap pages;    // rows read, by the number of their page
+	int pageRows;               // rows per page
+	cacheLineMap editedLines;   // rows of the result changed, by their index in it
+	cacheLinePool *addPool;
 	cacheLine savedLine;
 	int lastRow;
 
-	int *lineIndex;     // reindex of lines in dataSet to handle deleted rows
+	wxArrayInt deletedRows;     // rows of the result deleted, in ascending order
+	bool *binaryCols;   // columns not displayed (bytea)
 
 	int nCols;          // columns from dataSet
-	int nRows;          // rows initially returned by dataSet
-	int rowsCached;     // rows read from dataset; if nRows=rowsCached, dataSet can be deleted
+	int nRows;          // rows returned by the query
 	int rowsAdded;      // rows added (never been in dataSet)
 	int rowsStored;     // rows added and stored to db
 	int rowsDeleted;    // rows deleted from initial dataSet
@@ -304,6 +393,10 @@ private:
 	void OnToggleToolBar(wxCommandEvent &event);
 	void OnAuiUpdate(wxAuiManagerEvent &event);
 	void OnDefaultView(wxCommandEvent &event);
+	// Runs the query on the query thread, while keeping the window
+	// responsive. The thread is left in thread, if the query succeeded.
+	bool RunQuery(const wxString &qry);
+	void EnableRefresh(bool enable);
 
 	wxAuiManager manager;
 	ctlSQLEditGrid *sqlGrid;
@@ -15,6 +15,9 @@
 
 class ctlSQLResult;
 class pgSet;
+class pgConn;
+class pgQueryThread;
+class wxFile;
 
 #include "dlg/dlgClasses.h"
 
@@ -27,6 +30,14 @@ public:
 
 	bool Export(pgSet *set);
 
+	// Exporting the result of a query, while it is being received: the
+	// query is run as COPY ... TO STDOUT, and the data is written to the
+	// file by the query thread. GetCopyQuery() returns an empty string, if
+	// the query or the chosen options can not be expressed that way.
+	wxString GetCopyQuery(pgConn *conn, const wxString &query);
+	bool StartCopy(pgQueryThread *thread);
+	bool FinishCopy(pgQueryThread *thread, bool success);
+
 private:
 	void OnChange(wxCommandEvent &ev);
 	void OnHelp(wxCommandEvent &ev);
@@ -35,6 +46,7 @@ private:
 	void OnBrowseFile(wxCommandEvent &ev);
 
 	wxWindow *parent;
+	wxFile *copyFile;
 
 	DECLARE_EVENT_TABLE()
 };
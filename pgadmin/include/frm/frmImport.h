@@ -13,10 +13,81 @@
 #ifndef FRMIMPORT_H
 #define FRMIMPORT_H
 
+#include <wx/thread.h>
+
 #include "dlg/dlgClasses.h"
 #include "utils/factory.h"
 
 class frmMain;
+class wxInputStream;
+
+// Number and size of the buffers passed from the reader to the sender
+#define IMPORT_BUFFER_COUNT     4
+#define IMPORT_BUFFER_SIZE      (1024 * 1024)
+
+class importThread;
+
+// Reads the file into the free buffers, while the sender thread sends the
+// filled ones to the server
+class importReaderThread : public wxThread
+{
+public:
+	importReaderThread(importThread *_sender, wxInputStream *_stream, wxInputStream *_file);
+
+	virtual void *Entry();
+
+private:
+	importThread  *sender;
+	wxInputStream *stream;
+	// The file itself, for the progress of compressed files
+	wxInputStream *file;
+};
+
+// Runs COPY ... FROM STDIN with the data of the file. The file may be
+// compressed with gzip, in which case it is decompressed on the fly.
+class importThread : public wxThread
+{
+public:
+	importThread(wxEvtHandler *_caller, pgConn *_conn, const wxString &_filename, const wxString &_query);
+	~importThread();
+
+	virtual void *Entry();
+	void Cancel();
+
+	bool IsCancelled() const
+	{
+		return cancelled;
+	}
+	const wxString &GetErrorMessage() const
+	{
+		return errorMessage;
+	}
+
+private:
+	void PostProgress(wxFileOffset pos, bool force);
+
+	wxEvtHandler *caller;
+	pgConn *conn;
+	wxString filename;
+	wxString query;
+	bool cancelled;
+	wxString errorMessage;
+
+	// The ring of buffers
+	char *buffers[IMPORT_BUFFER_COUNT];
+	size_t lengths[IMPORT_BUFFER_COUNT];
+	// Position in the file, when the buffer has been read
+	wxFileOffset positions[IMPORT_BUFFER_COUNT];
+	bool readError;
+	bool stopReading;
+	wxSemaphore freeBuffers;
+	wxSemaphore filledBuffers;
+
+	wxFileOffset fileLength;
+	wxLongLong lastProgress;
+
+	friend class importReaderThread;
+};
 
 class frmImport : public pgDialog
 {
@@ -29,10 +100,16 @@ private:
 	void OnSelectFilename(wxCommandEvent &ev);
 	void OnChangeFormat(wxCommandEvent &ev);
 	void OnOK(wxCommandEvent &ev);
+	void OnCancel(wxCommandEvent &ev);
+	void OnClose(wxCloseEvent &ev);
+	void OnImportProgress(wxCommandEvent &ev);
+	void OnImportDone(wxCommandEvent &ev);
+	void StopImport();
 
 	pgConn *connection;
 	pgObject *object;
 	bool done;
+	importThread *thread;
 
 	DECLARE_EVENT_TABLE()
 };
@@ -44,6 +44,8 @@ class pgServer;
 class pgServerCollection;
 class ctlSQLBox;
 class ctlTree;
+class ctlPaneLoader;
+class ctlServerConnector;
 class dlgProperty;
 class serverCollection;
 
@@ -144,6 +146,10 @@ public:
 		return serversObj;
 	}
 	pgServer *ConnectToServer(const wxString &servername, bool restore = false);
+	ctlServerConnector *GetServerConnector()
+	{
+		return serverConnector;
+	}
 
 	void SetLastPluginUtility(pluginUtilityFactory *pluginFactory)
 	{
@@ -182,6 +188,8 @@ private:
 	ctlListView *properties;
 	ctlListView *statistics;
 	ctlListView *dependents, *dependencies;
+	ctlPaneLoader *paneLoader;
+	ctlServerConnector *serverConnector;
 	ctlAuiNotebook *listViews;
 	ctlSQLBox *sqlPane;
 	wxMenu *newMenu, *debuggingMenu, *reportMenu, *toolsMenu, *pluginsMenu, *viewMenu,
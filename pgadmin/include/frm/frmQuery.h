@@ -57,6 +57,7 @@ public:
 	QueryExecInfo()
 	{
 		toFileExportForm = NULL;
+		copyToFile = false;
 	}
 	~QueryExecInfo()
 	{
@@ -66,6 +67,8 @@ public:
 
 	int queryOffset;
 	frmExport *toFileExportForm;
+	// The data is written to the file by COPY, while it is received
+	bool copyToFile;
 	bool singleResult;
 	bool explain;
 	bool verbose;
@@ -249,6 +252,7 @@ private:
 	void updateMenu(bool allowUpdateModelSize = true);
 	void execQuery(const wxString &query, int resultToRetrieve = 0, bool singleResult = false, const int queryOffset = 0, bool toFile = false, bool explain = false, bool verbose = false);
 	void OnQueryComplete(pgQueryResultEvent &ev);
+	void OnQueryRows(pgQueryResultEvent &ev);
 	void completeQuery(bool done, bool explain, bool verbose);
 	bool isBeginNotRequired(wxString query);
 	void OnScriptComplete(wxCommandEvent &ev);
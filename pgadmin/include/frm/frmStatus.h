@@ -25,6 +25,15 @@
 #include "dlg/dlgClasses.h"
 #include "utils/factory.h"
 #include "ctl/ctlAuiNotebook.h"
+#include "ctl/ctlStatusList.h"
+#include "ctl/ctlStatusGraph.h"
+#include "ctl/ctlLogList.h"
+#include "utils/statusHistory.h"
+#include "utils/waitForGraph.h"
+#include "db/pgQueryResultEvent.h"
+
+class pgQueryThread;
+class CSVSpan;
 
 enum
 {
@@ -38,12 +47,19 @@ enum
 	CTL_ROTATEBTN,
 	CTL_STATUSLIST,
 	CTL_LOCKLIST,
+	CTL_LOCKVIEW,
+	CTL_BLOCKLIST,
 	CTL_XACTLIST,
 	CTL_LOGLIST,
+	CTL_LOGLEVEL,
+	CTL_LOGFILTER,
+	CTL_HISTORYSPAN,
 	MNU_STATUSPAGE,
 	MNU_LOCKPAGE,
 	MNU_XACTPAGE,
 	MNU_LOGPAGE,
+	MNU_HISTORYPAGE,
+	MNU_SAVEHISTORY,
 	MNU_TERMINATE,
 	MNU_COMMIT,
 	MNU_ROLLBACK,
@@ -53,7 +69,11 @@ enum
 	TIMER_STATUS_ID,
 	TIMER_LOCKS_ID,
 	TIMER_XACT_ID,
-	TIMER_LOG_ID
+	TIMER_LOG_ID,
+	TIMER_HISTORY_ID,
+	QUERY_REFRESH_ID,
+	QUERY_HISTORY_ID,
+	QUERY_LOG_ID
 };
 
 
@@ -66,18 +86,26 @@ enum
 };
 
 
+// What the locks pane shows
+enum
+{
+	LOCKVIEW_ALL = 0,
+	LOCKVIEW_BLOCKING
+};
+
+
 //
 // This number MUST be incremented if changing any of the default perspectives
 //
-#define FRMSTATUS_PERSPECTIVE_VER wxT("8274")
+#define FRMSTATUS_PERSPECTIVE_VER wxT("8275")
 
 #ifdef __WXMAC__
-#define FRMSTATUS_DEFAULT_PERSPECTIVE wxT("layout2|name=Activity;caption=Activity;state=6293500;dir=4;layer=0;row=0;pos=0;prop=100000;bestw=321;besth=244;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=462;floaty=165;floatw=595;floath=282|name=Locks;caption=Locks;state=6293500;dir=4;layer=0;row=0;pos=1;prop=100000;bestw=321;besth=244;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-231;floaty=235;floatw=595;floath=282|name=Transactions;caption=Transactions;state=6293500;dir=4;layer=0;row=0;pos=2;prop=100000;bestw=0;besth=0;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=461;floaty=527;floatw=595;floath=282|name=Logfile;caption=Logfile;state=6293500;dir=5;layer=0;row=0;pos=0;prop=100000;bestw=0;besth=0;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-103;floaty=351;floatw=595;floath=282|name=toolBar;caption=Tool bar;state=2124528;dir=1;layer=10;row=0;pos=0;prop=100000;bestw=808;besth=33;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=888;floaty=829;floatw=558;floath=49|dock_size(4,0,0)=583|dock_size(5,0,0)=10|dock_size(1,10,0)=35|")
+#define FRMSTATUS_DEFAULT_PERSPECTIVE wxT("layout2|name=Activity;caption=Activity;state=6293500;dir=4;layer=0;row=0;pos=0;prop=100000;bestw=321;besth=244;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=462;floaty=165;floatw=595;floath=282|name=Locks;caption=Locks;state=6293500;dir=4;layer=0;row=0;pos=1;prop=100000;bestw=321;besth=244;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-231;floaty=235;floatw=595;floath=282|name=Transactions;caption=Transactions;state=6293500;dir=4;layer=0;row=0;pos=2;prop=100000;bestw=0;besth=0;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=461;floaty=527;floatw=595;floath=282|name=History;caption=History;state=6293500;dir=4;layer=0;row=0;pos=3;prop=100000;bestw=0;besth=0;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=461;floaty=527;floatw=595;floath=282|name=Logfile;caption=Logfile;state=6293500;dir=5;layer=0;row=0;pos=0;prop=100000;bestw=0;besth=0;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-103;floaty=351;floatw=595;floath=282|name=toolBar;caption=Tool bar;state=2124528;dir=1;layer=10;row=0;pos=0;prop=100000;bestw=808;besth=33;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=888;floaty=829;floatw=558;floath=49|dock_size(4,0,0)=583|dock_size(5,0,0)=10|dock_size(1,10,0)=35|")
 #else
 #ifdef __WXGTK__
-#define FRMSTATUS_DEFAULT_PERSPECTIVE wxT("layout2|name=Activity;caption=Activity;state=6293500;dir=4;layer=0;row=0;pos=2;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=Locks;caption=Locks;state=6293500;dir=4;layer=0;row=0;pos=1;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=Transactions;caption=Transactions;state=6293500;dir=4;layer=0;row=0;pos=0;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=Logfile;caption=Logfile;state=6293500;dir=5;layer=0;row=0;pos=0;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=toolBar;caption=Tool bar;state=2108144;dir=1;layer=10;row=0;pos=0;prop=100000;bestw=1020;besth=31;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|dock_size(4,0,0)=549|dock_size(5,0,0)=22|dock_size(1,10,0)=33|")
+#define FRMSTATUS_DEFAULT_PERSPECTIVE wxT("layout2|name=Activity;caption=Activity;state=6293500;dir=4;layer=0;row=0;pos=2;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=Locks;caption=Locks;state=6293500;dir=4;layer=0;row=0;pos=1;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=Transactions;caption=Transactions;state=6293500;dir=4;layer=0;row=0;pos=0;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=History;caption=History;state=6293500;dir=4;layer=0;row=0;pos=3;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=Logfile;caption=Logfile;state=6293500;dir=5;layer=0;row=0;pos=0;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=toolBar;caption=Tool bar;state=2108144;dir=1;layer=10;row=0;pos=0;prop=100000;bestw=1020;besth=31;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|dock_size(4,0,0)=549|dock_size(5,0,0)=22|dock_size(1,10,0)=33|")
 #else
-#define FRMSTATUS_DEFAULT_PERSPECTIVE wxT("layout2|name=Activity;caption=Activity;state=6309884;dir=4;layer=0;row=1;pos=0;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=174;floaty=216;floatw=578;floath=282|name=Locks;caption=Locks;state=6293500;dir=4;layer=0;row=1;pos=1;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=136;floaty=339;floatw=576;floath=283|name=Transactions;caption=Transactions;state=6293500;dir=4;layer=0;row=1;pos=2;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=133;floaty=645;floatw=577;floath=283|name=Logfile;caption=Logfile;state=6293500;dir=5;layer=0;row=0;pos=0;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=toolBar;caption=Tool bar;state=2108144;dir=1;layer=10;row=0;pos=0;prop=100000;bestw=716;besth=23;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=586;floaty=525;floatw=483;floath=49|dock_size(5,0,0)=22|dock_size(1,10,0)=25|dock_size(4,0,1)=627|")
+#define FRMSTATUS_DEFAULT_PERSPECTIVE wxT("layout2|name=Activity;caption=Activity;state=6309884;dir=4;layer=0;row=1;pos=0;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=174;floaty=216;floatw=578;floath=282|name=Locks;caption=Locks;state=6293500;dir=4;layer=0;row=1;pos=1;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=136;floaty=339;floatw=576;floath=283|name=Transactions;caption=Transactions;state=6293500;dir=4;layer=0;row=1;pos=2;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=133;floaty=645;floatw=577;floath=283|name=History;caption=History;state=6293500;dir=4;layer=0;row=1;pos=3;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=133;floaty=645;floatw=577;floath=283|name=Logfile;caption=Logfile;state=6293500;dir=5;layer=0;row=0;pos=0;prop=100000;bestw=20;besth=20;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=-1;floaty=-1;floatw=-1;floath=-1|name=toolBar;caption=Tool bar;state=2108144;dir=1;layer=10;row=0;pos=0;prop=100000;bestw=716;besth=23;minw=-1;minh=-1;maxw=-1;maxh=-1;floatx=586;floaty=525;floatw=483;floath=49|dock_size(5,0,0)=22|dock_size(1,10,0)=25|dock_size(4,0,1)=627|")
 #endif
 #endif
 
@@ -100,6 +128,32 @@ private:
 	frmMain *mainForm;
 	pgConn *connection, *locks_connection;
 
+	// The activity, locks and transactions are queried on this one in the
+	// background, so that the window doesn't wait for the server
+	pgConn *refresh_connection;
+	long refresh_pid;
+	bool refreshFailed;
+	// One refresh at a time per pane, and whether another one has been
+	// asked for meanwhile
+	pgQueryThread *refreshThreads[PANE_XACT + 1];
+	bool refreshAgain[PANE_XACT + 1];
+	// Whether the locks being refreshed are the blocking chains
+	bool refreshBlocking;
+
+	// The last snapshot of the blocking chains, and the sessions whose
+	// chains are collapsed
+	waitForGraph *lockGraph;
+	wxArrayLong collapsedPids;
+
+	// The activity is sampled each second on a connection of its own
+	statusHistory *history;
+	pgConn *history_connection;
+	pgQueryThread *historyThread;
+	long history_pid;
+	wxString historyQuery;
+	wxLongLong historyStarted;
+	bool historyFailed;
+
 	wxString logFormat;
 	bool logHasTimestamp, logFormatKnown;
 	int logFmtPos;
@@ -107,14 +161,22 @@ private:
 	wxDateTime logfileTimestamp, latestTimestamp;
 	wxString logDirectory, logfileName;
 
-	wxString savedPartialLine;
+	// The logfile is read in chunks in the background, on a connection
+	// of its own. The bytes after the last complete line are kept for
+	// the next chunk.
+	pgConn *log_connection;
+	pgQueryThread *logThread;
+	long log_pid;
+	bool logFailed, logSkipFirst;
+	wxMemoryBuffer logPending;
 
 	bool showCurrent, isCurrent;
 
 	long backend_pid;
 
 	bool loaded;
-	long logfileLength;
+	// The offset read up to
+	wxLongLong logfileLength;
 
 	int currentPane;
 
@@ -131,21 +193,26 @@ private:
 	ctlComboBoxFix *cbDatabase;
 
 	wxTimer *refreshUITimer;
-	wxTimer *statusTimer, *locksTimer, *xactTimer, *logTimer;
+	wxTimer *statusTimer, *locksTimer, *xactTimer, *logTimer, *historyTimer;
 	int statusRate, locksRate, xactRate, logRate;
 
-	ctlListView   *statusList;
-	ctlListView   *lockList;
-	ctlListView   *xactList;
-	ctlListView   *logList;
+	ctlStatusList *statusList;
+	ctlStatusList *lockList;
+	ctlStatusList *blockList;
+	wxChoice      *cbLockView;
+	wxStaticText  *stLockSummary;
+	ctlStatusList *xactList;
+	ctlLogList    *logList;
+	wxChoice      *cbLogLevel;
+	wxTextCtrl    *txtLogFilter;
+	ctlStatusGraph *historyGraph;
+	wxChoice      *cbHistorySpan;
 
 	wxMenu        *actionMenu;
 	wxMenu        *statusPopupMenu;
 	wxMenu        *lockPopupMenu;
 	wxMenu        *xactPopupMenu;
 
-	wxArrayString queries;
-
 	int statusColWidth[12], lockColWidth[10], xactColWidth[5];
 
 	int cboToRate();
@@ -157,6 +224,7 @@ private:
 	void AddLockPane();
 	void AddXactPane();
 	void AddLogPane();
+	void AddHistoryPane();
 
 	void OnHelp(wxCommandEvent &ev);
 	void OnContents(wxCommandEvent &ev);
@@ -169,6 +237,7 @@ private:
 	void OnToggleLockPane(wxCommandEvent &event);
 	void OnToggleXactPane(wxCommandEvent &event);
 	void OnToggleLogPane(wxCommandEvent &event);
+	void OnToggleHistoryPane(wxCommandEvent &event);
 	void OnToggleToolBar(wxCommandEvent &event);
 	void OnDefaultView(wxCommandEvent &event);
 	void OnHighlightStatus(wxCommandEvent &event);
@@ -178,6 +247,24 @@ private:
 	void OnRefreshLocksTimer(wxTimerEvent &event);
 	void OnRefreshXactTimer(wxTimerEvent &event);
 	void OnRefreshLogTimer(wxTimerEvent &event);
+	void OnRefreshHistoryTimer(wxTimerEvent &event);
+	void OnHistoryResult(pgQueryResultEvent &ev);
+	void OnHistorySpan(wxCommandEvent &event);
+	void OnSaveHistory(wxCommandEvent &event);
+
+	pgConn *GetRefreshConnection(int pane);
+	void RunRefresh(int pane, const wxString &sql);
+	void StopRefresh(int pane);
+	void OnRefreshResult(pgQueryResultEvent &ev);
+	void RefreshDone(int pane, pgSet *set);
+	void FillStatusList(pgSet *dataSet1);
+	void FillLockList(pgSet *dataSet2);
+	wxString GetBlockingQuery();
+	void FillBlockList(pgSet *dataSet2);
+	void ShowBlockingChains();
+	void FillXactList(pgSet *dataSet3);
+	void SetQuietLogging(pgConn *conn);
+	bool IsOwnBackend(long pid);
 
 	void SetColumnImage(ctlListView *list, int col, int image);
 	void OnSortStatusGrid(wxListEvent &event);
@@ -210,6 +297,11 @@ private:
 	void OnLocksTerminateBtn(wxCommandEvent &event);
 	void OnSelStatusItem(wxListEvent &event);
 	void OnSelLockItem(wxListEvent &event);
+	void OnLockView(wxCommandEvent &event);
+	void OnBlockItemActivated(wxListEvent &event);
+	bool IsBlockingView();
+	ctlStatusList *GetLockList();
+	wxString GetLockPid(long item);
 	void OnSelXactItem(wxListEvent &event);
 	void OnSelLogItem(wxListEvent &event);
 	void OnLoadLogfile(wxCommandEvent &event);
@@ -223,8 +315,19 @@ private:
 	void emptyLogfileCombo();
 
 	void addLogFile(wxDateTime *dt, bool skipFirst);
-	void addLogFile(const wxString &filename, const wxDateTime timestamp, long len, long &read, bool skipFirst);
-	void addLogLine(const wxString &str, bool formatted = true, bool csv_log_format = false);
+	void addLogFile(const wxString &filename, const wxDateTime timestamp, bool skipFirst);
+	void addLogText(const wxString &text);
+	void addLogLine(const wxString &str, bool formatted = true);
+	size_t addCsvLog(const char *data, size_t len);
+	void addCsvLogLine(const CSVSpan &line);
+	void checkLogRotation();
+
+	wxString logChunkQuery();
+	void readLogChunk();
+	bool logChunkRead(pgSet *set);
+	void stopLogRead();
+	void OnLogResult(pgQueryResultEvent &ev);
+	void OnLogFilter(wxCommandEvent &event);
 
 	void checkConnection();
 
@@ -23,12 +23,14 @@ class pgSchema;
 class pgForeignDataWrapper;
 class pgForeignServer;
 class pgUserMapping;
+class ctlTreeLoader;
 
 // Class declarations
 class pgCollection : public pgObject
 {
 public:
 	pgCollection(pgaFactory *factory);
+	~pgCollection();
 
 	virtual bool IsCollection() const
 	{
@@ -78,6 +80,22 @@ public:
 	void UpdateChildCount(ctlTree *browser, int substract = 0);
 	pgObject *FindChild(ctlTree *browser, const int index);
 
+	// Large collections show a page of objects at a time. The rows of the
+	// others are kept, and turned into objects when the user asks for them.
+	void SetPendingObjects(ctlTree *browser, pgSet *set);
+	void AppendMoreObjects(ctlTree *browser);
+	long GetPendingCount() const;
+	bool IsMoreItem(const wxTreeItemId &item) const
+	{
+		return pendingObjects && item == moreItem;
+	}
+
+	// Set, while the objects are being loaded in the background
+	void SetLoader(ctlTreeLoader *l)
+	{
+		loader = l;
+	}
+
 	bool HasStats()
 	{
 		return false;
@@ -99,6 +117,9 @@ protected:
 	pgForeignDataWrapper *fdw;
 	pgForeignServer *fsrv;
 	pgUserMapping *um;
+	ctlTreeLoader *loader;
+	pgSet *pendingObjects;
+	wxTreeItemId moreItem;
 };
 
 
@@ -25,6 +25,7 @@ class pgSet;
 class pgServer;
 class pgTable;
 class pgaJob;
+class ctlListFiller;
 
 
 class pgTypes
@@ -362,6 +363,9 @@ public:
 protected:
 	void CreateList3Columns(ctlListView *properties, const wxString &left = _("Object"), const wxString &middle = _("Owner"), const wxString &right = _("Value"));
 	void CreateListColumns(ctlListView *properties, const wxString &left = _("Property"), const wxString &right = _("Value"));
+	// Adds the rows of the query to the list, in the background if the
+	// list supports it
+	void FillList(ctlListView *list, pgConn *conn, const wxString &query, ctlListFiller *filler);
 
 	void AppendMenu(wxMenu *menu, int type = -1);
 	virtual void SetContextInfo(frmMain *form) {}
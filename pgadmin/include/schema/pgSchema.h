@@ -168,12 +168,23 @@ public:
 		return true;
 	}
 
+	// Objects of a child collection, fetched together with the others when
+	// the schema is expanded. The caller takes the ownership of the set.
+	pgSet *TakePrefetchedObjects(pgaFactory *factory);
+
 protected:
 	wxString m_defPrivsOnTables, m_defPrivsOnSeqs, m_defPrivsOnFuncs, m_defPrivsOnTypes;
 
 private:
+	void PrefetchObjects();
+	void ClearPrefetchedObjects();
+	void SetDefaultPrivileges(pgSet *set);
+
 	long schemaTyp;
 	bool createPrivilege;
+
+	wxArrayPtrVoid prefetchFactories;
+	pgSetArray prefetchSets;
 };
 
 class pgSchema : public pgSchemaBase
@@ -20,7 +20,8 @@ class pgSequenceFactory : public pgSchemaObjFactory
 public:
 	pgSequenceFactory();
 	virtual dlgProperty *CreateDialog(frmMain *frame, pgObject *node, pgObject *parent);
-	virtual pgObject *CreateObjects(pgCollection *obj, ctlTree *browser, const wxString &restr = wxEmptyString);
+	virtual wxString GetObjectsQuery(pgCollection *obj, const wxString &restr = wxEmptyString);
+	virtual pgObject *CreateObjectFromSet(pgCollection *obj, pgSet *set);
 	virtual pgCollection *CreateCollection(pgObject *obj);
 	int GetReplicatedIconId()
 	{
@@ -60,6 +60,13 @@ public:
 	}
 	wxString GetTranslatedMessage(int kindOfMessage) const;
 	int Connect(frmMain *form, bool askPassword = true, const wxString &pwd = wxEmptyString, bool forceStorePassword = false, bool askTunnelPassword = false);
+	// Connecting without blocking: StartConnect() creates the connection
+	// object, which has to be polled (pgConn::PollConnect()) until it is
+	// done, then FinishConnect() completes the server object. Returns false,
+	// if the connection would need a password to be entered or a tunnel to
+	// be set up.
+	bool StartConnect();
+	int FinishConnect(frmMain *form, bool storePassword = false);
 	bool Disconnect(frmMain *form);
 	void StorePassword();
 	bool GetPasswordIsStored();
@@ -214,6 +221,7 @@ public:
 		replayTimestamp = s;
 	}
 
+	// Takes an idle connection from the pgConnPool, if there is one
 	pgConn *CreateConn(wxString dbName = wxEmptyString, OID oid = 0, wxString applicationname = wxEmptyString);
 
 	wxString GetLastDatabase() const
@@ -530,6 +538,7 @@ public:
 
 private:
 	wxString passwordFilename();
+	wxString GetPoolKey(const wxString &dbName);
 
 	pgConn *conn;
 	long serverIndex;
@@ -21,7 +21,8 @@ class pgViewFactory : public pgSchemaObjFactory
 public:
 	pgViewFactory();
 	virtual dlgProperty *CreateDialog(frmMain *frame, pgObject *node, pgObject *parent);
-	virtual pgObject *CreateObjects(pgCollection *obj, ctlTree *browser, const wxString &restr = wxEmptyString);
+	virtual wxString GetObjectsQuery(pgCollection *obj, const wxString &restr = wxEmptyString);
+	virtual pgObject *CreateObjectFromSet(pgCollection *obj, pgSet *set);
 	virtual pgCollection *CreateCollection(pgObject *obj);
 	int GetMaterializedIconId()
 	{
@@ -24,6 +24,7 @@
 #endif
 
 class pgObject;
+class pgSet;
 class frmMain;
 class dlgProperty;
 class ctlTree;
@@ -36,10 +37,21 @@ class pgaFactory
 {
 public:
 	virtual dlgProperty *CreateDialog(frmMain *frame, pgObject *node, pgObject *parent) = 0;
-	virtual pgObject *CreateObjects(pgCollection  *obj, ctlTree *browser, const wxString &restr = wxEmptyString)
+	virtual pgObject *CreateObjects(pgCollection  *obj, ctlTree *browser, const wxString &restr = wxEmptyString);
+	// Factories, which list their objects with a single query, return it
+	// here, and create the objects from its rows using CreateObjectFromSet().
+	// This allows the objects to be loaded in the background.
+	virtual wxString GetObjectsQuery(pgCollection *obj, const wxString &restr = wxEmptyString)
+	{
+		return wxEmptyString;
+	}
+	virtual pgObject *CreateObjectFromSet(pgCollection *obj, pgSet *set)
 	{
 		return 0;
 	}
+	// Creates the objects from the rows of GetObjectsQuery(), and takes
+	// the ownership of the set
+	pgObject *AppendObjectsFromSet(pgCollection *obj, ctlTree *browser, pgSet *set);
 	virtual pgCollection *CreateCollection(pgObject *obj) = 0;
 	virtual bool IsCollection()
 	{
@@ -115,6 +127,8 @@ public:
 		return itemFactory;
 	}
 	pgObject *CreateObjects(pgCollection  *obj, ctlTree *browser, const wxString &restr = wxEmptyString);
+	wxString GetObjectsQuery(pgCollection *obj, const wxString &restr = wxEmptyString);
+	pgObject *CreateObjectFromSet(pgCollection *obj, pgSet *set);
 
 protected:
 	virtual bool IsCollection()
@@ -18,10 +18,12 @@ pgadmin3_SOURCES += \
 	include/utils/pgDefs.h \
 	include/utils/pgconfig.h \
 	include/utils/registry.h \
+	include/utils/statusHistory.h \
 	include/utils/sysLogger.h \
 	include/utils/sysProcess.h \
 	include/utils/sysSettings.h \
 	include/utils/utffile.h \
+	include/utils/waitForGraph.h \
 	include/utils/macros.h
 
 if BUILD_SSH_TUNNEL
@@ -65,6 +65,7 @@
 #define PGOID_TYPE_TRIGGER                  2279L
 #define PGOID_TYPE_LANGUAGE_HANDLER         2280L
 #define PGOID_TYPE_INTERNAL                 2281L
+#define PGOID_TYPE_UUID                     2950L
 #define PGOID_TYPE_HANDLER                  3115L
 
 
@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// statusHistory.h - Recent history of the server's activity, as rates
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef STATUSHISTORY_H
+#define STATUSHISTORY_H
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// 24 hours at one sample per second
+#define STATUSHISTORY_CAPACITY  86400
+
+enum
+{
+	HISTORY_XACTS = 0,      // Counters, shown as rates
+	HISTORY_TUP_READ,
+	HISTORY_TUP_WRITTEN,
+	HISTORY_BLKS_HIT,
+	HISTORY_BLKS_READ,
+	HISTORY_ACTIVE,         // Gauges, shown as they are
+	HISTORY_WAITING,
+
+	HISTORY_METRICS
+};
+
+// Only the differences to the previous sample are kept for the
+// counters, which fit in 32 bits even on the busiest servers.
+class statusSample
+{
+public:
+	// Since the time of the first sample, and since the previous sample
+	wxUint32 offsetMs;
+	wxUint32 intervalMs;
+	wxInt32  values[HISTORY_METRICS];
+};
+
+// The memory is allocated once. When full, the oldest sample is
+// overwritten by the newest one.
+class statusHistory
+{
+public:
+	statusHistory(size_t _capacity = STATUSHISTORY_CAPACITY);
+	~statusHistory();
+
+	// The readings (HISTORY_METRICS of them) taken at the time (in ms
+	// since the epoch). The first reading is only kept as the base of the
+	// next one.
+	void AddReading(const wxLongLong &time, const wxLongLong *readings);
+	void Clear();
+
+	// The samples are numbered from the oldest one (0)
+	size_t GetCount() const
+	{
+		return count;
+	}
+	wxLongLong GetTime(size_t i) const
+	{
+		return baseTime + wxLongLong(0, Sample(i).offsetMs);
+	}
+	// Per second for the counters
+	double GetValue(size_t i, int metric) const;
+	// The first sample taken at the time, or later
+	size_t FindTime(const wxLongLong &time) const;
+
+	static bool IsCounter(int metric)
+	{
+		return metric < HISTORY_ACTIVE;
+	}
+	static wxString GetMetricName(int metric);
+
+	// One line per sample, with its time and values
+	wxString GetCsv() const;
+
+private:
+	const statusSample &Sample(size_t i) const
+	{
+		return samples[(first + i) % capacity];
+	}
+
+	statusSample *samples;
+	size_t capacity, first, count;
+
+	// Time of the offset 0
+	wxLongLong baseTime;
+
+	// The previous reading, which the next one is compared to
+	bool hasReading;
+	wxLongLong lastTime;
+	wxLongLong lastReadings[HISTORY_METRICS];
+};
+
+#endif
@@ -20,12 +20,45 @@
 #include <wx/config.h>
 #include <wx/fileconf.h>
 
+BEGIN_DECLARE_EVENT_TYPES()
+extern const wxEventType SETTINGS_CHANGED_EVENT;
+END_DECLARE_EVENT_TYPES()
+
+// The settings needed for every cell shown or copied by the result grids,
+// read once into plain fields, as reading wxConfig costs a lookup by key
+// (and maybe a file access) each time.
+class sysSettingsSnapshot
+{
+public:
+	bool indicateNull;
+	wxString decimalMark;
+	wxString thousandsSeparator;
+	long maxColSize;
+	wxString copyColSeparator;
+	wxString copyQuoteChar;
+	int copyQuoting;
+};
+
 // Class declarations
 class sysSettings : private wxConfig
 {
 public:
 	sysSettings(const wxString &name);
 	~sysSettings();
+
+	// The snapshot of the settings above, as they were when the options
+	// were saved last
+	const sysSettingsSnapshot &GetSnapshot()
+	{
+		if (!snapshot)
+			snapshot = ReadSnapshot();
+		return *snapshot;
+	}
+	// Rebuilds the snapshot, after the options have been saved, and sends
+	// SETTINGS_CHANGED_EVENT to the listeners then
+	void PublishSnapshot();
+	void AddSnapshotListener(wxEvtHandler *handler);
+	void RemoveSnapshotListener(wxEvtHandler *handler);
 	// Display options
 	bool GetDisplayOption(const wxString &objtype, bool GetDefault = false);
 	void SetDisplayOption(const wxString &objtype, bool display);
@@ -714,6 +747,56 @@ public:
 	{
 		WriteLong(wxT("frmQuery/MaxColSize"), newval);
 	}
+	bool GetStreamResults() const
+	{
+		bool b;
+		Read(wxT("frmQuery/StreamResults"), &b, true);
+		return b;
+	}
+	void SetStreamResults(const bool newval)
+	{
+		WriteBool(wxT("frmQuery/StreamResults"), newval);
+	}
+	long GetStreamBatchRows() const
+	{
+		long l;
+		Read(wxT("frmQuery/StreamBatchRows"), &l, 1000L);
+		return l;
+	}
+	void SetStreamBatchRows(const long newval)
+	{
+		WriteLong(wxT("frmQuery/StreamBatchRows"), newval);
+	}
+	long GetStreamMemoryLimit() const // in kB, 0=unlimited
+	{
+		long l;
+		Read(wxT("frmQuery/StreamMemoryLimit"), &l, 262144L);
+		return l;
+	}
+	void SetStreamMemoryLimit(const long newval)
+	{
+		WriteLong(wxT("frmQuery/StreamMemoryLimit"), newval);
+	}
+	int GetStreamMemoryPolicy() const // 0=stop 1=spill to disk
+	{
+		int i;
+		Read(wxT("frmQuery/StreamMemoryPolicy"), &i, 1);
+		return i;
+	}
+	void SetStreamMemoryPolicy(const int newval)
+	{
+		WriteInt(wxT("frmQuery/StreamMemoryPolicy"), newval);
+	}
+	bool GetBinaryResults() const
+	{
+		bool b;
+		Read(wxT("frmQuery/BinaryResults"), &b, false);
+		return b;
+	}
+	void SetBinaryResults(const bool newval)
+	{
+		WriteBool(wxT("frmQuery/BinaryResults"), newval);
+	}
 	bool GetAskSaveConfirmation() const
 	{
 		bool b;
@@ -763,6 +846,39 @@ public:
 	{
 		WriteInt(wxT("RefreshOnClick"), newval);
 	}
+	bool GetBackgroundTreeLoading() const
+	{
+		bool b;
+		Read(wxT("BackgroundTreeLoading"), &b, true);
+		return b;
+	}
+	void SetBackgroundTreeLoading(const bool newval)
+	{
+		WriteBool(wxT("BackgroundTreeLoading"), newval);
+	}
+	// Connect at startup to the servers, which have been connected when
+	// pgAdmin was closed (and need no password to be entered)
+	bool GetReconnectServers() const
+	{
+		bool b;
+		Read(wxT("ReconnectServers"), &b, true);
+		return b;
+	}
+	void SetReconnectServers(const bool newval)
+	{
+		WriteBool(wxT("ReconnectServers"), newval);
+	}
+	// Objects added to a collection at a time, 0 adds them all at once
+	int GetBrowserPageSize() const
+	{
+		int i;
+		Read(wxT("BrowserPageSize"), &i, 1000);
+		return i;
+	}
+	void SetBrowserPageSize(const int newval)
+	{
+		WriteInt(wxT("BrowserPageSize"), newval);
+	}
 
 	bool GetShowNotices() const
 	{
@@ -841,7 +957,11 @@ private:
 	bool moveStringValue(const wxChar *oldKey, const wxChar *newKey, int index = -1);
 	bool moveLongValue(const wxChar *oldKey, const wxChar *newKey, int index = -1);
 
+	sysSettingsSnapshot *ReadSnapshot();
+
 	wxFileConfig *defaultSettings;
+	sysSettingsSnapshot *snapshot;
+	wxArrayPtrVoid snapshotListeners;
 };
 
 #endif
@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// waitForGraph.h - Which sessions wait for which, as blocking chains
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef WAITFORGRAPH_H
+#define WAITFORGRAPH_H
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/hashmap.h>
+
+// A session waiting, or being waited for
+class waitForSession
+{
+public:
+	waitForSession(long _pid) : pid(_pid), depth(0), behind(0), inCycle(false) {}
+
+	long pid;
+	// Whatever the caller wants to show about the session
+	wxArrayString values;
+
+	// Set by Analyze(): the level in the tree (0 for the roots), the number
+	// of sessions below it in the tree, and whether it is part of a cycle,
+	// i.e. of a deadlock
+	int depth;
+	size_t behind;
+	bool inCycle;
+};
+WX_DEFINE_ARRAY_PTR(waitForSession *, waitForSessionArray);
+WX_DECLARE_HASH_MAP(long, long, wxIntegerHash, wxIntegerEqual, waitForPidMap);
+
+// The sessions are shown as a forest. Its roots are the sessions which
+// wait for nobody, and one session of each cycle nobody else leads to.
+// A session waiting for several others is shown once, below the first
+// one reached. Analyze() takes linear time in the sessions and waits.
+class waitForGraph
+{
+public:
+	waitForGraph();
+	~waitForGraph();
+
+	void Clear();
+
+	// Adds both sessions, if not there yet
+	void AddWait(long waiter, long blocker);
+	// NULL if not added
+	waitForSession *FindSession(long pid) const;
+
+	// Builds the tree, the roots with the most sessions behind them first
+	void Analyze();
+
+	// In tree order: each session is followed by the sessions below it
+	size_t GetCount() const
+	{
+		return order.GetCount();
+	}
+	const waitForSession &GetSession(size_t i) const
+	{
+		return *sessions.Item(order.Item(i));
+	}
+
+	size_t GetRootCount() const
+	{
+		return roots;
+	}
+	size_t GetCycleCount() const
+	{
+		return cycles;
+	}
+
+private:
+	long AddSession(long pid);
+
+	waitForSessionArray sessions;
+	waitForPidMap indices;
+
+	// The waits, as indices of the sessions
+	wxArrayLong waiters, blockers;
+
+	// The indices of the sessions in tree order
+	wxArrayLong order;
+	size_t roots, cycles;
+};
+
+#endif
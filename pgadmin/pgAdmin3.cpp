@@ -62,6 +62,8 @@
 #include "frm/frmSplash.h"
 #include "dlg/dlgSelectConnection.h"
 #include "db/pgConn.h"
+#include "db/pgQueryExecutor.h"
+#include "db/pgConnPool.h"
 #include "utils/sysLogger.h"
 #include "utils/registry.h"
 #include "frm/frmHint.h"
@@ -838,6 +840,10 @@ int pgAdmin3::OnExit()
 		delete updateThread;
 	}
 
+	// All the windows are gone, so are the queries they have been running
+	pgQueryExecutor::Shutdown();
+	pgConnPool::Shutdown();
+
 	// Delete the settings object to ensure settings are saved.
 	delete settings;
 
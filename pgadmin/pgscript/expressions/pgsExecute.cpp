@@ -94,13 +94,14 @@ pgsOperand pgsExecute::eval(pgsVarMap &vars) const
 				{
 					if (m_app->TestDestroy()) // wxThread::TestDestroy()
 					{
-						thread.Delete();
+						thread.CancelExecution();
+						thread.Wait();
 						break;
 					}
-					else if (thread.IsRunning())
+					else if (!thread.WaitForCompletion(20))
 					{
-						m_app->Yield();
-						m_app->Sleep(20);
+						// Still running - check for the destruction again
+						continue;
 					}
 					else
 					{
@@ -14,6 +14,7 @@
 
 // App headers
 #include "pgAdmin3.h"
+#include "ctl/ctlTreeLoader.h"
 #include "frm/menu.h"
 #include "utils/misc.h"
 #include "agent/pgaJob.h"
@@ -32,6 +33,17 @@ pgCollection::pgCollection(pgaFactory *factory)
 	schema = 0;
 	database = 0;
 	server = 0;
+	loader = 0;
+	pendingObjects = 0;
+}
+
+
+pgCollection::~pgCollection()
+{
+	if (loader)
+		loader->Cancel(this, false);
+	if (pendingObjects)
+		delete pendingObjects;
 }
 
 bool pgCollection::IsCollectionFor(pgObject *obj)
@@ -93,11 +105,84 @@ void pgCollection::ShowList(const wxString &name, ctlTree *browser, ctlListView
 void pgCollection::UpdateChildCount(ctlTree *browser, int substract)
 {
 	wxString label;
-	label.Printf(wxString(wxGetTranslation(GetName())) + wxT(" (%d)"), (int)browser->GetChildrenCount(GetId(), false) - substract);
+	int count = (int)browser->GetChildrenCount(GetId(), false) - substract;
+
+	// The "Show next" item stands for the objects not added yet
+	if (pendingObjects)
+		count += GetPendingCount() - 1;
+
+	label.Printf(wxString(wxGetTranslation(GetName())) + wxT(" (%d)"), count);
 	browser->SetItemText(GetId(), label);
 }
 
 
+void pgCollection::SetPendingObjects(ctlTree *browser, pgSet *set)
+{
+	if (pendingObjects)
+		delete pendingObjects;
+
+	pendingObjects = set;
+	if (!pendingObjects)
+		return;
+
+	long count = GetPendingCount();
+	long pageSize = settings->GetBrowserPageSize();
+	if (pageSize <= 0 || pageSize > count)
+		pageSize = count;
+
+	moreItem = browser->AppendItem(GetId(),
+	                               wxString::Format(_("Show next %ld of %ld remaining..."), pageSize, count));
+}
+
+
+long pgCollection::GetPendingCount() const
+{
+	if (!pendingObjects || pendingObjects->Eof())
+		return 0;
+	return pendingObjects->NumRows() - pendingObjects->CurrentPos() + 1;
+}
+
+
+void pgCollection::AppendMoreObjects(ctlTree *browser)
+{
+	if (!pendingObjects || !GetFactory())
+		return;
+
+	long pageSize = settings->GetBrowserPageSize();
+	long count = 0;
+
+	browser->Freeze();
+	browser->Delete(moreItem);
+	moreItem = wxTreeItemId();
+
+	while (!pendingObjects->Eof() && (pageSize <= 0 || count < pageSize))
+	{
+		pgObject *obj = GetFactory()->CreateObjectFromSet(this, pendingObjects);
+		if (obj)
+			browser->AppendObject(this, obj);
+
+		pendingObjects->MoveNext();
+		count++;
+	}
+
+	if (pendingObjects->Eof())
+	{
+		delete pendingObjects;
+		pendingObjects = 0;
+	}
+	else
+	{
+		// Re-add the item below the objects just appended
+		pgSet *set = pendingObjects;
+		pendingObjects = 0;
+		SetPendingObjects(browser, set);
+	}
+	browser->Thaw();
+
+	UpdateChildCount(browser);
+}
+
+
 int pgCollection::GetIconId()
 {
 	pgaFactory *objFactory = pgaFactory::GetFactory(GetType());
@@ -133,9 +218,39 @@ pgObject *pgCollection::FindChild(ctlTree *browser, const int index)
 
 void pgCollection::ShowTreeDetail(ctlTree *browser, frmMain *form, ctlListView *properties, ctlSQLBox *sqlPane)
 {
+	if (loader && loader->IsLoading(this))
+	{
+		// The objects are still being fetched, the list will be shown,
+		// when they have been appended.
+		if (properties)
+			ShowList(browser, properties);
+		return;
+	}
+
+	if (!pendingObjects)
+		browser->RemoveDummyChild(this);
 	if (browser->GetChildrenCount(GetId(), false) == 0)
 	{
-		if (GetFactory())
+		// The children have been removed (i.e. refreshed)
+		if (pendingObjects)
+		{
+			delete pendingObjects;
+			pendingObjects = 0;
+		}
+
+		if (GetFactory() && browser->GetLoader()->Load(this))
+			return;
+
+		// Fetched together with the other collections of the schema, when
+		// not loaded in the background
+		pgSet *prefetched = 0;
+		if (schema && GetItemFactory() &&
+		        (schema->GetMetaType() == PGM_SCHEMA || schema->GetMetaType() == PGM_CATALOG))
+			prefetched = schema->TakePrefetchedObjects(GetItemFactory());
+
+		if (prefetched)
+			GetFactory()->AppendObjectsFromSet(this, browser, prefetched);
+		else if (GetFactory())
 			GetFactory()->CreateObjects(this, browser);
 	}
 
@@ -19,6 +19,7 @@
 #include "schema/pgServer.h"
 #include "frm/frmMain.h"
 #include "frm/frmReport.h"
+#include "ctl/ctlPaneLoader.h"
 #include "schema/pgDomain.h"
 #include "schema/pgAggregate.h"
 #include "schema/pgSequence.h"
@@ -238,196 +239,228 @@ bool pgObject::UpdateIcon(ctlTree *browser)
 }
 
 
-void pgObject::ShowDependency(pgDatabase *db, ctlListView *list, const wxString &query, const wxString &clsorder)
+// Fills the dependencies and dependents lists
+class dependencyListFiller : public ctlListFiller
 {
-	list->ClearAll();
-	list->AddColumn(_("Type"), 60);
-	list->AddColumn(_("Name"), 100);
-	list->AddColumn(_("Restriction"), 50);
+public:
+	dependencyListFiller(pgDatabase *_db) : db(_db) {}
+	void Fill(ctlListView *list, pgSet *set);
 
-	pgConn *conn = GetConnection();
-	if (conn)
-	{
-		pgSet *set;
-		// currently missing:
-		// - pg_cast
-		// - pg_operator
-		// - pg_opclass
+private:
+	pgDatabase *db;
+};
 
-		// not being implemented:
-		// - pg_index (done by pg_class)
 
-		set = conn->ExecuteSet(query + wxT("\n")
-		                       wxT("   AND ") + clsorder + wxT(" IN (\n")
-		                       wxT("   SELECT oid FROM pg_class\n")
-		                       wxT("    WHERE relname IN ('pg_class', 'pg_constraint', 'pg_conversion', 'pg_language', 'pg_proc',\n")
-		                       wxT("                      'pg_rewrite', 'pg_namespace', 'pg_trigger', 'pg_type', 'pg_attrdef', 'pg_event_trigger'))\n")
-		                       wxT(" ORDER BY ") + clsorder + wxT(", cl.relkind"));
+void dependencyListFiller::Fill(ctlListView *list, pgSet *set)
+{
+	while (!set->Eof())
+	{
+		wxString refname;
+		wxString _refname = set->GetVal(wxT("refname"));
 
-		if (set)
+		if (db)
+			refname = db->GetQuotedSchemaPrefix(set->GetVal(wxT("nspname")));
+		else
 		{
-			while (!set->Eof())
-			{
-				wxString refname;
-				wxString _refname = set->GetVal(wxT("refname"));
+			refname = qtIdent(set->GetVal(wxT("nspname")));
+			if (!refname.IsEmpty())
+				refname += wxT(".");
+		}
 
-				if (db)
-					refname = db->GetQuotedSchemaPrefix(set->GetVal(wxT("nspname")));
-				else
-				{
-					refname = qtIdent(set->GetVal(wxT("nspname")));
-					if (!refname.IsEmpty())
-						refname += wxT(".");
-				}
+		wxString typestr = set->GetVal(wxT("type"));
+		pgaFactory *depFactory = 0;
+		switch ((wxChar)typestr.c_str()[0])
+		{
+			case 'c':
+			case 's':   // we don't know these; internally handled
+			case 't':
+				set->MoveNext();
+				continue;
 
-				wxString typestr = set->GetVal(wxT("type"));
-				pgaFactory *depFactory = 0;
-				switch ((wxChar)typestr.c_str()[0])
+			case 'r':
+			{
+				if (StrToLong(typestr.Mid(1)) > 0)
+					depFactory = &columnFactory;
+				else
+					depFactory = &tableFactory;
+				break;
+			}
+			case 'i':
+				depFactory = &indexFactory;
+				break;
+			case 'S':
+				depFactory = &sequenceFactory;
+				break;
+			case 'v':
+				depFactory = &viewFactory;
+				break;
+			case 'x':
+				depFactory = &extTableFactory;
+				break;
+			case 'p':
+				depFactory = &functionFactory;
+				break;
+			case 'n':
+				depFactory = &schemaFactory;
+				break;
+			case 'y':
+				depFactory = &typeFactory;
+				break;
+			case 'T':
+				depFactory = &triggerFactory;
+				break;
+			case 'l':
+				depFactory = &languageFactory;
+				break;
+			case 'R':
+			{
+				refname = _refname + wxT(" ON ") + refname + set->GetVal(wxT("ownertable"));
+				_refname = wxEmptyString;
+				depFactory = &ruleFactory;
+				break;
+			}
+			case 'C':
+			{
+				switch ((wxChar)typestr.c_str()[1])
 				{
 					case 'c':
-					case 's':   // we don't know these; internally handled
-					case 't':
-						set->MoveNext();
-						continue;
-
-					case 'r':
-					{
-						if (StrToLong(typestr.Mid(1)) > 0)
-							depFactory = &columnFactory;
-						else
-							depFactory = &tableFactory;
-						break;
-					}
-					case 'i':
-						depFactory = &indexFactory;
-						break;
-					case 'S':
-						depFactory = &sequenceFactory;
+						depFactory = &checkFactory;
 						break;
-					case 'v':
-						depFactory = &viewFactory;
-						break;
-					case 'x':
-						depFactory = &extTableFactory;
+					case 'f':
+						refname += set->GetVal(wxT("ownertable")) + wxT(".");
+						depFactory = &foreignKeyFactory;
 						break;
 					case 'p':
-						depFactory = &functionFactory;
-						break;
-					case 'n':
-						depFactory = &schemaFactory;
-						break;
-					case 'y':
-						depFactory = &typeFactory;
-						break;
-					case 'T':
-						depFactory = &triggerFactory;
+						depFactory = &primaryKeyFactory;
 						break;
-					case 'l':
-						depFactory = &languageFactory;
+					case 'u':
+						depFactory = &uniqueFactory;
 						break;
-					case 'R':
-					{
-						refname = _refname + wxT(" ON ") + refname + set->GetVal(wxT("ownertable"));
-						_refname = wxEmptyString;
-						depFactory = &ruleFactory;
-						break;
-					}
-					case 'C':
-					{
-						switch ((wxChar)typestr.c_str()[1])
-						{
-							case 'c':
-								depFactory = &checkFactory;
-								break;
-							case 'f':
-								refname += set->GetVal(wxT("ownertable")) + wxT(".");
-								depFactory = &foreignKeyFactory;
-								break;
-							case 'p':
-								depFactory = &primaryKeyFactory;
-								break;
-							case 'u':
-								depFactory = &uniqueFactory;
-								break;
-							case 'x':
-								depFactory = &excludeFactory;
-								break;
-							default:
-								break;
-						}
+					case 'x':
+						depFactory = &excludeFactory;
 						break;
-					}
-					case 'A':
-					{
-						// Include only functions
-						if (set->GetVal(wxT("adbin")).StartsWith(wxT("{FUNCEXPR")))
-						{
-							depFactory = &functionFactory;
-							refname = set->GetVal(wxT("adsrc"));
-							break;
-						}
-						else
-						{
-							set->MoveNext();
-							continue;
-						}
-					}
 					default:
 						break;
 				}
-
-				refname += _refname;
-
-				wxString typname;
-				int icon;
-				if (depFactory)
+				break;
+			}
+			case 'A':
+			{
+				// Include only functions
+				if (set->GetVal(wxT("adbin")).StartsWith(wxT("{FUNCEXPR")))
 				{
-					typname = depFactory->GetTypeName();
-					icon = depFactory->GetIconId();
+					depFactory = &functionFactory;
+					refname = set->GetVal(wxT("adsrc"));
+					break;
 				}
 				else
 				{
-					typname = _("Unknown");
-					icon = -1;
+					set->MoveNext();
+					continue;
 				}
+			}
+			default:
+				break;
+		}
 
-				wxString deptype;
+		refname += _refname;
 
-				switch ( (wxChar) set->GetVal(wxT("deptype")).c_str()[0])
+		wxString typname;
+		int icon;
+		if (depFactory)
+		{
+			typname = depFactory->GetTypeName();
+			icon = depFactory->GetIconId();
+		}
+		else
+		{
+			typname = _("Unknown");
+			icon = -1;
+		}
+
+		wxString deptype;
+
+		switch ( (wxChar) set->GetVal(wxT("deptype")).c_str()[0])
+		{
+			case 'n':
+				deptype = wxT("normal");
+				break;
+			case 'a':
+				deptype = wxT("auto");
+				break;
+			case 'i':
+			{
+				if (settings->GetShowSystemObjects())
+					deptype = wxT("internal");
+				else
 				{
-					case 'n':
-						deptype = wxT("normal");
-						break;
-					case 'a':
-						deptype = wxT("auto");
-						break;
-					case 'i':
-					{
-						if (settings->GetShowSystemObjects())
-							deptype = wxT("internal");
-						else
-						{
-							set->MoveNext();
-							continue;
-						}
-						break;
-					}
-					case 'p':
-						deptype = wxT("pin");
-						typname = wxEmptyString;
-						break;
-					default:
-						break;
+					set->MoveNext();
+					continue;
 				}
-
-				list->AppendItem(icon, typname, refname, deptype);
-				set->MoveNext();
+				break;
 			}
-			delete set;
+			case 'p':
+				deptype = wxT("pin");
+				typname = wxEmptyString;
+				break;
+			default:
+				break;
 		}
+
+		list->AppendItem(icon, typname, refname, deptype);
+		set->MoveNext();
 	}
 }
 
+
+void pgObject::ShowDependency(pgDatabase *db, ctlListView *list, const wxString &query, const wxString &clsorder)
+{
+	list->ClearAll();
+	list->AddColumn(_("Type"), 60);
+	list->AddColumn(_("Name"), 100);
+	list->AddColumn(_("Restriction"), 50);
+
+	pgConn *conn = GetConnection();
+	if (conn)
+	{
+		// currently missing:
+		// - pg_cast
+		// - pg_operator
+		// - pg_opclass
+
+		// not being implemented:
+		// - pg_index (done by pg_class)
+
+		wxString sql = query + wxT("\n")
+		               wxT("   AND ") + clsorder + wxT(" IN (\n")
+		               wxT("   SELECT oid FROM pg_class\n")
+		               wxT("    WHERE relname IN ('pg_class', 'pg_constraint', 'pg_conversion', 'pg_language', 'pg_proc',\n")
+		               wxT("                      'pg_rewrite', 'pg_namespace', 'pg_trigger', 'pg_type', 'pg_attrdef', 'pg_event_trigger'))\n")
+		               wxT(" ORDER BY ") + clsorder + wxT(", cl.relkind");
+
+		FillList(list, conn, sql, new dependencyListFiller(db));
+	}
+}
+
+
+void pgObject::FillList(ctlListView *list, pgConn *conn, const wxString &query, ctlListFiller *filler)
+{
+	if (list->GetPaneLoader())
+	{
+		list->GetPaneLoader()->Add(list, conn, query, filler);
+		return;
+	}
+
+	pgSet *set = conn->ExecuteSet(query);
+	if (set)
+	{
+		filler->Fill(list, set);
+		delete set;
+	}
+	delete filler;
+}
+
+
 void pgObject::CreateList3Columns(ctlListView *list, const wxString &left, const wxString &middle, const wxString &right)
 {
 	list->ClearAll();
@@ -664,6 +697,39 @@ void pgObject::ShowDependencies(frmMain *form, ctlListView *Dependencies, const
 }
 
 
+// Sequences used by the defaults of the columns, see ShowDependents()
+class sequenceDependentsFiller : public ctlListFiller
+{
+public:
+	void Fill(ctlListView *list, pgSet *set);
+};
+
+
+void sequenceDependentsFiller::Fill(ctlListView *list, pgSet *set)
+{
+	int iconId = sequenceFactory.GetIconId();
+
+	while (!set->Eof())
+	{
+		wxString refname = set->GetVal(wxT("refname"));
+		wxString deptype = set->GetVal(wxT("deptype"));
+		set->MoveNext();
+
+		if (refname.IsEmpty())
+			continue;
+
+		if (deptype == wxT("a"))
+			deptype = _("auto");
+		else if (deptype == wxT("n"))
+			deptype = _("normal");
+		else if (deptype == wxT("i"))
+			deptype = _("internal");
+
+		list->AppendItem(iconId, wxT("Sequence"), refname, deptype);
+	}
+}
+
+
 void pgObject::ShowDependents(frmMain *form, ctlListView *referencedBy, const wxString &wh)
 {
 	if (this->IsCollection())
@@ -802,7 +868,6 @@ void pgObject::ShowDependents(frmMain *form, ctlListView *referencedBy, const wx
 	*/
 	if (conn && (GetMetaType() == PGM_TABLE || GetMetaType() == PGM_COLUMN))
 	{
-		int iconId = sequenceFactory.GetIconId();
 		wxString strQuery =
 		    wxT("SELECT ref.relname AS refname, d2.refclassid, dep.deptype AS deptype\n")
 		    wxT("  FROM pg_depend dep\n")
@@ -814,24 +879,7 @@ void pgObject::ShowDependents(frmMain *form, ctlListView *referencedBy, const wx
 		    wxT("    AND dep.refobjid NOT IN (SELECT d3.refobjid FROM pg_depend d3 WHERE d3.objid=d2.refobjid)");
 
 
-		pgSetIterator set(conn, strQuery);
-
-		while (set.RowsLeft())
-		{
-			wxString refname = set.GetVal(wxT("refname"));
-			if (refname.IsEmpty())
-				continue;
-
-			wxString deptype = set.GetVal(wxT("deptype"));
-			if (deptype == wxT("a"))
-				deptype = _("auto");
-			else if (deptype == wxT("n"))
-				deptype = _("normal");
-			else if (deptype == wxT("i"))
-				deptype = _("internal");
-
-			referencedBy->AppendItem(iconId, wxT("Sequence"), refname, deptype);
-		}
+		FillList(referencedBy, conn, strQuery, new sequenceDependentsFiller());
 	}
 }
 
@@ -1447,6 +1495,22 @@ wxString pgDatabaseObject::GetQuotedSchemaPrefix(const wxString &schemaname) con
 }
 
 
+// One row of statistics, shown as a name/value pair per column
+class statisticsListFiller : public ctlListFiller
+{
+public:
+	void Fill(ctlListView *list, pgSet *set)
+	{
+		int col;
+		for (col = 0 ; col < set->NumCols() ; col++)
+		{
+			if (!set->ColName(col).IsEmpty())
+				list->AppendItem(set->ColName(col), set->GetVal(col));
+		}
+	}
+};
+
+
 void pgDatabaseObject::DisplayStatistics(ctlListView *statistics, const wxString &query)
 {
 	if (statistics)
@@ -1456,18 +1520,7 @@ void pgDatabaseObject::DisplayStatistics(ctlListView *statistics, const wxString
 		// Add the statistics view columns
 		CreateListColumns(statistics, _("Statistic"), _("Value"));
 
-		pgSet *stats = database->ExecuteSet(query);
-
-		if (stats)
-		{
-			int col;
-			for (col = 0 ; col < stats->NumCols() ; col++)
-			{
-				if (!stats->ColName(col).IsEmpty())
-					statistics->AppendItem(stats->ColName(col), stats->GetVal(col));
-			}
-			delete stats;
-		}
+		FillList(statistics, GetConnection(), query, new statisticsListFiller());
 	}
 }
 
@@ -179,6 +179,97 @@ pgSchemaBase::pgSchemaBase(pgaFactory &factory, const wxString &newName)
 {
 }
 
+
+void pgSchemaBase::PrefetchObjects()
+{
+	// Collections, which are populated with a single query
+	pgaFactory *factories[] = { &sequenceFactory, &tableFactory, &viewFactory };
+	const wxChar *options[] = { __("Sequences"), __("Tables"), __("Views") };
+	wxString sql;
+	size_t i;
+
+	ClearPrefetchedObjects();
+
+	// The browser loads these collections on a connection of its own then,
+	// without blocking the window while the server answers
+	if (settings->GetBackgroundTreeLoading())
+		return;
+
+	for (i = 0 ; i < WXSIZEOF(factories) ; i++)
+	{
+		if (!settings->GetDisplayOption(wxGetTranslation(options[i])))
+			continue;
+
+		pgCollection *collection = factories[i]->CreateCollection(this);
+		wxString query = factories[i]->GetObjectsQuery(collection);
+		delete collection;
+
+		if (query.IsEmpty())
+			continue;
+
+		sql += query + wxT(";\n");
+		prefetchFactories.Add(factories[i]);
+	}
+
+	// Default privileges, listed under the NULL factory
+	if (GetConnection()->BackendMinimumVersion(9, 0))
+	{
+		sql += wxT("SELECT defaclobjtype, defaclacl FROM pg_catalog.pg_default_acl dacl WHERE dacl.defaclnamespace = ") + GetOidStr() + wxT(";\n");
+		prefetchFactories.Add(NULL);
+	}
+
+	// Not worth it for a single query
+	if (prefetchFactories.GetCount() < 2 ||
+	        !GetConnection()->ExecuteSets(sql, prefetchSets, false) ||
+	        prefetchSets.GetCount() != prefetchFactories.GetCount())
+		ClearPrefetchedObjects();
+}
+
+
+pgSet *pgSchemaBase::TakePrefetchedObjects(pgaFactory *factory)
+{
+	int index = prefetchFactories.Index(factory);
+	if (index == wxNOT_FOUND)
+		return 0;
+
+	pgSet *set = prefetchSets.Item(index);
+	prefetchFactories.RemoveAt(index);
+	prefetchSets.RemoveAt(index);
+
+	return set;
+}
+
+
+void pgSchemaBase::ClearPrefetchedObjects()
+{
+	WX_CLEAR_ARRAY(prefetchSets);
+	prefetchFactories.Clear();
+}
+
+
+void pgSchemaBase::SetDefaultPrivileges(pgSet *set)
+{
+	if (!set)
+		return;
+
+	while (!set->Eof())
+	{
+		wxString objtype = set->GetVal(wxT("defaclobjtype"));
+
+		if (objtype == wxT("r"))
+			m_defPrivsOnTables = set->GetVal(wxT("defaclacl"));
+		else if (objtype == wxT("S"))
+			m_defPrivsOnSeqs = set->GetVal(wxT("defaclacl"));
+		else if (objtype == wxT("f"))
+			m_defPrivsOnFuncs = set->GetVal(wxT("defaclacl"));
+		else if (objtype == wxT("T") && GetConnection()->BackendMinimumVersion(9, 2))
+			m_defPrivsOnTypes = set->GetVal(wxT("defaclacl"));
+
+		set->MoveNext();
+	}
+	delete set;
+}
+
 wxString pgCatalog::GetDisplayName()
 {
 	if (GetFullName() == wxT("pg_catalog"))
@@ -329,6 +420,8 @@ void pgSchemaBase::ShowTreeDetail(ctlTree *browser, frmMain *form, ctlListView *
 
 		if (!(GetMetaType() == PGM_CATALOG && (GetFullName() == wxT("dbo") || GetFullName() == wxT("sys") || GetFullName() == wxT("information_schema"))))
 		{
+			PrefetchObjects();
+
 			if (settings->GetDisplayOption(_("Aggregates")))
 				browser->AppendCollection(this, aggregateFactory);
 			if (settings->GetDisplayOption(_("Collations")) && GetConnection()->BackendMinimumVersion(9, 1))
@@ -405,14 +498,13 @@ void pgSchemaBase::ShowTreeDetail(ctlTree *browser, frmMain *form, ctlListView *
 
 		if (GetConnection()->BackendMinimumVersion(9, 0))
 		{
-			m_defPrivsOnTables = GetConnection()->ExecuteScalar(wxT("SELECT defaclacl FROM pg_catalog.pg_default_acl dacl WHERE dacl.defaclnamespace = ") + GetOidStr() + wxT(" AND defaclobjtype='r'"));
-			m_defPrivsOnSeqs   = GetConnection()->ExecuteScalar(wxT("SELECT defaclacl FROM pg_catalog.pg_default_acl dacl WHERE dacl.defaclnamespace = ") + GetOidStr() + wxT(" AND defaclobjtype='S'"));
-			m_defPrivsOnFuncs  = GetConnection()->ExecuteScalar(wxT("SELECT defaclacl FROM pg_catalog.pg_default_acl dacl WHERE dacl.defaclnamespace = ") + GetOidStr() + wxT(" AND defaclobjtype='f'"));
-		}
-		if (GetConnection()->BackendMinimumVersion(9, 2))
-		{
-			m_defPrivsOnTypes = GetConnection()->ExecuteScalar(wxT("SELECT defaclacl FROM pg_catalog.pg_default_acl dacl WHERE dacl.defaclnamespace = ") + GetOidStr() + wxT(" AND defaclobjtype='T'"));
+			pgSet *set = TakePrefetchedObjects(0);
+			if (!set)
+				set = GetConnection()->ExecuteSet(wxT("SELECT defaclobjtype, defaclacl FROM pg_catalog.pg_default_acl dacl WHERE dacl.defaclnamespace = ") + GetOidStr());
+			SetDefaultPrivileges(set);
 		}
+
+		ClearPrefetchedObjects();
 	}
 
 
@@ -313,10 +313,8 @@ wxString pgSequenceCollection::GetTranslatedMessage(int kindOfMessage) const
 ///////////////////////////////////////////////////////////////////////////////
 
 
-pgObject *pgSequenceFactory::CreateObjects(pgCollection *collection, ctlTree *browser, const wxString &restriction)
+wxString pgSequenceFactory::GetObjectsQuery(pgCollection *collection, const wxString &restriction)
 {
-	pgSet *sequences;
-	pgSequence *sequence = 0;
 	wxString sql;
 
 	sql = wxT("SELECT cl.oid, relname, pg_get_userbyid(relowner) AS seqowner, relacl, description");
@@ -331,36 +329,26 @@ pgObject *pgSequenceFactory::CreateObjects(pgCollection *collection, ctlTree *br
 	       + restriction + wxT("\n")
 	       wxT(" ORDER BY relname");
 
-	sequences = collection->GetDatabase()->ExecuteSet(sql);
+	return sql;
+}
 
-	if (sequences)
-	{
-		while (!sequences->Eof())
-		{
-			sequence = new pgSequence(collection->GetSchema(),
-			                          sequences->GetVal(wxT("relname")));
 
-			sequence->iSetOid(sequences->GetOid(wxT("oid")));
-			sequence->iSetComment(sequences->GetVal(wxT("description")));
-			sequence->iSetOwner(sequences->GetVal(wxT("seqowner")));
-			sequence->iSetAcl(sequences->GetVal(wxT("relacl")));
+pgObject *pgSequenceFactory::CreateObjectFromSet(pgCollection *collection, pgSet *sequences)
+{
+	pgSequence *sequence = new pgSequence(collection->GetSchema(),
+	                                      sequences->GetVal(wxT("relname")));
 
-			if (collection->GetDatabase()->BackendMinimumVersion(9, 1))
-			{
-				sequence->iSetProviders(sequences->GetVal(wxT("providers")));
-				sequence->iSetLabels(sequences->GetVal(wxT("labels")));
-			}
+	sequence->iSetOid(sequences->GetOid(wxT("oid")));
+	sequence->iSetComment(sequences->GetVal(wxT("description")));
+	sequence->iSetOwner(sequences->GetVal(wxT("seqowner")));
+	sequence->iSetAcl(sequences->GetVal(wxT("relacl")));
 
-			if (browser)
-			{
-				browser->AppendObject(collection, sequence);
-				sequences->MoveNext();
-			}
-			else
-				break;
-		}
-		delete sequences;
+	if (collection->GetDatabase()->BackendMinimumVersion(9, 1))
+	{
+		sequence->iSetProviders(sequences->GetVal(wxT("providers")));
+		sequence->iSetLabels(sequences->GetVal(wxT("labels")));
 	}
+
 	return sequence;
 }
 
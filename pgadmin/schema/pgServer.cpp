@@ -23,7 +23,9 @@
 #include "ctl/ctlMenuToolbar.h"
 #include "frm/menu.h"
 #include "utils/misc.h"
+#include "db/pgConnPool.h"
 #include "frm/frmMain.h"
+#include "ctl/ctlServerConnector.h"
 #include "frm/frmHint.h"
 #include "dlg/dlgConnect.h"
 #include "schema/pgDatabase.h"
@@ -96,6 +98,9 @@ pgServer::pgServer(const wxString &newName, const wxString &newHostAddr, const w
 
 pgServer::~pgServer()
 {
+	if (winMain && winMain->GetServerConnector())
+		winMain->GetServerConnector()->Cancel(this);
+
 	if (conn)
 		delete conn;
 
@@ -229,7 +234,10 @@ pgConn *pgServer::CreateConn(wxString dbName, OID oid, wxString applicationname)
 		oid = dbOid;
 	}
 
-	pgConn *conn = NULL;
+	pgConn *conn = pgConnPool::Get()->Acquire(GetPoolKey(dbName), applicationname);
+	if (conn)
+		return conn;
+
 #if defined(HAVE_OPENSSL_CRYPTO) || defined(HAVE_GCRYPT)
 	if(sshTunnel)
 	{
@@ -251,6 +259,16 @@ pgConn *pgServer::CreateConn(wxString dbName, OID oid, wxString applicationname)
 }
 
 
+wxString pgServer::GetPoolKey(const wxString &dbName)
+{
+#if defined(HAVE_OPENSSL_CRYPTO) || defined(HAVE_GCRYPT)
+	if(sshTunnel)
+		return pgConnPool::GetKey(local_listenhost, service, hostaddr, local_listenport, dbName, username, rolename, ssl);
+#endif
+	return pgConnPool::GetKey(GetName(), service, hostaddr, port, dbName, username, rolename, ssl);
+}
+
+
 wxString pgServer::GetFullName()
 {
 	if (GetDescription().Length() > 0)
@@ -266,6 +284,9 @@ wxString pgServer::GetFullIdentifier()
 
 bool pgServer::Disconnect(frmMain *form)
 {
+	// The pooled connections may go through the tunnel
+	pgConnPool::Get()->Clear(GetPoolKey(wxEmptyString));
+
 #if defined(HAVE_OPENSSL_CRYPTO) || defined(HAVE_GCRYPT)
 	if(tunnelObj)
 	{
@@ -830,6 +851,38 @@ int pgServer::Connect(frmMain *form, bool askPassword, const wxString &pwd, bool
 			}
 		}
 	}
+	int status = FinishConnect(form, storePassword || forceStorePassword);
+
+	form->EndMsg(connected && status == PGCONN_OK);
+
+	return status;
+}
+
+
+bool pgServer::StartConnect()
+{
+	if (connected || conn)
+		return false;
+
+	// Only those servers, which need no questions to be asked (the SSH
+	// tunnel is set up synchronously too)
+	if (sshTunnel || database.IsEmpty())
+		return false;
+	if ((!passwordValid || !GetPasswordIsStored() || !GetStorePwd()) && GetSSLCert() == wxEmptyString)
+		return false;
+
+	wxLogInfo(wxT("Starting to connect to the server %s in the background..."), GetName().c_str());
+
+	conn = new pgConn(GetName(), service, hostaddr, database, username, password, port, rolename, ssl, 0,
+	                  appearanceFactory->GetLongAppName() + _(" - Browser"), sslcert, sslkey, sslrootcert, sslcrl,
+	                  sslcompression, true);
+
+	return true;
+}
+
+
+int pgServer::FinishConnect(frmMain *form, bool storePassword)
+{
 	int status = conn->GetStatus();
 	if (status == PGCONN_OK)
 	{
@@ -977,7 +1030,7 @@ int pgServer::Connect(frmMain *form, bool askPassword, const wxString &pwd, bool
 			settings->WriteBool(wxT("Updates/UseSSL"), true);
 
 		UpdateIcon(form->GetBrowser());
-		if (storePassword || forceStorePassword)
+		if (storePassword)
 			StorePassword();
 	}
 	else
@@ -985,8 +1038,6 @@ int pgServer::Connect(frmMain *form, bool askPassword, const wxString &pwd, bool
 		connected = false;
 	}
 
-	form->EndMsg(connected && status == PGCONN_OK);
-
 	passwordValid = connected;
 	return status;
 }
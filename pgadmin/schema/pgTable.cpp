@@ -1513,23 +1513,10 @@ void pgTable::ShowStatistics(frmMain *form, ctlListView *statistics)
 }
 
 
-pgObject *pgTableFactory::CreateObjects(pgCollection *collection, ctlTree *browser, const wxString &restriction)
+wxString pgTableFactory::GetObjectsQuery(pgCollection *collection, const wxString &restriction)
 {
 	wxString query;
-	pgTable *table = 0;
-
-	// Greenplum returns reltuples and relpages as tuples per segmentDB and pages per segmentDB,
-	// so we need to multiply them by the number of segmentDBs to get reasonable values.
-	long gp_segments = 1;
-	if (collection->GetConnection()->GetIsGreenplum())
-	{
-		query = wxT("SELECT count(*) AS gp_segments from pg_catalog.gp_configuration where definedprimary = 't' and content >= 0");
-		gp_segments = StrToLong(collection->GetDatabase()->ExecuteScalar(query));
-		if (gp_segments <= 1)
-			gp_segments = 1;
-	}
 
-	pgSet *tables;
 	if (collection->GetConnection()->BackendMinimumVersion(8, 0))
 	{
 		/*ABDUL:BEGIN*/
@@ -1571,6 +1558,9 @@ pgObject *pgTableFactory::CreateObjects(pgCollection *collection, ctlTree *brows
 			query += wxT(", substring(array_to_string(rel.reloptions, ',') FROM 'fillfactor=([0-9]*)') AS fillfactor \n");
 		if (collection->GetConnection()->GetIsGreenplum())
 		{
+			// Greenplum returns reltuples and relpages as tuples per segmentDB and pages per segmentDB,
+			// so we need to multiply them by the number of segmentDBs to get reasonable values.
+			query += wxT(", (SELECT count(*) FROM pg_catalog.gp_configuration WHERE definedprimary = 't' AND content >= 0) AS gp_segments \n");
 			query += wxT(", gpd.localoid, gpd.attrnums \n");
 			query += wxT(", substring(array_to_string(rel.reloptions, ',') from 'appendonly=([a-z]*)') AS appendonly \n");
 			query += wxT(", substring(array_to_string(rel.reloptions, ',') from 'compresslevel=([0-9]*)') AS compresslevel \n");
@@ -1659,144 +1649,143 @@ pgObject *pgTableFactory::CreateObjects(pgCollection *collection, ctlTree *brows
 		        + restriction +
 		        wxT(" ORDER BY rel.relname");
 	}
-	tables = collection->GetDatabase()->ExecuteSet(query);
-	if (tables)
-	{
-		while (!tables->Eof())
-		{
-			table = new pgTable(collection->GetSchema(), tables->GetVal(wxT("relname")));
 
-			table->iSetOid(tables->GetOid(wxT("oid")));
-			table->iSetOwner(tables->GetVal(wxT("relowner")));
-			table->iSetAcl(tables->GetVal(wxT("relacl")));
-			if (collection->GetConnection()->BackendMinimumVersion(8, 0))
-			{
-				if (tables->GetOid(wxT("spcoid")) == 0)
-					table->iSetTablespaceOid(collection->GetDatabase()->GetTablespaceOid());
-				else
-					table->iSetTablespaceOid(tables->GetOid(wxT("spcoid")));
+	return query;
+}
 
-				if (tables->GetVal(wxT("spcname")) == wxEmptyString)
-					table->iSetTablespace(collection->GetDatabase()->GetTablespace());
-				else
-					table->iSetTablespace(tables->GetVal(wxT("spcname")));
-			}
-			if (collection->GetConnection()->BackendMinimumVersion(9, 0))
-			{
-				table->iSetOfTypeOid(tables->GetOid(wxT("reloftype")));
-				table->iSetOfType(tables->GetVal(wxT("typname")));
-			}
-			else
-			{
-				table->iSetOfTypeOid(0);
-				table->iSetOfType(wxT(""));
-			}
-			table->iSetComment(tables->GetVal(wxT("description")));
-			if (collection->GetConnection()->BackendMinimumVersion(9, 1))
-				table->iSetUnlogged(tables->GetVal(wxT("relpersistence")) == wxT("u"));
-			else
-				table->iSetUnlogged(false);
-			table->iSetHasOids(tables->GetBool(wxT("relhasoids")));
-			table->iSetEstimatedRows(tables->GetDouble(wxT("reltuples")) * gp_segments);
-			if (collection->GetConnection()->BackendMinimumVersion(8, 2))
-			{
-				table->iSetFillFactor(tables->GetVal(wxT("fillfactor")));
-			}
-			if (collection->GetConnection()->BackendMinimumVersion(8, 4))
-			{
-				table->iSetRelOptions(tables->GetVal(wxT("reloptions")));
-				if (table->GetCustomAutoVacuumEnabled())
-				{
-					if (tables->GetVal(wxT("autovacuum_enabled")).IsEmpty())
-						table->iSetAutoVacuumEnabled(2);
-					else if (tables->GetBool(wxT("autovacuum_enabled")))
-						table->iSetAutoVacuumEnabled(1);
-					else
-						table->iSetAutoVacuumEnabled(0);
-					table->iSetAutoVacuumVacuumThreshold(tables->GetVal(wxT("autovacuum_vacuum_threshold")));
-					table->iSetAutoVacuumVacuumScaleFactor(tables->GetVal(wxT("autovacuum_vacuum_scale_factor")));
-					table->iSetAutoVacuumAnalyzeThreshold(tables->GetVal(wxT("autovacuum_analyze_threshold")));
-					table->iSetAutoVacuumAnalyzeScaleFactor(tables->GetVal(wxT("autovacuum_analyze_scale_factor")));
-					table->iSetAutoVacuumVacuumCostDelay(tables->GetVal(wxT("autovacuum_vacuum_cost_delay")));
-					table->iSetAutoVacuumVacuumCostLimit(tables->GetVal(wxT("autovacuum_vacuum_cost_limit")));
-					table->iSetAutoVacuumFreezeMinAge(tables->GetVal(wxT("autovacuum_freeze_min_age")));
-					table->iSetAutoVacuumFreezeMaxAge(tables->GetVal(wxT("autovacuum_freeze_max_age")));
-					table->iSetAutoVacuumFreezeTableAge(tables->GetVal(wxT("autovacuum_freeze_table_age")));
-				}
-				table->iSetHasToastTable(tables->GetBool(wxT("hastoasttable")));
-				if (table->GetHasToastTable())
-				{
-					table->iSetToastRelOptions(tables->GetVal(wxT("toast_reloptions")));
 
-					if (table->GetToastCustomAutoVacuumEnabled())
-					{
-						if (tables->GetVal(wxT("toast_autovacuum_enabled")).IsEmpty())
-							table->iSetToastAutoVacuumEnabled(2);
-						else if (tables->GetBool(wxT("toast_autovacuum_enabled")))
-							table->iSetToastAutoVacuumEnabled(1);
-						else
-							table->iSetToastAutoVacuumEnabled(0);
-
-						table->iSetToastAutoVacuumVacuumThreshold(tables->GetVal(wxT("toast_autovacuum_vacuum_threshold")));
-						table->iSetToastAutoVacuumVacuumScaleFactor(tables->GetVal(wxT("toast_autovacuum_vacuum_scale_factor")));
-						table->iSetToastAutoVacuumVacuumCostDelay(tables->GetVal(wxT("toast_autovacuum_vacuum_cost_delay")));
-						table->iSetToastAutoVacuumVacuumCostLimit(tables->GetVal(wxT("toast_autovacuum_vacuum_cost_limit")));
-						table->iSetToastAutoVacuumFreezeMinAge(tables->GetVal(wxT("toast_autovacuum_freeze_min_age")));
-						table->iSetToastAutoVacuumFreezeMaxAge(tables->GetVal(wxT("toast_autovacuum_freeze_max_age")));
-						table->iSetToastAutoVacuumFreezeTableAge(tables->GetVal(wxT("toast_autovacuum_freeze_table_age")));
-					}
-				}
-			}
-			table->iSetHasSubclass(tables->GetBool(wxT("relhassubclass")));
-			table->iSetPrimaryKeyName(tables->GetVal(wxT("conname")));
-			table->iSetIsReplicated(tables->GetBool(wxT("isrepl")));
-			table->iSetTriggerCount(tables->GetLong(wxT("triggercount")));
-			wxString cn = tables->GetVal(wxT("conkey"));
-			cn = cn.Mid(1, cn.Length() - 2);
-			table->iSetPrimaryKeyColNumbers(cn);
-
-			if (collection->GetConnection()->GetIsGreenplum())
-			{
-				Oid lo = tables->GetOid(wxT("localoid"));
-				wxString db = tables->GetVal(wxT("attrnums"));
-				db = db.Mid(1, db.Length() - 2);
-				table->iSetDistributionColNumbers(db);
-				if (lo > 0 && db.Length() == 0)
-					table->iSetDistributionIsRandom();
-				table->iSetAppendOnly(tables->GetVal(wxT("appendonly")));
-				table->iSetCompressLevel(tables->GetVal(wxT("compresslevel")));
-				table->iSetOrientation(tables->GetVal(wxT("orientation")));
-				table->iSetCompressType(tables->GetVal(wxT("compresstype")));
-				table->iSetBlocksize(tables->GetVal(wxT("blocksize")));
-				table->iSetChecksum(tables->GetVal(wxT("checksum")));
-
-				table->iSetPartitionDef(wxT(""));
-				table->iSetIsPartitioned(false);
-
-				if (collection->GetConnection()->BackendMinimumVersion(8, 2, 9))
-				{
-					table->iSetIsPartitioned(tables->GetBool(wxT("ispartitioned")));
-				}
+pgObject *pgTableFactory::CreateObjectFromSet(pgCollection *collection, pgSet *tables)
+{
+	pgTable *table = new pgTable(collection->GetSchema(), tables->GetVal(wxT("relname")));
 
-			}
+	long gp_segments = 1;
+	if (collection->GetConnection()->GetIsGreenplum())
+	{
+		gp_segments = tables->GetLong(wxT("gp_segments"));
+		if (gp_segments <= 1)
+			gp_segments = 1;
+	}
 
-			if (collection->GetConnection()->BackendMinimumVersion(9, 1))
-			{
-				table->iSetProviders(tables->GetVal(wxT("providers")));
-				table->iSetLabels(tables->GetVal(wxT("labels")));
-			}
+	table->iSetOid(tables->GetOid(wxT("oid")));
+	table->iSetOwner(tables->GetVal(wxT("relowner")));
+	table->iSetAcl(tables->GetVal(wxT("relacl")));
+	if (collection->GetConnection()->BackendMinimumVersion(8, 0))
+	{
+		if (tables->GetOid(wxT("spcoid")) == 0)
+			table->iSetTablespaceOid(collection->GetDatabase()->GetTablespaceOid());
+		else
+			table->iSetTablespaceOid(tables->GetOid(wxT("spcoid")));
 
-			if (browser)
+		if (tables->GetVal(wxT("spcname")) == wxEmptyString)
+			table->iSetTablespace(collection->GetDatabase()->GetTablespace());
+		else
+			table->iSetTablespace(tables->GetVal(wxT("spcname")));
+	}
+	if (collection->GetConnection()->BackendMinimumVersion(9, 0))
+	{
+		table->iSetOfTypeOid(tables->GetOid(wxT("reloftype")));
+		table->iSetOfType(tables->GetVal(wxT("typname")));
+	}
+	else
+	{
+		table->iSetOfTypeOid(0);
+		table->iSetOfType(wxT(""));
+	}
+	table->iSetComment(tables->GetVal(wxT("description")));
+	if (collection->GetConnection()->BackendMinimumVersion(9, 1))
+		table->iSetUnlogged(tables->GetVal(wxT("relpersistence")) == wxT("u"));
+	else
+		table->iSetUnlogged(false);
+	table->iSetHasOids(tables->GetBool(wxT("relhasoids")));
+	table->iSetEstimatedRows(tables->GetDouble(wxT("reltuples")) * gp_segments);
+	if (collection->GetConnection()->BackendMinimumVersion(8, 2))
+	{
+		table->iSetFillFactor(tables->GetVal(wxT("fillfactor")));
+	}
+	if (collection->GetConnection()->BackendMinimumVersion(8, 4))
+	{
+		table->iSetRelOptions(tables->GetVal(wxT("reloptions")));
+		if (table->GetCustomAutoVacuumEnabled())
+		{
+			if (tables->GetVal(wxT("autovacuum_enabled")).IsEmpty())
+				table->iSetAutoVacuumEnabled(2);
+			else if (tables->GetBool(wxT("autovacuum_enabled")))
+				table->iSetAutoVacuumEnabled(1);
+			else
+				table->iSetAutoVacuumEnabled(0);
+			table->iSetAutoVacuumVacuumThreshold(tables->GetVal(wxT("autovacuum_vacuum_threshold")));
+			table->iSetAutoVacuumVacuumScaleFactor(tables->GetVal(wxT("autovacuum_vacuum_scale_factor")));
+			table->iSetAutoVacuumAnalyzeThreshold(tables->GetVal(wxT("autovacuum_analyze_threshold")));
+			table->iSetAutoVacuumAnalyzeScaleFactor(tables->GetVal(wxT("autovacuum_analyze_scale_factor")));
+			table->iSetAutoVacuumVacuumCostDelay(tables->GetVal(wxT("autovacuum_vacuum_cost_delay")));
+			table->iSetAutoVacuumVacuumCostLimit(tables->GetVal(wxT("autovacuum_vacuum_cost_limit")));
+			table->iSetAutoVacuumFreezeMinAge(tables->GetVal(wxT("autovacuum_freeze_min_age")));
+			table->iSetAutoVacuumFreezeMaxAge(tables->GetVal(wxT("autovacuum_freeze_max_age")));
+			table->iSetAutoVacuumFreezeTableAge(tables->GetVal(wxT("autovacuum_freeze_table_age")));
+		}
+		table->iSetHasToastTable(tables->GetBool(wxT("hastoasttable")));
+		if (table->GetHasToastTable())
+		{
+			table->iSetToastRelOptions(tables->GetVal(wxT("toast_reloptions")));
+
+			if (table->GetToastCustomAutoVacuumEnabled())
 			{
-				browser->AppendObject(collection, table);
-				tables->MoveNext();
+				if (tables->GetVal(wxT("toast_autovacuum_enabled")).IsEmpty())
+					table->iSetToastAutoVacuumEnabled(2);
+				else if (tables->GetBool(wxT("toast_autovacuum_enabled")))
+					table->iSetToastAutoVacuumEnabled(1);
+				else
+					table->iSetToastAutoVacuumEnabled(0);
+
+				table->iSetToastAutoVacuumVacuumThreshold(tables->GetVal(wxT("toast_autovacuum_vacuum_threshold")));
+				table->iSetToastAutoVacuumVacuumScaleFactor(tables->GetVal(wxT("toast_autovacuum_vacuum_scale_factor")));
+				table->iSetToastAutoVacuumVacuumCostDelay(tables->GetVal(wxT("toast_autovacuum_vacuum_cost_delay")));
+				table->iSetToastAutoVacuumVacuumCostLimit(tables->GetVal(wxT("toast_autovacuum_vacuum_cost_limit")));
+				table->iSetToastAutoVacuumFreezeMinAge(tables->GetVal(wxT("toast_autovacuum_freeze_min_age")));
+				table->iSetToastAutoVacuumFreezeMaxAge(tables->GetVal(wxT("toast_autovacuum_freeze_max_age")));
+				table->iSetToastAutoVacuumFreezeTableAge(tables->GetVal(wxT("toast_autovacuum_freeze_table_age")));
 			}
-			else
-				break;
+		}
+	}
+	table->iSetHasSubclass(tables->GetBool(wxT("relhassubclass")));
+	table->iSetPrimaryKeyName(tables->GetVal(wxT("conname")));
+	table->iSetIsReplicated(tables->GetBool(wxT("isrepl")));
+	table->iSetTriggerCount(tables->GetLong(wxT("triggercount")));
+	wxString cn = tables->GetVal(wxT("conkey"));
+	cn = cn.Mid(1, cn.Length() - 2);
+	table->iSetPrimaryKeyColNumbers(cn);
+
+	if (collection->GetConnection()->GetIsGreenplum())
+	{
+		Oid lo = tables->GetOid(wxT("localoid"));
+		wxString db = tables->GetVal(wxT("attrnums"));
+		db = db.Mid(1, db.Length() - 2);
+		table->iSetDistributionColNumbers(db);
+		if (lo > 0 && db.Length() == 0)
+			table->iSetDistributionIsRandom();
+		table->iSetAppendOnly(tables->GetVal(wxT("appendonly")));
+		table->iSetCompressLevel(tables->GetVal(wxT("compresslevel")));
+		table->iSetOrientation(tables->GetVal(wxT("orientation")));
+		table->iSetCompressType(tables->GetVal(wxT("compresstype")));
+		table->iSetBlocksize(tables->GetVal(wxT("blocksize")));
+		table->iSetChecksum(tables->GetVal(wxT("checksum")));
+
+		table->iSetPartitionDef(wxT(""));
+		table->iSetIsPartitioned(false);
+
+		if (collection->GetConnection()->BackendMinimumVersion(8, 2, 9))
+		{
+			table->iSetIsPartitioned(tables->GetBool(wxT("ispartitioned")));
 		}
 
-		delete tables;
 	}
+
+	if (collection->GetConnection()->BackendMinimumVersion(9, 1))
+	{
+		table->iSetProviders(tables->GetVal(wxT("providers")));
+		table->iSetLabels(tables->GetVal(wxT("labels")));
+	}
+
 	return table;
 }
 
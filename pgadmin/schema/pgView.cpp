@@ -697,9 +697,8 @@ wxString pgViewCollection::GetTranslatedMessage(int kindOfMessage) const
 ///////////////////////////////////////////////////////
 
 
-pgObject *pgViewFactory::CreateObjects(pgCollection *collection, ctlTree *browser, const wxString &restriction)
+wxString pgViewFactory::GetObjectsQuery(pgCollection *collection, const wxString &restriction)
 {
-	pgView *view = 0;
 	wxString sql;
 
 	if (collection->GetDatabase()->BackendMinimumVersion(9, 3))
@@ -773,117 +772,102 @@ pgObject *pgViewFactory::CreateObjects(pgCollection *collection, ctlTree *browse
 	       + restriction
 	       + wxT(" ORDER BY relname");
 
-	pgSet *views = collection->GetDatabase()->ExecuteSet(sql);
-
-	if (views)
-	{
-		while (!views->Eof())
-		{
-			view = new pgView(collection->GetSchema(), views->GetVal(wxT("relname")));
-
-			view->iSetOid(views->GetOid(wxT("oid")));
-			view->iSetXid(views->GetOid(wxT("xmin")));
-			view->iSetOwner(views->GetVal(wxT("viewowner")));
-			view->iSetComment(views->GetVal(wxT("description")));
-			view->iSetAcl(views->GetVal(wxT("relacl")));
-			view->iSetDefinition(views->GetVal(wxT("definition")));
-			view->iSetMaterializedView(false);
-			if (collection->GetDatabase()->BackendMinimumVersion(9, 4))
-			{
-				view->iSetCheckOption(views->GetVal(wxT("check_option")));
-			}
+	return sql;
+}
 
-			if (collection->GetDatabase()->BackendMinimumVersion(9, 1))
-			{
-				view->iSetProviders(views->GetVal(wxT("providers")));
-				view->iSetLabels(views->GetVal(wxT("labels")));
-			}
-			if (collection->GetConnection()->BackendMinimumVersion(9, 2))
-			{
-				view->iSetSecurityBarrier(views->GetVal(wxT("security_barrier")));
-			}
 
-			if (collection->GetConnection()->BackendMinimumVersion(9, 3))
-			{
-				view->iSetFillFactor(views->GetVal(wxT("fillfactor")));
-
-				if (views->GetOid(wxT("spcoid")) == 0)
-					view->iSetTablespaceOid(collection->GetDatabase()->GetTablespaceOid());
-				else
-					view->iSetTablespaceOid(views->GetOid(wxT("spcoid")));
+pgObject *pgViewFactory::CreateObjectFromSet(pgCollection *collection, pgSet *views)
+{
+	pgView *view = new pgView(collection->GetSchema(), views->GetVal(wxT("relname")));
+
+	view->iSetOid(views->GetOid(wxT("oid")));
+	view->iSetXid(views->GetOid(wxT("xmin")));
+	view->iSetOwner(views->GetVal(wxT("viewowner")));
+	view->iSetComment(views->GetVal(wxT("description")));
+	view->iSetAcl(views->GetVal(wxT("relacl")));
+	view->iSetDefinition(views->GetVal(wxT("definition")));
+	view->iSetMaterializedView(false);
+	if (collection->GetDatabase()->BackendMinimumVersion(9, 4))
+	{
+		view->iSetCheckOption(views->GetVal(wxT("check_option")));
+	}
 
-				view->iSetRelOptions(views->GetVal(wxT("reloptions")));
+	if (collection->GetDatabase()->BackendMinimumVersion(9, 1))
+	{
+		view->iSetProviders(views->GetVal(wxT("providers")));
+		view->iSetLabels(views->GetVal(wxT("labels")));
+	}
+	if (collection->GetConnection()->BackendMinimumVersion(9, 2))
+	{
+		view->iSetSecurityBarrier(views->GetVal(wxT("security_barrier")));
+	}
 
-				view->iSetIsPopulated(views->GetVal(wxT("ispopulated")));
+	if (collection->GetConnection()->BackendMinimumVersion(9, 3))
+	{
+		view->iSetFillFactor(views->GetVal(wxT("fillfactor")));
 
-				if (view->GetCustomAutoVacuumEnabled())
-				{
-					if (views->GetVal(wxT("autovacuum_enabled")).IsEmpty())
-						view->iSetAutoVacuumEnabled(2);
-					else if (views->GetBool(wxT("autovacuum_enabled")))
-						view->iSetAutoVacuumEnabled(1);
-					else
-						view->iSetAutoVacuumEnabled(0);
-					view->iSetAutoVacuumVacuumThreshold(views->GetVal(wxT("autovacuum_vacuum_threshold")));
-					view->iSetAutoVacuumVacuumScaleFactor(views->GetVal(wxT("autovacuum_vacuum_scale_factor")));
-					view->iSetAutoVacuumAnalyzeThreshold(views->GetVal(wxT("autovacuum_analyze_threshold")));
-					view->iSetAutoVacuumAnalyzeScaleFactor(views->GetVal(wxT("autovacuum_analyze_scale_factor")));
-					view->iSetAutoVacuumVacuumCostDelay(views->GetVal(wxT("autovacuum_vacuum_cost_delay")));
-					view->iSetAutoVacuumVacuumCostLimit(views->GetVal(wxT("autovacuum_vacuum_cost_limit")));
-					view->iSetAutoVacuumFreezeMinAge(views->GetVal(wxT("autovacuum_freeze_min_age")));
-					view->iSetAutoVacuumFreezeMaxAge(views->GetVal(wxT("autovacuum_freeze_max_age")));
-					view->iSetAutoVacuumFreezeTableAge(views->GetVal(wxT("autovacuum_freeze_table_age")));
-				}
+		if (views->GetOid(wxT("spcoid")) == 0)
+			view->iSetTablespaceOid(collection->GetDatabase()->GetTablespaceOid());
+		else
+			view->iSetTablespaceOid(views->GetOid(wxT("spcoid")));
 
-				view->iSetHasToastTable(views->GetBool(wxT("hastoasttable")));
+		view->iSetRelOptions(views->GetVal(wxT("reloptions")));
 
-				if (view->GetHasToastTable())
-				{
-					view->iSetToastRelOptions(views->GetVal(wxT("toast_reloptions")));
+		view->iSetIsPopulated(views->GetVal(wxT("ispopulated")));
 
-					if (view->GetToastCustomAutoVacuumEnabled())
-					{
-						if (views->GetVal(wxT("toast_autovacuum_enabled")).IsEmpty())
-							view->iSetToastAutoVacuumEnabled(2);
-						else if (views->GetBool(wxT("toast_autovacuum_enabled")))
-							view->iSetToastAutoVacuumEnabled(1);
-						else
-							view->iSetToastAutoVacuumEnabled(0);
-
-						view->iSetToastAutoVacuumVacuumThreshold(views->GetVal(wxT("toast_autovacuum_vacuum_threshold")));
-						view->iSetToastAutoVacuumVacuumScaleFactor(views->GetVal(wxT("toast_autovacuum_vacuum_scale_factor")));
-						view->iSetToastAutoVacuumVacuumCostDelay(views->GetVal(wxT("toast_autovacuum_vacuum_cost_delay")));
-						view->iSetToastAutoVacuumVacuumCostLimit(views->GetVal(wxT("toast_autovacuum_vacuum_cost_limit")));
-						view->iSetToastAutoVacuumFreezeMinAge(views->GetVal(wxT("toast_autovacuum_freeze_min_age")));
-						view->iSetToastAutoVacuumFreezeMaxAge(views->GetVal(wxT("toast_autovacuum_freeze_max_age")));
-						view->iSetToastAutoVacuumFreezeTableAge(views->GetVal(wxT("toast_autovacuum_freeze_table_age")));
-					}
-				}
+		if (view->GetCustomAutoVacuumEnabled())
+		{
+			if (views->GetVal(wxT("autovacuum_enabled")).IsEmpty())
+				view->iSetAutoVacuumEnabled(2);
+			else if (views->GetBool(wxT("autovacuum_enabled")))
+				view->iSetAutoVacuumEnabled(1);
+			else
+				view->iSetAutoVacuumEnabled(0);
+			view->iSetAutoVacuumVacuumThreshold(views->GetVal(wxT("autovacuum_vacuum_threshold")));
+			view->iSetAutoVacuumVacuumScaleFactor(views->GetVal(wxT("autovacuum_vacuum_scale_factor")));
+			view->iSetAutoVacuumAnalyzeThreshold(views->GetVal(wxT("autovacuum_analyze_threshold")));
+			view->iSetAutoVacuumAnalyzeScaleFactor(views->GetVal(wxT("autovacuum_analyze_scale_factor")));
+			view->iSetAutoVacuumVacuumCostDelay(views->GetVal(wxT("autovacuum_vacuum_cost_delay")));
+			view->iSetAutoVacuumVacuumCostLimit(views->GetVal(wxT("autovacuum_vacuum_cost_limit")));
+			view->iSetAutoVacuumFreezeMinAge(views->GetVal(wxT("autovacuum_freeze_min_age")));
+			view->iSetAutoVacuumFreezeMaxAge(views->GetVal(wxT("autovacuum_freeze_max_age")));
+			view->iSetAutoVacuumFreezeTableAge(views->GetVal(wxT("autovacuum_freeze_table_age")));
+		}
 
-				if (views->GetVal(wxT("spcname")) == wxEmptyString)
-					view->iSetTablespace(collection->GetDatabase()->GetTablespace());
-				else
-					view->iSetTablespace(views->GetVal(wxT("spcname")));
+		view->iSetHasToastTable(views->GetBool(wxT("hastoasttable")));
 
-				if (views->GetVal(wxT("relkind")).Cmp(wxT("m")) == 0)
-					view->iSetMaterializedView(true);
-			}
+		if (view->GetHasToastTable())
+		{
+			view->iSetToastRelOptions(views->GetVal(wxT("toast_reloptions")));
 
-			if (browser)
+			if (view->GetToastCustomAutoVacuumEnabled())
 			{
-				collection->AppendBrowserItem(browser, view);
-				// If it is materialized view then display the materialized view icon
-				if (collection->GetConnection()->BackendMinimumVersion(9, 3) && views->GetVal(wxT("relkind")).Cmp(wxT("m")) == 0)
-					browser->SetItemImage(view->GetId(), viewFactory.GetMaterializedIconId());
-
-				views->MoveNext();
+				if (views->GetVal(wxT("toast_autovacuum_enabled")).IsEmpty())
+					view->iSetToastAutoVacuumEnabled(2);
+				else if (views->GetBool(wxT("toast_autovacuum_enabled")))
+					view->iSetToastAutoVacuumEnabled(1);
+				else
+					view->iSetToastAutoVacuumEnabled(0);
+
+				view->iSetToastAutoVacuumVacuumThreshold(views->GetVal(wxT("toast_autovacuum_vacuum_threshold")));
+				view->iSetToastAutoVacuumVacuumScaleFactor(views->GetVal(wxT("toast_autovacuum_vacuum_scale_factor")));
+				view->iSetToastAutoVacuumVacuumCostDelay(views->GetVal(wxT("toast_autovacuum_vacuum_cost_delay")));
+				view->iSetToastAutoVacuumVacuumCostLimit(views->GetVal(wxT("toast_autovacuum_vacuum_cost_limit")));
+				view->iSetToastAutoVacuumFreezeMinAge(views->GetVal(wxT("toast_autovacuum_freeze_min_age")));
+				view->iSetToastAutoVacuumFreezeMaxAge(views->GetVal(wxT("toast_autovacuum_freeze_max_age")));
+				view->iSetToastAutoVacuumFreezeTableAge(views->GetVal(wxT("toast_autovacuum_freeze_table_age")));
 			}
-			else
-				break;
 		}
 
-		delete views;
+		if (views->GetVal(wxT("spcname")) == wxEmptyString)
+			view->iSetTablespace(collection->GetDatabase()->GetTablespace());
+		else
+			view->iSetTablespace(views->GetVal(wxT("spcname")));
+
+		if (views->GetVal(wxT("relkind")).Cmp(wxT("m")) == 0)
+			view->iSetMaterializedView(true);
 	}
+
 	return view;
 }
 
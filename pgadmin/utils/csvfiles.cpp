@@ -13,6 +13,17 @@
 #include "utils/sysLogger.h"
 #include "utils/csvfiles.h"
 
+#include <string.h>
+
+// SSE2 is always there on x86-64, and on x86 if the compiler has been told so
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CSV_USE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 // PostgreSQL and GPDB now support CSV format logs.
 // So, we need a way to parse the CSV files into lines, and lines into tokens (fields).
 
@@ -140,3 +151,175 @@ wxString CSVLineTokenizer::GetNextLine(bool &partial)
 
 	return token;
 }
+
+
+#ifdef CSV_USE_SSE2
+// The position of the lowest bit set in a mask, which isn't 0
+static inline int LowestBit(int mask)
+{
+#ifdef _MSC_VER
+	unsigned long bit;
+	_BitScanForward(&bit, (unsigned long)mask);
+	return (int)bit;
+#else
+	return __builtin_ctz((unsigned int)mask);
+#endif
+}
+#endif
+
+// Find the first of the chars a, b and c in [p, end), or end
+static inline const char *FindAny(const char *p, const char *end, char a, char b, char c)
+{
+#ifdef CSV_USE_SSE2
+	const __m128i va = _mm_set1_epi8(a);
+	const __m128i vb = _mm_set1_epi8(b);
+	const __m128i vc = _mm_set1_epi8(c);
+
+	while (end - p >= 16)
+	{
+		__m128i chunk = _mm_loadu_si128((const __m128i *)p);
+		__m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)),
+		                             _mm_cmpeq_epi8(chunk, vc));
+		int mask = _mm_movemask_epi8(found);
+		if (mask)
+			return p + LowestBit(mask);
+		p += 16;
+	}
+#endif
+
+	while (p < end && *p != a && *p != b && *p != c)
+		p++;
+	return p;
+}
+
+wxString CSVSpan::ToString() const
+{
+	if (!len)
+		return wxEmptyString;
+
+	wxString str(data, wxConvUTF8, len);
+	if (str.IsEmpty())
+		str = wxString(data, wxConvLibc, len);
+
+	// Remove double doublequote chars, replace with single doublequote chars
+	if (quoted && memchr(data, '\"', len))
+		str.Replace(wxT("\"\""), wxT("\""), true);
+
+	return str;
+}
+
+bool CSVBufferTokenizer::GetNextLine(CSVSpan &line)
+{
+	// find the end of this line.  CSV lines end in "\n", but
+	// CSV lines may have "\n" chars inside double-quoted strings, so we need to find that out.
+
+	const char *start = m_buf + m_pos;
+	const char *end = m_buf + m_len;
+	const char *p = start;
+	bool inquote = false;
+
+	while (p < end)
+	{
+		// Inside a quoted string, only its end matters
+		if (inquote)
+			p = FindAny(p, end, '\"', '\"', '\"');
+		else
+			p = FindAny(p, end, '\"', '\n', '\n');
+
+		if (p == end)
+			break;
+
+		if (*p == '\"')
+			inquote = !inquote;
+		else
+		{
+			// Good, we found a complete log line terminated
+			// by "\n", and the "\n" wasn't in a quoted string.
+			line.data = start;
+			line.len = p - start + 1;
+			line.quoted = false;
+			m_pos = p + 1 - m_buf;
+			return true;
+		}
+		p++;
+	}
+
+	// Some of the line must still be coming.
+	return false;
+}
+
+CSVFields::CSVFields(const CSVSpan &line)
+	: m_count(0)
+{
+	const char *p = line.data;
+	const char *end = line.data + line.len;
+
+	// Trailing blanks and the line end are not part of the last field
+	while (end > p && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+		end--;
+
+	while (p < end && m_count < CSV_MAX_FIELDS)
+	{
+		// Nothing but delimiters left is no more fields, as in CSVTokenizer
+		if (p > line.data)
+		{
+			const char *q = p;
+			while (q < end && *q == ',')
+				q++;
+			if (q == end)
+				break;
+		}
+
+		CSVSpan &field = m_fields[m_count++];
+
+		// skip leading blanks if not quoted.
+		while (p < end && *p == ' ')
+			p++;
+
+		const char *pos;
+
+		if (p < end && *p == '\"')
+		{
+			// Are we a quoted field?  Must handle this special.
+			bool inquote = true;
+
+			pos = p + 1;
+			while (pos < end)
+			{
+				if (inquote)
+					pos = FindAny(pos, end, '\"', '\"', '\"');
+				else
+					pos = FindAny(pos, end, '\"', ',', ',');
+
+				if (pos == end || *pos == ',')
+					break;
+
+				inquote = !inquote;
+				pos++;
+			}
+
+			if (!inquote)
+			{
+				// Remove leading and trailing quotes
+				field.data = p + 1;
+				field.len = pos - p - 2;
+				field.quoted = true;
+			}
+			else
+			{
+				field.data = p;
+				field.len = pos - p;
+				wxLogNotice(wxT("unterminated double quoted string: %s\n"), field.ToString().c_str());
+			}
+		}
+		else
+		{
+			pos = FindAny(p, end, ',', ',', ',');
+			field.data = p;
+			field.len = pos - p;
+		}
+
+		// Skip token and delimiter
+		p = pos < end ? pos + 1 : end;
+	}
+}
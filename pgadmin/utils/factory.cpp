@@ -14,6 +14,7 @@
 
 #include "ctl/ctlMenuToolbar.h"
 #include "schema/pgCollection.h"
+#include "schema/pgDatabase.h"
 #include "frm/menu.h"
 
 // wxWindows headers
@@ -190,6 +191,52 @@ int pgaFactory::GetMetaType()
 }
 
 
+pgObject *pgaFactory::CreateObjects(pgCollection  *obj, ctlTree *browser, const wxString &restr)
+{
+	wxString query = GetObjectsQuery(obj, restr);
+
+	if (query.IsEmpty())
+		return 0;
+
+	return AppendObjectsFromSet(obj, browser, obj->GetDatabase()->ExecuteSet(query));
+}
+
+
+pgObject *pgaFactory::AppendObjectsFromSet(pgCollection *obj, ctlTree *browser, pgSet *set)
+{
+	pgObject *object = 0;
+	long pageSize = settings->GetBrowserPageSize();
+	long count = 0;
+
+	if (set)
+	{
+		while (!set->Eof())
+		{
+			object = CreateObjectFromSet(obj, set);
+
+			if (browser)
+			{
+				browser->AppendObject(obj, object);
+				set->MoveNext();
+
+				// The rest is added, when the user asks for it
+				if (pageSize > 0 && ++count >= pageSize && !set->Eof())
+				{
+					obj->SetPendingObjects(browser, set);
+					set = 0;
+					break;
+				}
+			}
+			else
+				break;
+		}
+		if (set)
+			delete set;
+	}
+	return object;
+}
+
+
 pgaCollectionFactory::pgaCollectionFactory(pgaFactory *f, const wxChar *tn, wxImage *img, wxImage *imgSm)
 	: pgaFactory(tn, f->GetNewString(), f->GetNewLongString())
 {
@@ -215,6 +262,22 @@ pgObject *pgaCollectionFactory::CreateObjects(pgCollection  *obj, ctlTree *brows
 }
 
 
+wxString pgaCollectionFactory::GetObjectsQuery(pgCollection *obj, const wxString &restr)
+{
+	if (itemFactory)
+		return itemFactory->GetObjectsQuery(obj, restr);
+	return wxEmptyString;
+}
+
+
+pgObject *pgaCollectionFactory::CreateObjectFromSet(pgCollection *obj, pgSet *set)
+{
+	if (itemFactory)
+		return itemFactory->CreateObjectFromSet(obj, set);
+	return 0;
+}
+
+
 dlgProperty *pgaCollectionFactory::CreateDialog(frmMain *frame, pgObject *node, pgObject *parent)
 {
 	if (itemFactory)
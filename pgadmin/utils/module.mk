@@ -16,11 +16,13 @@ pgadmin3_SOURCES += \
 	utils/misc.cpp \
 	utils/pgconfig.cpp \
 	utils/registry.cpp \
+	utils/statusHistory.cpp \
 	utils/sysLogger.cpp \
 	utils/sysProcess.cpp \
 	utils/sysSettings.cpp \
 	utils/tabcomplete.c \
 	utils/utffile.cpp \
+	utils/waitForGraph.cpp \
 	utils/macros.cpp
 
 if BUILD_SSH_TUNNEL
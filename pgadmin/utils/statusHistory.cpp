@@ -0,0 +1,190 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// statusHistory.cpp - Recent history of the server's activity, as rates
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+#include <wx/datetime.h>
+
+// App headers
+#include "utils/statusHistory.h"
+#include "utils/misc.h"
+
+// The offsets of the samples wrap after 49 days
+#define HISTORY_MAX_OFFSET  wxLL(0xF0000000)
+
+
+statusHistory::statusHistory(size_t _capacity)
+	: capacity(_capacity), first(0), count(0), hasReading(false)
+{
+	samples = new statusSample[capacity];
+}
+
+
+statusHistory::~statusHistory()
+{
+	delete [] samples;
+}
+
+
+void statusHistory::Clear()
+{
+	first = 0;
+	count = 0;
+	hasReading = false;
+}
+
+
+void statusHistory::AddReading(const wxLongLong &time, const wxLongLong *readings)
+{
+	int metric;
+
+	if (hasReading && (time <= lastTime || (count && time - baseTime >= wxLongLong(HISTORY_MAX_OFFSET))))
+	{
+		// The clock went backwards, or the window has been open for weeks
+		Clear();
+	}
+
+	if (!hasReading)
+	{
+		hasReading = true;
+		lastTime = time;
+		for (metric = 0 ; metric < HISTORY_METRICS ; metric++)
+			lastReadings[metric] = readings[metric];
+		return;
+	}
+
+	if (!count)
+		baseTime = lastTime;
+
+	statusSample *sample;
+	if (count < capacity)
+		sample = &samples[(first + count++) % capacity];
+	else
+	{
+		// Overwrite the oldest one
+		sample = &samples[first];
+		first = (first + 1) % capacity;
+	}
+
+	sample->offsetMs = (wxUint32)(time - baseTime).GetLo();
+	sample->intervalMs = (wxUint32)(time - lastTime).GetLo();
+
+	for (metric = 0 ; metric < HISTORY_METRICS ; metric++)
+	{
+		wxLongLong value = readings[metric];
+
+		if (IsCounter(metric))
+		{
+			value -= lastReadings[metric];
+
+			// The statistics have been reset, or a database dropped
+			if (value < 0)
+				value = 0;
+		}
+
+		if (value > wxLongLong(0x7FFFFFFFL))
+			value = 0x7FFFFFFFL;
+		if (value < 0)
+			value = 0;
+		sample->values[metric] = (wxInt32)value.GetLo();
+
+		lastReadings[metric] = readings[metric];
+	}
+	lastTime = time;
+}
+
+
+double statusHistory::GetValue(size_t i, int metric) const
+{
+	const statusSample &sample = Sample(i);
+
+	if (!IsCounter(metric))
+		return sample.values[metric];
+
+	if (!sample.intervalMs)
+		return 0.0;
+	return sample.values[metric] * 1000.0 / sample.intervalMs;
+}
+
+
+size_t statusHistory::FindTime(const wxLongLong &time) const
+{
+	size_t lo = 0, hi = count;
+
+	if (!count || time <= baseTime)
+		return 0;
+
+	wxLongLong offset = time - baseTime;
+
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (wxLongLong(0, Sample(mid).offsetMs) < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+
+wxString statusHistory::GetMetricName(int metric)
+{
+	switch (metric)
+	{
+		case HISTORY_XACTS:
+			return _("Transactions/s");
+		case HISTORY_TUP_READ:
+			return _("Tuples read/s");
+		case HISTORY_TUP_WRITTEN:
+			return _("Tuples written/s");
+		case HISTORY_BLKS_HIT:
+			return _("Blocks hit/s");
+		case HISTORY_BLKS_READ:
+			return _("Blocks read/s");
+		case HISTORY_ACTIVE:
+			return _("Active backends");
+		case HISTORY_WAITING:
+			return _("Waiting backends");
+	}
+	return wxEmptyString;
+}
+
+
+wxString statusHistory::GetCsv() const
+{
+	wxString csv;
+	int metric;
+	size_t i;
+
+	// Roughly 60 characters per line
+	csv.Alloc(count * 60 + 200);
+
+	csv += wxT("\"time\"");
+	for (metric = 0 ; metric < HISTORY_METRICS ; metric++)
+		csv += wxT(",\"") + GetMetricName(metric) + wxT("\"");
+	csv += END_OF_LINE;
+
+	for (i = 0 ; i < count ; i++)
+	{
+		wxDateTime time(GetTime(i));
+
+		csv += time.Format(wxT("%Y-%m-%d %H:%M:%S"));
+		for (metric = 0 ; metric < HISTORY_METRICS ; metric++)
+			csv += wxT(",") + NumToStr(GetValue(i, metric));
+		csv += END_OF_LINE;
+	}
+
+	return csv;
+}
@@ -30,8 +30,13 @@
 #include "utils/sysSettings.h"
 #include "utils/sysLogger.h"
 #include "utils/misc.h"
+
+DEFINE_EVENT_TYPE(SETTINGS_CHANGED_EVENT)
+
 sysSettings::sysSettings(const wxString &name) : wxConfig(name)
 {
+	snapshot = NULL;
+
 	// Open the default settings file
 	defaultSettings = NULL;
 	if (!settingsIni.IsEmpty())
@@ -69,6 +74,61 @@ sysSettings::~sysSettings()
 		delete defaultSettings;
 		defaultSettings = NULL;
 	}
+
+	if (snapshot)
+		delete snapshot;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Snapshot of the settings used by the result grids
+//////////////////////////////////////////////////////////////////////////
+
+sysSettingsSnapshot *sysSettings::ReadSnapshot()
+{
+	sysSettingsSnapshot *snap = new sysSettingsSnapshot;
+
+	snap->indicateNull = GetIndicateNull();
+	snap->decimalMark = GetDecimalMark();
+	snap->thousandsSeparator = GetThousandsSeparator();
+	snap->maxColSize = GetMaxColSize();
+	snap->copyColSeparator = GetCopyColSeparator();
+	snap->copyQuoteChar = GetCopyQuoteChar();
+	snap->copyQuoting = GetCopyQuoting();
+
+	return snap;
+}
+
+void sysSettings::PublishSnapshot()
+{
+	sysSettingsSnapshot *snap = ReadSnapshot();
+
+	// Replaced in place, so that the references handed out stay valid
+	if (snapshot)
+	{
+		*snapshot = *snap;
+		delete snap;
+	}
+	else
+		snapshot = snap;
+
+	for (size_t i = 0 ; i < snapshotListeners.GetCount() ; i++)
+	{
+		wxCommandEvent ev(SETTINGS_CHANGED_EVENT);
+		((wxEvtHandler *)snapshotListeners.Item(i))->ProcessEvent(ev);
+	}
+}
+
+void sysSettings::AddSnapshotListener(wxEvtHandler *handler)
+{
+	if (snapshotListeners.Index(handler) == wxNOT_FOUND)
+		snapshotListeners.Add(handler);
+}
+
+void sysSettings::RemoveSnapshotListener(wxEvtHandler *handler)
+{
+	int idx = snapshotListeners.Index(handler);
+	if (idx != wxNOT_FOUND)
+		snapshotListeners.RemoveAt(idx);
 }
 
 bool sysSettings::GetDisplayOption(const wxString &objtype, bool GetDefault)
@@ -0,0 +1,310 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// pgAdmin III - PostgreSQL Tools
+//
+// Copyright (C) 2002 - 2016, The pgAdmin Development Team
+// This software is released under the PostgreSQL Licence
+//
+// waitForGraph.cpp - Which sessions wait for which, as blocking chains
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "pgAdmin3.h"
+
+// wxWindows headers
+#include <wx/wx.h>
+
+// App headers
+#include "utils/waitForGraph.h"
+
+// A root of the tree, with the sessions below it
+class waitForRoot
+{
+public:
+	size_t behind;
+	// Position in the tree as built
+	size_t start;
+};
+
+
+// The most sessions behind first, and the order they were found in
+// otherwise
+static int CompareRoots(const void *a, const void *b)
+{
+	const waitForRoot *ra = (const waitForRoot *)a;
+	const waitForRoot *rb = (const waitForRoot *)b;
+
+	if (ra->behind != rb->behind)
+		return ra->behind > rb->behind ? -1 : 1;
+	if (ra->start != rb->start)
+		return ra->start < rb->start ? -1 : 1;
+	return 0;
+}
+
+
+waitForGraph::waitForGraph()
+	: roots(0), cycles(0)
+{
+}
+
+
+waitForGraph::~waitForGraph()
+{
+	WX_CLEAR_ARRAY(sessions);
+}
+
+
+void waitForGraph::Clear()
+{
+	WX_CLEAR_ARRAY(sessions);
+	indices.clear();
+	waiters.Clear();
+	blockers.Clear();
+	order.Clear();
+	roots = 0;
+	cycles = 0;
+}
+
+
+long waitForGraph::AddSession(long pid)
+{
+	waitForPidMap::iterator it = indices.find(pid);
+	if (it != indices.end())
+		return it->second;
+
+	long i = (long)sessions.GetCount();
+	sessions.Add(new waitForSession(pid));
+	indices[pid] = i;
+	return i;
+}
+
+
+void waitForGraph::AddWait(long waiter, long blocker)
+{
+	if (waiter == blocker)
+		return;
+
+	waiters.Add(AddSession(waiter));
+	blockers.Add(AddSession(blocker));
+}
+
+
+waitForSession *waitForGraph::FindSession(long pid) const
+{
+	waitForPidMap::const_iterator it = indices.find(pid);
+	if (it == indices.end())
+		return NULL;
+	return sessions.Item(it->second);
+}
+
+
+void waitForGraph::Analyze()
+{
+	long n = (long)sessions.GetCount();
+	long m = (long)waiters.GetCount();
+	long e, v, w, d;
+
+	order.Clear();
+	roots = 0;
+	cycles = 0;
+	if (!n)
+		return;
+
+	// The sessions waiting for each session (from next[start[v]] up to
+	// next[start[v + 1]]), in the order the waits were added
+	long *start = new long[n + 1];
+	long *fill = new long[n];
+	long *next = new long[m];
+
+	for (v = 0 ; v <= n ; v++)
+		start[v] = 0;
+	for (e = 0 ; e < m ; e++)
+		start[blockers.Item(e) + 1]++;
+	for (v = 0 ; v < n ; v++)
+		start[v + 1] += start[v];
+	for (v = 0 ; v < n ; v++)
+		fill[v] = start[v];
+	for (e = 0 ; e < m ; e++)
+		next[fill[blockers.Item(e)]++] = waiters.Item(e);
+
+	// Find the cycles, as strongly connected components (Tarjan), without
+	// recursion: the sessions being visited are on callNode, with the
+	// position of the next wait to follow on callEdge
+	long *index = new long[n];
+	long *low = new long[n];
+	long *component = new long[n];
+	long *stack = new long[n];
+	long *callNode = new long[n];
+	long *callEdge = new long[n];
+	bool *onStack = new bool[n];
+	long counter = 0, stackTop = 0, components = 0, r;
+
+	for (v = 0 ; v < n ; v++)
+	{
+		index[v] = -1;
+		onStack[v] = false;
+	}
+
+	for (r = 0 ; r < n ; r++)
+	{
+		if (index[r] >= 0)
+			continue;
+
+		d = 0;
+		callNode[0] = r;
+		callEdge[0] = start[r];
+		index[r] = low[r] = counter++;
+		stack[stackTop++] = r;
+		onStack[r] = true;
+
+		while (d >= 0)
+		{
+			v = callNode[d];
+			if (callEdge[d] < start[v + 1])
+			{
+				w = next[callEdge[d]++];
+				if (index[w] < 0)
+				{
+					index[w] = low[w] = counter++;
+					stack[stackTop++] = w;
+					onStack[w] = true;
+					d++;
+					callNode[d] = w;
+					callEdge[d] = start[w];
+				}
+				else if (onStack[w] && index[w] < low[v])
+					low[v] = index[w];
+			}
+			else
+			{
+				if (low[v] == index[v])
+				{
+					do
+					{
+						w = stack[--stackTop];
+						onStack[w] = false;
+						component[w] = components;
+					}
+					while (w != v);
+					components++;
+				}
+				d--;
+				if (d >= 0 && low[v] < low[callNode[d]])
+					low[callNode[d]] = low[v];
+			}
+		}
+	}
+
+	// The components nobody outside of them waits for hold the roots
+	long *componentSize = new long[components];
+	bool *componentEntered = new bool[components];
+
+	for (v = 0 ; v < components ; v++)
+	{
+		componentSize[v] = 0;
+		componentEntered[v] = false;
+	}
+	for (v = 0 ; v < n ; v++)
+		componentSize[component[v]]++;
+	for (e = 0 ; e < m ; e++)
+	{
+		if (component[waiters.Item(e)] != component[blockers.Item(e)])
+			componentEntered[component[waiters.Item(e)]] = true;
+	}
+
+	for (v = 0 ; v < n ; v++)
+	{
+		waitForSession *session = sessions.Item(v);
+		session->depth = 0;
+		session->behind = 0;
+		session->inCycle = componentSize[component[v]] > 1;
+	}
+
+	// Build the tree depth first, from the first session of each root
+	// component. Every other session is reached from one of them.
+	long *parent = new long[n];
+	bool *visited = new bool[n];
+	waitForRoot *rootList = new waitForRoot[n];
+	wxArrayLong tree;
+
+	tree.Alloc(n);
+	for (v = 0 ; v < n ; v++)
+		visited[v] = false;
+
+	for (r = 0 ; r < n ; r++)
+	{
+		if (componentEntered[component[r]])
+			continue;
+
+		// Only one root per component
+		componentEntered[component[r]] = true;
+		if (componentSize[component[r]] > 1)
+			cycles++;
+
+		rootList[roots].start = tree.GetCount();
+		roots++;
+
+		d = 0;
+		callNode[0] = r;
+		callEdge[0] = start[r];
+		visited[r] = true;
+		parent[r] = -1;
+		tree.Add(r);
+
+		while (d >= 0)
+		{
+			v = callNode[d];
+			if (callEdge[d] < start[v + 1])
+			{
+				w = next[callEdge[d]++];
+				if (!visited[w])
+				{
+					visited[w] = true;
+					parent[w] = v;
+					sessions.Item(w)->depth = d + 1;
+					tree.Add(w);
+					d++;
+					callNode[d] = w;
+					callEdge[d] = start[w];
+				}
+			}
+			else
+				d--;
+		}
+	}
+
+	// Each session comes after its parent in the tree
+	for (v = (long)tree.GetCount() - 1 ; v >= 0 ; v--)
+	{
+		w = tree.Item(v);
+		if (parent[w] >= 0)
+			sessions.Item(parent[w])->behind += sessions.Item(w)->behind + 1;
+	}
+
+	for (r = 0 ; r < (long)roots ; r++)
+		rootList[r].behind = sessions.Item(tree.Item(rootList[r].start))->behind;
+	qsort(rootList, roots, sizeof(waitForRoot), CompareRoots);
+
+	order.Alloc(n);
+	for (r = 0 ; r < (long)roots ; r++)
+	{
+		for (size_t i = 0 ; i <= rootList[r].behind ; i++)
+			order.Add(tree.Item(rootList[r].start + i));
+	}
+
+	delete [] rootList;
+	delete [] visited;
+	delete [] parent;
+	delete [] componentEntered;
+	delete [] componentSize;
+	delete [] onStack;
+	delete [] callEdge;
+	delete [] callNode;
+	delete [] stack;
+	delete [] component;
+	delete [] low;
+	delete [] index;
+	delete [] next;
+	delete [] fill;
+	delete [] start;
+}